@@ -27,10 +27,75 @@ class OrderSide(Enum):
     BID = "BID"
     ASK = "ASK"
 
+# Binary wire format (must match order_book_processor/feed_protocol.hpp)
+# Little-endian, no padding: 48-byte header followed by a type-specific body
+FEED_MAGIC = 0x4642
+FEED_PROTOCOL_VERSION = 1
+FEED_PRICE_SCALE = 1_000_000  # 6 implied decimals
+
+FEED_HEADER = struct.Struct('<HBBHBB8s4sIQQQ')  # magic, version, type, length, side, flags,
+                                                # symbol, exchange, reserved, seq, ts, mono_ns
+FEED_ORDER_BODY = struct.Struct('<QqII')        # order_id, price, size, remaining_size
+FEED_TRADE_BODY = struct.Struct('<QqII')        # order_id, trade_price, trade_size, reserved
+FEED_QUOTE_BODY = struct.Struct('<qqII')        # bid_price, ask_price, bid_size, ask_size
+FEED_STATUS_BODY = struct.Struct('<H')          # text_length (text follows)
+
+FEED_MESSAGE_TYPES = {
+    'ADD_ORDER': 1, 'MODIFY_ORDER': 2, 'CANCEL_ORDER': 3, 'DELETE_ORDER': 4,
+    'TRADE': 5, 'QUOTE_UPDATE': 6, 'MARKET_STATUS': 7
+}
+FEED_SIDES = {'BID': 1, 'ASK': 2}
+FEED_FLAG_AGGRESSOR = 0x01
+FEED_FLAG_TRADING_HALTED = 0x02
+
+def encode_price(price):
+    return int(round(price * FEED_PRICE_SCALE))
+
+def encode_binary_event(event):
+    """Encode an order book event dict into the binary feed format"""
+    event_type = event['event_type']
+    # The JSON feed carries the same number as a decimal string
+    order_id = int(event.get('order_id', '0'))
+
+    if event_type == 'TRADE':
+        body = FEED_TRADE_BODY.pack(order_id, encode_price(event.get('trade_price', 0.0)),
+                                    event.get('trade_size', 0), 0)
+    elif event_type == 'QUOTE_UPDATE':
+        body = FEED_QUOTE_BODY.pack(encode_price(event.get('bid_price', 0.0)),
+                                    encode_price(event.get('ask_price', 0.0)),
+                                    event.get('bid_size', 0), event.get('ask_size', 0))
+    elif event_type == 'MARKET_STATUS':
+        text = event.get('status_message', '').encode('utf-8')
+        body = FEED_STATUS_BODY.pack(len(text)) + text
+    else:
+        body = FEED_ORDER_BODY.pack(order_id, encode_price(event.get('price', 0.0)),
+                                    event.get('size', 0), event.get('remaining_size', 0))
+
+    flags = 0
+    if event.get('is_aggressor'):
+        flags |= FEED_FLAG_AGGRESSOR
+    if event.get('is_trading_halted'):
+        flags |= FEED_FLAG_TRADING_HALTED
+
+    header = FEED_HEADER.pack(
+        FEED_MAGIC, FEED_PROTOCOL_VERSION, FEED_MESSAGE_TYPES[event_type],
+        FEED_HEADER.size + len(body), FEED_SIDES.get(event.get('side'), 0), flags,
+        event['symbol'].encode('ascii')[:8], event.get('exchange', '').encode('ascii')[:4], 0,
+        event.get('sequence_number', 0), event.get('timestamp', 0), event.get('exchange_mono_ns', 0))
+    return header + body
+
 class MarketDataSimulator:
-    def __init__(self, multicast_group='224.0.0.1', port=12345, symbols=None, update_rate=100):
+    def __init__(self, multicast_group='224.0.0.1', port=12345, symbols=None, update_rate=100,
+                 wire_format='json', line_b_group=None, loss=0.0):
         self.multicast_group = multicast_group
         self.port = port
+        self.wire_format = wire_format  # 'json' or 'binary'
+        
+        # Redundant feed: every event also goes to line B (same port, same sequence number)
+        self.line_b_group = line_b_group
+        # Probability of dropping each datagram, applied to each line independently
+        self.loss = loss
+
         self.update_rate = update_rate  # updates per second
         self.running = False
         
@@ -55,9 +120,11 @@ class MarketDataSimulator:
             self.order_books[symbol] = {
                 'bids': {},  # price -> size
                 'asks': {},  # price -> size
-                'next_order_id': 1000
             }
         
+        # Order IDs are numbered feed-wide, so both wire formats carry the same ID
+        self.next_order_id = 1000
+        
         # Multicast socket
         self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
         
@@ -97,9 +164,9 @@ class MarketDataSimulator:
             weights=list(event_weights.values())
         )[0]
         
-        # Generate order ID
-        order_id = f"{symbol}_{book['next_order_id']}"
-        book['next_order_id'] += 1
+        # Generate order ID (sent as a decimal string in JSON, as the integer in binary)
+        order_id = str(self.next_order_id)
+        self.next_order_id += 1
         
         # Choose side
         side = random.choice([OrderSide.BID, OrderSide.ASK])
@@ -107,8 +174,6 @@ class MarketDataSimulator:
         # Timestamps
         timestamp = int(time.time() * 1_000_000_000)
         mono_ns = time.monotonic_ns()
-        sequence = getattr(self, 'sequence', 0)
-        self.sequence = sequence + 1
         
         event = {
             'event_type': event_type.value,
@@ -117,7 +182,6 @@ class MarketDataSimulator:
             'order_id': order_id,
             'side': side.value,
             'timestamp': timestamp,
-            'sequence_number': sequence,
             'exchange_mono_ns': mono_ns
         }
         
@@ -217,6 +281,10 @@ class MarketDataSimulator:
                 'ask_size': ask_size
             })
         
+        # Numbered only once the event is final (the retries above must not leave gaps)
+        sequence = getattr(self, 'sequence', 0)
+        self.sequence = sequence + 1
+        event['sequence_number'] = sequence
         return event
     
     """Old function, no longer being used"""
@@ -269,11 +337,16 @@ class MarketDataSimulator:
     def send_order_book_event(self, event):
         """Send an order book event via multicast"""
         try:
-            # Convert to JSON and encode
-            data = json.dumps(event).encode('utf-8')
+            # Encode in the selected wire format
+            if self.wire_format == 'binary':
+                data = encode_binary_event(event)
+            else:
+                data = json.dumps(event).encode('utf-8')
             
-            # Send via multicast to all subscribers
-            self.sock.sendto(data, (self.multicast_group, self.port))
+            # Send via multicast to all subscribers (on both lines when redundant)
+            for group in (self.multicast_group, self.line_b_group):
+                if group and (self.loss <= 0 or random.random() >= self.loss):
+                    self.sock.sendto(data, (group, self.port))
             
             # Print what we're sending (for debugging)
             event_type = event['event_type']
@@ -315,6 +388,11 @@ class MarketDataSimulator:
         print(f"Starting multicast market data simulation on {self.multicast_group}:{self.port}")
         print(f"Symbols: {', '.join(self.symbols)}")
         print(f"Update rate: {self.update_rate} quotes/second")
+        print(f"Wire format: {self.wire_format}")
+        if self.line_b_group:
+            print(f"Line B: {self.line_b_group}:{self.port}")
+        if self.loss > 0:
+            print(f"Simulated loss: {self.loss * 100:.1f}% per line")
         print("Broadcasting market data via multicast to all subscribers")
         print("Press Ctrl+C to stop")
         print("-" * 60)
@@ -361,6 +439,11 @@ def main():
     parser.add_argument('--port', type=int, default=12345, help='Multicast port (default: 12345)')
     parser.add_argument('--rate', type=int, default=100, help='Order book events per second (default: 100)')
     parser.add_argument('--symbols', nargs='+', help='Custom symbols to simulate')
+    parser.add_argument('--format', choices=['json', 'binary'], default='json',
+                        help='Wire format (default: json)')
+    parser.add_argument('--line-b-group', help='Also send every event to this group (redundant B line)')
+    parser.add_argument('--loss', type=float, default=0.0,
+                        help='Fraction of datagrams dropped on each line, e.g. 0.01 (default: 0)')
     
     args = parser.parse_args()
     
@@ -369,7 +452,10 @@ def main():
         multicast_group=args.multicast_group,
         port=args.port,
         symbols=args.symbols,
-        update_rate=args.rate
+        update_rate=args.rate,
+        wire_format=args.format,
+        line_b_group=args.line_b_group,
+        loss=args.loss
     )
     
     try:
@@ -0,0 +1,632 @@
+#ifndef HTTP_SERVER_HPP
+#define HTTP_SERVER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// One parsed HTTP request. The views point into the connection's input buffer
+// and are only valid during the handler call.
+struct HttpRequest {
+    std::string_view method;
+    std::string_view uri;
+    std::string_view version;
+    std::string_view headers;       // Raw header lines, without the request line
+    bool keep_alive = true;
+    size_t loop = 0;                // Event loop serving the request (0..threads-1), for per-loop state
+
+    // Value of a header (case-insensitive name), empty if absent
+    std::string_view header(std::string_view name) const {
+        size_t pos = 0;
+        while (pos < headers.size()) {
+            size_t end = headers.find("\r\n", pos);
+            if (end == std::string_view::npos) end = headers.size();
+            std::string_view line = headers.substr(pos, end - pos);
+            pos = end + 2;
+
+            size_t colon = line.find(':');
+            if (colon != name.size() || !equals_ignore_case(line.substr(0, colon), name)) continue;
+            std::string_view value = line.substr(colon + 1);
+            while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) value.remove_prefix(1);
+            while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.remove_suffix(1);
+            return value;
+        }
+        return {};
+    }
+
+    // Value of a query string parameter (not percent-decoded), empty if absent
+    std::string_view query(std::string_view name) const {
+        size_t start = uri.find('?');
+        while (start != std::string_view::npos) {
+            size_t end = uri.find('&', start + 1);
+            std::string_view pair = uri.substr(start + 1, end == std::string_view::npos ? end : end - start - 1);
+            if (pair.size() > name.size() && pair.substr(0, name.size()) == name && pair[name.size()] == '=') {
+                return pair.substr(name.size() + 1);
+            }
+            start = end;
+        }
+        return {};
+    }
+
+    static bool equals_ignore_case(std::string_view a, std::string_view b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            char x = a[i] >= 'A' && a[i] <= 'Z' ? a[i] + ('a' - 'A') : a[i];
+            char y = b[i] >= 'A' && b[i] <= 'Z' ? b[i] + ('a' - 'A') : b[i];
+            if (x != y) return false;
+        }
+        return true;
+    }
+};
+
+// Event-driven HTTP/1.1 server: a fixed pool of epoll loops sharing one
+// non-blocking listening socket.
+//
+// Every loop waits on the listening socket (EPOLLEXCLUSIVE, so a new
+// connection wakes one loop) and owns the connections it accepts, so no
+// connection state is shared between threads. Connections are kept alive and
+// pipelined requests are answered in order from one read. The handler appends a
+// complete response (status line, headers, body) to the connection's output
+// buffer, which is sent as is; it runs on the loop thread and must not block.
+//
+// Streaming responses (Server-Sent Events): a handler that calls open_stream()
+// keeps the connection open after its response headers. Further requests on it
+// are ignored and it is exempt from the idle timeout. The stream pump runs for
+// it on its loop thread after notify_streams(), once a second, and when its
+// client has caught up, but only while nothing is left unsent for that client:
+// a slow client is pumped less often, so the pump should append the latest
+// state rather than every change (per-client conflation).
+class HttpServer {
+public:
+    using Handler = std::function<void(const HttpRequest&, std::string& out)>;
+    using StreamPump = std::function<bool(size_t loop, uint64_t stream, std::string& out)>;  // false = close it
+    using StreamClosed = std::function<void(size_t loop, uint64_t stream)>;
+
+    static constexpr size_t MAX_REQUEST_BYTES = 16 * 1024;  // Header block limit
+    static constexpr size_t MAX_BODY_BYTES = 16 * 1024;     // Request body limit (bodies are skipped)
+    static constexpr size_t MAX_PENDING_OUTPUT = 1024 * 1024;  // Stop reading a client that does not read its responses
+    static constexpr int IDLE_TIMEOUT_SECONDS = 30;
+    static constexpr int STREAM_SEND_BUFFER = 64 * 1024;  // Kernel buffering per stream, bounds what a slow client lags by
+
+    explicit HttpServer(int port, size_t threads = 2)
+        : port_(port), threads_(threads > 0 ? threads : 1), listen_fd_(-1), running_(false),
+          connections_accepted_(0), requests_served_(0), next_stream_(0) {}
+
+    ~HttpServer() {
+        stop();
+    }
+
+    void set_handler(Handler handler) { handler_ = handler; }
+    void set_stream_handlers(StreamPump pump, StreamClosed closed) {
+        stream_pump_ = pump;
+        stream_closed_ = closed;
+    }
+
+    // From a handler: keep the request's connection open as a stream once the
+    // response headers it appended are sent. Returns the stream's ID (unique
+    // per server), which the pump and close callbacks are given.
+    uint64_t open_stream(const HttpRequest& request) {
+        uint64_t stream = ++next_stream_;
+        loops_[request.loop]->opening_stream = stream;
+        return stream;
+    }
+
+    // Any thread: something streams may want changed; pump every open stream soon.
+    // Cheap when called often: each loop is woken once until it has pumped.
+    // The notifying thread must be stopped before stop().
+    void notify_streams() {
+        if (!running_.load(std::memory_order_acquire)) {
+            return;
+        }
+        for (auto& loop : loops_) {
+            if (loop->stream_count.load(std::memory_order_relaxed) > 0 &&
+                !loop->notified.exchange(true, std::memory_order_acq_rel)) {
+                loop->wake();
+            }
+        }
+    }
+
+    // Number of event loops (call before start)
+    void set_threads(size_t threads) { threads_ = threads > 0 ? threads : 1; }
+    size_t get_threads() const { return threads_; }
+
+    bool start() {
+        if (running_.load()) {
+            return true;
+        }
+
+        listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listen_fd_ < 0) {
+            std::cerr << "Failed to create socket: " << strerror(errno) << std::endl;
+            return false;
+        }
+
+        int opt = 1;
+        if (setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
+            std::cerr << "Failed to set socket options: " << strerror(errno) << std::endl;
+            close_listener();
+            return false;
+        }
+
+        struct sockaddr_in address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = INADDR_ANY;
+        address.sin_port = htons(port_);
+        if (bind(listen_fd_, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) < 0) {
+            std::cerr << "Failed to bind socket to port " << port_ << ": " << strerror(errno) << std::endl;
+            close_listener();
+            return false;
+        }
+
+        if (listen(listen_fd_, SOMAXCONN) < 0) {
+            std::cerr << "Failed to listen on socket: " << strerror(errno) << std::endl;
+            close_listener();
+            return false;
+        }
+
+        for (size_t i = 0; i < threads_; ++i) {
+            auto loop = std::make_unique<EventLoop>(*this, i);
+            if (!loop->initialize()) {
+                loops_.clear();
+                close_listener();
+                return false;
+            }
+            loops_.push_back(std::move(loop));
+        }
+
+        running_.store(true);
+        for (auto& loop : loops_) {
+            loop->thread = std::thread([this, raw = loop.get()]() { raw->run(); });
+        }
+        return true;
+    }
+
+    void stop() {
+        if (!running_.exchange(false)) {
+            return;
+        }
+        for (auto& loop : loops_) {
+            loop->wake();
+        }
+        for (auto& loop : loops_) {
+            if (loop->thread.joinable()) {
+                loop->thread.join();
+            }
+        }
+        loops_.clear();
+        close_listener();
+    }
+
+    bool is_running() const { return running_.load(); }
+    int get_port() const { return port_; }
+    uint64_t get_connections_accepted() const { return connections_accepted_.load(std::memory_order_relaxed); }
+    uint64_t get_requests_served() const { return requests_served_.load(std::memory_order_relaxed); }
+    size_t get_open_streams() const {
+        size_t streams = 0;
+        for (const auto& loop : loops_) {
+            streams += loop->stream_count.load(std::memory_order_relaxed);
+        }
+        return streams;
+    }
+
+    // Disable copy constructor and assignment
+    HttpServer(const HttpServer&) = delete;
+    HttpServer& operator=(const HttpServer&) = delete;
+
+private:
+    struct Connection {
+        std::string in;             // Received, not yet parsed
+        std::string out;            // Responses not yet sent
+        size_t out_offset = 0;
+        size_t header_scanned = 0;  // Bytes of the next request in already searched for the header end
+        bool closing = false;       // Close once out is sent
+        uint64_t stream = 0;        // Stream ID once open_stream() was called for it (0 = plain requests)
+        uint32_t events = EPOLLIN | EPOLLRDHUP;  // Registered epoll interest
+        std::chrono::steady_clock::time_point last_active;
+    };
+
+    struct EventLoop {
+        HttpServer& server;
+        size_t index;
+        int epoll_fd = -1;
+        int wake_fd = -1;
+        std::thread thread;
+        std::unordered_map<int, Connection> connections;
+        std::vector<int> streams;                   // Connections that are streams
+        std::atomic<size_t> stream_count{0};        // streams.size(), for notify_streams()
+        std::atomic<bool> notified{false};          // Woken by notify_streams(), not yet pumped
+        uint64_t opening_stream = 0;                // Set by open_stream() during a handler call
+        bool pump_due = false;
+
+        EventLoop(HttpServer& owner, size_t loop_index) : server(owner), index(loop_index) {}
+
+        ~EventLoop() {
+            for (auto& entry : connections) {
+                close(entry.first);
+            }
+            if (wake_fd >= 0) close(wake_fd);
+            if (epoll_fd >= 0) close(epoll_fd);
+        }
+
+        bool initialize() {
+            epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+            wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (epoll_fd < 0 || wake_fd < 0) {
+                std::cerr << "Failed to create event loop: " << strerror(errno) << std::endl;
+                return false;
+            }
+            struct epoll_event event;
+            std::memset(&event, 0, sizeof(event));
+            event.events = EPOLLIN | EPOLLEXCLUSIVE;
+            event.data.fd = server.listen_fd_;
+            if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, server.listen_fd_, &event) < 0) {
+                std::cerr << "Failed to watch listening socket: " << strerror(errno) << std::endl;
+                return false;
+            }
+            event.events = EPOLLIN;
+            event.data.fd = wake_fd;
+            if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event) < 0) {
+                std::cerr << "Failed to watch wake descriptor: " << strerror(errno) << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        void wake() {
+            uint64_t one = 1;
+            if (write(wake_fd, &one, sizeof(one)) < 0) {
+                // Already signalled
+            }
+        }
+
+        void run() {
+            constexpr int MAX_EVENTS = 64;
+            struct epoll_event events[MAX_EVENTS];
+            auto last_sweep = std::chrono::steady_clock::now();
+
+            while (server.running_.load(std::memory_order_relaxed)) {
+                int count = epoll_wait(epoll_fd, events, MAX_EVENTS, 1000);
+                if (count < 0) {
+                    if (errno == EINTR) continue;
+                    std::cerr << "epoll_wait failed: " << strerror(errno) << std::endl;
+                    break;
+                }
+                for (int i = 0; i < count; ++i) {
+                    int fd = events[i].data.fd;
+                    if (fd == wake_fd) {
+                        uint64_t value;
+                        if (read(wake_fd, &value, sizeof(value)) < 0) {
+                            // Already drained
+                        }
+                        if (notified.exchange(false, std::memory_order_acq_rel)) {
+                            pump_due = true;
+                        }
+                        continue;
+                    }
+                    if (fd == server.listen_fd_) {
+                        accept_connections();
+                        continue;
+                    }
+                    auto it = connections.find(fd);
+                    if (it == connections.end()) continue;
+                    if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                        close_connection(fd);
+                        continue;
+                    }
+                    if ((events[i].events & (EPOLLIN | EPOLLRDHUP)) && !read_requests(fd, it->second)) {
+                        close_connection(fd);
+                        continue;
+                    }
+                    bool was_pending = it->second.out_offset < it->second.out.size();
+                    if (!flush(fd, it->second)) {
+                        close_connection(fd);
+                        continue;
+                    }
+                    if (it->second.stream != 0 && was_pending && it->second.out.empty()) {
+                        pump_due = true;  // A stream's client caught up: give it the latest
+                    }
+                }
+
+                auto now = std::chrono::steady_clock::now();
+                if (now - last_sweep >= std::chrono::seconds(1)) {
+                    close_idle(now);
+                    last_sweep = now;
+                    if (!streams.empty()) pump_due = true;  // Lets pumps send keep-alives
+                }
+                if (pump_due) {
+                    pump_due = false;
+                    pump_streams();
+                }
+            }
+        }
+
+        // Let every stream whose client has everything sent so far append what is new
+        void pump_streams() {
+            for (size_t i = 0; i < streams.size();) {
+                int fd = streams[i];
+                Connection& conn = connections.at(fd);
+                bool drained = conn.out_offset == conn.out.size();
+                if (drained && server.stream_pump_ && !server.stream_pump_(index, conn.stream, conn.out)) {
+                    conn.closing = true;
+                }
+                if (drained && !flush(fd, conn)) {
+                    close_connection(fd);  // Removes streams[i]
+                    continue;
+                }
+                ++i;
+            }
+        }
+
+        void accept_connections() {
+            while (true) {
+                int fd = accept4(server.listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (fd < 0) {
+                    if (errno == EINTR || errno == ECONNABORTED) continue;
+                    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                        std::cerr << "Failed to accept client connection: " << strerror(errno) << std::endl;
+                    }
+                    return;
+                }
+                int one = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+                struct epoll_event event;
+                std::memset(&event, 0, sizeof(event));
+                event.events = EPOLLIN | EPOLLRDHUP;
+                event.data.fd = fd;
+                if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+                    close(fd);
+                    continue;
+                }
+                connections[fd].last_active = std::chrono::steady_clock::now();
+                server.connections_accepted_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        // Read what is available and answer every complete request; false to close now
+        bool read_requests(int fd, Connection& conn) {
+            char buffer[16384];
+            while (conn.out.size() - conn.out_offset < MAX_PENDING_OUTPUT) {
+                ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+                if (received > 0) {
+                    // Anything after a "Connection: close" request, or on a stream, is ignored
+                    if (!conn.closing && conn.stream == 0) {
+                        conn.in.append(buffer, static_cast<size_t>(received));
+                        handle_requests(fd, conn);
+                    }
+                    continue;
+                }
+                if (received == 0) {
+                    conn.closing = true;  // Peer is done sending; answer what arrived, then close
+                    break;
+                }
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                return false;
+            }
+            conn.last_active = std::chrono::steady_clock::now();
+            return true;
+        }
+
+        void handle_requests(int fd, Connection& conn) {
+            size_t offset = 0;
+            while (offset < conn.in.size()) {
+                std::string_view pending(conn.in.data() + offset, conn.in.size() - offset);
+                // Resume the search where the last recv left it (minus a terminator split across reads)
+                size_t header_end = pending.find("\r\n\r\n", conn.header_scanned > 3 ? conn.header_scanned - 3 : 0);
+                if (header_end == std::string_view::npos) {
+                    conn.header_scanned = pending.size();
+                    if (pending.size() > MAX_REQUEST_BYTES) {
+                        respond_error(conn, "431 Request Header Fields Too Large");
+                    }
+                    break;
+                }
+                conn.header_scanned = header_end;
+
+                HttpRequest request;
+                std::string_view head = pending.substr(0, header_end);
+                size_t line_end = head.find("\r\n");
+                std::string_view request_line = head.substr(0, line_end);
+                request.headers = line_end == std::string_view::npos ? std::string_view() : head.substr(line_end + 2);
+
+                size_t first_space = request_line.find(' ');
+                size_t second_space = first_space == std::string_view::npos ? first_space
+                                                                            : request_line.find(' ', first_space + 1);
+                if (second_space == std::string_view::npos) {
+                    respond_error(conn, "400 Bad Request");
+                    break;
+                }
+                request.method = request_line.substr(0, first_space);
+                request.uri = request_line.substr(first_space + 1, second_space - first_space - 1);
+                request.version = request_line.substr(second_space + 1);
+
+                // Skip any body (the API only serves GETs), up to MAX_BODY_BYTES
+                size_t body_length = 0;
+                std::string_view content_length = request.header("Content-Length");
+                bool length_valid = true;
+                for (char c : content_length) {
+                    if (c < '0' || c > '9') {
+                        length_valid = false;
+                        break;
+                    }
+                    body_length = body_length * 10 + static_cast<size_t>(c - '0');
+                    if (body_length > MAX_BODY_BYTES) break;  // Stops before it can overflow
+                }
+                if (!length_valid) {
+                    respond_error(conn, "400 Bad Request");
+                    break;
+                }
+                if (body_length > MAX_BODY_BYTES) {
+                    respond_error(conn, "413 Payload Too Large");
+                    break;
+                }
+                size_t request_size = header_end + 4 + body_length;
+                if (pending.size() < request_size) {
+                    break;
+                }
+
+                std::string_view connection = request.header("Connection");
+                if (request.version == "HTTP/1.0") {
+                    request.keep_alive = HttpRequest::equals_ignore_case(connection, "keep-alive");
+                } else {
+                    request.keep_alive = !HttpRequest::equals_ignore_case(connection, "close");
+                }
+
+                request.loop = index;
+                size_t response_start = conn.out.size();
+                opening_stream = 0;
+                if (server.handler_) {
+                    server.handler_(request, conn.out);
+                }
+                offset += request_size;
+                conn.header_scanned = 0;
+                server.requests_served_.fetch_add(1, std::memory_order_relaxed);
+                if (opening_stream != 0) {
+                    start_stream(fd, conn, opening_stream);
+                    break;
+                }
+                if (!request.keep_alive) {
+                    mark_close(conn.out, response_start);
+                }
+
+                if (!request.keep_alive) {
+                    conn.closing = true;
+                    break;
+                }
+            }
+            conn.in.erase(0, offset);
+            if (conn.closing || conn.stream != 0) {
+                conn.in.clear();
+            }
+        }
+
+        void start_stream(int fd, Connection& conn, uint64_t stream) {
+            int buffer = STREAM_SEND_BUFFER;
+            setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &buffer, sizeof(buffer));
+            conn.stream = stream;
+            streams.push_back(fd);
+            stream_count.store(streams.size(), std::memory_order_relaxed);
+            pump_due = true;  // First state goes out right behind the headers
+        }
+
+        void respond_error(Connection& conn, const char* status) {
+            conn.out += "HTTP/1.1 ";
+            conn.out += status;
+            conn.out += "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+            conn.in.clear();
+            conn.closing = true;
+        }
+
+        // Add "Connection: close" to the header block of the response starting at start
+        static void mark_close(std::string& response, size_t start) {
+            size_t header_end = response.find("\r\n\r\n", start);
+            if (header_end != std::string::npos) {
+                response.insert(header_end + 2, "Connection: close\r\n");
+            }
+        }
+
+        // Send queued output; false to close now (error, or done with a closing connection)
+        bool flush(int fd, Connection& conn) {
+            while (conn.out_offset < conn.out.size()) {
+                ssize_t sent = send(fd, conn.out.data() + conn.out_offset, conn.out.size() - conn.out_offset,
+                                    MSG_NOSIGNAL);
+                if (sent > 0) {
+                    conn.out_offset += static_cast<size_t>(sent);
+                    continue;
+                }
+                if (sent < 0 && errno == EINTR) continue;
+                if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+                return false;
+            }
+
+            size_t pending = conn.out.size() - conn.out_offset;
+            if (pending == 0) {
+                conn.out.clear();
+                conn.out_offset = 0;
+                if (conn.closing) return false;
+            }
+
+            // Read while there is room for more responses, wait for writability while any are queued
+            uint32_t events = 0;
+            if (!conn.closing) events |= EPOLLRDHUP;
+            if (!conn.closing && pending < MAX_PENDING_OUTPUT) events |= EPOLLIN;
+            if (pending > 0) events |= EPOLLOUT;
+            if (events != conn.events) {
+                struct epoll_event event;
+                std::memset(&event, 0, sizeof(event));
+                event.events = events;
+                event.data.fd = fd;
+                epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event);
+                conn.events = events;
+            }
+            return true;
+        }
+
+        void close_connection(int fd) {
+            auto it = connections.find(fd);
+            if (it != connections.end() && it->second.stream != 0) {
+                streams.erase(std::find(streams.begin(), streams.end(), fd));
+                stream_count.store(streams.size(), std::memory_order_relaxed);
+                if (server.stream_closed_) {
+                    server.stream_closed_(index, it->second.stream);
+                }
+            }
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+            close(fd);
+            connections.erase(fd);
+        }
+
+        void close_idle(std::chrono::steady_clock::time_point now) {
+            std::vector<int> idle;
+            for (const auto& entry : connections) {
+                if (entry.second.stream == 0 &&
+                    now - entry.second.last_active > std::chrono::seconds(IDLE_TIMEOUT_SECONDS)) {
+                    idle.push_back(entry.first);
+                }
+            }
+            for (int fd : idle) {
+                close_connection(fd);
+            }
+        }
+    };
+
+    void close_listener() {
+        if (listen_fd_ >= 0) {
+            close(listen_fd_);
+            listen_fd_ = -1;
+        }
+    }
+
+    int port_;
+    size_t threads_;
+    int listen_fd_;
+    std::atomic<bool> running_;
+    Handler handler_;
+    StreamPump stream_pump_;
+    StreamClosed stream_closed_;
+    std::vector<std::unique_ptr<EventLoop>> loops_;
+    std::atomic<uint64_t> connections_accepted_;
+    std::atomic<uint64_t> requests_served_;
+    std::atomic<uint64_t> next_stream_;
+};
+
+#endif // HTTP_SERVER_HPP
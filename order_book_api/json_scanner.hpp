@@ -0,0 +1,181 @@
+#ifndef JSON_SCANNER_HPP
+#define JSON_SCANNER_HPP
+
+#include <charconv>
+#include <cstddef>
+#include <string_view>
+#include <system_error>
+
+// Single-pass, allocation-free scanning of the processor's JSON messages.
+//
+// The scanners walk one object (or array) from left to right and hand out
+// members as string_views into the original text: a string keeps its quotes,
+// a nested object or array is returned whole, so it can be scanned in turn.
+// Strings are not unescaped (the processor never escapes anything). Numbers
+// are converted with std::from_chars.
+
+namespace json_detail {
+
+inline size_t skip_space(std::string_view text, size_t pos) {
+    while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r')) {
+        ++pos;
+    }
+    return pos;
+}
+
+// Position just past the value starting at pos, or npos if it is malformed
+inline size_t skip_value(std::string_view text, size_t pos) {
+    if (pos >= text.size()) return std::string_view::npos;
+
+    char c = text[pos];
+    if (c == '"') {
+        for (size_t i = pos + 1; i < text.size(); ++i) {
+            if (text[i] == '\\') {
+                ++i;
+            } else if (text[i] == '"') {
+                return i + 1;
+            }
+        }
+        return std::string_view::npos;
+    }
+
+    if (c == '{' || c == '[') {
+        int depth = 0;
+        for (size_t i = pos; i < text.size(); ++i) {
+            char d = text[i];
+            if (d == '"') {
+                i = skip_value(text, i);
+                if (i == std::string_view::npos) return i;
+                --i;
+            } else if (d == '{' || d == '[') {
+                ++depth;
+            } else if ((d == '}' || d == ']') && --depth == 0) {
+                return i + 1;
+            }
+        }
+        return std::string_view::npos;
+    }
+
+    // Number or literal: up to the next delimiter
+    size_t end = pos;
+    while (end < text.size() && text[end] != ',' && text[end] != '}' && text[end] != ']' && text[end] != ' ' &&
+           text[end] != '\t' && text[end] != '\n' && text[end] != '\r') {
+        ++end;
+    }
+    return end > pos ? end : std::string_view::npos;
+}
+
+} // namespace json_detail
+
+// Members of one JSON object, in order
+class JsonObjectScanner {
+public:
+    explicit JsonObjectScanner(std::string_view text) : text_(text), pos_(0), failed_(false) {
+        pos_ = json_detail::skip_space(text_, 0);
+        if (pos_ >= text_.size() || text_[pos_] != '{') {
+            failed_ = true;
+        } else {
+            ++pos_;
+        }
+    }
+
+    // Next member; false at the end of the object, or if the text is malformed (failed())
+    bool next(std::string_view& key, std::string_view& value) {
+        if (failed_) return false;
+        pos_ = json_detail::skip_space(text_, pos_);
+        if (pos_ < text_.size() && text_[pos_] == '}') return false;
+
+        size_t key_end = json_detail::skip_value(text_, pos_);
+        if (key_end == std::string_view::npos || text_[pos_] != '"') return fail();
+        key = text_.substr(pos_ + 1, key_end - pos_ - 2);
+
+        pos_ = json_detail::skip_space(text_, key_end);
+        if (pos_ >= text_.size() || text_[pos_] != ':') return fail();
+        pos_ = json_detail::skip_space(text_, pos_ + 1);
+
+        size_t value_end = json_detail::skip_value(text_, pos_);
+        if (value_end == std::string_view::npos) return fail();
+        value = text_.substr(pos_, value_end - pos_);
+
+        pos_ = json_detail::skip_space(text_, value_end);
+        if (pos_ < text_.size() && text_[pos_] == ',') {
+            ++pos_;
+        } else if (pos_ >= text_.size() || text_[pos_] != '}') {
+            return fail();
+        }
+        return true;
+    }
+
+    bool failed() const { return failed_; }
+
+private:
+    bool fail() {
+        failed_ = true;
+        return false;
+    }
+
+    std::string_view text_;
+    size_t pos_;
+    bool failed_;
+};
+
+// Elements of one JSON array, in order
+class JsonArrayScanner {
+public:
+    explicit JsonArrayScanner(std::string_view text) : text_(text), pos_(0), failed_(false) {
+        pos_ = json_detail::skip_space(text_, 0);
+        if (pos_ >= text_.size() || text_[pos_] != '[') {
+            failed_ = true;
+        } else {
+            ++pos_;
+        }
+    }
+
+    // Next element; false at the end of the array, or if the text is malformed (failed())
+    bool next(std::string_view& value) {
+        if (failed_) return false;
+        pos_ = json_detail::skip_space(text_, pos_);
+        if (pos_ < text_.size() && text_[pos_] == ']') return false;
+
+        size_t value_end = json_detail::skip_value(text_, pos_);
+        if (value_end == std::string_view::npos) return fail();
+        value = text_.substr(pos_, value_end - pos_);
+
+        pos_ = json_detail::skip_space(text_, value_end);
+        if (pos_ < text_.size() && text_[pos_] == ',') {
+            ++pos_;
+        } else if (pos_ >= text_.size() || text_[pos_] != ']') {
+            return fail();
+        }
+        return true;
+    }
+
+    bool failed() const { return failed_; }
+
+private:
+    bool fail() {
+        failed_ = true;
+        return false;
+    }
+
+    std::string_view text_;
+    size_t pos_;
+    bool failed_;
+};
+
+// Convert a number member (integer or floating point); false if it is not entirely a number
+template<typename T>
+inline bool json_number(std::string_view value, T& out) {
+    const char* end = value.data() + value.size();
+    auto result = std::from_chars(value.data(), end, out);
+    return result.ec == std::errc() && result.ptr == end;
+}
+
+// Contents of a string member, without the quotes; false if it is not a string
+inline bool json_string(std::string_view value, std::string_view& out) {
+    if (value.size() < 2 || value.front() != '"' || value.back() != '"') return false;
+    out = value.substr(1, value.size() - 2);
+    return true;
+}
+
+#endif // JSON_SCANNER_HPP
@@ -2,28 +2,11 @@
 #include <sstream>
 #include <iomanip>
 #include <chrono>
-
-// Message types for multicast
-enum class MulticastMessageType {
-    ORDER_BOOK_UPDATE,
-    TRADE_UPDATE,
-    HEARTBEAT
-};
-
-// Multicast message structure
-struct MulticastMessage {
-    MulticastMessageType type;
-    std::string symbol;
-    uint64_t timestamp;
-    std::string data; // JSON payload
-    
-    MulticastMessage() = default;
-    MulticastMessage(MulticastMessageType t, const std::string& s, uint64_t ts, const std::string& d)
-        : type(t), symbol(s), timestamp(ts), data(d) {}
-};
+#include "json_scanner.hpp"
 
 MulticastSubscriber::MulticastSubscriber() 
-    : socket_fd_(-1), port_(0), listening_(false), messages_received_(0), bytes_received_(0), parse_errors_(0) {
+    : socket_fd_(-1), port_(0), listening_(false), messages_received_(0), bytes_received_(0), parse_errors_(0),
+      packets_lost_(0), packets_out_of_order_(0) {
 }
 
 MulticastSubscriber::~MulticastSubscriber() {
@@ -128,7 +111,7 @@ void MulticastSubscriber::stop_listening() {
 }
 
 void MulticastSubscriber::listen_loop() {
-    char buffer[4096];
+    char buffer[65536];  // Largest UDP payload, packed datagrams included
     
     while (listening_.load()) {
         struct sockaddr_in sender_addr;
@@ -144,91 +127,349 @@ void MulticastSubscriber::listen_loop() {
             continue;
         }
         
-        buffer[bytes_received] = '\0';
-        std::string json_str(buffer);
-        
         messages_received_++;
         bytes_received_ += bytes_received;
         
-        // Parse and handle message
-        MulticastMessage message;
-        if (parse_message(json_str, message)) {
-            switch (message.type) {
-                case MulticastMessageType::ORDER_BOOK_UPDATE:
-                    handle_order_book_update(message.symbol, message.data);
+        if (is_binary_multicast_message(buffer, static_cast<size_t>(bytes_received))) {
+            handle_binary_datagram(buffer, static_cast<size_t>(bytes_received));
+            continue;
+        }
+        
+        // A JSON datagram may carry several newline-separated messages (packed top-of-book)
+        std::string_view datagram(buffer, static_cast<size_t>(bytes_received));
+        while (!datagram.empty()) {
+            size_t end = datagram.find('\n');
+            std::string_view line = datagram.substr(0, end);
+            if (!line.empty()) {
+                handle_json_message(line);
+            }
+            datagram.remove_prefix(end == std::string_view::npos ? datagram.size() : end + 1);
+        }
+    }
+}
+
+bool MulticastSubscriber::track_sequence(uint16_t channel, uint64_t sequence) {
+    auto it = next_sequence_.find(channel);
+    if (it == next_sequence_.end()) {
+        // First packet seen on this channel (we may have joined mid-stream)
+        next_sequence_[channel] = sequence + 1;
+        return true;
+    }
+    
+    uint64_t expected = it->second;
+    if (sequence == expected) {
+        it->second = sequence + 1;
+        return true;
+    }
+    
+    if (sequence == 1) {
+        // Publisher restarted
+        std::cerr << "Multicast channel " << channel << " restarted" << std::endl;
+        it->second = 2;
+        return true;
+    }
+    
+    if (sequence > expected) {
+        uint64_t lost = sequence - expected;
+        packets_lost_ += lost;
+        std::cerr << "Multicast gap on channel " << channel << ": expected " << expected
+                  << ", got " << sequence << " (" << lost << " lost)" << std::endl;
+        it->second = sequence + 1;
+        return true;
+    }
+    
+    // Older than expected: duplicate or reordered, the state it carries is stale
+    packets_out_of_order_++;
+    return false;
+}
+
+void MulticastSubscriber::handle_binary_datagram(const char* data, size_t len) {
+    MulticastPacketHeader packet;
+    if (!decode_packet_header(data, len, packet)) {
+        parse_errors_++;
+        std::cerr << "Malformed binary multicast packet" << std::endl;
+        return;
+    }
+    if (!track_sequence(packet.channel, packet.sequence)) {
+        return;
+    }
+    
+    size_t offset = sizeof(MulticastPacketHeader);
+    while (offset < len) {
+        MulticastHeader header;
+        size_t length = decode_multicast_header(data + offset, len - offset, header);
+        if (length == 0) {
+            parse_errors_++;
+            std::cerr << "Malformed binary multicast message at offset " << offset << std::endl;
+            return;
+        }
+        
+        const char* body = data + offset + sizeof(MulticastHeader);
+        size_t body_len = length - sizeof(MulticastHeader);
+        offset += length;
+        
+        size_t symbol_len = 0;
+        while (symbol_len < sizeof(header.symbol) && header.symbol[symbol_len] != '\0') ++symbol_len;
+        symbol_.assign(header.symbol, symbol_len);
+        
+        switch (static_cast<MulticastMessageType>(header.msg_type)) {
+            case MulticastMessageType::ORDER_BOOK_UPDATE: {
+                TopOfBookMessage message;
+                if (!decode_top_of_book(header, body, body_len, message)) {
+                    parse_errors_++;
+                    break;
+                }
+                if (top_of_book_callback_) {
+                    top_of_book_callback_(symbol_, message);
+                }
+                break;
+            }
+            case MulticastMessageType::TRADE_UPDATE: {
+                TradeMessage message;
+                if (!decode_trade(header, body, body_len, message)) {
+                    parse_errors_++;
                     break;
-                case MulticastMessageType::TRADE_UPDATE:
-                    handle_trade_update(message.symbol, message.data);
+                }
+                if (trade_message_callback_) {
+                    trade_message_callback_(symbol_, message);
+                }
+                break;
+            }
+            case MulticastMessageType::DEPTH_UPDATE: {
+                if (!decode_depth_update(header, body, body_len, depth_message_)) {
+                    parse_errors_++;
                     break;
-                case MulticastMessageType::HEARTBEAT:
-                    handle_heartbeat(message.data);
+                }
+                if (depth_callback_) {
+                    depth_callback_(symbol_, depth_message_);
+                }
+                break;
+            }
+            case MulticastMessageType::ANALYTICS_UPDATE: {
+                AnalyticsMessage message;
+                if (!decode_analytics(header, body, body_len, message)) {
+                    parse_errors_++;
                     break;
-                default:
-                    std::cerr << "Unknown message type: " << static_cast<int>(message.type) << std::endl;
+                }
+                if (analytics_callback_) {
+                    analytics_callback_(symbol_, message);
+                }
+                break;
+            }
+            case MulticastMessageType::HEARTBEAT: {
+                MulticastHeartbeatBody heartbeat;
+                if (body_len < sizeof(heartbeat)) {
+                    parse_errors_++;
                     break;
+                }
+                std::memcpy(&heartbeat, body, sizeof(heartbeat));
+                size_t text_length = feed_detail::from_le(heartbeat.text_length);
+                if (body_len < sizeof(heartbeat) + text_length) {
+                    parse_errors_++;
+                    break;
+                }
+                handle_heartbeat(std::string(body + sizeof(heartbeat), text_length));
+                break;
             }
-        } else {
-            parse_errors_++;
-            std::cerr << "Failed to parse message: " << json_str << std::endl;
+            default:
+                std::cerr << "Unknown message type: " << static_cast<int>(header.msg_type) << std::endl;
+                break;
         }
     }
 }
 
-bool MulticastSubscriber::parse_message(const std::string& json_str, MulticastMessage& message) {
-    // Simple JSON parsing (in production, use a proper JSON library)
-    // This is a basic implementation for demonstration
+void MulticastSubscriber::handle_json_message(std::string_view text) {
+    // Envelope: {"type":N,"symbol":"...","timestamp":N,"data":{...}}
+    JsonObjectScanner envelope(text);
+    std::string_view key, value, symbol, data;
+    int type = -1;
+    uint64_t timestamp = 0;
+    while (envelope.next(key, value)) {
+        if (key == "type") {
+            json_number(value, type);
+        } else if (key == "symbol") {
+            json_string(value, symbol);
+        } else if (key == "timestamp") {
+            json_number(value, timestamp);
+        } else if (key == "data") {
+            data = value;
+        }
+    }
+    if (envelope.failed() || type < 0 || data.empty()) {
+        parse_errors_++;
+        std::cerr << "Failed to parse message: " << text << std::endl;
+        return;
+    }
+    symbol_.assign(symbol.data(), symbol.size());
     
-    try {
-        // Find type
-        size_t type_pos = json_str.find("\"type\":");
-        if (type_pos == std::string::npos) return false;
-        
-        size_t type_start = json_str.find_first_of("0123456789", type_pos);
-        size_t type_end = json_str.find_first_not_of("0123456789", type_start);
-        int type_val = std::stoi(json_str.substr(type_start, type_end - type_start));
-        message.type = static_cast<MulticastMessageType>(type_val);
-        
-        // Find symbol
-        size_t symbol_pos = json_str.find("\"symbol\":");
-        if (symbol_pos != std::string::npos) {
-            size_t symbol_start = json_str.find("\"", symbol_pos + 9) + 1;
-            size_t symbol_end = json_str.find("\"", symbol_start);
-            message.symbol = json_str.substr(symbol_start, symbol_end - symbol_start);
+    bool parsed = true;
+    switch (static_cast<MulticastMessageType>(type)) {
+        case MulticastMessageType::ORDER_BOOK_UPDATE: {
+            TopOfBookMessage message;
+            parsed = parse_top_of_book(data, message);
+            message.timestamp = timestamp;
+            if (parsed && top_of_book_callback_) {
+                top_of_book_callback_(symbol_, message);
+            }
+            break;
         }
-        
-        // Find timestamp
-        size_t timestamp_pos = json_str.find("\"timestamp\":");
-        if (timestamp_pos != std::string::npos) {
-            size_t timestamp_start = json_str.find_first_of("0123456789", timestamp_pos);
-            size_t timestamp_end = json_str.find_first_not_of("0123456789", timestamp_start);
-            message.timestamp = std::stoull(json_str.substr(timestamp_start, timestamp_end - timestamp_start));
+        case MulticastMessageType::TRADE_UPDATE: {
+            TradeMessage message;
+            parsed = parse_trade(data, message);
+            message.timestamp = timestamp;
+            if (parsed && trade_message_callback_) {
+                trade_message_callback_(symbol_, message);
+            }
+            break;
         }
-        
-        // Find data
-        size_t data_pos = json_str.find("\"data\":");
-        if (data_pos != std::string::npos) {
-            size_t data_start = json_str.find("{", data_pos);
-            size_t data_end = json_str.find_last_of("}") + 1;
-            message.data = json_str.substr(data_start, data_end - data_start);
+        case MulticastMessageType::DEPTH_UPDATE:
+            parsed = parse_depth_update(data, depth_message_);
+            depth_message_.timestamp = timestamp;
+            if (parsed && depth_callback_) {
+                depth_callback_(symbol_, depth_message_);
+            }
+            break;
+        case MulticastMessageType::ANALYTICS_UPDATE: {
+            AnalyticsMessage message;
+            parsed = parse_analytics(data, message);
+            message.timestamp = timestamp;
+            if (parsed && analytics_callback_) {
+                analytics_callback_(symbol_, message);
+            }
+            break;
+        }
+        case MulticastMessageType::HEARTBEAT:
+            handle_heartbeat(std::string(data));
+            break;
+        default:
+            std::cerr << "Unknown message type: " << type << std::endl;
+            break;
+    }
+    if (!parsed) {
+        parse_errors_++;
+        std::cerr << "Failed to parse message: " << text << std::endl;
+    }
+}
+
+bool MulticastSubscriber::parse_top_of_book(std::string_view data, TopOfBookMessage& message) {
+    message = TopOfBookMessage{{0.0, 0}, {0.0, 0}, 0, 0};
+    JsonObjectScanner scanner(data);
+    std::string_view key, value;
+    bool ok = true;
+    while (scanner.next(key, value)) {
+        if (key == "best_bid_price") {
+            ok &= json_number(value, message.best_bid.first);
+        } else if (key == "best_bid_size") {
+            ok &= json_number(value, message.best_bid.second);
+        } else if (key == "best_ask_price") {
+            ok &= json_number(value, message.best_ask.first);
+        } else if (key == "best_ask_size") {
+            ok &= json_number(value, message.best_ask.second);
         }
-        
-        return true;
-    } catch (const std::exception& e) {
-        std::cerr << "JSON parsing error: " << e.what() << std::endl;
-        return false;
     }
+    return ok && !scanner.failed();
 }
 
-void MulticastSubscriber::handle_order_book_update(const std::string& symbol, const std::string& data) {
-    if (order_book_callback_) {
-        order_book_callback_(symbol, data);
+bool MulticastSubscriber::parse_trade(std::string_view data, TradeMessage& message) {
+    message = TradeMessage{0.0, 0, OrderSide::UNKNOWN, 0, 0};
+    JsonObjectScanner scanner(data);
+    std::string_view key, value, side;
+    bool ok = true;
+    while (scanner.next(key, value)) {
+        if (key == "price") {
+            ok &= json_number(value, message.price);
+        } else if (key == "size") {
+            ok &= json_number(value, message.size);
+        } else if (key == "aggressor_side" && json_string(value, side)) {
+            message.aggressor_side = side == "BID" ? OrderSide::BID : side == "ASK" ? OrderSide::ASK : OrderSide::UNKNOWN;
+        }
+    }
+    return ok && !scanner.failed();
+}
+
+bool MulticastSubscriber::parse_depth_update(std::string_view data, DepthUpdateMessage& message) {
+    // {"reset":true,"depth":10,"levels":[{"action":"NEW","side":"BID","level":0,"price":...,"size":...},...]}
+    message.reset = false;
+    message.depth = 0;
+    message.delta_count = 0;
+    message.sequence = 0;
+    
+    JsonObjectScanner scanner(data);
+    std::string_view key, value, levels;
+    unsigned depth = 0;
+    while (scanner.next(key, value)) {
+        if (key == "reset") {
+            message.reset = value == "true";
+        } else if (key == "depth") {
+            if (!json_number(value, depth) || depth > MAX_BOOK_DEPTH) return false;
+            message.depth = static_cast<uint8_t>(depth);
+        } else if (key == "levels") {
+            levels = value;
+        }
+    }
+    if (scanner.failed()) return false;
+    
+    JsonArrayScanner entries(levels);
+    std::string_view entry;
+    while (entries.next(entry)) {
+        if (message.delta_count == 4 * MAX_BOOK_DEPTH) return false;
+        DepthDelta& delta = message.deltas[message.delta_count++];
+        delta = DepthDelta{DepthAction::CHANGE, OrderSide::BID, 0, 0.0, 0};
+        
+        JsonObjectScanner fields(entry);
+        std::string_view text;
+        unsigned level = 0;
+        bool ok = true;
+        while (fields.next(key, value)) {
+            if (key == "action" && json_string(value, text)) {
+                if (text == "NEW") {
+                    delta.action = DepthAction::NEW;
+                } else if (text == "CHANGE") {
+                    delta.action = DepthAction::CHANGE;
+                } else if (text == "DELETE") {
+                    delta.action = DepthAction::DELETE;
+                } else {
+                    ok = false;
+                }
+            } else if (key == "side" && json_string(value, text)) {
+                delta.side = text == "BID" ? OrderSide::BID : OrderSide::ASK;
+            } else if (key == "level") {
+                ok &= json_number(value, level) && level < MAX_BOOK_DEPTH;
+                delta.level = static_cast<uint8_t>(level);
+            } else if (key == "price") {
+                ok &= json_number(value, delta.price);
+            } else if (key == "size") {
+                ok &= json_number(value, delta.size);
+            }
+        }
+        if (!ok || fields.failed()) return false;
     }
+    return !entries.failed();
 }
 
-void MulticastSubscriber::handle_trade_update(const std::string& symbol, const std::string& data) {
-    if (trade_callback_) {
-        trade_callback_(symbol, data);
+bool MulticastSubscriber::parse_analytics(std::string_view data, AnalyticsMessage& message) {
+    message = AnalyticsMessage{};
+    JsonObjectScanner scanner(data);
+    std::string_view key, value;
+    bool ok = true;
+    while (scanner.next(key, value)) {
+        if (key == "vwap") {
+            ok &= json_number(value, message.vwap);
+        } else if (key == "microprice") {
+            ok &= json_number(value, message.microprice);
+        } else if (key == "depth_imbalance") {
+            ok &= json_number(value, message.depth_imbalance);
+        } else if (key == "order_flow_imbalance") {
+            ok &= json_number(value, message.order_flow_imbalance);
+        } else if (key == "window_volume") {
+            ok &= json_number(value, message.window_volume);
+        } else if (key == "window_trades") {
+            ok &= json_number(value, message.window_trades);
+        } else if (key == "window_ms") {
+            ok &= json_number(value, message.window_ms);
+        }
     }
+    return ok && !scanner.failed();
 }
 
 void MulticastSubscriber::handle_heartbeat(const std::string& data) {
@@ -237,14 +478,22 @@ void MulticastSubscriber::handle_heartbeat(const std::string& data) {
     }
 }
 
-void MulticastSubscriber::set_order_book_callback(std::function<void(const std::string&, const std::string&)> callback) {
-    order_book_callback_ = callback;
+void MulticastSubscriber::set_heartbeat_callback(std::function<void(const std::string&)> callback) {
+    heartbeat_callback_ = callback;
 }
 
-void MulticastSubscriber::set_trade_callback(std::function<void(const std::string&, const std::string&)> callback) {
-    trade_callback_ = callback;
+void MulticastSubscriber::set_top_of_book_callback(std::function<void(const std::string&, const TopOfBookMessage&)> callback) {
+    top_of_book_callback_ = callback;
 }
 
-void MulticastSubscriber::set_heartbeat_callback(std::function<void(const std::string&)> callback) {
-    heartbeat_callback_ = callback;
+void MulticastSubscriber::set_trade_message_callback(std::function<void(const std::string&, const TradeMessage&)> callback) {
+    trade_message_callback_ = callback;
+}
+
+void MulticastSubscriber::set_depth_callback(std::function<void(const std::string&, const DepthUpdateMessage&)> callback) {
+    depth_callback_ = callback;
+}
+
+void MulticastSubscriber::set_analytics_callback(std::function<void(const std::string&, const AnalyticsMessage&)> callback) {
+    analytics_callback_ = callback;
 }
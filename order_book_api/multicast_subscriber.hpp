@@ -11,10 +11,10 @@
 #include <thread>
 #include <atomic>
 #include <functional>
+#include <string_view>
+#include <unordered_map>
 #include "../order_book_processor/orderbook.hpp"
-
-// Forward declaration
-struct MulticastMessage;
+#include "../order_book_processor/multicast_protocol.hpp"
 
 // UDP Multicast Subscriber
 class MulticastSubscriber {
@@ -34,16 +34,24 @@ public:
     // Check if listening
     bool is_listening() const { return listening_.load(); }
     
-    // Set callbacks for different message types
-    void set_order_book_callback(std::function<void(const std::string&, const std::string&)> callback);
-    void set_trade_callback(std::function<void(const std::string&, const std::string&)> callback);
+    // Heartbeat counters and stats (JSON object text, either wire format)
     void set_heartbeat_callback(std::function<void(const std::string&)> callback);
     
+    // Decoded messages (symbol, message), from binary and JSON datagrams alike
+    void set_top_of_book_callback(std::function<void(const std::string&, const TopOfBookMessage&)> callback);
+    void set_trade_message_callback(std::function<void(const std::string&, const TradeMessage&)> callback);
+    void set_depth_callback(std::function<void(const std::string&, const DepthUpdateMessage&)> callback);
+    void set_analytics_callback(std::function<void(const std::string&, const AnalyticsMessage&)> callback);
+    
     // Get statistics
     uint64_t get_messages_received() const { return messages_received_; }
     uint64_t get_bytes_received() const { return bytes_received_; }
     uint64_t get_parse_errors() const { return parse_errors_; }
     
+    // Binary packet sequence tracking (per publisher channel)
+    uint64_t get_packets_lost() const { return packets_lost_; }
+    uint64_t get_packets_out_of_order() const { return packets_out_of_order_; }
+    
     // Get multicast group and port
     std::string get_multicast_group() const { return multicast_group_; }
     int get_port() const { return port_; }
@@ -52,14 +60,23 @@ private:
     // Main listening loop
     void listen_loop();
     
-    // Parse incoming message
-    bool parse_message(const std::string& json_str, MulticastMessage& message);
+    // Decode one JSON message and dispatch it by type
+    void handle_json_message(std::string_view text);
+    
+    // Decode every message in a binary datagram
+    void handle_binary_datagram(const char* data, size_t len);
+    
+    // Check a packet's channel sequence number; false for duplicates / stale packets
+    bool track_sequence(uint16_t channel, uint64_t sequence);
     
-    // Handle different message types
-    void handle_order_book_update(const std::string& symbol, const std::string& data);
-    void handle_trade_update(const std::string& symbol, const std::string& data);
     void handle_heartbeat(const std::string& data);
     
+    // Decode a JSON message's data object (single pass, no allocation)
+    static bool parse_top_of_book(std::string_view data, TopOfBookMessage& message);
+    static bool parse_trade(std::string_view data, TradeMessage& message);
+    static bool parse_depth_update(std::string_view data, DepthUpdateMessage& message);
+    static bool parse_analytics(std::string_view data, AnalyticsMessage& message);
+    
     // Member variables
     int socket_fd_;
     struct sockaddr_in multicast_addr_;
@@ -70,14 +87,21 @@ private:
     std::unique_ptr<std::thread> listen_thread_;
     
     // Callbacks
-    std::function<void(const std::string&, const std::string&)> order_book_callback_;
-    std::function<void(const std::string&, const std::string&)> trade_callback_;
     std::function<void(const std::string&)> heartbeat_callback_;
+    std::function<void(const std::string&, const TopOfBookMessage&)> top_of_book_callback_;
+    std::function<void(const std::string&, const TradeMessage&)> trade_message_callback_;
+    std::function<void(const std::string&, const DepthUpdateMessage&)> depth_callback_;
+    std::function<void(const std::string&, const AnalyticsMessage&)> analytics_callback_;
+    DepthUpdateMessage depth_message_;  // Decode buffer for depth updates
+    std::string symbol_;            // Decode buffer for message symbols
+    std::unordered_map<uint16_t, uint64_t> next_sequence_;  // Expected packet sequence per channel
     
     // Statistics
     std::atomic<uint64_t> messages_received_;
     std::atomic<uint64_t> bytes_received_;
     std::atomic<uint64_t> parse_errors_;
+    std::atomic<uint64_t> packets_lost_;
+    std::atomic<uint64_t> packets_out_of_order_;
 };
 
 #endif // MULTICAST_SUBSCRIBER_HPP
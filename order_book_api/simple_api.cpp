@@ -7,7 +7,10 @@
 #include <cstdlib>
 
 SimpleOrderBookAPI::SimpleOrderBookAPI(int port) 
-    : port_(port), server_socket_(-1), running_(false) {
+    : port_(port), server_(port), symbol_metrics_(MAX_SYMBOLS) {
+    std::ostringstream prefix;
+    prefix << std::hex << std::chrono::system_clock::now().time_since_epoch().count();
+    etag_prefix_ = prefix.str();
 }
 
 SimpleOrderBookAPI::~SimpleOrderBookAPI() {
@@ -15,195 +18,240 @@ SimpleOrderBookAPI::~SimpleOrderBookAPI() {
 }
 
 bool SimpleOrderBookAPI::start() {
-    if (running_.load()) {
+    if (server_.is_running()) {
         return true;
     }
     
-    // Create socket
-    server_socket_ = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_socket_ < 0) {
-        std::cerr << "Failed to create socket" << std::endl;
-        return false;
+    response_caches_.clear();
+    for (size_t i = 0; i < server_.get_threads(); ++i) {
+        response_caches_.push_back(std::make_unique<ResponseCache>());
     }
     
-    // Set socket options
-    int opt = 1;
-    if (setsockopt(server_socket_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
-        std::cerr << "Failed to set socket options" << std::endl;
-        close(server_socket_);
+    server_.set_handler([this](const HttpRequest& request, std::string& out) { handle_request(request, out); });
+    server_.set_stream_handlers(
+        [this](size_t loop, uint64_t stream, std::string& out) { return pump_stream(loop, stream, out); },
+        [this](size_t loop, uint64_t stream) { close_stream(loop, stream); });
+    if (!server_.start()) {
         return false;
     }
     
-    // Bind socket
-    struct sockaddr_in address;
-    address.sin_family = AF_INET;
-    address.sin_addr.s_addr = INADDR_ANY;
-    address.sin_port = htons(port_);
-    
-    if (bind(server_socket_, (struct sockaddr*)&address, sizeof(address)) < 0) {
-        std::cerr << "Failed to bind socket to port " << port_ << std::endl;
-        close(server_socket_);
-        return false;
+    std::cout << "Simple Order Book API server started on port " << port_ << " (" << server_.get_threads()
+              << " event loops)" << std::endl;
+    return true;
+}
+
+void SimpleOrderBookAPI::stop() {
+    if (!server_.is_running()) {
+        return;
     }
     
-    // Listen for connections
-    if (listen(server_socket_, 10) < 0) {
-        std::cerr << "Failed to listen on socket" << std::endl;
-        close(server_socket_);
-        return false;
+    server_.stop();
+    std::cout << "Simple Order Book API server stopped" << std::endl;
+}
+
+void SimpleOrderBookAPI::handle_request(const HttpRequest& request, std::string& out) {
+    if (request.method != "GET") {
+        out += create_http_response("{\"error\": \"Method not allowed\"}", 405);
+        return;
     }
     
-    // Start server thread
-    server_thread_ = std::make_unique<std::thread>(&SimpleOrderBookAPI::server_thread_function, this);
-    
-    // Wait a moment for server to start
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    
-    return running_.load();
+    const std::string_view& uri = request.uri;
+    if (uri == "/api/symbols") {
+        serve_symbols(request, out);
+    } else if (uri.find("/api/metrics/") == 0) {
+        serve_symbol(request, SymbolEndpoint::METRICS, std::string(uri.substr(13)), out); // Remove "/api/metrics/"
+    } else if (uri.find("/api/depth/") == 0) {
+        serve_symbol(request, SymbolEndpoint::DEPTH, std::string(uri.substr(11)), out); // Remove "/api/depth/"
+    } else if (uri.find("/api/trades/") == 0) {
+        serve_symbol(request, SymbolEndpoint::TRADES, std::string(uri.substr(12)), out); // Remove "/api/trades/"
+    } else if (uri == "/api/stream" || uri.find("/api/stream?") == 0) {
+        open_stream(request, out);
+    } else if (uri == "/api/health") {
+        out += handle_get_health();
+    } else if (uri == "/api/stats") {
+        out += handle_get_stats();
+    } else {
+        out += create_http_response("{\"error\": \"Not found\"}", 404);
+    }
 }
 
-void SimpleOrderBookAPI::stop() {
-    if (!running_.load()) {
+void SimpleOrderBookAPI::serve_symbol(const HttpRequest& request, SymbolEndpoint endpoint, const std::string& symbol,
+                                      std::string& out) {
+    uint64_t version = symbol_metrics_.version(symbol);
+    if (version == 0) {
+        // Unknown symbol: empty metrics, not cached (the URI space is unbounded)
+        out += create_http_response(symbol_body(endpoint, symbol, MarketMetrics()));
         return;
     }
     
-    running_.store(false);
-    
-    if (server_socket_ >= 0) {
-        close(server_socket_);
-        server_socket_ = -1;
+    CachedResponse& entry = cache_entry(request);
+    if (entry.version != version) {
+        MetricsSnapshot snapshot;
+        symbol_metrics_.load(symbol, snapshot, &version);
+        render(entry, version, symbol_body(endpoint, symbol, to_market_metrics(snapshot)));
     }
-    
-    if (server_thread_ && server_thread_->joinable()) {
-        server_thread_->join();
+    append_cached(request, entry, out);
+}
+
+void SimpleOrderBookAPI::serve_symbols(const HttpRequest& request, std::string& out) {
+    // Symbols are only ever added, so the count versions the list
+    uint64_t version = symbol_metrics_.size() + 1;
+    CachedResponse& entry = cache_entry(request);
+    if (entry.version != version) {
+        render(entry, version, symbols_to_json());
     }
+    append_cached(request, entry, out);
 }
 
-void SimpleOrderBookAPI::server_thread_function() {
-    running_.store(true);
-    std::cout << "Simple Order Book API server started on port " << port_ << std::endl;
-    
-    while (running_.load()) {
-        struct sockaddr_in client_address;
-        socklen_t client_len = sizeof(client_address);
-        
-        int client_socket = accept(server_socket_, (struct sockaddr*)&client_address, &client_len);
-        if (client_socket < 0) {
-            if (running_.load()) {
-                std::cerr << "Failed to accept client connection" << std::endl;
-            }
-            continue;
+SimpleOrderBookAPI::CachedResponse& SimpleOrderBookAPI::cache_entry(const HttpRequest& request) {
+    ResponseCache& cache = *response_caches_[request.loop];
+    cache.key.assign(request.uri.data(), request.uri.size());
+    return cache.entries[cache.key];
+}
+
+void SimpleOrderBookAPI::render(CachedResponse& entry, uint64_t version, const std::string& body) {
+    entry.version = version;
+    entry.etag = "\"" + etag_prefix_ + "-" + std::to_string(version) + "\"";
+    entry.response = create_http_response(body, 200, entry.etag);
+    entry.not_modified = create_http_response(std::string(), 304, entry.etag);
+    responses_rendered_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SimpleOrderBookAPI::append_cached(const HttpRequest& request, const CachedResponse& entry, std::string& out) {
+    std::string_view if_none_match = request.header("If-None-Match");
+    if (!if_none_match.empty() && (if_none_match == "*" || if_none_match.find(entry.etag) != std::string_view::npos)) {
+        out += entry.not_modified;
+        not_modified_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    out += entry.response;
+}
+
+void SimpleOrderBookAPI::open_stream(const HttpRequest& request, std::string& out) {
+    StreamSubscription subscription;
+    std::string_view list = request.query("symbols");
+    while (!list.empty() && subscription.symbols.size() < MAX_SYMBOLS) {
+        size_t comma = list.find(',');
+        std::string_view symbol = list.substr(0, comma);
+        if (!symbol.empty()) {
+            subscription.symbols.emplace_back(symbol);
         }
-        
-        // Handle client in a separate thread
-        std::thread client_thread(&SimpleOrderBookAPI::handle_client, this, client_socket);
-        client_thread.detach();
+        list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
     }
-    
-    std::cout << "Simple Order Book API server stopped" << std::endl;
+    subscription.all_symbols = subscription.symbols.empty();
+    subscription.sent_versions.assign(subscription.symbols.size(), 0);
+    subscription.last_write = std::chrono::steady_clock::now();
+    
+    uint64_t stream = server_.open_stream(request);
+    response_caches_[request.loop]->streams[stream] = std::move(subscription);
+    
+    // No Content-Length: the body runs until either side closes
+    out += "HTTP/1.1 200 OK\r\n"
+           "Content-Type: text/event-stream\r\n"
+           "Cache-Control: no-cache\r\n"
+           "Access-Control-Allow-Origin: *\r\n"
+           "\r\n"
+           "retry: 1000\n\n";
 }
 
-void SimpleOrderBookAPI::handle_client(int client_socket) {
-    char buffer[4096];
-    int bytes_received = recv(client_socket, buffer, sizeof(buffer) - 1, 0);
-    
-    if (bytes_received <= 0) {
-        close(client_socket);
-        return;
+bool SimpleOrderBookAPI::pump_stream(size_t loop, uint64_t stream, std::string& out) {
+    ResponseCache& cache = *response_caches_[loop];
+    auto it = cache.streams.find(stream);
+    if (it == cache.streams.end()) {
+        return false;
+    }
+    StreamSubscription& subscription = it->second;
+    
+    if (subscription.all_symbols && symbol_metrics_.size() != subscription.symbols.size()) {
+        // Insertion order, so the symbols already followed keep their index
+        std::vector<std::string> symbols = symbol_metrics_.symbols();
+        for (size_t i = subscription.symbols.size(); i < symbols.size(); ++i) {
+            subscription.symbols.push_back(std::move(symbols[i]));
+            subscription.sent_versions.push_back(0);
+        }
     }
     
-    buffer[bytes_received] = '\0';
-    std::string request(buffer);
-    
-    // Parse HTTP request
-    std::string method = parse_method(request);
-    std::string uri = parse_uri(request);
-    
-    std::string response;
-    
-    // Route requests
-    if (method == "GET") {
-        if (uri == "/api/symbols") {
-            response = handle_get_symbols();
-        } else if (uri.find("/api/metrics/") == 0) {
-            std::string symbol = uri.substr(13); // Remove "/api/metrics/"
-            response = handle_get_metrics(symbol);
-        } else if (uri.find("/api/depth/") == 0) {
-            std::string symbol = uri.substr(11); // Remove "/api/depth/"
-            response = handle_get_depth(symbol);
-        } else if (uri.find("/api/trades/") == 0) {
-            std::string symbol = uri.substr(12); // Remove "/api/trades/"
-            response = handle_get_trades(symbol);
-        } else if (uri == "/api/health") {
-            response = handle_get_health();
-        } else {
-            response = create_http_response("{\"error\": \"Not found\"}", 404);
+    size_t start = out.size();
+    uint64_t sent = 0;
+    for (size_t i = 0; i < subscription.symbols.size(); ++i) {
+        uint64_t version = symbol_metrics_.version(subscription.symbols[i]);
+        if (version == 0 || version == subscription.sent_versions[i]) {
+            continue;
         }
-    } else {
-        response = create_http_response("{\"error\": \"Method not allowed\"}", 405);
+        const CachedEvent& event = stream_event(cache, subscription.symbols[i], version);
+        if (event.version == subscription.sent_versions[i]) {
+            continue;  // Caught mid-update; the next notify brings the new version
+        }
+        out += event.text;
+        subscription.sent_versions[i] = event.version;
+        ++sent;
     }
     
-    // Send response
-    send(client_socket, response.c_str(), response.length(), 0);
-    close(client_socket);
+    auto now = std::chrono::steady_clock::now();
+    if (out.size() > start) {
+        subscription.last_write = now;
+        stream_events_sent_.fetch_add(sent, std::memory_order_relaxed);
+    } else if (now - subscription.last_write >= std::chrono::seconds(STREAM_KEEPALIVE_SECONDS)) {
+        out += ": keep-alive\n\n";  // Keeps proxies from timing the stream out
+        subscription.last_write = now;
+    }
+    return true;
 }
 
-std::string SimpleOrderBookAPI::parse_uri(const std::string& request) {
-    size_t start = request.find(' ');
-    if (start == std::string::npos) return "";
-    
-    size_t end = request.find(' ', start + 1);
-    if (end == std::string::npos) return "";
-    
-    return request.substr(start + 1, end - start - 1);
+void SimpleOrderBookAPI::close_stream(size_t loop, uint64_t stream) {
+    response_caches_[loop]->streams.erase(stream);
 }
 
-std::string SimpleOrderBookAPI::parse_method(const std::string& request) {
-    size_t end = request.find(' ');
-    if (end == std::string::npos) return "";
-    
-    return request.substr(0, end);
+const SimpleOrderBookAPI::CachedEvent& SimpleOrderBookAPI::stream_event(ResponseCache& cache, const std::string& symbol,
+                                                                         uint64_t version) {
+    CachedEvent& event = cache.events[symbol];
+    if (event.version != version) {
+        MetricsSnapshot snapshot;
+        symbol_metrics_.load(symbol, snapshot, &event.version);
+        event.text = "event: metrics\ndata: {\"symbol\": \"" + symbol + "\", \"metrics\": " +
+                     metrics_to_json(to_market_metrics(snapshot)) + "}\n\n";
+    }
+    return event;
 }
 
-std::string SimpleOrderBookAPI::handle_get_symbols() {
-    std::lock_guard<std::mutex> lock(data_mutex_);
-    
+std::string SimpleOrderBookAPI::symbols_to_json() const {
     std::ostringstream json;
     json << "{\"symbols\": [";
     
     bool first = true;
-    for (const auto& pair : symbol_metrics_) {
+    for (const auto& symbol : get_available_symbols()) {
         if (!first) json << ",";
-        json << "\"" << pair.first << "\"";
+        json << "\"" << symbol << "\"";
         first = false;
     }
     
     json << "]}";
     
-    return create_http_response(json.str());
-}
-
-std::string SimpleOrderBookAPI::handle_get_metrics(const std::string& symbol) {
-    MarketMetrics metrics = get_metrics(symbol);
-    std::string json = metrics_to_json(metrics);
-    return create_http_response(json);
+    return json.str();
 }
 
-std::string SimpleOrderBookAPI::handle_get_depth(const std::string& symbol) {
-    MarketMetrics metrics = get_metrics(symbol);
+std::string SimpleOrderBookAPI::symbol_body(SymbolEndpoint endpoint, const std::string& symbol,
+                                            const MarketMetrics& metrics) {
+    if (endpoint == SymbolEndpoint::METRICS) {
+        return metrics_to_json(metrics);
+    }
+    if (endpoint == SymbolEndpoint::TRADES) {
+        return trade_to_json(metrics.last_trade);
+    }
+    
+    // Depth, cut to the configured number of levels
+    size_t levels = static_cast<size_t>(depth_levels_);
+    std::vector<DepthLevel> bids(metrics.bid_depth.begin(),
+                                 metrics.bid_depth.begin() + std::min(levels, metrics.bid_depth.size()));
+    std::vector<DepthLevel> asks(metrics.ask_depth.begin(),
+                                 metrics.ask_depth.begin() + std::min(levels, metrics.ask_depth.size()));
     
     std::ostringstream json;
     json << "{\"symbol\": \"" << symbol << "\",";
-    json << "\"bid_depth\": " << depth_to_json(metrics.bid_depth, "bid") << ",";
-    json << "\"ask_depth\": " << depth_to_json(metrics.ask_depth, "ask") << "}";
+    json << "\"bid_depth\": " << depth_to_json(bids, "bid") << ",";
+    json << "\"ask_depth\": " << depth_to_json(asks, "ask") << "}";
     
-    return create_http_response(json.str());
-}
-
-std::string SimpleOrderBookAPI::handle_get_trades(const std::string& symbol) {
-    MarketMetrics metrics = get_metrics(symbol);
-    std::string json = trade_to_json(metrics.last_trade);
-    return create_http_response(json);
+    return json.str();
 }
 
 std::string SimpleOrderBookAPI::handle_get_health() {
@@ -211,16 +259,42 @@ std::string SimpleOrderBookAPI::handle_get_health() {
     json << "{\"status\": \"healthy\",";
     json << "\"running\": " << (is_running() ? "true" : "false") << ",";
     json << "\"port\": " << port_ << ",";
-    json << "\"symbols_count\": " << get_available_symbols().size() << "}";
+    json << "\"symbols_count\": " << get_available_symbols().size() << ",";
+    json << "\"http_threads\": " << server_.get_threads() << ",";
+    json << "\"connections_accepted\": " << server_.get_connections_accepted() << ",";
+    json << "\"requests_served\": " << server_.get_requests_served() << ",";
+    json << "\"depth_levels\": " << depth_levels_ << ",";
+    json << "\"depth_update_errors\": " << get_depth_update_errors() << ",";
+    json << "\"responses_rendered\": " << get_responses_rendered() << ",";
+    json << "\"not_modified\": " << get_not_modified() << ",";
+    json << "\"streams_open\": " << get_open_streams() << ",";
+    json << "\"stream_events_sent\": " << get_stream_events_sent() << "}";
     
     return create_http_response(json.str());
 }
 
-std::string SimpleOrderBookAPI::create_http_response(const std::string& body, int status_code) {
+std::string SimpleOrderBookAPI::handle_get_stats() {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    
+    if (processor_stats_json_.empty()) {
+        return create_http_response("{\"error\": \"No processor stats received yet\"}", 404);
+    }
+    
+    std::ostringstream json;
+    json << "{\"received_timestamp\": " << processor_stats_timestamp_ << ",";
+    json << "\"processor\": " << processor_stats_json_ << "}";
+    
+    return create_http_response(json.str());
+}
+
+std::string SimpleOrderBookAPI::create_http_response(const std::string& body, int status_code,
+                                                     const std::string& etag) {
     std::ostringstream response;
     
     if (status_code == 200) {
         response << "HTTP/1.1 200 OK\r\n";
+    } else if (status_code == 304) {
+        response << "HTTP/1.1 304 Not Modified\r\n";
     } else if (status_code == 404) {
         response << "HTTP/1.1 404 Not Found\r\n";
     } else if (status_code == 405) {
@@ -229,10 +303,15 @@ std::string SimpleOrderBookAPI::create_http_response(const std::string& body, in
         response << "HTTP/1.1 400 Bad Request\r\n";
     }
     
-    response << "Content-Type: application/json\r\n";
-    response << "Content-Length: " << body.length() << "\r\n";
+    if (status_code != 304) {
+        response << "Content-Type: application/json\r\n";
+        response << "Content-Length: " << body.length() << "\r\n";
+    }
+    if (!etag.empty()) {
+        response << "ETag: " << etag << "\r\n";
+        response << "Cache-Control: no-cache\r\n";
+    }
     response << "Access-Control-Allow-Origin: *\r\n";
-    response << "Connection: close\r\n";
     response << "\r\n";
     response << body;
     
@@ -251,6 +330,13 @@ std::string SimpleOrderBookAPI::metrics_to_json(const MarketMetrics& metrics) {
     json << "\"spread\": " << metrics.spread << ",";
     json << "\"midprice\": " << metrics.midprice << ",";
     json << "\"quote_imbalance\": " << metrics.quote_imbalance << ",";
+    json << "\"vwap\": " << metrics.vwap << ",";
+    json << "\"microprice\": " << metrics.microprice << ",";
+    json << "\"depth_imbalance\": " << metrics.depth_imbalance << ",";
+    json << "\"order_flow_imbalance\": " << metrics.order_flow_imbalance << ",";
+    json << "\"window_volume\": " << metrics.window_volume << ",";
+    json << "\"window_trades\": " << metrics.window_trades << ",";
+    json << "\"analytics_window_ms\": " << metrics.analytics_window_ms << ",";
     json << "\"last_update_timestamp\": " << metrics.last_update_timestamp << ",";
     json << "\"total_events_processed\": " << metrics.total_events_processed;
     json << "}";
@@ -279,7 +365,9 @@ std::string SimpleOrderBookAPI::trade_to_json(const TradeInfo& trade) {
     json << "{";
     json << "\"price\": " << trade.price << ",";
     json << "\"size\": " << trade.size << ",";
-    json << "\"aggressor_side\": \"" << (trade.aggressor_side == OrderSide::BID ? "BID" : "ASK") << "\",";
+    json << "\"aggressor_side\": \""
+         << (trade.aggressor_side == OrderSide::BID ? "BID" : trade.aggressor_side == OrderSide::ASK ? "ASK" : "UNKNOWN")
+         << "\",";
     json << "\"timestamp\": " << trade.timestamp;
     json << "}";
     
@@ -287,100 +375,201 @@ std::string SimpleOrderBookAPI::trade_to_json(const TradeInfo& trade) {
 }
 
 void SimpleOrderBookAPI::update_order_book(const std::string& symbol, const OrderBook& book) {
-    std::lock_guard<std::mutex> lock(data_mutex_);
-    
-    MarketMetrics metrics = calculate_metrics(book);
-    metrics.last_update_timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    uint64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
         std::chrono::steady_clock::now().time_since_epoch()).count();
     
-    // Preserve existing event count if symbol already exists
-    auto it = symbol_metrics_.find(symbol);
-    if (it != symbol_metrics_.end()) {
-        metrics.total_events_processed = it->second.total_events_processed;
-        metrics.last_trade = it->second.last_trade; // Preserve trade info too
+    // Event count and last trade carry over in the symbol's slot
+    bool stored = symbol_metrics_.update(symbol, true, [&](MetricsSnapshot& metrics) {
+        calculate_metrics(book, metrics);
+        metrics.last_update_timestamp = now;
+    });
+    if (!stored && !store_full_reported_) {
+        std::cerr << "Metrics store full (" << MAX_SYMBOLS << " symbols) or symbol too long, dropping "
+                  << symbol << std::endl;
+        store_full_reported_ = true;
     }
+    server_.notify_streams();
+}
+
+void SimpleOrderBookAPI::update_top_of_book(const std::string& symbol, std::pair<double, uint32_t> best_bid,
+                                            std::pair<double, uint32_t> best_ask) {
+    uint64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
     
-    symbol_metrics_[symbol] = metrics;
+    bool stored = symbol_metrics_.update(symbol, true, [&](MetricsSnapshot& metrics) {
+        set_top_of_book(best_bid, best_ask, metrics);
+        if (!metrics.depth_from_feed) {
+            // No depth updates for this symbol: the top of book is all the depth we have
+            metrics.bid_depth_count = 0;
+            metrics.ask_depth_count = 0;
+            if (best_bid.first > 0) metrics.bid_depth[metrics.bid_depth_count++] = DepthLevel(best_bid.first, best_bid.second);
+            if (best_ask.first > 0) metrics.ask_depth[metrics.ask_depth_count++] = DepthLevel(best_ask.first, best_ask.second);
+        }
+        metrics.last_update_timestamp = now;
+    });
+    if (!stored && !store_full_reported_) {
+        std::cerr << "Metrics store full (" << MAX_SYMBOLS << " symbols) or symbol too long, dropping "
+                  << symbol << std::endl;
+        store_full_reported_ = true;
+    }
+    server_.notify_streams();
+}
+
+void SimpleOrderBookAPI::apply_depth_update(const std::string& symbol, const DepthUpdateMessage& update) {
+    size_t depth = update.depth < MAX_DEPTH_LEVELS ? update.depth : MAX_DEPTH_LEVELS;
+    uint64_t errors = 0;
+    
+    symbol_metrics_.update(symbol, true, [&](MetricsSnapshot& metrics) {
+        metrics.depth_from_feed = true;
+        if (update.reset) {
+            metrics.bid_depth_count = 0;
+            metrics.ask_depth_count = 0;
+            metrics.depth_stale = false;
+        }
+        if (metrics.depth_stale) {
+            return;  // Deltas only make sense on top of the levels they were computed from
+        }
+        for (size_t i = 0; i < update.delta_count; ++i) {
+            const DepthDelta& delta = update.deltas[i];
+            bool applied = delta.side == OrderSide::BID
+                ? apply_depth_delta(metrics.bid_depth, metrics.bid_depth_count, depth, delta)
+                : apply_depth_delta(metrics.ask_depth, metrics.ask_depth_count, depth, delta);
+            if (!applied) {
+                metrics.depth_stale = true;
+                ++errors;
+                break;
+            }
+        }
+    });
+    if (errors > 0) {
+        depth_update_errors_.fetch_add(errors, std::memory_order_relaxed);
+    }
+    server_.notify_streams();
 }
 
 void SimpleOrderBookAPI::update_trade(const std::string& symbol, double price, uint32_t size, 
                                      OrderSide aggressor_side, uint64_t timestamp) {
-    std::lock_guard<std::mutex> lock(data_mutex_);
-    
-    if (symbol_metrics_.find(symbol) != symbol_metrics_.end()) {
-        symbol_metrics_[symbol].last_trade = TradeInfo(price, size, aggressor_side, timestamp);
-    }
+    symbol_metrics_.update(symbol, false, [&](MetricsSnapshot& metrics) {
+        metrics.last_trade = TradeInfo(price, size, aggressor_side, timestamp);
+    });
+    server_.notify_streams();
+}
+
+void SimpleOrderBookAPI::update_analytics(const std::string& symbol, const AnalyticsMessage& analytics) {
+    // Sent right after the symbol's top of book, so it never creates a symbol on its own
+    symbol_metrics_.update(symbol, false, [&](MetricsSnapshot& metrics) {
+        metrics.vwap = analytics.vwap;
+        metrics.microprice = analytics.microprice;
+        metrics.depth_imbalance = analytics.depth_imbalance;
+        metrics.order_flow_imbalance = analytics.order_flow_imbalance;
+        metrics.window_volume = analytics.window_volume;
+        metrics.window_trades = analytics.window_trades;
+        metrics.analytics_window_ms = analytics.window_ms;
+    });
+    server_.notify_streams();
 }
 
 void SimpleOrderBookAPI::increment_event_count(const std::string& symbol) {
-    std::lock_guard<std::mutex> lock(data_mutex_);
+    symbol_metrics_.update(symbol, false, [](MetricsSnapshot& metrics) {
+        metrics.total_events_processed++;
+    });
+    server_.notify_streams();
+}
+
+void SimpleOrderBookAPI::update_processor_stats(const std::string& stats_json) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
     
-    if (symbol_metrics_.find(symbol) != symbol_metrics_.end()) {
-        symbol_metrics_[symbol].total_events_processed++;
-    }
+    processor_stats_json_ = stats_json;
+    processor_stats_timestamp_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
 MarketMetrics SimpleOrderBookAPI::get_metrics(const std::string& symbol) const {
-    std::lock_guard<std::mutex> lock(data_mutex_);
-    
-    auto it = symbol_metrics_.find(symbol);
-    if (it != symbol_metrics_.end()) {
-        return it->second;
+    MetricsSnapshot snapshot;
+    if (symbol_metrics_.load(symbol, snapshot)) {
+        return to_market_metrics(snapshot);
     }
     
     return MarketMetrics(); // Return empty metrics if symbol not found
 }
 
 std::vector<std::string> SimpleOrderBookAPI::get_available_symbols() const {
-    std::lock_guard<std::mutex> lock(data_mutex_);
-    
-    std::vector<std::string> symbols;
-    for (const auto& pair : symbol_metrics_) {
-        symbols.push_back(pair.first);
-    }
-    
+    std::vector<std::string> symbols = symbol_metrics_.symbols();
+    std::sort(symbols.begin(), symbols.end());
     return symbols;
 }
 
-MarketMetrics SimpleOrderBookAPI::calculate_metrics(const OrderBook& book) const {
-    MarketMetrics metrics;
-    
-    // Get best bid/ask
-    auto best_bid = book.get_best_bid();
-    auto best_ask = book.get_best_ask();
-    
+void SimpleOrderBookAPI::calculate_metrics(const OrderBook& book, MetricsSnapshot& metrics) const {
+    set_top_of_book(book.get_best_bid(), book.get_best_ask(), metrics);
+    
+    // Depth snapshot (top N levels) straight from the book's depth view, or just
+    // the best bid/ask when the book keeps none
+    metrics.bid_depth_count = 0;
+    metrics.ask_depth_count = 0;
+    const DepthView& bids = book.get_depth(OrderSide::BID);
+    const DepthView& asks = book.get_depth(OrderSide::ASK);
+    if (bids.depth() > 0) {
+        for (size_t i = 0; i < bids.size() && i < MAX_DEPTH_LEVELS; ++i) {
+            metrics.bid_depth[metrics.bid_depth_count++] = DepthLevel(bids[i].price, bids[i].size);
+        }
+        for (size_t i = 0; i < asks.size() && i < MAX_DEPTH_LEVELS; ++i) {
+            metrics.ask_depth[metrics.ask_depth_count++] = DepthLevel(asks[i].price, asks[i].size);
+        }
+        return;
+    }
+    if (metrics.best_bid_price > 0) {
+        metrics.bid_depth[metrics.bid_depth_count++] = DepthLevel(metrics.best_bid_price, metrics.best_bid_size);
+    }
+    if (metrics.best_ask_price > 0) {
+        metrics.ask_depth[metrics.ask_depth_count++] = DepthLevel(metrics.best_ask_price, metrics.best_ask_size);
+    }
+}
+
+void SimpleOrderBookAPI::set_top_of_book(std::pair<double, uint32_t> best_bid, std::pair<double, uint32_t> best_ask,
+                                         MetricsSnapshot& metrics) {
     metrics.best_bid_price = best_bid.first;
     metrics.best_bid_size = best_bid.second;
     metrics.best_ask_price = best_ask.first;
     metrics.best_ask_size = best_ask.second;
     
     // Calculate spread and midprice
+    metrics.spread = 0.0;
+    metrics.midprice = 0.0;
     if (metrics.best_bid_price > 0 && metrics.best_ask_price > 0) {
         metrics.spread = metrics.best_ask_price - metrics.best_bid_price;
         metrics.midprice = (metrics.best_bid_price + metrics.best_ask_price) / 2.0;
     }
     
     // Calculate quote imbalance
+    metrics.quote_imbalance = 0.0;
     uint32_t total_size = metrics.best_bid_size + metrics.best_ask_size;
     if (total_size > 0) {
         metrics.quote_imbalance = (static_cast<double>(metrics.best_bid_size) - 
                                   static_cast<double>(metrics.best_ask_size)) / total_size;
     }
-    
-    // Get depth snapshot (top N levels)
-    // Note: This is a simplified implementation. In a real system, you'd want
-    // to maintain depth levels in the OrderBook class itself.
-    metrics.bid_depth.clear();
-    metrics.ask_depth.clear();
-    
-    // For now, just add the best bid/ask as depth levels
-    if (metrics.best_bid_price > 0) {
-        metrics.bid_depth.push_back(DepthLevel(metrics.best_bid_price, metrics.best_bid_size));
-    }
-    if (metrics.best_ask_price > 0) {
-        metrics.ask_depth.push_back(DepthLevel(metrics.best_ask_price, metrics.best_ask_size));
-    }
-    
+}
+
+MarketMetrics SimpleOrderBookAPI::to_market_metrics(const MetricsSnapshot& snapshot) {
+    MarketMetrics metrics;
+    metrics.best_bid_price = snapshot.best_bid_price;
+    metrics.best_bid_size = snapshot.best_bid_size;
+    metrics.best_ask_price = snapshot.best_ask_price;
+    metrics.best_ask_size = snapshot.best_ask_size;
+    metrics.spread = snapshot.spread;
+    metrics.midprice = snapshot.midprice;
+    metrics.quote_imbalance = snapshot.quote_imbalance;
+    metrics.vwap = snapshot.vwap;
+    metrics.microprice = snapshot.microprice;
+    metrics.depth_imbalance = snapshot.depth_imbalance;
+    metrics.order_flow_imbalance = snapshot.order_flow_imbalance;
+    metrics.window_volume = snapshot.window_volume;
+    metrics.window_trades = snapshot.window_trades;
+    metrics.analytics_window_ms = snapshot.analytics_window_ms;
+    metrics.bid_depth.assign(snapshot.bid_depth, snapshot.bid_depth + snapshot.bid_depth_count);
+    metrics.ask_depth.assign(snapshot.ask_depth, snapshot.ask_depth + snapshot.ask_depth_count);
+    metrics.last_trade = snapshot.last_trade;
+    metrics.last_update_timestamp = snapshot.last_update_timestamp;
+    metrics.total_events_processed = snapshot.total_events_processed;
     return metrics;
 }
 
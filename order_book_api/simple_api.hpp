@@ -10,12 +10,14 @@
 #include <functional>
 #include <chrono>
 #include <sstream>
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
-#include <unistd.h>
 #include <cstring>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 #include "orderbook.hpp"
+#include "multicast_protocol.hpp"
+#include "http_server.hpp"
+#include "symbol_store.hpp"
 
 // Trade information for aggressor side tracking
 struct TradeInfo {
@@ -49,6 +51,15 @@ struct MarketMetrics {
     double midprice = 0.0;
     double quote_imbalance = 0.0;
     
+    // Rolling analytics, computed by the processor as events arrive
+    double vwap = 0.0;
+    double microprice = 0.0;
+    double depth_imbalance = 0.0;
+    int64_t order_flow_imbalance = 0;
+    uint64_t window_volume = 0;
+    uint32_t window_trades = 0;
+    uint32_t analytics_window_ms = 0;   // 0 = no analytics received
+    
     // Depth snapshot (top N levels)
     std::vector<DepthLevel> bid_depth;
     std::vector<DepthLevel> ask_depth;
@@ -63,70 +74,196 @@ struct MarketMetrics {
     MarketMetrics() = default;
 };
 
+// Most depth levels kept per side (the processor's depth view limit)
+constexpr size_t MAX_DEPTH_LEVELS = MAX_BOOK_DEPTH;
+
+// Fixed-size form of MarketMetrics kept in the lock-free store (no heap members)
+struct MetricsSnapshot {
+    double best_bid_price = 0.0;
+    uint32_t best_bid_size = 0;
+    double best_ask_price = 0.0;
+    uint32_t best_ask_size = 0;
+    double spread = 0.0;
+    double midprice = 0.0;
+    double quote_imbalance = 0.0;
+    
+    double vwap = 0.0;
+    double microprice = 0.0;
+    double depth_imbalance = 0.0;
+    int64_t order_flow_imbalance = 0;
+    uint64_t window_volume = 0;
+    uint32_t window_trades = 0;
+    uint32_t analytics_window_ms = 0;
+    
+    uint32_t bid_depth_count = 0;
+    uint32_t ask_depth_count = 0;
+    DepthLevel bid_depth[MAX_DEPTH_LEVELS];
+    DepthLevel ask_depth[MAX_DEPTH_LEVELS];
+    bool depth_from_feed = false;       // Levels come from depth updates, not just the top of book
+    bool depth_stale = false;           // A delta did not apply; ignore deltas until the next refresh
+    
+    TradeInfo last_trade;
+    uint64_t last_update_timestamp = 0;
+    uint64_t total_events_processed = 0;
+};
+
 // Simple HTTP API Server
+//
+// Per-symbol metrics live in a SymbolStore: the update_* calls (one thread,
+// the multicast ingest thread) never wait on HTTP readers, and readers take
+// consistent snapshots without a lock.
+//
+// Symbol endpoints are served from pre-rendered responses, one cache per HTTP
+// event loop: a response is rendered again only once the symbol's store
+// version has moved, and carries the version as its ETag, so an unchanged
+// poll with If-None-Match gets a bodyless 304.
+//
+// /api/stream pushes the same metrics as Server-Sent Events instead: every
+// update wakes the event loops, and each stream is sent the symbols whose
+// version moved since it was last written to. A client still reading earlier
+// events is skipped until it catches up and then gets only the latest state,
+// so slow clients fall behind by at most one update per symbol, never a backlog.
 class SimpleOrderBookAPI {
 public:
+    static constexpr size_t MAX_SYMBOLS = 1024;
+    static constexpr int STREAM_KEEPALIVE_SECONDS = 15;  // Comment line on a stream that had nothing to send
+    
     SimpleOrderBookAPI(int port = 8080);
     ~SimpleOrderBookAPI();
     
     // Start/stop the API server
     bool start();
     void stop();
-    bool is_running() const { return running_.load(); }
+    bool is_running() const { return server_.is_running(); }
     
-    // Update order book data (called by the main strategy)
+    // Update order book data (called by the main strategy, from one thread)
     void update_order_book(const std::string& symbol, const OrderBook& book);
+    void update_top_of_book(const std::string& symbol, std::pair<double, uint32_t> best_bid,
+                            std::pair<double, uint32_t> best_ask);
+    void apply_depth_update(const std::string& symbol, const DepthUpdateMessage& update);
     void update_trade(const std::string& symbol, double price, uint32_t size, 
                      OrderSide aggressor_side, uint64_t timestamp);
+    void update_analytics(const std::string& symbol, const AnalyticsMessage& analytics);
     void increment_event_count(const std::string& symbol);
     
+    // Latest processor stats snapshot (JSON object from the processor heartbeat)
+    void update_processor_stats(const std::string& stats_json);
+    
     // Get current metrics for a symbol
     MarketMetrics get_metrics(const std::string& symbol) const;
     std::vector<std::string> get_available_symbols() const;
     
     // Configuration
-    void set_depth_levels(int levels) { depth_levels_ = levels; }
-    int get_depth_levels() const { return depth_levels_; }
+    void set_http_threads(size_t threads) { server_.set_threads(threads); }  // Event loops (before start)
+    void set_depth_levels(int levels) { depth_levels_ = levels < static_cast<int>(MAX_DEPTH_LEVELS) ? levels : MAX_DEPTH_LEVELS; }
+    int get_depth_levels() const { return depth_levels_; }  // Levels served per side by /api/depth/
+    
+    // Depth deltas dropped because the symbol's levels were out of step
+    uint64_t get_depth_update_errors() const { return depth_update_errors_.load(std::memory_order_relaxed); }
+    
+    // Response cache: renders done, and requests answered with 304 Not Modified
+    uint64_t get_responses_rendered() const { return responses_rendered_.load(std::memory_order_relaxed); }
+    uint64_t get_not_modified() const { return not_modified_.load(std::memory_order_relaxed); }
+    
+    // Streaming clients connected, and metrics events pushed to them
+    size_t get_open_streams() const { return server_.get_open_streams(); }
+    uint64_t get_stream_events_sent() const { return stream_events_sent_.load(std::memory_order_relaxed); }
+    
+    // /metrics response body (public for the benchmarks)
+    std::string metrics_to_json(const MarketMetrics& metrics);
     
 private:
-    // HTTP server management
-    void server_thread_function();
-    void handle_client(int client_socket);
-    
-    // HTTP request parsing
-    std::string parse_uri(const std::string& request);
-    std::string parse_method(const std::string& request);
-    
-    // API endpoint handlers
-    std::string handle_get_symbols();
-    std::string handle_get_metrics(const std::string& symbol);
-    std::string handle_get_depth(const std::string& symbol);
-    std::string handle_get_trades(const std::string& symbol);
+    // Pre-rendered response for one URI, reused until the data behind it changes
+    struct CachedResponse {
+        uint64_t version = 0;           // Version the response was rendered from
+        std::string etag;
+        std::string response;           // Complete 200 response
+        std::string not_modified;       // Complete 304 response
+    };
+    
+    // One /api/stream client: its symbols and the version of each it was last sent
+    struct StreamSubscription {
+        bool all_symbols = false;       // No symbols given: every symbol, including ones added later
+        std::vector<std::string> symbols;
+        std::vector<uint64_t> sent_versions;
+        std::chrono::steady_clock::time_point last_write;
+    };
+    
+    // One symbol's metrics as a rendered event, shared by the streams of a loop
+    struct CachedEvent {
+        uint64_t version = 0;
+        std::string text;
+    };
+    
+    // One per event loop; only ever touched by that loop's thread, so no locking
+    struct ResponseCache {
+        std::unordered_map<std::string, CachedResponse> entries;  // By request URI
+        std::string key;                                          // Reused lookup key
+        std::unordered_map<uint64_t, StreamSubscription> streams; // Open streams, by stream ID
+        std::unordered_map<std::string, CachedEvent> events;      // By symbol
+    };
+    
+    enum class SymbolEndpoint { METRICS, DEPTH, TRADES };
+    
+    // Route one request to its endpoint handler and append the response to out
+    // (runs on an event loop thread)
+    void handle_request(const HttpRequest& request, std::string& out);
+    
+    // Cached endpoints: re-render when the version moved, then append the 200 or 304
+    void serve_symbol(const HttpRequest& request, SymbolEndpoint endpoint, const std::string& symbol,
+                      std::string& out);
+    void serve_symbols(const HttpRequest& request, std::string& out);
+    CachedResponse& cache_entry(const HttpRequest& request);
+    void render(CachedResponse& entry, uint64_t version, const std::string& body);
+    void append_cached(const HttpRequest& request, const CachedResponse& entry, std::string& out);
+    
+    // Streams: subscribe (/api/stream?symbols=A,B), append what changed, forget a closed one
+    void open_stream(const HttpRequest& request, std::string& out);
+    bool pump_stream(size_t loop, uint64_t stream, std::string& out);
+    void close_stream(size_t loop, uint64_t stream);
+    const CachedEvent& stream_event(ResponseCache& cache, const std::string& symbol, uint64_t version);
+    
+    // Response bodies
+    std::string symbols_to_json() const;
+    std::string symbol_body(SymbolEndpoint endpoint, const std::string& symbol, const MarketMetrics& metrics);
     std::string handle_get_health();
+    std::string handle_get_stats();
     
     // JSON response helpers
-    std::string metrics_to_json(const MarketMetrics& metrics);
     std::string depth_to_json(const std::vector<DepthLevel>& depth, const std::string& side);
     std::string trade_to_json(const TradeInfo& trade);
     std::string error_response(const std::string& message, int code = 400);
     std::string success_response(const std::string& data);
     
     // Calculate metrics from order book
-    MarketMetrics calculate_metrics(const OrderBook& book) const;
+    void calculate_metrics(const OrderBook& book, MetricsSnapshot& metrics) const;
+    static void set_top_of_book(std::pair<double, uint32_t> best_bid, std::pair<double, uint32_t> best_ask,
+                                MetricsSnapshot& metrics);
+    static MarketMetrics to_market_metrics(const MetricsSnapshot& snapshot);
     
-    // HTTP response helpers
-    std::string create_http_response(const std::string& body, int status_code = 200);
+    // HTTP response helpers (an ETag also marks the response as revalidate-before-use)
+    std::string create_http_response(const std::string& body, int status_code = 200,
+                                     const std::string& etag = std::string());
     
     // Member variables
     int port_;
-    int server_socket_;
-    std::atomic<bool> running_;
-    std::unique_ptr<std::thread> server_thread_;
+    HttpServer server_;
     
     // Data storage
-    mutable std::mutex data_mutex_;
-    std::map<std::string, MarketMetrics> symbol_metrics_;
-    int depth_levels_ = 5;  // Default to top 5 levels
+    SymbolStore<MetricsSnapshot> symbol_metrics_;
+    bool store_full_reported_ = false;          // Writer only
+    std::atomic<uint64_t> depth_update_errors_{0};
+    
+    // Response caches, indexed by HttpRequest::loop (sized at start)
+    std::vector<std::unique_ptr<ResponseCache>> response_caches_;
+    std::string etag_prefix_;                   // Tells this run's versions from a previous run's
+    std::atomic<uint64_t> responses_rendered_{0};
+    std::atomic<uint64_t> not_modified_{0};
+    std::atomic<uint64_t> stream_events_sent_{0};
+    mutable std::mutex stats_mutex_;            // Guards the processor stats below
+    std::string processor_stats_json_;          // Empty until the first heartbeat with stats
+    uint64_t processor_stats_timestamp_ = 0;
+    int depth_levels_ = 10;  // Default to top 10 levels
 };
 
 #endif // SIMPLE_API_HPP
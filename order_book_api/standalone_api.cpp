@@ -9,9 +9,12 @@
 #include <map>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
+#include <cstdlib>
 
 #include "simple_api.hpp"
 #include "multicast_subscriber.hpp"
+#include "json_scanner.hpp"
 
 // Global flag for graceful shutdown
 std::atomic<bool> shutdown_flag{false};
@@ -26,124 +29,75 @@ void signal_handler(int /* signal */) {
     shutdown_flag.store(true);
 }
 
-// Parse JSON data and update API
-void update_api_from_json(const std::string& symbol, const std::string& json_data) {
-    if (!api) return;
-    
-    try {
-        // Simple JSON parsing for order book data
-        // In production, use a proper JSON library like nlohmann/json
-        
-        // Extract best bid/ask from JSON
-        double best_bid_price = 0.0, best_ask_price = 0.0;
-        uint32_t best_bid_size = 0, best_ask_size = 0;
-        
-        // Find best_bid_price
-        size_t pos = json_data.find("\"best_bid_price\":");
-        if (pos != std::string::npos) {
-            size_t start = json_data.find_first_of("0123456789.", pos);
-            size_t end = json_data.find_first_not_of("0123456789.", start);
-            best_bid_price = std::stod(json_data.substr(start, end - start));
-        }
-        
-        // Find best_bid_size
-        pos = json_data.find("\"best_bid_size\":");
-        if (pos != std::string::npos) {
-            size_t start = json_data.find_first_of("0123456789", pos);
-            size_t end = json_data.find_first_not_of("0123456789", start);
-            best_bid_size = std::stoul(json_data.substr(start, end - start));
-        }
-        
-        // Find best_ask_price
-        pos = json_data.find("\"best_ask_price\":");
-        if (pos != std::string::npos) {
-            size_t start = json_data.find_first_of("0123456789.", pos);
-            size_t end = json_data.find_first_not_of("0123456789.", start);
-            best_ask_price = std::stod(json_data.substr(start, end - start));
-        }
-        
-        // Find best_ask_size
-        pos = json_data.find("\"best_ask_size\":");
-        if (pos != std::string::npos) {
-            size_t start = json_data.find_first_of("0123456789", pos);
-            size_t end = json_data.find_first_not_of("0123456789", start);
-            best_ask_size = std::stoul(json_data.substr(start, end - start));
-        }
-        
-        // Create a simple order book with just the best bid/ask
-        OrderBook book;
-        if (best_bid_price > 0 && best_bid_size > 0) {
-            book.add_order(OrderSide::BID, best_bid_price, best_bid_size);
-        }
-        if (best_ask_price > 0 && best_ask_size > 0) {
-            book.add_order(OrderSide::ASK, best_ask_price, best_ask_size);
-        }
-        
-        // Update API
-        api->update_order_book(symbol, book);
-        api->increment_event_count(symbol);
-        
-    } catch (const std::exception& e) {
-        std::cerr << "Error parsing order book JSON: " << e.what() << std::endl;
+// Update API with a symbol's top of book
+void apply_top_of_book(const std::string& symbol, double best_bid_price, uint32_t best_bid_size,
+                       double best_ask_price, uint32_t best_ask_size) {
+    // Empty sides arrive as (0, 0)
+    if (best_bid_price <= 0 || best_bid_size == 0) {
+        best_bid_price = 0.0;
+        best_bid_size = 0;
+    }
+    if (best_ask_price <= 0 || best_ask_size == 0) {
+        best_ask_price = 0.0;
+        best_ask_size = 0;
     }
+    
+    api->update_top_of_book(symbol, {best_bid_price, best_bid_size}, {best_ask_price, best_ask_size});
+    api->increment_event_count(symbol);
 }
 
-// Parse trade JSON and update API
-void update_trade_from_json(const std::string& symbol, const std::string& json_data) {
-    if (!api) return;
+// Update API with a trade
+void apply_trade(const std::string& symbol, double price, uint32_t size, OrderSide aggressor_side) {
+    uint64_t timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
     
-    try {
-        // Extract trade data from JSON
-        double price = 0.0;
-        uint32_t size = 0;
-        OrderSide aggressor_side = OrderSide::UNKNOWN;
-        
-        // Find price
-        size_t pos = json_data.find("\"price\":");
-        if (pos != std::string::npos) {
-            size_t start = json_data.find_first_of("0123456789.", pos);
-            size_t end = json_data.find_first_not_of("0123456789.", start);
-            price = std::stod(json_data.substr(start, end - start));
-        }
-        
-        // Find size
-        pos = json_data.find("\"size\":");
-        if (pos != std::string::npos) {
-            size_t start = json_data.find_first_of("0123456789", pos);
-            size_t end = json_data.find_first_not_of("0123456789", start);
-            size = std::stoul(json_data.substr(start, end - start));
-        }
-        
-        // Find aggressor_side
-        pos = json_data.find("\"aggressor_side\":");
-        if (pos != std::string::npos) {
-            size_t start = json_data.find("\"", pos + 16) + 1;
-            size_t end = json_data.find("\"", start);
-            std::string side_str = json_data.substr(start, end - start);
-            aggressor_side = (side_str == "BID") ? OrderSide::BID : OrderSide::ASK;
-        }
-        
-        // Update API
-        uint64_t timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
-            std::chrono::steady_clock::now().time_since_epoch()).count();
-        
-        api->update_trade(symbol, price, size, aggressor_side, timestamp);
-        
-    } catch (const std::exception& e) {
-        std::cerr << "Error parsing trade JSON: " << e.what() << std::endl;
-    }
+    api->update_trade(symbol, price, size, aggressor_side, timestamp);
+}
+
+// Top-of-book message (binary or JSON, decoded by the subscriber)
+void update_api_from_message(const std::string& symbol, const TopOfBookMessage& message) {
+    if (!api) return;
+    apply_top_of_book(symbol, message.best_bid.first, message.best_bid.second,
+                      message.best_ask.first, message.best_ask.second);
+}
+
+// Trade message (binary or JSON)
+void update_trade_from_message(const std::string& symbol, const TradeMessage& message) {
+    if (!api) return;
+    apply_trade(symbol, message.price, message.size, message.aggressor_side);
+}
+
+// Depth level deltas (binary or JSON, decoded by the subscriber)
+void update_depth_from_message(const std::string& symbol, const DepthUpdateMessage& message) {
+    if (!api) return;
+    api->apply_depth_update(symbol, message);
+}
+
+// Rolling analytics (binary or JSON), sent by the processor next to the top of book
+void update_analytics_from_message(const std::string& symbol, const AnalyticsMessage& message) {
+    if (!api) return;
+    api->update_analytics(symbol, message);
 }
 
 // Handle heartbeat messages
-void handle_heartbeat(const std::string& /* data */) {
-    // Optional: Log heartbeat or update statistics
+void handle_heartbeat(const std::string& data) {
+    // Processor latency/queue stats ride along as a nested "stats" object
+    JsonObjectScanner scanner(data);
+    std::string_view key, value;
+    while (api && scanner.next(key, value)) {
+        if (key == "stats") {
+            api->update_processor_stats(std::string(value));
+            break;
+        }
+    }
+    
     static int heartbeat_count = 0;
     if (++heartbeat_count % 100 == 0) {
         std::cout << "Received " << heartbeat_count << " heartbeats" << std::endl;
     }
 }
 
-int main(int /* argc */, char* /* argv */[]) {
+int main(int argc, char* argv[]) {
     // Set up signal handler
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
@@ -152,15 +106,31 @@ int main(int /* argc */, char* /* argv */[]) {
     const int api_port = 8080;
     const std::string multicast_group = "224.0.0.1";
     const int multicast_port = 12346;
+    size_t http_threads = 2;
+    int depth_levels = 10;
+    
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--http-threads" && i + 1 < argc) {
+            http_threads = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--depth-levels" && i + 1 < argc) {
+            depth_levels = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--http-threads N] [--depth-levels N]" << std::endl;
+            return 1;
+        }
+    }
     
     std::cout << "=== Standalone Order Book API Server ===" << std::endl;
-    std::cout << "API Port: " << api_port << std::endl;
+    std::cout << "API Port: " << api_port << " (" << http_threads << " HTTP event loops)" << std::endl;
     std::cout << "Multicast Group: " << multicast_group << ":" << multicast_port << std::endl;
     std::cout << std::endl;
     
     try {
         // Initialize API
         api = std::make_unique<SimpleOrderBookAPI>(api_port);
+        api->set_http_threads(http_threads);
+        api->set_depth_levels(depth_levels);
         if (!api->start()) {
             std::cerr << "Failed to start API server" << std::endl;
             return 1;
@@ -174,9 +144,11 @@ int main(int /* argc */, char* /* argv */[]) {
         }
         
         // Set up callbacks
-        subscriber->set_order_book_callback(update_api_from_json);
-        subscriber->set_trade_callback(update_trade_from_json);
         subscriber->set_heartbeat_callback(handle_heartbeat);
+        subscriber->set_top_of_book_callback(update_api_from_message);
+        subscriber->set_trade_message_callback(update_trade_from_message);
+        subscriber->set_depth_callback(update_depth_from_message);
+        subscriber->set_analytics_callback(update_analytics_from_message);
         
         // Start listening for multicast messages
         if (!subscriber->start_listening()) {
@@ -198,7 +170,8 @@ int main(int /* argc */, char* /* argv */[]) {
             if (std::chrono::steady_clock::now() - last_stats_time > std::chrono::seconds(10)) {
                 std::cout << "Stats - Messages: " << subscriber->get_messages_received() 
                          << ", Bytes: " << subscriber->get_bytes_received()
-                         << ", Errors: " << subscriber->get_parse_errors() << std::endl;
+                         << ", Errors: " << subscriber->get_parse_errors()
+                         << ", Lost packets: " << subscriber->get_packets_lost() << std::endl;
                 last_stats_time = std::chrono::steady_clock::now();
             }
         }
@@ -0,0 +1,199 @@
+#ifndef SYMBOL_STORE_HPP
+#define SYMBOL_STORE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Single-writer sequence lock around a trivially copyable value.
+//
+// The writer bumps the sequence to odd, stores the value, then bumps it to
+// even; a reader copies the value and retries if the sequence was odd or moved
+// meanwhile. Neither side ever blocks the writer. The value is kept as relaxed
+// atomic words, so concurrent copies are well-defined (and race-detector clean).
+template<typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock needs a trivially copyable type");
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+public:
+    SeqLock() : sequence_(0) {
+        store(T{});
+    }
+
+    // Writer only
+    void store(const T& value) {
+        uint64_t words[WORDS] = {};
+        std::memcpy(words, &value, sizeof(T));
+
+        uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; ++i) {
+            words_[i].store(words[i], std::memory_order_relaxed);
+        }
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    // Any thread: a consistent copy of the last stored value, and optionally
+    // the version it was stored as (see version())
+    T load(uint64_t* version = nullptr) const {
+        uint64_t words[WORDS];
+        while (true) {
+            uint64_t before = sequence_.load(std::memory_order_acquire);
+            if ((before & 1) == 0) {
+                for (size_t i = 0; i < WORDS; ++i) {
+                    words[i] = words_[i].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (sequence_.load(std::memory_order_relaxed) == before) {
+                    if (version) *version = before;
+                    break;
+                }
+            }
+            // The writer is mid-store; let it run (it may share this core)
+            std::this_thread::yield();
+        }
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+    // Any thread: changes with every store (odd while one is in progress), without copying the value
+    uint64_t version() const {
+        return sequence_.load(std::memory_order_acquire);
+    }
+
+    // Disable copy constructor and assignment
+    SeqLock(const SeqLock&) = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+
+private:
+    alignas(64) std::atomic<uint64_t> sequence_;
+    std::atomic<uint64_t> words_[WORDS];
+};
+
+// Fixed-capacity table of per-symbol values: one writer thread updates them,
+// any number of reader threads take lock-free snapshots.
+//
+// Open addressing with linear probing over a power-of-two table at most half
+// full. Symbols are never removed, so a slot's name is immutable once the slot
+// is published and a probe can stop at the first unused slot.
+template<typename T>
+class SymbolStore {
+public:
+    static constexpr size_t MAX_SYMBOL_LENGTH = 15;
+
+    explicit SymbolStore(size_t capacity) : capacity_(capacity), count_(0) {
+        size_t table_size = 1;
+        while (table_size < capacity * 2) table_size <<= 1;
+        mask_ = table_size - 1;
+        slots_.reset(new Slot[table_size]);
+        order_.reset(new std::atomic<uint32_t>[capacity]);
+    }
+
+    // Writer only: apply fn to the symbol's value and publish the result.
+    // A missing symbol is added when create is set; returns false if it is
+    // missing (and not created), too long, or the store is full.
+    template<typename Fn>
+    bool update(std::string_view symbol, bool create, Fn&& fn) {
+        Slot* slot = probe(symbol);
+        if (!slot) return false;
+
+        bool is_new = !slot->used.load(std::memory_order_relaxed);
+        if (is_new) {
+            size_t count = count_.load(std::memory_order_relaxed);
+            if (!create || count == capacity_) return false;
+            std::memcpy(slot->name, symbol.data(), symbol.size());
+            slot->length = static_cast<uint8_t>(symbol.size());
+            slot->staged = T{};
+        }
+
+        fn(slot->staged);
+        slot->value.store(slot->staged);
+
+        if (is_new) {
+            // Publish the name (and first value) before readers can find the slot
+            slot->used.store(true, std::memory_order_release);
+            size_t count = count_.load(std::memory_order_relaxed);
+            order_[count].store(static_cast<uint32_t>(slot - slots_.get()), std::memory_order_relaxed);
+            count_.store(count + 1, std::memory_order_release);
+        }
+        return true;
+    }
+
+    // Any thread: copy of the symbol's latest value (and its version), false if it is unknown
+    bool load(std::string_view symbol, T& out, uint64_t* version = nullptr) const {
+        const Slot* slot = const_cast<SymbolStore*>(this)->probe(symbol);
+        if (!slot || !slot->used.load(std::memory_order_acquire)) return false;
+        out = slot->value.load(version);
+        return true;
+    }
+
+    // Any thread: the symbol's current value version (0 if it is unknown); a
+    // cheap check for whether anything derived from an earlier load is stale
+    uint64_t version(std::string_view symbol) const {
+        const Slot* slot = const_cast<SymbolStore*>(this)->probe(symbol);
+        if (!slot || !slot->used.load(std::memory_order_acquire)) return 0;
+        return slot->value.version();
+    }
+
+    // Any thread: every symbol, in the order they were added
+    std::vector<std::string> symbols() const {
+        size_t count = count_.load(std::memory_order_acquire);
+        std::vector<std::string> names;
+        names.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            const Slot& slot = slots_[order_[i].load(std::memory_order_relaxed)];
+            names.emplace_back(slot.name, slot.length);
+        }
+        return names;
+    }
+
+    size_t size() const { return count_.load(std::memory_order_acquire); }
+    size_t capacity() const { return capacity_; }
+
+    // Disable copy constructor and assignment
+    SymbolStore(const SymbolStore&) = delete;
+    SymbolStore& operator=(const SymbolStore&) = delete;
+
+private:
+    struct Slot {
+        std::atomic<bool> used{false};
+        uint8_t length = 0;
+        char name[MAX_SYMBOL_LENGTH + 1] = {};
+        SeqLock<T> value;       // Readers' copy
+        T staged{};             // Writer's working copy
+    };
+
+    // The slot holding symbol, or the unused slot where it would go (nullptr if too long)
+    Slot* probe(std::string_view symbol) {
+        if (symbol.size() > MAX_SYMBOL_LENGTH) return nullptr;
+        uint64_t hash = 14695981039346656037ULL;  // FNV-1a
+        for (char c : symbol) {
+            hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ULL;
+        }
+        for (size_t i = hash & mask_;; i = (i + 1) & mask_) {
+            Slot& slot = slots_[i];
+            if (!slot.used.load(std::memory_order_acquire)) return &slot;
+            if (slot.length == symbol.size() && std::memcmp(slot.name, symbol.data(), symbol.size()) == 0) {
+                return &slot;
+            }
+        }
+    }
+
+    size_t capacity_;
+    size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    std::unique_ptr<std::atomic<uint32_t>[]> order_;    // Slot indices in insertion order
+    std::atomic<size_t> count_;
+};
+
+#endif // SYMBOL_STORE_HPP
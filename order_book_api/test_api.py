@@ -115,26 +115,38 @@ def test_trades(symbol):
         return False
 
 def monitor_metrics(symbol, duration=30):
-    """Monitor metrics for a symbol over time"""
+    """Monitor metrics for a symbol over time via the event stream"""
     print(f"\nMonitoring metrics for {symbol} for {duration} seconds...")
     print("Press Ctrl+C to stop monitoring")
     
     try:
         start_time = time.time()
-        while time.time() - start_time < duration:
-            response = requests.get(f"{API_BASE_URL}/api/metrics/{symbol}")
-            if response.status_code == 200:
-                data = response.json()
-                timestamp = time.strftime("%H:%M:%S")
-                print(f"[{timestamp}] {symbol}: "
-                      f"Bid={data.get('best_bid_price', 0):.2f} "
-                      f"Ask={data.get('best_ask_price', 0):.2f} "
-                      f"Spread={data.get('spread', 0):.4f} "
-                      f"Events={data.get('total_events_processed', 0)}")
-            else:
-                print(f"❌ Failed to get metrics: {response.status_code}")
-            
-            time.sleep(1)
+        response = requests.get(f"{API_BASE_URL}/api/stream", params={"symbols": symbol},
+                                stream=True, timeout=duration)
+        if response.status_code != 200:
+            print(f"❌ Failed to open stream: {response.status_code}")
+            return
+        
+        last_print = 0
+        for line in response.iter_lines(decode_unicode=True):
+            if time.time() - start_time >= duration:
+                break
+            if not line or not line.startswith("data: "):
+                continue  # Event name, keep-alive comment or separator
+            # Updates arrive conflated; print at most one per second
+            if time.time() - last_print < 1:
+                continue
+            last_print = time.time()
+            data = json.loads(line[len("data: "):]).get("metrics", {})
+            timestamp = time.strftime("%H:%M:%S")
+            print(f"[{timestamp}] {symbol}: "
+                  f"Bid={data.get('best_bid_price', 0):.2f} "
+                  f"Ask={data.get('best_ask_price', 0):.2f} "
+                  f"Spread={data.get('spread', 0):.4f} "
+                  f"Events={data.get('total_events_processed', 0)}")
+        response.close()
+    except requests.exceptions.RequestException as e:
+        print(f"❌ Stream ended: {e}")
     except KeyboardInterrupt:
         print("\nMonitoring stopped by user")
 
@@ -0,0 +1,246 @@
+#ifndef ASYNC_LOGGER_HPP
+#define ASYNC_LOGGER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "queue.hpp"
+#include "quote.hpp"
+#include "latency_stats.hpp"
+
+// How much the consumer reports
+enum class Verbosity {
+    QUIET,   // Nothing per event
+    STATS,   // Periodic performance statistics only
+    EVENTS   // Every event plus periodic statistics (default)
+};
+
+enum class LogRecordType : uint8_t {
+    ORDER_BOOK_EVENT,
+    PERFORMANCE_STATS
+};
+
+// Per-event fields of an ORDER_BOOK_EVENT record
+struct LogEventFields {
+    OrderBookEventType event_type = OrderBookEventType::UNKNOWN;
+    OrderSide side = OrderSide::UNKNOWN;
+    bool is_aggressor = false;
+    char symbol[16] = {};                // NUL-padded, truncated if longer
+    OrderId order_id = INVALID_ORDER_ID;
+    double price = 0.0;
+    uint32_t size = 0;
+    uint32_t trade_size = 0;
+    double trade_price = 0.0;
+
+    // Book state after the event
+    double best_bid_price = 0.0;
+    double best_ask_price = 0.0;
+    uint32_t best_bid_size = 0;
+    uint32_t best_ask_size = 0;
+    double spread = 0.0;
+
+    // Latency breakdown (ns)
+    uint64_t exchange_to_udp_ns = 0;
+    uint64_t udp_to_queue_ns = 0;
+    uint64_t queue_to_strategy_ns = 0;
+    uint64_t total_latency_ns = 0;
+
+    void set_symbol(const std::string& s) {
+        size_t len = s.size() < sizeof(symbol) - 1 ? s.size() : sizeof(symbol) - 1;
+        std::memcpy(symbol, s.data(), len);
+        symbol[len] = '\0';
+    }
+};
+
+// Fixed-size, trivially copyable log record. The hot thread fills one of these
+// in a ring slot; all text formatting happens on the logger thread.
+struct LogRecord {
+    LogRecordType type;
+    union {
+        LogEventFields event;            // ORDER_BOOK_EVENT
+        StatsSnapshot stats;             // PERFORMANCE_STATS
+    };
+
+    LogRecord() : type(LogRecordType::ORDER_BOOK_EVENT), event() {}
+};
+
+// Per-thread producer side of the logger: a lock-free SPSC ring of LogRecords.
+// begin_record() claims a slot to fill in place, end_record() publishes it. If
+// the ring is full the record is dropped and counted rather than blocking.
+class LogWriter {
+public:
+    explicit LogWriter(size_t capacity) : ring_(capacity), dropped_(0) {}
+
+    // Slot to fill, or nullptr when the ring is full
+    LogRecord* begin_record() {
+        LogRecord* record = ring_.claim();
+        if (!record) {
+            dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+        return record;
+    }
+
+    void end_record() {
+        ring_.commit();
+    }
+
+    uint64_t get_dropped() const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+private:
+    friend class AsyncLogger;
+
+    SPSCRingBuffer<LogRecord> ring_;
+    alignas(64) std::atomic<uint64_t> dropped_;  // Written by the owning thread only
+};
+
+// Background logger: one thread drains every LogWriter ring, formats the
+// records and flushes stdout once per pass, so hot threads never block on I/O.
+class AsyncLogger {
+public:
+    explicit AsyncLogger(size_t ring_capacity = 16384) : ring_capacity_(ring_capacity), running_(false) {}
+
+    ~AsyncLogger() {
+        stop();
+    }
+
+    // Register a writer (call before start()); each writing thread needs its own
+    LogWriter* add_writer() {
+        writers_.push_back(std::make_unique<LogWriter>(ring_capacity_));
+        return writers_.back().get();
+    }
+
+    void start() {
+        if (running_.exchange(true)) return;
+        thread_ = std::thread([this] { run(); });
+    }
+
+    // Drain whatever is left and stop the logger thread
+    void stop() {
+        if (!running_.exchange(false)) return;
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        uint64_t dropped = get_dropped();
+        if (dropped > 0) {
+            std::cout << "Logger dropped " << dropped << " records (log ring full)" << std::endl;
+        }
+    }
+
+    uint64_t get_dropped() const {
+        uint64_t dropped = 0;
+        for (const auto& writer : writers_) {
+            dropped += writer->get_dropped();
+        }
+        return dropped;
+    }
+
+    // Disable copy constructor and assignment
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+private:
+    void run() {
+        while (running_.load(std::memory_order_acquire)) {
+            if (drain() == 0) {
+                // Nothing to write - the logger is not latency critical
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        drain();  // Final records after stop()
+    }
+
+    size_t drain() {
+        size_t written = 0;
+        for (auto& writer : writers_) {
+            size_t ready = writer->ring_.readable();
+            for (size_t i = 0; i < ready; ++i) {
+                format(*writer->ring_.peek(i));
+            }
+            writer->ring_.release(ready);
+            written += ready;
+        }
+        if (written > 0) {
+            std::cout.flush();
+        }
+        return written;
+    }
+
+    static void format(const LogRecord& record) {
+        if (record.type == LogRecordType::PERFORMANCE_STATS) {
+            format_stats(record.stats);
+        } else {
+            format_event(record.event);
+        }
+    }
+
+    static void format_stats(const StatsSnapshot& s) {
+        static const char* const labels[LATENCY_LEG_COUNT] = {
+            "Exchange→UDP", "UDP→Queue", "Queue→Strategy", "Total Latency", "Publish"
+        };
+        std::ostream& out = std::cout;
+        out << "\n📊 PERFORMANCE STATISTICS (Last " << s.legs[static_cast<size_t>(LatencyLeg::END_TO_END)].count
+            << " events, " << (s.interval_ns / 1000000) << " ms):\n";
+        for (size_t leg = 0; leg < LATENCY_LEG_COUNT; ++leg) {
+            const LatencySummary& l = s.legs[leg];
+            out << labels[leg] << ": p50 " << l.p50 << " ns, p99 " << l.p99 << " ns, p99.9 "
+                << l.p999 << " ns, max " << l.max << " ns\n";
+        }
+        out << "Producer Stats - Enqueued: " << s.events_enqueued << ", Dropped: " << s.events_dropped
+            << ", Processed: " << s.events_processed << '\n'
+            << "Feed Sequence - Gaps: " << s.sequence_gaps << ", Lost: " << s.messages_lost
+            << ", Duplicates: " << s.duplicates_dropped << '\n'
+            << "Queue Depth: " << s.queue_depth << " (max " << s.queue_depth_max << ")"
+            << ", Log Dropped: " << s.log_records_dropped << '\n';
+        if (s.unknown_symbols_interval > 0) {
+            out << "Warning: " << s.unknown_symbols_interval << " events with empty, unknown or over-long symbol ("
+                << s.unknown_symbols << " total)\n";
+        }
+        out << "=====================\n";
+    }
+
+    static void format_event(const LogEventFields& r) {
+        std::ostream& out = std::cout;
+        out << "\n=== ORDER BOOK EVENT RECEIVED ===\n"
+            << "Symbol: " << r.symbol << '\n'
+            << "Event Type: " << static_cast<int>(r.event_type) << '\n'
+            << "Order ID: " << r.order_id << '\n'
+            << "Side: " << static_cast<int>(r.side) << '\n'
+            << "Price: " << r.price << '\n'
+            << "Size: " << r.size << '\n';
+
+        if (r.event_type == OrderBookEventType::TRADE) {
+            out << "Trade Price: " << r.trade_price << '\n'
+                << "Trade Size: " << r.trade_size << '\n'
+                << "Is Aggressor: " << (r.is_aggressor ? "Yes" : "No") << '\n';
+        }
+
+        out << "--- CURRENT ORDER BOOK ---\n"
+            << "Best Bid: " << r.best_bid_price << " x " << r.best_bid_size << '\n'
+            << "Best Ask: " << r.best_ask_price << " x " << r.best_ask_size << '\n'
+            << "Spread: " << r.spread << '\n'
+            << "--- LATENCY BREAKDOWN ---\n"
+            << "Exchange → UDP Receive: " << r.exchange_to_udp_ns << " ns ("
+            << (r.exchange_to_udp_ns / 1000.0) << " μs)\n"
+            << "UDP Receive → Queue: " << r.udp_to_queue_ns << " ns ("
+            << (r.udp_to_queue_ns / 1000.0) << " μs)\n"
+            << "Queue → Strategy: " << r.queue_to_strategy_ns << " ns ("
+            << (r.queue_to_strategy_ns / 1000.0) << " μs)\n"
+            << "TOTAL LATENCY: " << r.total_latency_ns << " ns ("
+            << (r.total_latency_ns / 1000.0) << " μs)\n";
+    }
+
+    size_t ring_capacity_;
+    std::vector<std::unique_ptr<LogWriter>> writers_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+};
+
+#endif // ASYNC_LOGGER_HPP
@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+"""
+Compare two Google Benchmark JSON result files (--benchmark_out_format=json)
+and flag benchmarks that got slower than the threshold.
+Exits with status 1 if any benchmark regressed or reported an error (a failed
+correctness check, e.g. BM_BookTradeFill), so it can gate a release build.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load_times(path, errors=None):
+    """Benchmark name -> time per iteration (ns), preferring the mean when run with repetitions.
+    Benchmarks that reported an error are left out and added to errors (name -> message)."""
+    with open(path) as f:
+        results = json.load(f)
+
+    units = {'ns': 1.0, 'us': 1e3, 'ms': 1e6, 's': 1e9}
+    times = {}
+    for bench in results.get('benchmarks', []):
+        if bench.get('run_type') == 'aggregate' and bench.get('aggregate_name') != 'mean':
+            continue
+        name = bench.get('run_name', bench['name'])
+        if bench.get('error_occurred'):
+            if errors is not None:
+                errors[name] = bench.get('error_message', '')
+            continue
+        time_ns = bench['real_time'] * units[bench.get('time_unit', 'ns')]
+        if bench.get('run_type') == 'aggregate' or name not in times:
+            times[name] = time_ns
+    return times
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compare two benchmark result files')
+    parser.add_argument('baseline', help='Results of the previous release')
+    parser.add_argument('current', help='Results of this build')
+    parser.add_argument('--threshold', type=float, default=10.0,
+                        help='Slowdown in percent reported as a regression (default: 10)')
+    args = parser.parse_args()
+
+    baseline = load_times(args.baseline)
+    errors = {}
+    current = load_times(args.current, errors)
+
+    regressions = 0
+    print(f"{'Benchmark':<60} {'Baseline':>12} {'Current':>12} {'Change':>8}")
+    for name in sorted(set(baseline) | set(current)):
+        if name in errors:
+            continue  # Listed below
+        if name not in baseline or name not in current:
+            status = 'new' if name in current else 'removed'
+            print(f"{name:<60} {'':>12} {'':>12} {status:>8}")
+            continue
+        change = (current[name] / baseline[name] - 1.0) * 100.0 if baseline[name] > 0 else 0.0
+        marker = ''
+        if change > args.threshold:
+            marker = '  REGRESSION'
+            regressions += 1
+        print(f"{name:<60} {baseline[name]:>10.1f}ns {current[name]:>10.1f}ns {change:>+7.1f}%{marker}")
+
+    for name in sorted(errors):
+        print(f"{name:<60} ERROR: {errors[name]}")
+
+    if regressions:
+        print(f"\n{regressions} benchmark(s) slower than {args.threshold:.0f}%")
+    if errors:
+        print(f"\n{len(errors)} benchmark(s) failed")
+    if regressions or errors:
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
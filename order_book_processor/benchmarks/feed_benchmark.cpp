@@ -0,0 +1,720 @@
+// Google Benchmark suite for the hot paths of the feed pipeline:
+//   - OrderBook / TickOrderBook add/modify/cancel on a simulator-like order flow,
+//     with heap-grown pools or pools reserved in a prefaulted arena, and with the
+//     per-event analytics stage (BookAnalytics) on top
+//   - Trades filling resting orders end to end (decoder + book), with a
+//     correctness check of partial and full fills for both backends
+//   - SPSCRingBuffer throughput (push/pop and claim/commit) and round-trip latency
+//   - JSON parsing vs binary decoding of ingress messages
+//   - Symbol -> book lookup: string-keyed map vs interned symbol IDs
+//   - MulticastPublisher JSON formatting vs the binary encoder
+//   - SimpleOrderBookAPI::metrics_to_json and updates under concurrent reads
+//
+// Build (from order_book_processor/, needs libbenchmark-dev):
+//   g++ -std=c++17 -O2 -pthread -I. -I../order_book_api benchmarks/feed_benchmark.cpp
+//       multicast_publisher.cpp ../order_book_api/simple_api.cpp -lbenchmark -o feed_benchmark
+// Run, keeping the results for comparison between releases:
+//   ./feed_benchmark --benchmark_out=bench.json --benchmark_out_format=json
+//   python3 benchmarks/compare_benchmarks.py baseline.json bench.json
+//
+// The queue benchmarks pin their two threads when BENCH_PRODUCER_CPU and
+// BENCH_CONSUMER_CPU are set (pick two cores that do not share an L1).
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+#include "../book_analytics.hpp"
+#include "../cpu_affinity.hpp"
+#include "../feed_decoder.hpp"
+#include "../feed_protocol.hpp"
+#include "../multicast_protocol.hpp"
+#include "../multicast_publisher.hpp"
+#include "../orderbook.hpp"
+#include "../queue.hpp"
+#include "../symbol_directory.hpp"
+#include "../tick_order_book.hpp"
+#include "simple_api.hpp"
+
+namespace {
+
+constexpr double MID_PRICE = 100.0;
+constexpr double TICK_SIZE = 0.01;
+
+int cpu_from_env(const char* name) {
+    const char* value = std::getenv(name);
+    return value ? std::atoi(value) : -1;
+}
+
+// ---------------------------------------------------------------------------
+// Order book
+// ---------------------------------------------------------------------------
+
+enum class BookOpType : uint8_t { ADD, MODIFY, CANCEL };
+
+struct BookOp {
+    BookOpType type;
+    OrderSide side;
+    OrderId order_id;
+    double price;
+    uint32_t size;
+};
+
+struct BookWorkload {
+    std::vector<BookOp> prefill;    // Resting orders, applied before timing starts
+    std::vector<BookOp> ops;        // Timed order flow
+};
+
+// Order flow shaped like the simulator's: price distance from the touch is
+// geometric (most activity within a few ticks, a long tail out to MAX_LEVELS),
+// sizes are round lots, and 40% add / 20% modify / 40% cancel keeps the number
+// of resting orders (and so the queue depth per level) steady.
+BookWorkload make_book_workload(size_t resting_orders, double mean_level_distance, size_t op_count) {
+    constexpr int64_t MAX_LEVELS = 200;
+    std::mt19937_64 rng(42);
+    std::geometric_distribution<int64_t> distance(1.0 / (1.0 + mean_level_distance));
+    std::uniform_int_distribution<uint32_t> lots(1, 50);
+    std::uniform_int_distribution<int> action(0, 9);
+
+    BookWorkload workload;
+    std::vector<BookOp> live;       // Resting orders, for picking modify/cancel targets
+    OrderId next_id = 1;
+
+    auto new_order = [&]() {
+        BookOp op;
+        op.type = BookOpType::ADD;
+        op.side = (rng() & 1) ? OrderSide::BID : OrderSide::ASK;
+        int64_t ticks = std::min<int64_t>(distance(rng), MAX_LEVELS) + 1;
+        op.price = op.side == OrderSide::BID ? MID_PRICE - ticks * TICK_SIZE : MID_PRICE + ticks * TICK_SIZE;
+        op.size = lots(rng) * 100;
+        op.order_id = next_id++;
+        live.push_back(op);
+        return op;
+    };
+
+    for (size_t i = 0; i < resting_orders; ++i) {
+        workload.prefill.push_back(new_order());
+    }
+
+    workload.ops.reserve(op_count);
+    while (workload.ops.size() < op_count) {
+        int roll = action(rng);
+        if (roll < 4 || live.empty()) {
+            workload.ops.push_back(new_order());
+            continue;
+        }
+        size_t pick = rng() % live.size();
+        BookOp op = live[pick];
+        if (roll < 6) {
+            op.type = BookOpType::MODIFY;
+            op.size = lots(rng) * 100;
+            live[pick].size = op.size;
+        } else {
+            op.type = BookOpType::CANCEL;
+            live[pick] = live.back();
+            live.pop_back();
+        }
+        workload.ops.push_back(op);
+    }
+    return workload;
+}
+
+template<typename Book>
+void apply_book_op(Book& book, const BookOp& op) {
+    switch (op.type) {
+        case BookOpType::ADD: book.add_order(op.order_id, op.side, op.price, op.size); break;
+        case BookOpType::MODIFY: book.modify_order(op.order_id, op.size); break;
+        case BookOpType::CANCEL: book.cancel_order(op.order_id); break;
+    }
+}
+
+// Args: resting orders, mean distance from the touch (ticks)
+// use_arena: draw the book's slabs from a fresh prefaulted arena and reserve for the workload up front
+// analytics: updated after every op, as the consumer does (events 1 us apart)
+template<typename Book>
+void run_book_order_flow(benchmark::State& state, size_t depth_levels, bool use_arena = false,
+                         BookAnalytics* analytics = nullptr) {
+    const BookWorkload workload = make_book_workload(static_cast<size_t>(state.range(0)),
+                                                     static_cast<double>(state.range(1)), 100000);
+    for (auto _ : state) {
+        state.PauseTiming();
+        BookArena arena;
+        Book book;
+        if (use_arena && arena.initialize(8 << 20)) {
+            book.set_arena(&arena);
+            book.reserve(workload.prefill.size() * 2, 1024);
+        }
+        book.set_depth_levels(depth_levels);
+        for (const auto& op : workload.prefill) {
+            apply_book_op(book, op);
+        }
+        state.ResumeTiming();
+
+        uint64_t timestamp = 0;
+        for (const auto& op : workload.ops) {
+            apply_book_op(book, op);
+            if (analytics) {
+                analytics->update(0, book, timestamp += 1000);
+            }
+        }
+        benchmark::DoNotOptimize(book.get_best_bid());
+
+        state.PauseTiming();
+        state.counters["levels"] = static_cast<double>(book.get_bid_levels() + book.get_ask_levels());
+        book.clear();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * workload.ops.size()));
+}
+
+template<typename Book>
+void BM_BookOrderFlow(benchmark::State& state) {
+    run_book_order_flow<Book>(state, 0);
+}
+
+// Same flow with the book keeping a depth view; third arg: levels per side
+template<typename Book>
+void BM_BookOrderFlowDepth(benchmark::State& state) {
+    run_book_order_flow<Book>(state, static_cast<size_t>(state.range(2)));
+}
+
+// Same flow with the book's pools reserved up front in a prefaulted arena (--arena-mb)
+template<typename Book>
+void BM_BookOrderFlowArena(benchmark::State& state) {
+    run_book_order_flow<Book>(state, 0, true);
+}
+
+// Depth flow with the analytics stage after every event; third arg: levels per side
+template<typename Book>
+void BM_BookOrderFlowAnalytics(benchmark::State& state) {
+    SymbolDirectory symbols;
+    symbols.intern("AAPL");
+    BookAnalytics analytics(symbols, 5000);
+    run_book_order_flow<Book>(state, static_cast<size_t>(state.range(2)), false, &analytics);
+    benchmark::DoNotOptimize(analytics.get(0));
+}
+
+// Top of book read after every event, as the consumer does for the conflator
+template<typename Book>
+void BM_BookBestBidAsk(benchmark::State& state) {
+    const BookWorkload workload = make_book_workload(static_cast<size_t>(state.range(0)), 4.0, 0);
+    Book book;
+    for (const auto& op : workload.prefill) {
+        apply_book_op(book, op);
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(book.get_best_bid());
+        benchmark::DoNotOptimize(book.get_best_ask());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(BM_BookOrderFlow, OrderBook)
+    ->ArgNames({"resting", "distance"})->Args({1000, 4})->Args({10000, 4})->Args({10000, 32})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_BookOrderFlow, TickOrderBook)
+    ->ArgNames({"resting", "distance"})->Args({1000, 4})->Args({10000, 4})->Args({10000, 32})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_BookOrderFlowArena, OrderBook)
+    ->ArgNames({"resting", "distance"})->Args({10000, 4})->Args({10000, 32})->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_BookOrderFlowArena, TickOrderBook)
+    ->ArgNames({"resting", "distance"})->Args({10000, 4})->Args({10000, 32})->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_BookOrderFlowDepth, OrderBook)
+    ->ArgNames({"resting", "distance", "depth"})->Args({10000, 4, 10})->Args({10000, 4, 20})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_BookOrderFlowDepth, TickOrderBook)
+    ->ArgNames({"resting", "distance", "depth"})->Args({10000, 4, 10})->Args({10000, 4, 20})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_BookOrderFlowAnalytics, OrderBook)
+    ->ArgNames({"resting", "distance", "depth"})->Args({10000, 4, 10})->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_BookOrderFlowAnalytics, TickOrderBook)
+    ->ArgNames({"resting", "distance", "depth"})->Args({10000, 4, 10})->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_BookBestBidAsk, OrderBook)->Arg(10000);
+BENCHMARK_TEMPLATE(BM_BookBestBidAsk, TickOrderBook)->Arg(10000);
+
+// Trades against resting orders, fed through the JSON decoder into the book as
+// the consumer applies them. Each round adds two orders at one level, fills the
+// first partially, then fully, then the second with an oversized trade. The
+// first round checks the fills (FIFO position kept on a partial fill, level and
+// depth removed on a full one, interned order IDs released) and the benchmark
+// fails with an error if any of it is wrong.
+std::string trade_json(const char* type, const std::string& order_id, uint32_t size) {
+    bool trade = std::strcmp(type, "TRADE") == 0;
+    char json[256];
+    snprintf(json, sizeof(json),
+             "{\"event_type\": \"%s\", \"symbol\": \"AAPL\", \"exchange\": \"SIM\", \"order_id\": \"%s\", "
+             "\"side\": \"BID\", \"%s\": 100.00, \"%s\": %u}",
+             type, order_id.c_str(), trade ? "trade_price" : "price", trade ? "trade_size" : "size", size);
+    return json;
+}
+
+template<typename Book>
+std::vector<OrderId> resting_order_ids(const Book& book) {
+    std::vector<OrderId> ids;
+    book.for_each_order([&ids](const Order& order) { ids.push_back(order.order_id); });
+    return ids;
+}
+
+// First failed check of one round on an empty book ("" = all passed)
+template<typename Book>
+std::string run_trade_round(FeedDecoder& decoder, Book& book, bool check, size_t round) {
+    const std::string first = "AAPL_A" + std::to_string(round);
+    const std::string second = "AAPL_B" + std::to_string(round);
+    auto send = [&decoder](const std::string& json) { decoder.handle_datagram(json.data(), json.size(), 1); };
+
+    send(trade_json("ADD_ORDER", first, 300));
+    send(trade_json("ADD_ORDER", second, 200));
+    if (!check) {
+        send(trade_json("TRADE", first, 100));
+        send(trade_json("TRADE", first, 200));
+        send(trade_json("TRADE", second, 250));
+        return "";
+    }
+
+    const std::vector<OrderId> queued = resting_order_ids(book);
+    if (queued.size() != 2 || decoder.get_order_ids().size() != 2) return "orders not added";
+    send(trade_json("TRADE", first, 100));
+    if (resting_order_ids(book) != queued || book.get_best_bid() != std::make_pair(100.0, 400u) ||
+        book.get_depth(OrderSide::BID)[0].size != 400) {
+        return "partial fill lost the FIFO position or the level size";
+    }
+    send(trade_json("TRADE", first, 200));
+    if (resting_order_ids(book) != std::vector<OrderId>{queued[1]} || book.get_best_bid().second != 200) {
+        return "full fill left the order resting";
+    }
+    if (decoder.get_order_ids().size() != 1) return "full fill kept the order ID interned";
+    send(trade_json("TRADE", second, 250));
+    if (book.get_total_orders() != 0 || book.get_bid_levels() != 0 || book.get_depth(OrderSide::BID).size() != 0) {
+        return "full fill left the level or its depth entry";
+    }
+    if (decoder.get_order_ids().size() != 0) return "full fill kept the order ID interned";
+    return "";
+}
+
+template<typename Book>
+void BM_BookTradeFill(benchmark::State& state) {
+    FeedDecoder decoder;
+    decoder.set_sequence_check(false);  // Rounds repeat without numbering
+    Book book;
+    book.set_depth_levels(10);
+    decoder.set_order_book_callback([&book](const OrderBookEvent& event) {
+        if (event.event_type == OrderBookEventType::ADD_ORDER) {
+            book.add_order(event.order_id, event.side, event.get_price(), event.size, event.timestamp);
+        } else if (event.event_type == OrderBookEventType::TRADE) {
+            book.execute_order(event.order_id, event.size);
+        }
+    });
+
+    std::string error = run_trade_round(decoder, book, true, 0);
+    if (!error.empty()) {
+        state.SkipWithError(error.c_str());
+        return;
+    }
+    size_t round = 1;
+    for (auto _ : state) {
+        run_trade_round(decoder, book, false, round++ % 1000);
+    }
+    if (book.get_total_orders() != 0 || decoder.get_order_ids().size() != 0) {
+        state.SkipWithError("orders or interned order IDs left after the rounds");
+        return;
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * 5));
+}
+
+BENCHMARK_TEMPLATE(BM_BookTradeFill, OrderBook);
+BENCHMARK_TEMPLATE(BM_BookTradeFill, TickOrderBook);
+
+// ---------------------------------------------------------------------------
+// SPSC queue
+// ---------------------------------------------------------------------------
+
+constexpr size_t QUEUE_CAPACITY = 65536;
+constexpr size_t QUEUE_ITEMS = 1 << 20;
+
+// Spin, but give the CPU away now and then so the benchmark also finishes on a single core
+inline void backoff(uint32_t& spins) {
+    if ((++spins & 63) == 0) {
+        std::this_thread::yield();
+    }
+}
+
+// Producer on its own thread, consumer on the benchmark thread; one iteration moves QUEUE_ITEMS events
+void BM_QueuePushPop(benchmark::State& state) {
+    SPSCRingBuffer<OrderBookEvent> queue(QUEUE_CAPACITY);
+    pin_current_thread(cpu_from_env("BENCH_CONSUMER_CPU"));
+
+    for (auto _ : state) {
+        std::thread producer([&queue]() {
+            pin_current_thread(cpu_from_env("BENCH_PRODUCER_CPU"));
+            OrderBookEvent event;
+            event.symbol_id = 0;
+            uint32_t spins = 0;
+            for (size_t i = 0; i < QUEUE_ITEMS; ++i) {
+                event.sequence_number = i;
+                while (!queue.push(event)) backoff(spins);
+            }
+        });
+
+        OrderBookEvent event;
+        uint64_t checksum = 0;
+        uint32_t spins = 0;
+        for (size_t i = 0; i < QUEUE_ITEMS; ++i) {
+            while (!queue.pop(event)) backoff(spins);
+            checksum += event.sequence_number;
+        }
+        producer.join();
+        benchmark::DoNotOptimize(checksum);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * QUEUE_ITEMS));
+}
+
+// Same, with events written in place (claim/commit) and read in place (peek/release)
+// in batches of state.range(0), as the ingress and consumer threads do
+void BM_QueueClaimCommit(benchmark::State& state) {
+    const size_t batch = static_cast<size_t>(state.range(0));
+    SPSCRingBuffer<OrderBookEvent> queue(QUEUE_CAPACITY);
+    pin_current_thread(cpu_from_env("BENCH_CONSUMER_CPU"));
+
+    for (auto _ : state) {
+        std::thread producer([&queue, batch]() {
+            pin_current_thread(cpu_from_env("BENCH_PRODUCER_CPU"));
+            uint32_t spins = 0;
+            for (size_t i = 0; i < QUEUE_ITEMS; i += batch) {
+                size_t claimed = 0;
+                while (claimed < batch) {
+                    OrderBookEvent* slot = queue.claim(claimed);
+                    if (!slot) {
+                        if (claimed > 0) {
+                            queue.commit(claimed);
+                            claimed = 0;
+                        }
+                        backoff(spins);
+                        continue;
+                    }
+                    slot->sequence_number = i + claimed;
+                    ++claimed;
+                }
+                queue.commit(claimed);
+            }
+        });
+
+        uint64_t checksum = 0;
+        uint32_t spins = 0;
+        size_t consumed = 0;
+        while (consumed < QUEUE_ITEMS) {
+            size_t count = 0;
+            while (count < batch) {
+                const OrderBookEvent* event = queue.peek(count);
+                if (!event) break;
+                checksum += event->sequence_number;
+                ++count;
+            }
+            if (count == 0) {
+                backoff(spins);
+                continue;
+            }
+            queue.release(count);
+            consumed += count;
+        }
+        producer.join();
+        benchmark::DoNotOptimize(checksum);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * QUEUE_ITEMS));
+}
+
+// One-way latency: ping over one queue, echo back over another; reports the round trip
+void BM_QueueRoundTrip(benchmark::State& state) {
+    SPSCRingBuffer<uint64_t> ping(1024);
+    SPSCRingBuffer<uint64_t> pong(1024);
+    std::atomic<bool> stop(false);
+    pin_current_thread(cpu_from_env("BENCH_CONSUMER_CPU"));
+
+    std::thread echo([&]() {
+        pin_current_thread(cpu_from_env("BENCH_PRODUCER_CPU"));
+        uint64_t value;
+        uint32_t spins = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            if (ping.pop(value)) {
+                while (!pong.push(value)) backoff(spins);
+            } else {
+                backoff(spins);
+            }
+        }
+    });
+
+    uint64_t value = 0;
+    uint32_t spins = 0;
+    for (auto _ : state) {
+        while (!ping.push(value)) backoff(spins);
+        while (!pong.pop(value)) backoff(spins);
+        ++value;
+    }
+    stop.store(true);
+    echo.join();
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_QueuePushPop)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_QueueClaimCommit)->ArgName("batch")->Arg(1)->Arg(32)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_QueueRoundTrip)->UseRealTime();
+
+// ---------------------------------------------------------------------------
+// Ingress parsing
+// ---------------------------------------------------------------------------
+
+constexpr size_t FEED_MESSAGES = 1024;
+
+struct FeedMessages {
+    std::vector<std::string> json;
+    std::vector<std::string> binary;
+};
+
+void fill_text(char* field, size_t width, const std::string& text) {
+    std::memset(field, 0, width);
+    std::memcpy(field, text.data(), text.size() < width ? text.size() : width);
+}
+
+// The same order events in both wire formats, as market_feed_simulator.py sends them
+FeedMessages make_feed_messages() {
+    static const char* const TYPES[] = {"ADD_ORDER", "MODIFY_ORDER", "CANCEL_ORDER", "ADD_ORDER", "CANCEL_ORDER"};
+    static const FeedMessageType WIRE_TYPES[] = {FeedMessageType::ADD_ORDER, FeedMessageType::MODIFY_ORDER,
+                                                 FeedMessageType::CANCEL_ORDER, FeedMessageType::ADD_ORDER,
+                                                 FeedMessageType::CANCEL_ORDER};
+    static const char* const SYMBOLS[] = {"AAPL", "MSFT", "GOOGL", "AMZN", "NVDA"};
+    std::mt19937_64 rng(7);
+
+    FeedMessages messages;
+    for (size_t i = 0; i < FEED_MESSAGES; ++i) {
+        size_t kind = rng() % 5;
+        std::string symbol = SYMBOLS[rng() % 5];
+        bool bid = (rng() & 1) != 0;
+        int64_t price_cents = 15000 + static_cast<int64_t>(rng() % 600);
+        uint32_t size = static_cast<uint32_t>(100 + rng() % 4900);
+        uint64_t order_number = 1000 + rng() % 100000;
+        uint64_t timestamp = 1700000000000000000ULL + i * 1000;
+        uint64_t mono_ns = 5000000000ULL + i * 1000;
+
+        char json[512];
+        snprintf(json, sizeof(json),
+                 "{\"event_type\": \"%s\", \"symbol\": \"%s\", \"exchange\": \"SIM\", \"order_id\": \"%s_%llu\", "
+                 "\"side\": \"%s\", \"timestamp\": %llu, \"exchange_mono_ns\": %llu, \"price\": %lld.%02lld, "
+                 "\"size\": %u, \"sequence_number\": %zu}",
+                 TYPES[kind], symbol.c_str(), symbol.c_str(), static_cast<unsigned long long>(order_number),
+                 bid ? "BID" : "ASK", static_cast<unsigned long long>(timestamp),
+                 static_cast<unsigned long long>(mono_ns), static_cast<long long>(price_cents / 100),
+                 static_cast<long long>(price_cents % 100), size, i + 1);
+        messages.json.emplace_back(json);
+
+        FeedHeader header;
+        std::memset(&header, 0, sizeof(header));
+        header.magic = FEED_MAGIC;
+        header.version = FEED_PROTOCOL_VERSION;
+        header.msg_type = static_cast<uint8_t>(WIRE_TYPES[kind]);
+        header.length = sizeof(FeedHeader) + sizeof(FeedOrderBody);
+        header.side = static_cast<uint8_t>(bid ? FeedSide::BID : FeedSide::ASK);
+        fill_text(header.symbol, sizeof(header.symbol), symbol);
+        fill_text(header.exchange, sizeof(header.exchange), "SIM");
+        header.sequence_number = i + 1;
+        header.timestamp = timestamp;
+        header.exchange_mono_ns = mono_ns;
+        FeedOrderBody body;
+        body.order_id = order_number;
+        body.price = price_cents * (FEED_PRICE_SCALE / 100);
+        body.size = size;
+        body.remaining_size = 0;
+
+        std::string binary(sizeof(header) + sizeof(body), '\0');
+        std::memcpy(&binary[0], &header, sizeof(header));
+        std::memcpy(&binary[sizeof(header)], &body, sizeof(body));
+        messages.binary.push_back(binary);
+    }
+    return messages;
+}
+
+const FeedMessages& feed_messages() {
+    static const FeedMessages messages = make_feed_messages();
+    return messages;
+}
+
+void BM_ParseJson(benchmark::State& state) {
+    const auto& messages = feed_messages().json;
+    FeedDecoder decoder;
+    FeedMessageText text;
+    size_t i = 0;
+    for (auto _ : state) {
+        OrderBookEvent event = decoder.parse_json_order_book_event(messages[i++ % FEED_MESSAGES], text);
+        benchmark::DoNotOptimize(event);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_DecodeBinary(benchmark::State& state) {
+    const auto& messages = feed_messages().binary;
+    OrderBookEvent event;
+    FeedMessageText text;
+    size_t i = 0;
+    for (auto _ : state) {
+        const std::string& message = messages[i++ % FEED_MESSAGES];
+        benchmark::DoNotOptimize(decode_feed_message(message.data(), message.size(), event, text));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Whole ingress step (format detection, decode, counters, callback); arg 0 = JSON, 1 = binary
+void BM_FeedDecoderDatagram(benchmark::State& state) {
+    const auto& messages = state.range(0) ? feed_messages().binary : feed_messages().json;
+    FeedDecoder decoder;
+    decoder.set_sequence_check(false);  // The messages repeat
+    uint64_t delivered = 0;
+    decoder.set_order_book_callback([&delivered](const OrderBookEvent&) { ++delivered; });
+    size_t i = 0;
+    for (auto _ : state) {
+        const std::string& message = messages[i++ % FEED_MESSAGES];
+        decoder.handle_datagram(message.data(), message.size(), 1);
+    }
+    benchmark::DoNotOptimize(delivered);
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * messages[0].size()));
+}
+
+BENCHMARK(BM_ParseJson);
+BENCHMARK(BM_DecodeBinary);
+BENCHMARK(BM_FeedDecoderDatagram)->ArgName("binary")->Arg(0)->Arg(1);
+
+// Per-event book lookup over state.range(0) symbols: the consumer's old
+// std::map<std::string, Book> against an interned ID indexing a vector
+std::vector<std::string> bench_symbols(size_t count) {
+    std::vector<std::string> symbols;
+    for (size_t i = 0; i < count; ++i) {
+        symbols.push_back("SYM" + std::to_string(i));
+    }
+    return symbols;
+}
+
+void BM_SymbolLookupMap(benchmark::State& state) {
+    std::vector<std::string> symbols = bench_symbols(static_cast<size_t>(state.range(0)));
+    std::map<std::string, uint64_t> books;
+    for (const auto& symbol : symbols) {
+        books[symbol] = 0;
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        ++books.find(symbols[i++ % symbols.size()])->second;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Ingress interns the symbol once; the consumer indexes by the ID it receives
+void BM_SymbolLookupInterned(benchmark::State& state) {
+    std::vector<std::string> symbols = bench_symbols(static_cast<size_t>(state.range(0)));
+    SymbolDirectory directory;
+    std::vector<uint64_t> books(symbols.size(), 0);
+    for (const auto& symbol : symbols) {
+        directory.intern(symbol);
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        ++books[directory.intern(symbols[i++ % symbols.size()])];
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_SymbolLookupMap)->ArgName("symbols")->Arg(10)->Arg(1000);
+BENCHMARK(BM_SymbolLookupInterned)->ArgName("symbols")->Arg(10)->Arg(1000);
+
+// ---------------------------------------------------------------------------
+// Egress encoding and API responses
+// ---------------------------------------------------------------------------
+
+void BM_FormatTopOfBookJson(benchmark::State& state) {
+    const std::string symbol = "AAPL";
+    TopOfBookUpdate update{0, &symbol, {150.25, 1200}, {150.27, 800}};
+    char buffer[512];
+    uint64_t timestamp = 1700000000000000000ULL;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(MulticastPublisher::format_top_of_book(buffer, sizeof(buffer), update, timestamp++));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_EncodeTopOfBookBinary(benchmark::State& state) {
+    const std::string symbol = "AAPL";
+    char buffer[512];
+    uint64_t sequence = 0;
+    for (auto _ : state) {
+        ++sequence;
+        benchmark::DoNotOptimize(encode_top_of_book(buffer, 1, symbol, sequence, 1700000000000000000ULL + sequence,
+                                                    {150.25, 1200}, {150.27, 800}));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_MetricsToJson(benchmark::State& state) {
+    SimpleOrderBookAPI api;  // Not started: no socket
+    MarketMetrics metrics;
+    metrics.best_bid_price = 150.25;
+    metrics.best_bid_size = 1200;
+    metrics.best_ask_price = 150.27;
+    metrics.best_ask_size = 800;
+    metrics.spread = 0.02;
+    metrics.midprice = 150.26;
+    metrics.quote_imbalance = 0.2;
+    metrics.last_update_timestamp = 1700000000000000000ULL;
+    metrics.total_events_processed = 123456;
+    for (auto _ : state) {
+        std::string json = api.metrics_to_json(metrics);
+        benchmark::DoNotOptimize(json);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Ingest-side update cost while state.range(0) threads poll get_metrics() like HTTP clients
+void BM_ApiUpdateUnderReadLoad(benchmark::State& state) {
+    static const char* const SYMBOLS[] = {"AAPL", "MSFT", "GOOGL", "AMZN", "NVDA", "TSLA", "META", "AMD"};
+    SimpleOrderBookAPI api;
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> readers;
+    for (int64_t r = 0; r < state.range(0); ++r) {
+        readers.emplace_back([&api, &stop]() {
+            size_t i = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                benchmark::DoNotOptimize(api.get_metrics(SYMBOLS[i++ % 8]));
+            }
+        });
+    }
+
+    OrderBook book;
+    book.add_order(1, OrderSide::BID, 150.25, 1200);
+    book.add_order(2, OrderSide::ASK, 150.27, 800);
+    size_t i = 0;
+    for (auto _ : state) {
+        const std::string symbol = SYMBOLS[i++ % 8];
+        api.update_order_book(symbol, book);
+        api.increment_event_count(symbol);
+    }
+    stop.store(true);
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_FormatTopOfBookJson);
+BENCHMARK(BM_EncodeTopOfBookBinary);
+BENCHMARK(BM_MetricsToJson);
+BENCHMARK(BM_ApiUpdateUnderReadLoad)->ArgName("readers")->Arg(0)->Arg(2);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,295 @@
+// SPSCRingBuffer micro-benchmark: ops/sec and cache misses for the current
+// queue (push/pop and batched claim/commit) against the previous design, which
+// loaded both indices with relaxed ordering on every operation.
+//
+// Build (from order_book_processor/):
+//   g++ -std=c++17 -O2 -pthread -I. benchmarks/queue_benchmark.cpp -o queue_benchmark
+// Run:
+//   ./queue_benchmark [ops] [producer_cpu consumer_cpu]
+//
+// Cache misses come from perf_event_open (PERF_COUNT_HW_CACHE_MISSES, summed over
+// both threads) and print as n/a when the kernel does not allow it
+// (see /proc/sys/kernel/perf_event_paranoid).
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "../queue.hpp"
+#include "../quote.hpp"
+#include "../cpu_affinity.hpp"
+
+namespace legacy {
+
+// SPSCRingBuffer before cached indices: full()/empty() load both head_ and tail_
+// (relaxed) on every push and pop, and mask_ shares the consumer's cache line
+template<typename T>
+class SPSCRingBuffer {
+private:
+    alignas(64) T* buffer_;
+    size_t capacity_;
+    alignas(64) std::atomic<size_t> head_;
+    alignas(64) std::atomic<size_t> tail_;
+    size_t mask_;
+
+public:
+    explicit SPSCRingBuffer(size_t capacity) : capacity_(1), head_(0), tail_(0), mask_(0) {
+        while (capacity_ < capacity) capacity_ <<= 1;
+        mask_ = capacity_ - 1;
+        buffer_ = static_cast<T*>(aligned_alloc(64, capacity_ * sizeof(T)));
+        for (size_t i = 0; i < capacity_; ++i) new (&buffer_[i]) T();
+    }
+
+    ~SPSCRingBuffer() {
+        for (size_t i = 0; i < capacity_; ++i) buffer_[i].~T();
+        free(buffer_);
+    }
+
+    bool push(const T& item) {
+        if (full()) return false;
+        size_t head = head_.load(std::memory_order_relaxed);
+        buffer_[head] = item;
+        head_.store((head + 1) & mask_, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item) {
+        if (empty()) return false;
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        item = buffer_[tail];
+        tail_.store((tail + 1) & mask_, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return head_.load(std::memory_order_relaxed) == tail_.load(std::memory_order_relaxed);
+    }
+
+    bool full() const {
+        return ((head_.load(std::memory_order_relaxed) + 1) & mask_) == tail_.load(std::memory_order_relaxed);
+    }
+};
+
+} // namespace legacy
+
+namespace {
+
+constexpr size_t QUEUE_CAPACITY = 4096;
+constexpr size_t BATCH = 32;
+
+int producer_cpu = -1;
+int consumer_cpu = -1;
+
+// Per-thread hardware cache-miss counter (-1 if unavailable)
+int open_cache_miss_counter() {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    int fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    return fd;
+}
+
+int64_t read_cache_misses(int fd) {
+    if (fd < 0) return -1;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    uint64_t count = 0;
+    ssize_t n = read(fd, &count, sizeof(count));
+    close(fd);
+    return n == sizeof(count) ? static_cast<int64_t>(count) : -1;
+}
+
+// Back off on a full/empty ring; yielding keeps the run sane when both threads share a core
+inline void backoff(unsigned& spins) {
+    if (++spins >= 64) {
+        spins = 0;
+        std::this_thread::yield();
+    }
+}
+
+void make_item(uint64_t i, uint64_t& out) {
+    out = i;
+}
+
+void make_item(uint64_t i, OrderBookEvent& out) {
+    out.event_type = OrderBookEventType::ADD_ORDER;
+    out.symbol_id = 0;
+    out.order_id = i;
+    out.side = (i & 1) ? OrderSide::ASK : OrderSide::BID;
+    out.price = to_event_price(150.0 + static_cast<double>(i % 100) * 0.01);
+    out.size = 100;
+    out.sequence_number = i;
+}
+
+uint64_t item_key(const uint64_t& item) {
+    return item;
+}
+
+uint64_t item_key(const OrderBookEvent& item) {
+    return item.sequence_number;
+}
+
+struct Result {
+    double ops_per_sec;
+    int64_t cache_misses;  // -1 = unavailable
+    bool ordered;
+};
+
+// Producer/consumer bodies are callables taking (ops, cache_miss_out)
+template<typename Producer, typename Consumer>
+Result run_pair(uint64_t ops, Producer producer, Consumer consumer) {
+    std::atomic<int64_t> producer_misses{-1};
+    std::atomic<bool> ordered{true};
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread producer_thread([&] {
+        pin_current_thread(producer_cpu);
+        int fd = open_cache_miss_counter();
+        producer(ops);
+        producer_misses.store(read_cache_misses(fd));
+    });
+
+    pin_current_thread(consumer_cpu);
+    int fd = open_cache_miss_counter();
+    ordered.store(consumer(ops));
+    int64_t consumer_misses = read_cache_misses(fd);
+    producer_thread.join();
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int64_t misses = (consumer_misses < 0 || producer_misses.load() < 0) ? -1 : consumer_misses + producer_misses.load();
+    return Result{static_cast<double>(ops) / elapsed, misses, ordered.load()};
+}
+
+template<typename T, typename Queue>
+Result bench_push_pop(uint64_t ops) {
+    Queue queue(QUEUE_CAPACITY);
+    return run_pair(ops,
+        [&queue](uint64_t n) {
+            T item;
+            unsigned spins = 0;
+            for (uint64_t i = 0; i < n; ++i) {
+                make_item(i, item);
+                while (!queue.push(item)) backoff(spins);
+            }
+        },
+        [&queue](uint64_t n) {
+            T item;
+            unsigned spins = 0;
+            bool ordered = true;
+            for (uint64_t i = 0; i < n; ++i) {
+                while (!queue.pop(item)) backoff(spins);
+                ordered &= item_key(item) == i;
+            }
+            return ordered;
+        });
+}
+
+template<typename T>
+Result bench_claim_commit(uint64_t ops) {
+    SPSCRingBuffer<T> queue(QUEUE_CAPACITY);
+    return run_pair(ops,
+        [&queue](uint64_t n) {
+            unsigned spins = 0;
+            uint64_t i = 0;
+            while (i < n) {
+                size_t claimed = 0;
+                while (claimed < BATCH && i + claimed < n) {
+                    T* slot = queue.claim(claimed);
+                    if (!slot) break;
+                    make_item(i + claimed, *slot);
+                    ++claimed;
+                }
+                if (claimed == 0) {
+                    backoff(spins);
+                    continue;
+                }
+                queue.commit(claimed);
+                i += claimed;
+            }
+        },
+        [&queue](uint64_t n) {
+            unsigned spins = 0;
+            bool ordered = true;
+            uint64_t i = 0;
+            while (i < n) {
+                size_t ready = queue.readable();
+                if (ready == 0) {
+                    backoff(spins);
+                    continue;
+                }
+                if (ready > BATCH) ready = BATCH;
+                for (size_t k = 0; k < ready; ++k) {
+                    ordered &= item_key(*queue.peek(k)) == i + k;
+                }
+                queue.release(ready);
+                i += ready;
+            }
+            return ordered;
+        });
+}
+
+void report(const std::string& name, const Result& result, uint64_t ops) {
+    std::cout << std::left << std::setw(34) << name << std::right << std::setw(14)
+              << std::fixed << std::setprecision(0) << result.ops_per_sec << " ops/s";
+    if (result.cache_misses >= 0) {
+        std::cout << std::setw(14) << result.cache_misses << " misses ("
+                  << std::setprecision(3) << static_cast<double>(result.cache_misses) / static_cast<double>(ops)
+                  << "/op)";
+    } else {
+        std::cout << std::setw(14) << "n/a" << " misses";
+    }
+    if (!result.ordered) {
+        std::cout << "  ORDER VIOLATION";
+    }
+    std::cout << std::endl;
+}
+
+template<typename T>
+void run_suite(const std::string& label, uint64_t ops) {
+    std::cout << "\n--- " << label << " (" << ops << " ops, capacity " << QUEUE_CAPACITY << ") ---" << std::endl;
+    report("legacy push/pop", bench_push_pop<T, legacy::SPSCRingBuffer<T>>(ops), ops);
+    report("cached-index push/pop", bench_push_pop<T, SPSCRingBuffer<T>>(ops), ops);
+    report("claim/commit (batch " + std::to_string(BATCH) + ")", bench_claim_commit<T>(ops), ops);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint64_t ops = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000ULL;
+    if (argc > 3) {
+        producer_cpu = std::atoi(argv[2]);
+        consumer_cpu = std::atoi(argv[3]);
+    }
+    if (ops == 0) {
+        std::cerr << "Usage: " << argv[0] << " [ops] [producer_cpu consumer_cpu]" << std::endl;
+        return 1;
+    }
+
+    std::cout << "SPSCRingBuffer benchmark";
+    if (producer_cpu >= 0) {
+        std::cout << " (producer CPU " << producer_cpu << ", consumer CPU " << consumer_cpu << ")";
+    }
+    std::cout << std::endl;
+
+    run_suite<uint64_t>("uint64_t payload", ops);
+    run_suite<OrderBookEvent>("OrderBookEvent payload", ops / 4);
+    return 0;
+}
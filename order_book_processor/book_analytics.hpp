@@ -0,0 +1,256 @@
+#ifndef BOOK_ANALYTICS_HPP
+#define BOOK_ANALYTICS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+#include "depth_view.hpp"
+#include "multicast_publisher.hpp"
+#include "symbol_directory.hpp"
+
+// Time-windowed sums kept as a ring of WINDOW_BUCKETS buckets. Adding to the
+// window is O(1); it slides a whole bucket at a time as timestamps move on, and
+// the totals are re-summed from the buckets when it does (WINDOW_BUCKETS adds),
+// so they never drift.
+class RollingWindow {
+public:
+    static constexpr size_t WINDOW_BUCKETS = 16;
+
+    struct Sums {
+        double notional = 0.0;      // Trade price * size
+        uint64_t volume = 0;
+        uint32_t trades = 0;
+        int64_t order_flow = 0;
+    };
+
+    explicit RollingWindow(uint64_t window_ns = 1000000000ULL)
+        : bucket_ns_(window_ns / WINDOW_BUCKETS > 0 ? window_ns / WINDOW_BUCKETS : 1), current_(0) {}
+
+    // Slide the window up to timestamp (ns); an older timestamp counts in the current bucket
+    void advance(uint64_t timestamp) {
+        uint64_t index = timestamp / bucket_ns_;
+        if (index <= current_) {
+            return;
+        }
+        uint64_t expired = index - current_;
+        if (expired >= WINDOW_BUCKETS) {
+            for (Sums& bucket : buckets_) bucket = Sums();
+        } else {
+            for (uint64_t i = 1; i <= expired; ++i) buckets_[(current_ + i) % WINDOW_BUCKETS] = Sums();
+        }
+        current_ = index;
+
+        totals_ = Sums();
+        for (const Sums& bucket : buckets_) {
+            totals_.notional += bucket.notional;
+            totals_.volume += bucket.volume;
+            totals_.trades += bucket.trades;
+            totals_.order_flow += bucket.order_flow;
+        }
+    }
+
+    void add_trade(double price, uint32_t size) {
+        Sums& bucket = buckets_[current_ % WINDOW_BUCKETS];
+        double notional = price * static_cast<double>(size);
+        bucket.notional += notional;
+        bucket.volume += size;
+        bucket.trades += 1;
+        totals_.notional += notional;
+        totals_.volume += size;
+        totals_.trades += 1;
+    }
+
+    void add_order_flow(int64_t flow) {
+        buckets_[current_ % WINDOW_BUCKETS].order_flow += flow;
+        totals_.order_flow += flow;
+    }
+
+    const Sums& totals() const { return totals_; }
+
+private:
+    uint64_t bucket_ns_;
+    uint64_t current_;              // Index (timestamp / bucket_ns_) of the newest bucket
+    Sums buckets_[WINDOW_BUCKETS];
+    Sums totals_;
+};
+
+// Order-flow imbalance contribution of one best bid/ask change (Cont, Kukanov &
+// Stoikov): size joining a bid that held or improved is buying pressure, size
+// leaving a bid that held or fell back is selling pressure, mirrored on the ask.
+// An empty side is (0, 0); an empty ask counts as an infinitely high one.
+inline int64_t order_flow_imbalance(std::pair<double, uint32_t> prev_bid, std::pair<double, uint32_t> prev_ask,
+                                    std::pair<double, uint32_t> bid, std::pair<double, uint32_t> ask) {
+    const double none = std::numeric_limits<double>::infinity();
+    double prev_ask_price = prev_ask.first > 0 ? prev_ask.first : none;
+    double ask_price = ask.first > 0 ? ask.first : none;
+
+    int64_t flow = 0;
+    if (bid.first >= prev_bid.first) flow += bid.second;
+    if (bid.first <= prev_bid.first) flow -= prev_bid.second;
+    if (ask_price <= prev_ask_price) flow -= ask.second;
+    if (ask_price >= prev_ask_price) flow += prev_ask.second;
+    return flow;
+}
+
+// Per-symbol analytics for one consumer shard, published next to the top of book.
+//
+// Everything is maintained incrementally as events arrive, O(1) per event:
+// trades feed a rolling VWAP, best bid/ask changes feed a rolling order-flow
+// imbalance, and the book's depth views keep running size totals for the
+// multi-level imbalance. Microprice comes straight from the BBO. Windows run on
+// exchange timestamps, so a replay gives the same numbers as the live run, and
+// slide only when the symbol sees an event. A symbol is marked dirty when any
+// of its numbers changed; flush() publishes every dirty symbol's latest values.
+// Symbols are tracked by interned ID in a flat array. Owned by a single
+// consumer thread.
+class BookAnalytics {
+public:
+    // window_ms = 0 turns analytics off (update() and add_trade() do nothing)
+    BookAnalytics(const SymbolDirectory& symbols, uint32_t window_ms)
+        : symbols_(symbols), window_ms_(window_ms), updates_published_(0) {}
+
+    bool enabled() const { return window_ms_ > 0; }
+
+    // Record the book's state after an event (any backend with get_best_bid/get_best_ask/get_depth)
+    template<typename Book>
+    void update(SymbolId symbol_id, const Book& book, uint64_t timestamp) {
+        if (!enabled()) return;
+        Entry& entry = find(symbol_id);
+        entry.window.advance(timestamp);
+
+        std::pair<double, uint32_t> best_bid = book.get_best_bid();
+        std::pair<double, uint32_t> best_ask = book.get_best_ask();
+        bool changed = false;
+        if (!entry.has_quote) {
+            // The first look is the baseline (e.g. a restored book), not flow
+            entry.has_quote = true;
+            changed = true;
+        } else if (best_bid != entry.best_bid || best_ask != entry.best_ask) {
+            entry.window.add_order_flow(order_flow_imbalance(entry.best_bid, entry.best_ask, best_bid, best_ask));
+            changed = true;
+        }
+        entry.best_bid = best_bid;
+        entry.best_ask = best_ask;
+
+        // Resting size over the depth view, or just the best level when the book keeps none
+        const DepthView& bid_depth = book.get_depth(OrderSide::BID);
+        const DepthView& ask_depth = book.get_depth(OrderSide::ASK);
+        uint64_t bid_size = bid_depth.depth() > 0 ? bid_depth.total_size() : best_bid.second;
+        uint64_t ask_size = ask_depth.depth() > 0 ? ask_depth.total_size() : best_ask.second;
+        if (bid_size != entry.bid_size || ask_size != entry.ask_size) {
+            entry.bid_size = bid_size;
+            entry.ask_size = ask_size;
+            changed = true;
+        }
+
+        if (changed) mark_dirty(symbol_id, entry);
+    }
+
+    // Count a trade print in the symbol's window
+    void add_trade(SymbolId symbol_id, double price, uint32_t size, uint64_t timestamp) {
+        if (!enabled() || size == 0) return;
+        Entry& entry = find(symbol_id);
+        entry.window.advance(timestamp);
+        entry.window.add_trade(price, size);
+        mark_dirty(symbol_id, entry);
+    }
+
+    // Drop a symbol's window and quote baseline (its book was cleared)
+    void reset(SymbolId symbol_id) {
+        if (!enabled() || symbol_id >= entries_.size()) return;
+        Entry& entry = entries_[symbol_id];
+        bool dirty = entry.dirty;
+        entry = Entry(static_cast<uint64_t>(window_ms_) * 1000000ULL);
+        entry.dirty = dirty;
+    }
+
+    // The symbol's current values (zeros for a symbol never seen)
+    AnalyticsMessage get(SymbolId symbol_id) const {
+        AnalyticsMessage message{};
+        message.window_ms = window_ms_;
+        if (symbol_id >= entries_.size()) {
+            return message;
+        }
+        const Entry& entry = entries_[symbol_id];
+        const RollingWindow::Sums& totals = entry.window.totals();
+        if (totals.volume > 0) {
+            message.vwap = totals.notional / static_cast<double>(totals.volume);
+        }
+        uint64_t top_size = static_cast<uint64_t>(entry.best_bid.second) + entry.best_ask.second;
+        if (entry.best_bid.first > 0 && entry.best_ask.first > 0 && top_size > 0) {
+            message.microprice = (entry.best_bid.first * entry.best_ask.second +
+                                  entry.best_ask.first * entry.best_bid.second) / static_cast<double>(top_size);
+        }
+        uint64_t resting = entry.bid_size + entry.ask_size;
+        if (resting > 0) {
+            message.depth_imbalance = (static_cast<double>(entry.bid_size) - static_cast<double>(entry.ask_size)) /
+                                      static_cast<double>(resting);
+        }
+        message.order_flow_imbalance = totals.order_flow;
+        message.window_volume = totals.volume;
+        message.window_trades = totals.trades;
+        return message;
+    }
+
+    bool has_dirty() const {
+        return !dirty_.empty();
+    }
+
+    // Queue every dirty symbol's latest analytics on the publisher (sent with its next flush).
+    // Returns the number of symbols published.
+    size_t flush(MulticastPublisher& publisher, uint64_t timestamp) {
+        size_t published = dirty_.size();
+        for (SymbolId symbol_id : dirty_) {
+            entries_[symbol_id].dirty = false;
+            publisher.publish_analytics_update(symbol_id, symbols_.name(symbol_id), get(symbol_id), timestamp);
+        }
+        dirty_.clear();
+        updates_published_ += published;
+        return published;
+    }
+
+    uint32_t get_window_ms() const { return window_ms_; }
+    uint64_t get_updates_published() const { return updates_published_; }
+
+    // Disable copy constructor and assignment
+    BookAnalytics(const BookAnalytics&) = delete;
+    BookAnalytics& operator=(const BookAnalytics&) = delete;
+
+private:
+    struct Entry {
+        RollingWindow window;
+        std::pair<double, uint32_t> best_bid{0.0, 0};
+        std::pair<double, uint32_t> best_ask{0.0, 0};
+        uint64_t bid_size = 0;          // Resting size over the depth view
+        uint64_t ask_size = 0;
+        bool has_quote = false;         // best_bid/best_ask hold a previous update
+        bool dirty = false;             // Queued in dirty_
+
+        explicit Entry(uint64_t window_ns) : window(window_ns) {}
+    };
+
+    Entry& find(SymbolId symbol_id) {
+        while (symbol_id >= entries_.size()) {
+            entries_.emplace_back(static_cast<uint64_t>(window_ms_) * 1000000ULL);
+        }
+        return entries_[symbol_id];
+    }
+
+    void mark_dirty(SymbolId symbol_id, Entry& entry) {
+        if (!entry.dirty) {
+            entry.dirty = true;
+            dirty_.push_back(symbol_id);
+        }
+    }
+
+    const SymbolDirectory& symbols_;
+    uint32_t window_ms_;
+    std::vector<Entry> entries_;                // By symbol ID
+    std::vector<SymbolId> dirty_;               // Symbols changed since the last flush
+    uint64_t updates_published_;
+};
+
+#endif // BOOK_ANALYTICS_HPP
@@ -0,0 +1,97 @@
+#ifndef BOOK_ARENA_HPP
+#define BOOK_ARENA_HPP
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Per-shard memory region that book node slabs are carved out of.
+//
+// The whole region is mapped once at startup, backed by 2 MB huge pages when
+// the system has them (explicit hugetlbfs pages first, transparent huge pages
+// otherwise) and faulted in before the first event, so growing a pool never
+// takes a page fault or a trip into the heap. Allocation is a pointer bump and
+// nothing is handed back: slabs live as long as the shard. When the region is
+// used up, pools fall back to the heap and the miss is counted.
+// Owned by a single consumer thread.
+class BookArena {
+public:
+    static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    BookArena() : base_(nullptr), size_(0), used_(0), huge_pages_(false), exhausted_(0) {}
+
+    ~BookArena() {
+        if (base_) {
+            munmap(base_, size_);
+        }
+    }
+
+    // Map and prefault bytes (rounded up to whole huge pages). Run it on the
+    // thread that will use the arena, after pinning, so the pages land on its
+    // NUMA node. Returns false (and logs) if the region cannot be mapped.
+    bool initialize(size_t bytes) {
+        size_ = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+
+        void* base = mmap(nullptr, size_, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+        huge_pages_ = base != MAP_FAILED;
+        if (!huge_pages_) {
+            // No reserved huge pages: regular pages, promoted by THP where enabled
+            base = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (base == MAP_FAILED) {
+                std::cerr << "Failed to map " << size_ << " byte book arena: " << strerror(errno) << std::endl;
+                size_ = 0;
+                return false;
+            }
+            huge_pages_ = madvise(base, size_, MADV_HUGEPAGE) == 0;
+
+            // Fault every page in now rather than on the hot path
+            const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            volatile unsigned char* bytes_view = static_cast<unsigned char*>(base);
+            for (size_t offset = 0; offset < size_; offset += page) {
+                bytes_view[offset] = 0;
+            }
+        }
+        base_ = static_cast<unsigned char*>(base);
+        used_ = 0;
+        return true;
+    }
+
+    // bytes at the given alignment (a power of two), nullptr when the arena is
+    // unmapped or full
+    void* allocate(size_t bytes, size_t alignment) {
+        if (!base_) {
+            return nullptr;
+        }
+        size_t offset = (used_ + alignment - 1) & ~(alignment - 1);
+        if (offset + bytes > size_) {
+            ++exhausted_;
+            return nullptr;
+        }
+        used_ = offset + bytes;
+        return base_ + offset;
+    }
+
+    bool is_mapped() const { return base_ != nullptr; }
+    size_t get_size() const { return size_; }
+    size_t get_used() const { return used_; }
+    bool uses_huge_pages() const { return huge_pages_; }       // hugetlbfs pages, or THP advised
+    uint64_t get_exhausted() const { return exhausted_; }      // Requests that went to the heap instead
+
+    // Disable copy constructor and assignment
+    BookArena(const BookArena&) = delete;
+    BookArena& operator=(const BookArena&) = delete;
+
+private:
+    unsigned char* base_;
+    size_t size_;
+    size_t used_;
+    bool huge_pages_;
+    uint64_t exhausted_;
+};
+
+#endif // BOOK_ARENA_HPP
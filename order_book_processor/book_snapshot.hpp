@@ -0,0 +1,401 @@
+#ifndef BOOK_SNAPSHOT_HPP
+#define BOOK_SNAPSHOT_HPP
+
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "feed_protocol.hpp"
+#include "orderbook.hpp"
+#include "symbol_directory.hpp"
+
+// Order book snapshot files (recovery after a restart)
+//
+// One file per symbol, <dir>/<SYMBOL>.snap:
+//
+//   SnapshotHeader (32 bytes) | SnapshotChannel (32 bytes) x channel_count |
+//   SnapshotOrder (32 bytes) x order_count
+//
+// Orders are stored level by level, oldest first within a level, so adding them
+// back in file order rebuilds the same FIFO queues. Sequence numbers are per
+// exchange channel (see SequenceArbiter), so each channel that fed the book gets
+// a record of its last applied sequence number and exchange timestamp; a live
+// event at or before its own channel's point is already in the snapshot and is
+// skipped when it shows up again. Same conventions as feed_protocol.hpp:
+// little-endian, no padding, prices as FEED_PRICE_SCALE fixed point, NUL-padded
+// symbol and exchange.
+
+constexpr uint16_t SNAPSHOT_MAGIC = 0x5342;          // "BS" on the wire
+constexpr uint8_t SNAPSHOT_VERSION = 2;
+constexpr size_t SNAPSHOT_MAX_CHANNELS = 4;           // Channels tracked per book
+constexpr size_t MAX_SNAPSHOT_EXCHANGES = 256;        // Exchange directory capacity
+
+#pragma pack(push, 1)
+struct SnapshotHeader {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t channel_count;        // SnapshotChannel records after the header
+    uint32_t order_count;
+    char symbol[8];
+    uint64_t written_ns;          // Wall clock when the snapshot was taken
+    uint64_t reserved;
+};
+
+struct SnapshotChannel {
+    char exchange[16];            // Sequence channel (empty = the feed names none)
+    uint64_t sequence;            // Feed sequence number of the last event applied from it
+    uint64_t timestamp;           // Its exchange timestamp (ns)
+};
+
+struct SnapshotOrder {
+    uint64_t order_id;
+    int64_t price;
+    uint32_t size;
+    uint8_t side;                 // FeedSide
+    uint8_t reserved[3];
+    uint64_t timestamp;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(SnapshotHeader) == 32, "SnapshotHeader layout changed");
+static_assert(sizeof(SnapshotChannel) == 32, "SnapshotChannel layout changed");
+static_assert(sizeof(SnapshotOrder) == 32, "SnapshotOrder layout changed");
+static_assert(sizeof(SnapshotChannel::exchange) > SymbolDirectory::MAX_SYMBOL_LENGTH, "Exchange names must fit");
+
+// Where a book stands relative to each channel that fed it
+struct ChannelPosition {
+    SymbolId exchange_id = INVALID_SYMBOL_ID;  // OrderBookEvent::exchange_id
+    uint64_t last_sequence = 0;   // Last event applied from this channel
+    uint64_t last_timestamp = 0;  // Its exchange timestamp
+    bool replaying = false;       // Restored, no live event applied from it yet
+};
+
+// Where a book stands relative to the feed (kept next to each book by the consumer).
+// A book fed by more than SNAPSHOT_MAX_CHANNELS channels keeps the most recently
+// active ones; events from a channel without a position are always applied.
+struct BookSequenceState {
+    ChannelPosition channels[SNAPSHOT_MAX_CHANNELS];
+    size_t channel_count = 0;
+    size_t replaying = 0;         // Channels still replaying against the snapshot
+    uint64_t last_timestamp = 0;  // Exchange timestamp of the last event applied (any channel)
+    bool unsaved = false;         // Changed since the last snapshot was taken
+
+    ChannelPosition* find(SymbolId exchange_id) {
+        for (size_t i = 0; i < channel_count; ++i) {
+            if (channels[i].exchange_id == exchange_id) return &channels[i];
+        }
+        return nullptr;
+    }
+
+    void applied(SymbolId exchange_id, uint64_t sequence, uint64_t timestamp) {
+        ChannelPosition* channel = find(exchange_id);
+        if (!channel) {
+            channel = channel_count < SNAPSHOT_MAX_CHANNELS ? &channels[channel_count++] : least_recent();
+            if (channel->replaying) --replaying;
+            *channel = ChannelPosition();
+            channel->exchange_id = exchange_id;
+        }
+        channel->last_sequence = sequence;
+        channel->last_timestamp = timestamp;
+        last_timestamp = timestamp;
+        unsaved = true;
+    }
+
+    // Forget every channel (the book was cleared)
+    void reset() {
+        channel_count = 0;
+        replaying = 0;
+        unsaved = true;
+    }
+
+private:
+    ChannelPosition* least_recent() {
+        ChannelPosition* oldest = &channels[0];
+        for (size_t i = 1; i < channel_count; ++i) {
+            if (channels[i].last_timestamp < oldest->last_timestamp) oldest = &channels[i];
+        }
+        return oldest;
+    }
+};
+
+// What to do with a live event for a book restored from a snapshot
+enum class SnapshotReplay {
+    APPLY,        // After the snapshot point of its channel (or a channel the snapshot has no point for)
+    SKIP,         // Already contained in the snapshot
+    STALE         // Older sequence but a newer timestamp: the channel restarted, drop the snapshot
+};
+
+// Only compares an event against its own channel's point; the first event applied
+// from a channel ends that channel's replay.
+inline SnapshotReplay check_snapshot_replay(BookSequenceState& state, SymbolId exchange_id, uint64_t sequence,
+                                            uint64_t timestamp) {
+    ChannelPosition* channel = state.find(exchange_id);
+    if (!channel || !channel->replaying) return SnapshotReplay::APPLY;
+    if (sequence > channel->last_sequence) {
+        channel->replaying = false;
+        --state.replaying;
+        return SnapshotReplay::APPLY;
+    }
+    return timestamp <= channel->last_timestamp ? SnapshotReplay::SKIP : SnapshotReplay::STALE;
+}
+
+namespace snapshot_detail {
+
+template<typename T>
+inline T to_le(T v) {
+    return feed_detail::from_le(v);  // Little-endian conversion is its own inverse
+}
+
+inline int64_t price_to_wire(double price) {
+    return to_le(static_cast<int64_t>(std::llround(price * static_cast<double>(FEED_PRICE_SCALE))));
+}
+
+} // namespace snapshot_detail
+
+// Serialize a book (any backend with for_each_order) into out, replacing its contents.
+// exchanges names the channels in state.
+template<typename Book>
+void encode_book_snapshot(std::vector<char>& out, const std::string& symbol, const Book& book,
+                          const BookSequenceState& state, const SymbolDirectory& exchanges, uint64_t written_ns) {
+    using namespace snapshot_detail;
+    out.resize(sizeof(SnapshotHeader) + state.channel_count * sizeof(SnapshotChannel));
+
+    for (size_t i = 0; i < state.channel_count; ++i) {
+        const ChannelPosition& position = state.channels[i];
+        SnapshotChannel channel;
+        std::memset(&channel, 0, sizeof(channel));
+        if (position.exchange_id != INVALID_SYMBOL_ID) {
+            const std::string& exchange = exchanges.name(position.exchange_id);
+            std::memcpy(channel.exchange, exchange.data(), exchange.size());
+        }
+        channel.sequence = to_le(position.last_sequence);
+        channel.timestamp = to_le(position.last_timestamp);
+        std::memcpy(out.data() + sizeof(SnapshotHeader) + i * sizeof(SnapshotChannel), &channel, sizeof(channel));
+    }
+
+    uint32_t order_count = 0;
+    book.for_each_order([&](const Order& order) {
+        SnapshotOrder wire;
+        std::memset(&wire, 0, sizeof(wire));
+        wire.order_id = to_le(order.order_id);
+        wire.price = price_to_wire(order.price);
+        wire.size = to_le(order.size);
+        wire.side = static_cast<uint8_t>(order.side == OrderSide::BID ? FeedSide::BID : FeedSide::ASK);
+        wire.timestamp = to_le(order.timestamp);
+        const char* bytes = reinterpret_cast<const char*>(&wire);
+        out.insert(out.end(), bytes, bytes + sizeof(wire));
+        ++order_count;
+    });
+
+    SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = to_le(SNAPSHOT_MAGIC);
+    header.version = SNAPSHOT_VERSION;
+    header.channel_count = static_cast<uint8_t>(state.channel_count);
+    std::memcpy(header.symbol, symbol.data(), symbol.size() < sizeof(header.symbol) ? symbol.size() : sizeof(header.symbol));
+    header.order_count = to_le(order_count);
+    header.written_ns = to_le(written_ns);
+    std::memcpy(out.data(), &header, sizeof(header));
+}
+
+// Rebuild book from a snapshot (book should be empty). Fills symbol and state,
+// interning the channels' exchanges. Returns false on a truncated or malformed
+// snapshot (or one written by another version).
+template<typename Book>
+bool decode_book_snapshot(const char* data, size_t len, std::string& symbol, Book& book, BookSequenceState& state,
+                          SymbolDirectory& exchanges) {
+    using namespace feed_detail;
+    if (len < sizeof(SnapshotHeader)) return false;
+
+    SnapshotHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    uint32_t order_count = from_le(header.order_count);
+    if (from_le(header.magic) != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION ||
+        header.channel_count > SNAPSHOT_MAX_CHANNELS ||
+        len != sizeof(SnapshotHeader) + header.channel_count * sizeof(SnapshotChannel) +
+               static_cast<size_t>(order_count) * sizeof(SnapshotOrder)) {
+        return false;
+    }
+    assign_text(symbol, header.symbol, sizeof(header.symbol));
+
+    const char* cursor = data + sizeof(SnapshotHeader);
+    state.reset();
+    for (size_t i = 0; i < header.channel_count; ++i, cursor += sizeof(SnapshotChannel)) {
+        SnapshotChannel channel;
+        std::memcpy(&channel, cursor, sizeof(channel));
+        std::string_view exchange = text_view(channel.exchange, sizeof(channel.exchange));
+        SymbolId exchange_id = exchanges.intern(exchange);
+        if (exchange_id == INVALID_SYMBOL_ID && !exchange.empty()) {
+            return false;  // Exchange directory full
+        }
+        ChannelPosition& position = state.channels[state.channel_count++];
+        position.exchange_id = exchange_id;
+        position.last_sequence = from_le(channel.sequence);
+        position.last_timestamp = from_le(channel.timestamp);
+        position.replaying = true;
+        if (position.last_timestamp > state.last_timestamp) state.last_timestamp = position.last_timestamp;
+    }
+    state.replaying = state.channel_count;
+    state.unsaved = false;
+
+    for (uint32_t i = 0; i < order_count; ++i, cursor += sizeof(SnapshotOrder)) {
+        SnapshotOrder wire;
+        std::memcpy(&wire, cursor, sizeof(wire));
+        FeedSide feed_side = static_cast<FeedSide>(wire.side);
+        OrderSide side = feed_side == FeedSide::BID ? OrderSide::BID :
+                         feed_side == FeedSide::ASK ? OrderSide::ASK : OrderSide::UNKNOWN;
+        book.add_order(from_le(wire.order_id), side, price_from_wire(wire.price), from_le(wire.size),
+                       from_le(wire.timestamp));
+    }
+    return true;
+}
+
+// Symbols with a snapshot in dir (empty if the directory does not exist)
+inline std::vector<std::string> list_book_snapshots(const std::string& dir) {
+    std::vector<std::string> symbols;
+    DIR* handle = opendir(dir.c_str());
+    if (!handle) return symbols;
+
+    const std::string suffix = ".snap";
+    while (struct dirent* entry = readdir(handle)) {
+        std::string name = entry->d_name;
+        if (name.size() > suffix.size() && name[0] != '.' &&
+            name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0) {
+            symbols.push_back(name.substr(0, name.size() - suffix.size()));
+        }
+    }
+    closedir(handle);
+    return symbols;
+}
+
+// Symbols a snapshot file can be written for (fits the header, safe as a file name)
+inline bool is_snapshot_symbol(const std::string& symbol) {
+    return !symbol.empty() && symbol.size() <= sizeof(SnapshotHeader::symbol) && symbol[0] != '.' &&
+           symbol.find('/') == std::string::npos;
+}
+
+inline std::string book_snapshot_path(const std::string& dir, const std::string& symbol) {
+    return dir + "/" + symbol + ".snap";
+}
+
+inline bool read_book_snapshot(const std::string& path, std::vector<char>& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open snapshot " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !file.bad();
+}
+
+// Writes snapshot files on a background thread, so consumers only pay for
+// serializing into memory. Each file is written to <path>.tmp and renamed into
+// place, so a reader (or a crash) never sees a half-written snapshot.
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(const std::string& dir) : dir_(dir), running_(false), files_written_(0) {}
+
+    ~SnapshotWriter() {
+        stop();
+    }
+
+    // Create the directory if needed and start the writer thread
+    bool start() {
+        if (mkdir(dir_.c_str(), 0755) != 0 && errno != EEXIST) {
+            std::cerr << "Failed to create snapshot directory " << dir_ << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        running_ = true;
+        thread_ = std::thread([this]() { run(); });
+        return true;
+    }
+
+    // Write whatever is still queued, then join
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_) return;
+            running_ = false;
+        }
+        wake_.notify_one();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    // Queue one symbol's serialized snapshot (any thread)
+    void submit(const std::string& symbol, std::vector<char>&& data) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_.emplace_back(symbol, std::move(data));
+        }
+        wake_.notify_one();
+    }
+
+    const std::string& get_directory() const { return dir_; }
+    uint64_t get_files_written() const { return files_written_.load(std::memory_order_relaxed); }
+
+    // Disable copy constructor and assignment
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            wake_.wait(lock, [this]() { return !pending_.empty() || !running_; });
+            if (pending_.empty()) {
+                return;  // Stopped and drained
+            }
+            std::pair<std::string, std::vector<char>> job = std::move(pending_.front());
+            pending_.pop_front();
+            lock.unlock();
+            if (write_file(book_snapshot_path(dir_, job.first), job.second)) {
+                files_written_.fetch_add(1, std::memory_order_relaxed);
+            }
+            lock.lock();
+        }
+    }
+
+    static bool write_file(const std::string& path, const std::vector<char>& data) {
+        std::string tmp_path = path + ".tmp";
+        {
+            std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+            file.write(data.data(), static_cast<std::streamsize>(data.size()));
+            if (!file) {
+                std::cerr << "Failed to write snapshot " << tmp_path << std::endl;
+                return false;
+            }
+        }
+        if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+            std::cerr << "Failed to rename snapshot " << tmp_path << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    std::string dir_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<std::pair<std::string, std::vector<char>>> pending_;
+    std::thread thread_;
+    bool running_;
+    std::atomic<uint64_t> files_written_;
+};
+
+#endif // BOOK_SNAPSHOT_HPP
@@ -0,0 +1,91 @@
+#ifndef CPU_AFFINITY_HPP
+#define CPU_AFFINITY_HPP
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Thread placement for the pipeline threads: CPU pinning, real-time
+// scheduling, and keeping a thread's hot memory on its own NUMA node.
+
+// Pin the calling thread to one CPU. cpu < 0 leaves the affinity untouched.
+// Returns false (and logs) if the kernel rejects the request.
+inline bool pin_current_thread(int cpu) {
+    if (cpu < 0) {
+        return true;
+    }
+    if (cpu >= CPU_SETSIZE) {
+        std::cerr << "Failed to pin thread: CPU " << cpu << " out of range" << std::endl;
+        return false;
+    }
+
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (rc != 0) {
+        std::cerr << "Failed to pin thread to CPU " << cpu << ": " << strerror(rc) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Run the calling thread under SCHED_FIFO at priority (1-99). priority <= 0
+// leaves the policy untouched. Needs CAP_SYS_NICE (or an RLIMIT_RTPRIO grant);
+// returns false (and logs) if the kernel refuses. A SCHED_FIFO thread that
+// spins is never preempted by normal threads, so give it a CPU of its own.
+inline bool set_current_thread_realtime(int priority) {
+    if (priority <= 0) {
+        return true;
+    }
+
+    sched_param param{};
+    param.sched_priority = priority;
+    int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (rc != 0) {
+        std::cerr << "Failed to set SCHED_FIFO priority " << priority << ": " << strerror(rc) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// NUMA node of the CPU the calling thread is running on (-1 if unknown)
+inline int current_numa_node() {
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+        return -1;
+    }
+    return static_cast<int>(node);
+}
+
+// Prefer the calling thread's NUMA node for [addr, addr + len), migrating pages
+// already faulted in elsewhere (e.g. a buffer the main thread constructed).
+// Call after pinning. Returns the node, or -1 (and logs) if the kernel has no
+// NUMA support or refuses the move; the memory stays usable either way.
+inline int bind_memory_to_local_node(const void* addr, size_t len) {
+    int node = current_numa_node();
+    if (node < 0 || node >= 64 || len == 0) {
+        return -1;
+    }
+
+    const uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t start = reinterpret_cast<uintptr_t>(addr) & ~(page - 1);
+    uintptr_t end = (reinterpret_cast<uintptr_t>(addr) + len + page - 1) & ~(page - 1);
+    unsigned long nodemask = 1UL << node;
+    if (syscall(SYS_mbind, start, end - start, MPOL_PREFERRED, &nodemask, sizeof(nodemask) * 8,
+                MPOL_MF_MOVE) != 0) {
+        std::cerr << "Failed to bind memory to NUMA node " << node << ": " << strerror(errno) << std::endl;
+        return -1;
+    }
+    return node;
+}
+
+#endif // CPU_AFFINITY_HPP
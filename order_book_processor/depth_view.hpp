@@ -0,0 +1,191 @@
+#ifndef DEPTH_VIEW_HPP
+#define DEPTH_VIEW_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include "quote.hpp"
+
+// Most price levels a depth view keeps per side
+constexpr size_t MAX_BOOK_DEPTH = 20;
+
+// One aggregated price level
+struct DepthEntry {
+    double price = 0.0;
+    uint32_t size = 0;
+};
+
+// Market-by-price level change, applied in order to a side's best-first levels
+enum class DepthAction : uint8_t {
+    NEW,      // Insert at level (levels behind shift down, the last drops past the depth)
+    CHANGE,   // New size at level
+    DELETE    // Remove level (levels behind shift up)
+};
+
+struct DepthDelta {
+    DepthAction action;
+    OrderSide side;
+    uint8_t level;            // 0 = best
+    double price;
+    uint32_t size;
+};
+
+// Apply one delta to a side's levels (best first, count of them held, at most depth).
+// Level is any type with price and size members. Returns false if the delta does
+// not fit the levels held (the receiver is out of step until the next refresh).
+template<typename Level>
+inline bool apply_depth_delta(Level* levels, uint32_t& count, size_t depth, const DepthDelta& delta) {
+    size_t level = delta.level;
+    switch (delta.action) {
+        case DepthAction::NEW: {
+            if (level > count || level >= depth) return false;
+            size_t last = count < depth ? count : depth - 1;
+            for (size_t i = last; i > level; --i) levels[i] = levels[i - 1];
+            levels[level].price = delta.price;
+            levels[level].size = delta.size;
+            if (count < depth) ++count;
+            return true;
+        }
+        case DepthAction::CHANGE:
+            if (level >= count) return false;
+            levels[level].price = delta.price;
+            levels[level].size = delta.size;
+            return true;
+        case DepthAction::DELETE:
+            if (level >= count) return false;
+            for (size_t i = level + 1; i < count; ++i) levels[i - 1] = levels[i];
+            --count;
+            return true;
+    }
+    return false;
+}
+
+// Best N levels of one book side, kept in step with the book on every change.
+// The book reports each level it touches (price, new total size, 0 = gone);
+// a change behind the view is ignored, and when a level leaves a full view the
+// book is asked for the single next level to refill the last slot. N <= 20, so
+// finding a level is a short linear scan of a contiguous array. The size
+// resting in the view is kept as a running total, adjusted by each change.
+class DepthView {
+public:
+    explicit DepthView(bool is_bid) : is_bid_(is_bid), depth_(0), count_(0), total_size_(0), version_(0) {}
+
+    // Levels to keep (0 = off); the book refills the view after changing it
+    void set_depth(size_t depth) {
+        depth_ = static_cast<uint32_t>(depth < MAX_BOOK_DEPTH ? depth : MAX_BOOK_DEPTH);
+        clear();
+    }
+
+    // Level at price now holds size (0 = removed). next_worse(price, DepthEntry&)
+    // returns the book's first level behind price, false if there is none.
+    template<typename NextWorse>
+    void update(double price, uint32_t size, NextWorse&& next_worse) {
+        if (depth_ == 0) return;
+
+        uint32_t pos = 0;
+        while (pos < count_ && is_better(levels_[pos].price, price)) ++pos;
+
+        if (pos < count_ && levels_[pos].price == price) {
+            if (size > 0) {
+                total_size_ = total_size_ - levels_[pos].size + size;
+                levels_[pos].size = size;
+            } else {
+                bool was_full = count_ == depth_;
+                total_size_ -= levels_[pos].size;
+                for (uint32_t i = pos + 1; i < count_; ++i) levels_[i - 1] = levels_[i];
+                --count_;
+                // Only a full view can have levels behind it
+                DepthEntry next;
+                if (was_full && next_worse(count_ > 0 ? levels_[count_ - 1].price : price, next)) {
+                    levels_[count_++] = next;
+                    total_size_ += next.size;
+                }
+            }
+        } else if (size > 0 && pos < depth_) {
+            // New level inside the view; the worst one falls out if it was full
+            uint32_t last = count_ < depth_ ? count_ : depth_ - 1;
+            if (count_ == depth_) total_size_ -= levels_[last].size;
+            for (uint32_t i = last; i > pos; --i) levels_[i] = levels_[i - 1];
+            levels_[pos] = DepthEntry{price, size};
+            total_size_ += size;
+            if (count_ < depth_) ++count_;
+        } else {
+            return;  // Behind the view
+        }
+        ++version_;
+    }
+
+    // Append a level behind the current worst (rebuilding after set_depth)
+    void push_back(double price, uint32_t size) {
+        if (count_ < depth_) {
+            levels_[count_++] = DepthEntry{price, size};
+            total_size_ += size;
+            ++version_;
+        }
+    }
+
+    void clear() {
+        count_ = 0;
+        total_size_ = 0;
+        ++version_;
+    }
+
+    bool is_bid() const { return is_bid_; }
+    size_t depth() const { return depth_; }
+    size_t size() const { return count_; }
+    bool full() const { return count_ == depth_; }
+    const DepthEntry& operator[](size_t level) const { return levels_[level]; }
+    const DepthEntry* levels() const { return levels_; }
+    uint64_t total_size() const { return total_size_; }     // Sum of the levels' sizes
+
+    // Bumped on every change inside the view (cheap dirty check for publishers)
+    uint64_t version() const { return version_; }
+
+private:
+    bool is_better(double a, double b) const {
+        return is_bid_ ? a > b : a < b;
+    }
+
+    bool is_bid_;
+    uint32_t depth_;
+    uint32_t count_;
+    uint64_t total_size_;
+    uint64_t version_;
+    DepthEntry levels_[MAX_BOOK_DEPTH];
+};
+
+// Deltas that turn the published levels of one side into the current ones.
+// Writes at most 2 * MAX_BOOK_DEPTH deltas to out and returns how many;
+// published is updated to match current.
+inline size_t diff_depth(DepthEntry* published, uint32_t& published_count, const DepthView& current,
+                         DepthDelta* out) {
+    OrderSide side = current.is_bid() ? OrderSide::BID : OrderSide::ASK;
+    size_t depth = current.depth();
+    size_t n = 0;
+    auto emit = [&](DepthAction action, size_t level, const DepthEntry& entry) {
+        out[n] = DepthDelta{action, side, static_cast<uint8_t>(level), entry.price, entry.size};
+        apply_depth_delta(published, published_count, depth, out[n]);
+        ++n;
+    };
+    auto is_better = [&current](double a, double b) {
+        return current.is_bid() ? a > b : a < b;
+    };
+
+    for (size_t i = 0; i < current.size(); ++i) {
+        const DepthEntry& level = current[i];
+        // Published levels ahead of this one are gone from the book
+        while (i < published_count && is_better(published[i].price, level.price)) {
+            emit(DepthAction::DELETE, i, published[i]);
+        }
+        if (i < published_count && published[i].price == level.price) {
+            if (published[i].size != level.size) emit(DepthAction::CHANGE, i, level);
+        } else {
+            emit(DepthAction::NEW, i, level);
+        }
+    }
+    while (published_count > current.size()) {
+        emit(DepthAction::DELETE, current.size(), published[current.size()]);
+    }
+    return n;
+}
+
+#endif // DEPTH_VIEW_HPP
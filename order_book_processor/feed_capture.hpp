@@ -0,0 +1,237 @@
+#ifndef FEED_CAPTURE_HPP
+#define FEED_CAPTURE_HPP
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// Feed capture file: raw ingress datagrams with their receive timestamps
+//
+//   CaptureFileHeader (32 bytes) | record | record | ...
+//   record = CaptureRecordHeader (16 bytes) | payload | zero padding to 8 bytes
+//
+// The file is append-only and written through a shared memory mapping that grows
+// in CAPTURE_GROW_BYTES steps; the unused tail is zero, so a reader stops at the
+// first record with length 0 (a capture cut short by a crash stays readable).
+// Native byte order: captures are replayed on the machine type that made them.
+
+constexpr char CAPTURE_MAGIC[8] = {'F', 'E', 'E', 'D', 'C', 'A', 'P', '1'};
+constexpr uint32_t CAPTURE_VERSION = 1;
+constexpr size_t CAPTURE_GROW_BYTES = 64 * 1024 * 1024;
+
+struct CaptureFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t start_realtime_ns;   // Wall clock when the capture started
+    uint64_t reserved;
+};
+
+struct CaptureRecordHeader {
+    uint64_t rx_mono_ns;          // Receive timestamp (monotonic clock)
+    uint32_t length;              // Payload bytes
+    uint32_t reserved;
+};
+
+static_assert(sizeof(CaptureFileHeader) == 32, "CaptureFileHeader layout changed");
+static_assert(sizeof(CaptureRecordHeader) == 16, "CaptureRecordHeader layout changed");
+
+inline size_t capture_record_size(size_t payload_len) {
+    return (sizeof(CaptureRecordHeader) + payload_len + 7) & ~static_cast<size_t>(7);
+}
+
+// Appends datagrams to a capture file (ingress thread only).
+// append() is a bounds check and a memcpy into the mapping; the kernel writes
+// the pages back in the background.
+class FeedCaptureWriter {
+public:
+    FeedCaptureWriter() : fd_(-1), map_(nullptr), capacity_(0), used_(0), records_(0) {}
+
+    ~FeedCaptureWriter() {
+        close();
+    }
+
+    bool open(const std::string& path) {
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd_ == -1) {
+            std::cerr << "Failed to create capture file " << path << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        path_ = path;
+        if (!grow(CAPTURE_GROW_BYTES)) {
+            close();
+            return false;
+        }
+
+        CaptureFileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, CAPTURE_MAGIC, sizeof(header.magic));
+        header.version = CAPTURE_VERSION;
+        header.header_size = sizeof(CaptureFileHeader);
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        header.start_realtime_ns = static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+        std::memcpy(map_, &header, sizeof(header));
+        used_ = sizeof(header);
+        return true;
+    }
+
+    // Record one datagram. Returns false (and stops capturing) if the file cannot grow.
+    // Empty datagrams are not recorded: a length 0 record marks the end of the capture.
+    bool append(const char* data, size_t len, uint64_t rx_mono_ns) {
+        if (!map_) return false;
+        if (len == 0) return true;
+        size_t record_size = capture_record_size(len);
+        if (used_ + record_size > capacity_ && !grow(capacity_ + CAPTURE_GROW_BYTES + record_size)) {
+            close();
+            return false;
+        }
+
+        CaptureRecordHeader record;
+        record.rx_mono_ns = rx_mono_ns;
+        record.length = static_cast<uint32_t>(len);
+        record.reserved = 0;
+        std::memcpy(map_ + used_, &record, sizeof(record));
+        std::memcpy(map_ + used_ + sizeof(record), data, len);  // Padding is already zero
+        used_ += record_size;
+        ++records_;
+        return true;
+    }
+
+    // Unmap and trim the file to what was written
+    void close() {
+        if (map_) {
+            munmap(map_, capacity_);
+            map_ = nullptr;
+        }
+        if (fd_ != -1) {
+            if (ftruncate(fd_, static_cast<off_t>(used_)) != 0) {
+                std::cerr << "Failed to trim capture file " << path_ << ": " << strerror(errno) << std::endl;
+            }
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    bool is_open() const { return map_ != nullptr; }
+    uint64_t get_records() const { return records_; }
+    uint64_t get_bytes() const { return used_; }
+    const std::string& get_path() const { return path_; }
+
+    // Disable copy constructor and assignment
+    FeedCaptureWriter(const FeedCaptureWriter&) = delete;
+    FeedCaptureWriter& operator=(const FeedCaptureWriter&) = delete;
+
+private:
+    bool grow(size_t capacity) {
+        if (ftruncate(fd_, static_cast<off_t>(capacity)) != 0) {
+            std::cerr << "Failed to grow capture file " << path_ << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        void* map = map_ ? mremap(map_, capacity_, capacity, MREMAP_MAYMOVE)
+                         : mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (map == MAP_FAILED) {
+            std::cerr << "Failed to map capture file " << path_ << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        map_ = static_cast<char*>(map);
+        capacity_ = capacity;
+        return true;
+    }
+
+    int fd_;
+    std::string path_;
+    char* map_;
+    size_t capacity_;
+    size_t used_;
+    uint64_t records_;
+};
+
+// Read-only view of a capture file, mapped whole
+class FeedCaptureReader {
+public:
+    FeedCaptureReader() : map_(nullptr), size_(0), header_size_(sizeof(CaptureFileHeader)), offset_(0) {}
+
+    ~FeedCaptureReader() {
+        if (map_) {
+            munmap(const_cast<char*>(map_), size_);
+        }
+    }
+
+    bool open(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd == -1) {
+            std::cerr << "Failed to open capture file " << path << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(CaptureFileHeader))) {
+            std::cerr << "Capture file " << path << " is too short" << std::endl;
+            ::close(fd);
+            return false;
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        // MAP_POPULATE: fault the whole file in now, not during the replay
+        void* map = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+        ::close(fd);
+        if (map == MAP_FAILED) {
+            std::cerr << "Failed to map capture file " << path << ": " << strerror(errno) << std::endl;
+            size_ = 0;
+            return false;
+        }
+        map_ = static_cast<const char*>(map);
+
+        CaptureFileHeader header;
+        std::memcpy(&header, map_, sizeof(header));
+        if (std::memcmp(header.magic, CAPTURE_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != CAPTURE_VERSION || header.header_size < sizeof(header) || header.header_size > size_) {
+            std::cerr << "Not a feed capture file: " << path << std::endl;
+            return false;
+        }
+        header_size_ = header.header_size;
+        offset_ = header_size_;
+        return true;
+    }
+
+    // Next datagram, false at the end of the capture
+    bool next(const char*& data, size_t& len, uint64_t& rx_mono_ns) {
+        if (offset_ + sizeof(CaptureRecordHeader) > size_) return false;
+        CaptureRecordHeader record;
+        std::memcpy(&record, map_ + offset_, sizeof(record));
+        size_t record_size = capture_record_size(record.length);
+        if (record.length == 0 || offset_ + record_size > size_) return false;
+
+        data = map_ + offset_ + sizeof(record);
+        len = record.length;
+        rx_mono_ns = record.rx_mono_ns;
+        offset_ += record_size;
+        return true;
+    }
+
+    // Back to the first record
+    void rewind() {
+        offset_ = header_size_;
+    }
+
+    size_t get_size() const { return size_; }
+
+    // Disable copy constructor and assignment
+    FeedCaptureReader(const FeedCaptureReader&) = delete;
+    FeedCaptureReader& operator=(const FeedCaptureReader&) = delete;
+
+private:
+    const char* map_;
+    size_t size_;
+    size_t header_size_;
+    size_t offset_;
+};
+
+#endif // FEED_CAPTURE_HPP
@@ -0,0 +1,418 @@
+#ifndef FEED_DECODER_HPP
+#define FEED_DECODER_HPP
+
+#include <string>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <chrono>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "quote.hpp"
+#include "feed_protocol.hpp"
+#include "queue.hpp"
+#include "wait_strategy.hpp"
+#include "shard_map.hpp"
+#include "latency_stats.hpp"
+#include "sequence_arbiter.hpp"
+#include "feed_capture.hpp"
+
+// Datagram payload -> OrderBookEvent, shared by every ingress backend.
+// Backends only deliver raw payloads (with a receive timestamp); format
+// selection, parsing and the callback live here so all of them behave the same.
+class FeedDecoder {
+private:
+    std::function<void(const OrderBookEvent&)> order_book_callback_;
+    FeedFormat feed_format_;
+    OrderBookEvent event_;              // Decode target for the callback path, reused for every datagram
+    
+    // Zero-copy path (empty = use callbacks): one queue per consumer shard
+    struct Output {
+        SPSCRingBuffer<OrderBookEvent>* queue;
+        size_t pending;                 // Claimed and decoded, not yet committed
+        QueueWakeup* wakeup;            // Rung after each commit (nullptr = consumer polls)
+    };
+    std::vector<Output> outputs_;
+    const ShardMap* shard_map_;         // Routes symbols when there are several outputs
+    SymbolDirectory* symbols_;          // Interns event symbols (nullptr = events carry no symbol ID)
+    SymbolDirectory* exchanges_;        // Interns sequence channels (nullptr = events carry no exchange ID)
+    std::vector<uint8_t> route_cache_;  // Output index by symbol ID + 1 (0 = not routed yet)
+    IngressStats stats_;                // Enqueued / dropped (queue full), readable by the stats reporter
+    SequenceArbiter arbiter_;           // A/B dedupe and gap detection
+    OrderIdTable order_ids_;            // Non-numeric JSON order IDs
+    bool sequence_check_;
+    FeedCaptureWriter* capture_;        // Raw datagram recording (nullptr = off)
+    const std::atomic<bool>* block_until_;  // Wait for room when a queue is full (replay), until this is set
+
+public:
+    FeedDecoder() : order_book_callback_(nullptr), feed_format_(FeedFormat::AUTO),
+                    shard_map_(nullptr), symbols_(nullptr), exchanges_(nullptr), sequence_check_(true), capture_(nullptr), block_until_(nullptr) {}
+    
+    // Set callback for order book event processing
+    void set_order_book_callback(std::function<void(const OrderBookEvent&)> callback) {
+        order_book_callback_ = callback;
+    }
+    
+    // Assign every event its symbol's ID (and route by it; a symbol's shard is only computed once)
+    void set_symbol_directory(SymbolDirectory* symbols) {
+        symbols_ = symbols;
+        route_cache_.clear();
+    }
+    
+    // Assign every event its exchange's ID, so consumers can tell sequence channels apart
+    void set_exchange_directory(SymbolDirectory* exchanges) {
+        exchanges_ = exchanges;
+    }
+    
+    // Select the ingress wire format (default: AUTO)
+    void set_feed_format(FeedFormat format) {
+        feed_format_ = format;
+    }
+    
+    // Check sequence numbers: drop duplicate copies, count gaps (default: on).
+    // Turn off for feeds that do not number their messages.
+    void set_sequence_check(bool enabled) {
+        sequence_check_ = enabled;
+    }
+    
+    // Record every datagram (with its receive timestamp) before decoding it
+    void set_capture(FeedCaptureWriter* capture) {
+        capture_ = capture;
+    }
+    
+    // Make a full queue push back instead of dropping: wait for the consumer until
+    // stop is set. Only for sources that can wait (replay); the network cannot.
+    void set_block_when_full(const std::atomic<bool>* stop) {
+        block_until_ = stop;
+    }
+    
+    // Order ID intern counters (ingress thread, or after it stopped)
+    const OrderIdTable& get_order_ids() const {
+        return order_ids_;
+    }
+    
+    // Per-channel arbitration counters (ingress thread, or after it stopped)
+    const SequenceArbiter& get_sequence_arbiter() const {
+        return arbiter_;
+    }
+    
+    // Decode straight into ring slots instead of calling the order book callback.
+    // Decoded events stay unpublished until flush(), so one release store covers a
+    // whole receive batch. wakeup (if any) is notified after every flush that
+    // published something, for consumers that sleep while idle.
+    void set_output_queue(SPSCRingBuffer<OrderBookEvent>* queue, QueueWakeup* wakeup = nullptr) {
+        outputs_.assign(1, Output{queue, 0, wakeup});
+        shard_map_ = nullptr;
+        route_cache_.clear();
+    }
+    
+    // Sharded form: shard_map picks queues[shard_for(symbol)] for each event;
+    // wakeups, when given, pair up with queues
+    void set_output_queues(const std::vector<SPSCRingBuffer<OrderBookEvent>*>& queues, const ShardMap* shard_map,
+                           const std::vector<QueueWakeup*>& wakeups = {}) {
+        outputs_.clear();
+        for (size_t i = 0; i < queues.size(); ++i) {
+            outputs_.push_back(Output{queues[i], 0, i < wakeups.size() ? wakeups[i] : nullptr});
+        }
+        shard_map_ = shard_map;
+        route_cache_.clear();
+    }
+    
+    // Publish events decoded since the last flush (called by the backend after each receive batch)
+    void flush() {
+        for (auto& output : outputs_) {
+            if (output.pending > 0) {
+                output.queue->commit(output.pending);
+                stats_.add(stats_.events_enqueued, output.pending);
+                output.pending = 0;
+                if (output.wakeup) {
+                    output.wakeup->notify();
+                }
+            }
+        }
+    }
+    
+    uint64_t get_events_enqueued() const {
+        return stats_.events_enqueued.load(std::memory_order_relaxed);
+    }
+    
+    uint64_t get_events_dropped() const {
+        return stats_.events_dropped.load(std::memory_order_relaxed);
+    }
+    
+    const IngressStats& get_ingress_stats() const {
+        return stats_;
+    }
+    
+    // Decode one datagram and hand it to the output queue or registered callback
+    // rx_mono_ns: receive timestamp on the monotonic clock (0 = stamp now)
+    void handle_datagram(const char* data, size_t len, uint64_t rx_mono_ns) {
+        if (len == 0) {
+            return;  // Empty datagram: no message (recvmmsg delivers them, recvfrom callers skip them)
+        }
+        if (capture_) {
+            capture_->append(data, len, rx_mono_ns ? rx_mono_ns : static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count()));
+        }
+        
+        if (!outputs_.empty() || order_book_callback_) {
+            bool binary = feed_format_ == FeedFormat::BINARY ||
+                          (feed_format_ == FeedFormat::AUTO && is_binary_feed_message(data, len));
+            
+            // Pick the destination slot before decoding when the shard is already known:
+            // always with one queue, and from the fixed-offset header symbol for binary
+            OrderBookEvent* event = &event_;
+            Output* output = nullptr;
+            SymbolId symbol_id = INVALID_SYMBOL_ID;
+            if (outputs_.size() == 1) {
+                output = &outputs_[0];
+            } else if (!outputs_.empty() && binary) {
+                std::string_view symbol = peek_feed_symbol(data, len);
+                symbol_id = intern(symbol);
+                output = &outputs_[route(symbol_id, symbol)];
+            }
+            if (output) {
+                event = claim_slot(*output);
+                if (!event) {
+                    // Queue is full - just update error counter (no printing from producer thread)
+                    stats_.add(stats_.events_dropped, 1);
+                    return;
+                }
+            }
+            
+            // Symbol, exchange and status text stay in the datagram; only the event is stored
+            FeedMessageText text;
+            if (binary) {
+                // Binary path: decode in place from the receive buffer, no allocation
+                if (!decode_feed_message(data, len, *event, text)) {
+                    std::cerr << "Error parsing order book event: malformed binary message ("
+                              << len << " bytes)" << std::endl;
+                    return;
+                }
+            } else {
+                try {
+                    // Parse JSON into OrderBookEvent
+                    *event = parse_json_order_book_event(std::string_view(data, len), text);
+                } catch (const std::exception& e) {
+                    std::cerr << "Error parsing order book event: " << e.what() << std::endl;
+                    std::cerr << "Raw data: " << std::string(data, len) << std::endl;
+                    // Don't crash - continue listening
+                    return;
+                }
+            }
+            
+            event->symbol_id = symbol_id != INVALID_SYMBOL_ID ? symbol_id : intern(text.symbol);
+            event->exchange_id = exchanges_ ? exchanges_->intern(text.exchange) : INVALID_SYMBOL_ID;
+            
+            // First copy of each sequence wins; a duplicate's claimed slot is simply reused
+            if (sequence_check_ && !accept_sequence(text.exchange, event->sequence_number)) {
+                return;
+            }
+            
+            // Monotonic receive timestamp for latency measurement
+            uint64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+            event->udp_rx_mono_ns = rx_mono_ns ? rx_mono_ns : now_ns;
+            
+            if (outputs_.empty()) {
+                // Call the callback function with the parsed event
+                order_book_callback_(event_);
+                return;
+            }
+            
+            if (!output) {
+                // Sharded JSON: the symbol is only known after parsing, so route now and
+                // copy into the slot (one cache line)
+                output = &outputs_[route(event_.symbol_id, text.symbol)];
+                event = claim_slot(*output);
+                if (!event) {
+                    stats_.add(stats_.events_dropped, 1);
+                    return;
+                }
+                *event = event_;
+            }
+            
+            // Enqueue delay; the slot becomes visible at the next flush()
+            uint64_t delay = now_ns > event->udp_rx_mono_ns ? now_ns - event->udp_rx_mono_ns : 0;
+            event->enqueue_delay_ns = delay < UINT32_MAX ? static_cast<uint32_t>(delay) : UINT32_MAX;
+            ++output->pending;
+        }
+    }
+    
+    // Parse one JSON feed message (public for the benchmarks). Text fields come back
+    // as views into json; a malformed number throws std::invalid_argument.
+    OrderBookEvent parse_json_order_book_event(std::string_view json, FeedMessageText& text) {
+        OrderBookEvent event;
+        
+        // Start of the value of "key" (spaces skipped), npos if the key is absent
+        auto find_value = [&](std::string_view key) -> size_t {
+            for (size_t k = json.find(key); k != std::string_view::npos; k = json.find(key, k + 1)) {
+                if (k == 0 || json[k - 1] != '"' || k + key.size() >= json.size() || json[k + key.size()] != '"') {
+                    continue;  // Part of a longer key or of a value
+                }
+                size_t i = json.find(':', k + key.size());
+                if (i == std::string_view::npos) return i;
+                ++i;
+                while (i < json.size() && json[i] == ' ') ++i;
+                return i;
+            }
+            return std::string_view::npos;
+        };
+
+        auto find_string = [&](std::string_view key) -> std::string_view {
+            size_t i = find_value(key);
+            if (i == std::string_view::npos || i >= json.size() || json[i] != '"') return {};
+            size_t end = json.find('"', i + 1);
+            if (end == std::string_view::npos) return {};
+            return json.substr(i + 1, end - i - 1);
+        };
+
+        auto find_number = [&](std::string_view key) -> std::string_view {
+            size_t i = find_value(key);
+            if (i == std::string_view::npos) return {};
+            size_t start = i;
+            while (i < json.size() && (std::isdigit(static_cast<unsigned char>(json[i])) || json[i] == '.' ||
+                                       json[i] == '-')) ++i;
+            return json.substr(start, i - start);
+        };
+
+        auto find_bool = [&](std::string_view key) -> bool {
+            size_t i = find_value(key);
+            return i != std::string_view::npos && json.substr(i, 4) == "true";
+        };
+        
+        auto to_number = [](std::string_view value, auto& out) {
+            auto result = std::from_chars(value.data(), value.data() + value.size(), out);
+            if (result.ec != std::errc()) {
+                throw std::invalid_argument("invalid number '" + std::string(value) + "'");
+            }
+        };
+
+        // Extract basic fields
+        std::string_view event_type_str = find_string("event_type");
+        std::string_view side_str = find_string("side");
+        std::string_view order_id = find_string("order_id");
+        text.symbol = find_string("symbol");
+        text.exchange = find_string("exchange");
+        text.status = find_string("status_message");
+        
+        // Parse event type
+        if (event_type_str == "ADD_ORDER") event.event_type = OrderBookEventType::ADD_ORDER;
+        else if (event_type_str == "MODIFY_ORDER") event.event_type = OrderBookEventType::MODIFY_ORDER;
+        else if (event_type_str == "CANCEL_ORDER") event.event_type = OrderBookEventType::CANCEL_ORDER;
+        else if (event_type_str == "DELETE_ORDER") event.event_type = OrderBookEventType::DELETE_ORDER;
+        else if (event_type_str == "TRADE") event.event_type = OrderBookEventType::TRADE;
+        else if (event_type_str == "QUOTE_UPDATE") event.event_type = OrderBookEventType::QUOTE_UPDATE;
+        else if (event_type_str == "MARKET_STATUS") event.event_type = OrderBookEventType::MARKET_STATUS;
+        else event.event_type = OrderBookEventType::UNKNOWN;
+        
+        // Parse side
+        if (side_str == "BID") event.side = OrderSide::BID;
+        else if (side_str == "ASK") event.side = OrderSide::ASK;
+        else event.side = OrderSide::UNKNOWN;
+        
+        if (!order_id.empty()) {
+            event.order_id = order_ids_.intern(order_id);
+        }
+        
+        // Price and size (a trade carries them as trade_price / trade_size)
+        bool trade = event.event_type == OrderBookEventType::TRADE;
+        std::string_view price_str = find_number(trade ? "trade_price" : "price");
+        std::string_view size_str = find_number(trade ? "trade_size" : "size");
+        if (!price_str.empty()) {
+            double price = 0.0;
+            to_number(price_str, price);
+            event.price = to_event_price(price);
+        }
+        if (!size_str.empty()) to_number(size_str, event.size);
+        
+        // Interned strings live as long as the book holds their order
+        if (!order_id.empty()) {
+            switch (event.event_type) {
+                case OrderBookEventType::ADD_ORDER:
+                case OrderBookEventType::MODIFY_ORDER:
+                    order_ids_.set_size(event.order_id, event.size);
+                    break;
+                case OrderBookEventType::TRADE:
+                    order_ids_.fill(event.order_id, event.size);
+                    break;
+                case OrderBookEventType::CANCEL_ORDER:
+                case OrderBookEventType::DELETE_ORDER:
+                    order_ids_.release(event.order_id);
+                    break;
+                default:
+                    break;
+            }
+        }
+        
+        // Timestamps and sequence
+        std::string_view ts = find_number("timestamp");
+        std::string_view seq = find_number("sequence_number");
+        std::string_view ex_mono = find_number("exchange_mono_ns");
+        if (!ts.empty()) to_number(ts, event.timestamp);
+        if (!seq.empty()) to_number(seq, event.sequence_number);
+        if (!ex_mono.empty()) to_number(ex_mono, event.exchange_mono_ns);
+        
+        // Set boolean fields
+        if (find_bool("is_aggressor")) event.flags |= EVENT_FLAG_AGGRESSOR;
+        if (find_bool("is_trading_halted")) event.flags |= EVENT_FLAG_TRADING_HALTED;
+
+        return event;
+    }
+
+private:
+    OrderBookEvent* claim_slot(Output& output) {
+        OrderBookEvent* event = output.queue->claim(output.pending);
+        while (!event && block_until_ && !block_until_->load(std::memory_order_relaxed)) {
+            // Publish what is decoded so far so the consumer can make room
+            flush();
+            std::this_thread::yield();
+            event = output.queue->claim(output.pending);
+        }
+        return event;
+    }
+    
+    bool accept_sequence(std::string_view exchange, uint64_t sequence_number) {
+        uint64_t lost = 0;
+        switch (arbiter_.check(exchange, sequence_number, lost)) {
+            case SequenceCheck::DUPLICATE:
+                stats_.add(stats_.duplicates_dropped, 1);
+                return false;
+            case SequenceCheck::GAP:
+                stats_.add(stats_.sequence_gaps, 1);
+                stats_.add(stats_.messages_lost, lost);
+                return true;
+            default:
+                return true;
+        }
+    }
+    
+    SymbolId intern(std::string_view symbol) {
+        return symbols_ ? symbols_->intern(symbol) : INVALID_SYMBOL_ID;
+    }
+    
+    // Output for a symbol: hashed (or pinned) once per symbol ID, then an array lookup
+    size_t route(SymbolId symbol_id, std::string_view symbol) {
+        if (!shard_map_) {
+            return 0;
+        }
+        if (symbol_id == INVALID_SYMBOL_ID || outputs_.size() > 255) {
+            return shard_map_->shard_for(symbol) % outputs_.size();
+        }
+        if (symbol_id >= route_cache_.size()) {
+            route_cache_.resize(static_cast<size_t>(symbol_id) + 1, 0);
+        }
+        uint8_t& cached = route_cache_[symbol_id];
+        if (cached == 0) {
+            cached = static_cast<uint8_t>(shard_map_->shard_for(symbol) % outputs_.size() + 1);
+        }
+        return cached - 1;
+    }
+};
+
+#endif // FEED_DECODER_HPP
@@ -0,0 +1,276 @@
+#ifndef FEED_PROTOCOL_HPP
+#define FEED_PROTOCOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include "quote.hpp"
+
+// Binary ingress feed format (ITCH/SBE style)
+//
+// One message per datagram, fixed layout, little-endian, no padding:
+//
+//   FeedHeader (48 bytes) | body (depends on msg_type)
+//
+// Prices are signed fixed-point integers with FEED_PRICE_SCALE units per 1.0.
+// Text fields (symbol, exchange) are NUL-padded ASCII.
+// market_feed_client/market_feed_simulator.py --format binary is the reference encoder.
+
+// Ingress wire format selection
+enum class FeedFormat {
+    JSON,     // Text JSON (legacy simulator format)
+    BINARY,   // Fixed-layout binary messages (this file)
+    AUTO      // Detect per datagram from the binary magic
+};
+
+constexpr uint16_t FEED_MAGIC = 0x4642;           // "BF" on the wire
+constexpr uint8_t FEED_PROTOCOL_VERSION = 1;
+constexpr int64_t FEED_PRICE_SCALE = 1000000;      // 6 implied decimals
+static_assert(FEED_PRICE_SCALE == EVENT_PRICE_SCALE, "Feed prices are copied into events unscaled");
+
+enum class FeedMessageType : uint8_t {
+    ADD_ORDER = 1,
+    MODIFY_ORDER = 2,
+    CANCEL_ORDER = 3,
+    DELETE_ORDER = 4,
+    TRADE = 5,
+    QUOTE_UPDATE = 6,
+    MARKET_STATUS = 7
+};
+
+enum class FeedSide : uint8_t {
+    UNKNOWN = 0,
+    BID = 1,
+    ASK = 2
+};
+
+// FeedHeader::flags bits
+constexpr uint8_t FEED_FLAG_AGGRESSOR = 0x01;
+constexpr uint8_t FEED_FLAG_TRADING_HALTED = 0x02;
+
+#pragma pack(push, 1)
+struct FeedHeader {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t msg_type;             // FeedMessageType
+    uint16_t length;              // Header + body, in bytes
+    uint8_t side;                 // FeedSide
+    uint8_t flags;                // FEED_FLAG_*
+    char symbol[8];
+    char exchange[4];
+    uint32_t reserved;
+    uint64_t sequence_number;
+    uint64_t timestamp;           // Exchange wall clock (ns)
+    uint64_t exchange_mono_ns;    // Exchange monotonic clock (ns)
+};
+
+// ADD_ORDER, MODIFY_ORDER, CANCEL_ORDER, DELETE_ORDER
+struct FeedOrderBody {
+    uint64_t order_id;
+    int64_t price;
+    uint32_t size;
+    uint32_t remaining_size;
+};
+
+// TRADE
+struct FeedTradeBody {
+    uint64_t order_id;
+    int64_t trade_price;
+    uint32_t trade_size;
+    uint32_t reserved;
+};
+
+// QUOTE_UPDATE (top-of-book fields are not carried on OrderBookEvent)
+struct FeedQuoteBody {
+    int64_t bid_price;
+    int64_t ask_price;
+    uint32_t bid_size;
+    uint32_t ask_size;
+};
+
+// MARKET_STATUS: followed by text_length bytes of status text
+struct FeedStatusBody {
+    uint16_t text_length;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(FeedHeader) == 48, "FeedHeader layout changed");
+static_assert(sizeof(FeedOrderBody) == 24, "FeedOrderBody layout changed");
+static_assert(sizeof(FeedTradeBody) == 24, "FeedTradeBody layout changed");
+static_assert(sizeof(FeedQuoteBody) == 24, "FeedQuoteBody layout changed");
+
+namespace feed_detail {
+
+// Wire fields are little-endian; swap only on big-endian hosts
+inline uint16_t from_le(uint16_t v) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return __builtin_bswap16(v);
+#else
+    return v;
+#endif
+}
+
+inline uint32_t from_le(uint32_t v) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return __builtin_bswap32(v);
+#else
+    return v;
+#endif
+}
+
+inline uint64_t from_le(uint64_t v) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return __builtin_bswap64(v);
+#else
+    return v;
+#endif
+}
+
+inline int32_t from_le(int32_t v) {
+    return static_cast<int32_t>(from_le(static_cast<uint32_t>(v)));
+}
+
+inline int64_t from_le(int64_t v) {
+    return static_cast<int64_t>(from_le(static_cast<uint64_t>(v)));
+}
+
+inline double price_from_wire(int64_t price) {
+    return static_cast<double>(from_le(price)) / static_cast<double>(FEED_PRICE_SCALE);
+}
+
+// Assign a NUL-padded fixed-width field (no allocation while it fits in SSO)
+inline void assign_text(std::string& out, const char* field, size_t width) {
+    size_t len = 0;
+    while (len < width && field[len] != '\0') ++len;
+    out.assign(field, len);
+}
+
+// View of a NUL-padded fixed-width field
+inline std::string_view text_view(const char* field, size_t width) {
+    size_t len = 0;
+    while (len < width && field[len] != '\0') ++len;
+    return std::string_view(field, len);
+}
+
+} // namespace feed_detail
+
+// True if the buffer starts like a binary feed message (cheap format sniffing)
+inline bool is_binary_feed_message(const char* data, size_t len) {
+    uint16_t magic;
+    if (len < sizeof(magic)) return false;
+    std::memcpy(&magic, data, sizeof(magic));
+    return feed_detail::from_le(magic) == FEED_MAGIC;
+}
+
+// Symbol of a binary feed message without decoding it (empty if too short).
+// Lets the ingress thread pick a shard before claiming a queue slot.
+inline std::string_view peek_feed_symbol(const char* data, size_t len) {
+    if (len < sizeof(FeedHeader)) return {};
+    return feed_detail::text_view(data + offsetof(FeedHeader, symbol), sizeof(FeedHeader::symbol));
+}
+
+// Text fields of a decoded message that OrderBookEvent does not carry. Views into
+// the message buffer (JSON or binary), valid as long as it is.
+struct FeedMessageText {
+    std::string_view symbol;      // For the caller to intern into event.symbol_id
+    std::string_view exchange;    // Sequence channel
+    std::string_view status;      // MARKET_STATUS text (empty otherwise)
+};
+
+// Decode one binary feed message straight from the receive buffer into event.
+// Every field of event except symbol_id (left to the caller) is overwritten, so
+// callers can reuse one event object. Returns false on a truncated, malformed or
+// unsupported message.
+inline bool decode_feed_message(const char* data, size_t len, OrderBookEvent& event, FeedMessageText& text) {
+    using namespace feed_detail;
+
+    if (len < sizeof(FeedHeader)) return false;
+
+    FeedHeader header;
+    std::memcpy(&header, data, sizeof(header));  // Receive buffers are not aligned for us
+
+    size_t length = from_le(header.length);
+    if (from_le(header.magic) != FEED_MAGIC || header.version != FEED_PROTOCOL_VERSION ||
+        length < sizeof(FeedHeader) || length > len) {
+        return false;
+    }
+
+    const char* body = data + sizeof(FeedHeader);
+    size_t body_len = length - sizeof(FeedHeader);
+
+    text.symbol = text_view(data + offsetof(FeedHeader, symbol), sizeof(header.symbol));
+    text.exchange = text_view(data + offsetof(FeedHeader, exchange), sizeof(header.exchange));
+    text.status = std::string_view();
+
+    switch (static_cast<FeedSide>(header.side)) {
+        case FeedSide::BID: event.side = OrderSide::BID; break;
+        case FeedSide::ASK: event.side = OrderSide::ASK; break;
+        default: event.side = OrderSide::UNKNOWN; break;
+    }
+
+    event.flags = ((header.flags & FEED_FLAG_AGGRESSOR) ? EVENT_FLAG_AGGRESSOR : 0) |
+                  ((header.flags & FEED_FLAG_TRADING_HALTED) ? EVENT_FLAG_TRADING_HALTED : 0);
+    event.sequence_number = from_le(header.sequence_number);
+    event.timestamp = from_le(header.timestamp);
+    event.exchange_mono_ns = from_le(header.exchange_mono_ns);
+
+    event.order_id = INVALID_ORDER_ID;
+    event.price = 0;
+    event.size = 0;
+    event.udp_rx_mono_ns = 0;
+    event.enqueue_delay_ns = 0;
+
+    switch (static_cast<FeedMessageType>(header.msg_type)) {
+        case FeedMessageType::ADD_ORDER:
+        case FeedMessageType::MODIFY_ORDER:
+        case FeedMessageType::CANCEL_ORDER:
+        case FeedMessageType::DELETE_ORDER: {
+            if (body_len < sizeof(FeedOrderBody)) return false;
+            FeedOrderBody order;
+            std::memcpy(&order, body, sizeof(order));
+            event.order_id = from_le(order.order_id);
+            event.price = from_le(order.price);
+            event.size = from_le(order.size);
+
+            switch (static_cast<FeedMessageType>(header.msg_type)) {
+                case FeedMessageType::ADD_ORDER: event.event_type = OrderBookEventType::ADD_ORDER; break;
+                case FeedMessageType::MODIFY_ORDER: event.event_type = OrderBookEventType::MODIFY_ORDER; break;
+                case FeedMessageType::CANCEL_ORDER: event.event_type = OrderBookEventType::CANCEL_ORDER; break;
+                default: event.event_type = OrderBookEventType::DELETE_ORDER; break;
+            }
+            return true;
+        }
+        case FeedMessageType::TRADE: {
+            if (body_len < sizeof(FeedTradeBody)) return false;
+            FeedTradeBody trade;
+            std::memcpy(&trade, body, sizeof(trade));
+            event.event_type = OrderBookEventType::TRADE;
+            event.order_id = from_le(trade.order_id);
+            event.price = from_le(trade.trade_price);
+            event.size = from_le(trade.trade_size);
+            return true;
+        }
+        case FeedMessageType::QUOTE_UPDATE: {
+            if (body_len < sizeof(FeedQuoteBody)) return false;
+            event.event_type = OrderBookEventType::QUOTE_UPDATE;
+            return true;
+        }
+        case FeedMessageType::MARKET_STATUS: {
+            if (body_len < sizeof(FeedStatusBody)) return false;
+            FeedStatusBody status;
+            std::memcpy(&status, body, sizeof(status));
+            size_t text_length = from_le(status.text_length);
+            if (body_len < sizeof(FeedStatusBody) + text_length) return false;
+            event.event_type = OrderBookEventType::MARKET_STATUS;
+            text.status = std::string_view(body + sizeof(FeedStatusBody), text_length);
+            return true;
+        }
+        default:
+            event.event_type = OrderBookEventType::UNKNOWN;
+            return false;
+    }
+}
+
+#endif // FEED_PROTOCOL_HPP
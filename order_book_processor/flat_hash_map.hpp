@@ -0,0 +1,185 @@
+#ifndef FLAT_HASH_MAP_HPP
+#define FLAT_HASH_MAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Open-addressing hash map keyed on 64-bit integers.
+// Keys and values sit inline in one power-of-2 array with linear probing, so a
+// lookup is usually a single cache line. Erase uses backward-shift deletion
+// (no tombstones), so probe lengths stay short under heavy add/cancel churn.
+// EmptyKey marks free slots and cannot be stored.
+template<typename V, uint64_t EmptyKey = ~0ULL>
+class FlatHashMap {
+private:
+    struct Slot {
+        uint64_t key;
+        V value;
+    };
+
+    std::vector<Slot> slots_;
+    size_t size_;
+    size_t mask_;
+    unsigned shift_;  // 64 - log2(capacity), for Fibonacci hashing
+
+public:
+    explicit FlatHashMap(size_t initial_capacity = 16) : size_(0), mask_(0), shift_(0) {
+        rehash(initial_capacity);
+    }
+
+    // Find value by key (nullptr if absent)
+    V* find(uint64_t key) {
+        size_t i = find_slot(key);
+        return i == npos() ? nullptr : &slots_[i].value;
+    }
+
+    const V* find(uint64_t key) const {
+        size_t i = find_slot(key);
+        return i == npos() ? nullptr : &slots_[i].value;
+    }
+
+    bool contains(uint64_t key) const {
+        return find_slot(key) != npos();
+    }
+
+    // Insert if absent. Returns {value slot, true if inserted}; {nullptr, false} for EmptyKey.
+    std::pair<V*, bool> try_emplace(uint64_t key, V value) {
+        if (key == EmptyKey) {
+            return {nullptr, false};
+        }
+        if ((size_ + 1) * 10 > slots_.size() * 7) {  // Keep load factor <= 0.7
+            rehash(slots_.size() * 2);
+        }
+
+        size_t i = ideal_slot(key);
+        while (slots_[i].key != EmptyKey) {
+            if (slots_[i].key == key) {
+                return {&slots_[i].value, false};
+            }
+            i = (i + 1) & mask_;
+        }
+
+        slots_[i].key = key;
+        slots_[i].value = std::move(value);
+        ++size_;
+        return {&slots_[i].value, true};
+    }
+
+    // Erase by key using backward-shift deletion. Returns true if the key was present.
+    bool erase(uint64_t key) {
+        size_t hole = find_slot(key);
+        if (hole == npos()) {
+            return false;
+        }
+
+        size_t next = (hole + 1) & mask_;
+        while (slots_[next].key != EmptyKey) {
+            size_t ideal = ideal_slot(slots_[next].key);
+            // Shift back unless the entry's ideal slot lies cyclically in (hole, next]
+            bool stays = (hole <= next) ? (hole < ideal && ideal <= next)
+                                        : (hole < ideal || ideal <= next);
+            if (!stays) {
+                slots_[hole] = std::move(slots_[next]);
+                hole = next;
+            }
+            next = (next + 1) & mask_;
+        }
+
+        slots_[hole].key = EmptyKey;
+        slots_[hole].value = V();
+        --size_;
+        return true;
+    }
+
+    // Visit every (key, value) pair
+    template<typename F>
+    void for_each(F&& f) {
+        for (auto& slot : slots_) {
+            if (slot.key != EmptyKey) f(slot.key, slot.value);
+        }
+    }
+
+    template<typename F>
+    void for_each(F&& f) const {
+        for (const auto& slot : slots_) {
+            if (slot.key != EmptyKey) f(slot.key, slot.value);
+        }
+    }
+
+    // Pre-size so that `count` entries fit without rehashing
+    void reserve(size_t count) {
+        size_t needed = count * 10 / 7 + 1;
+        if (needed > slots_.size()) {
+            rehash(needed);
+        }
+    }
+
+    void clear() {
+        for (auto& slot : slots_) {
+            slot.key = EmptyKey;
+            slot.value = V();
+        }
+        size_ = 0;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    size_t capacity() const {
+        return slots_.size();
+    }
+
+private:
+    static constexpr size_t npos() {
+        return ~static_cast<size_t>(0);
+    }
+
+    size_t ideal_slot(uint64_t key) const {
+        // Fibonacci hashing spreads sequential exchange IDs across the table
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> shift_);
+    }
+
+    size_t find_slot(uint64_t key) const {
+        if (key == EmptyKey) {
+            return npos();
+        }
+        size_t i = ideal_slot(key);
+        while (slots_[i].key != EmptyKey) {
+            if (slots_[i].key == key) {
+                return i;
+            }
+            i = (i + 1) & mask_;
+        }
+        return npos();
+    }
+
+    void rehash(size_t requested) {
+        size_t capacity = 16;
+        unsigned bits = 4;
+        while (capacity < requested) {
+            capacity <<= 1;
+            ++bits;
+        }
+
+        std::vector<Slot> old_slots(capacity, Slot{EmptyKey, V()});
+        old_slots.swap(slots_);
+        mask_ = capacity - 1;
+        shift_ = 64 - bits;
+        size_ = 0;
+
+        for (auto& slot : old_slots) {
+            if (slot.key != EmptyKey) {
+                try_emplace(slot.key, std::move(slot.value));
+            }
+        }
+    }
+};
+
+#endif // FLAT_HASH_MAP_HPP
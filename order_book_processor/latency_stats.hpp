@@ -0,0 +1,309 @@
+#ifndef LATENCY_STATS_HPP
+#define LATENCY_STATS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "queue.hpp"
+#include "quote.hpp"
+
+// Pipeline legs with their own latency histogram
+enum class LatencyLeg : size_t {
+    EXCHANGE_TO_UDP,
+    UDP_TO_QUEUE,
+    QUEUE_TO_STRATEGY,
+    END_TO_END,
+    PUBLISH,      // Multicast publication time on the consumer
+    COUNT
+};
+
+constexpr size_t LATENCY_LEG_COUNT = static_cast<size_t>(LatencyLeg::COUNT);
+
+inline const char* latency_leg_name(size_t leg) {
+    static const char* const names[LATENCY_LEG_COUNT] = {
+        "exchange_to_udp", "udp_to_queue", "queue_to_strategy", "end_to_end", "publish"
+    };
+    return leg < LATENCY_LEG_COUNT ? names[leg] : "unknown";
+}
+
+// HDR-style log-linear histogram of nanosecond values.
+// Values below 128 get exact buckets; above that each power of two is split
+// into 64 sub-buckets, so every value is reported within 1.6% up to 2^36 ns
+// (~69 s, larger values saturate). One writer thread records with plain
+// relaxed load/store (no read-modify-write); any thread may read concurrently
+// and sees a slightly stale but usable distribution.
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 7;
+    static constexpr uint64_t SUB_BUCKET_COUNT = 1ULL << SUB_BUCKET_BITS;    // 128
+    static constexpr uint64_t SUB_BUCKET_HALF = SUB_BUCKET_COUNT / 2;         // 64
+    static constexpr unsigned MAX_VALUE_BITS = 36;
+    static constexpr uint64_t MAX_VALUE = (1ULL << MAX_VALUE_BITS) - 1;
+    static constexpr size_t BUCKET_COUNT =
+        SUB_BUCKET_COUNT + (MAX_VALUE_BITS - SUB_BUCKET_BITS) * SUB_BUCKET_HALF;
+
+    LatencyHistogram() : max_(0) {
+        for (auto& count : counts_) {
+            count.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // Writer thread only
+    void record(uint64_t value) {
+        if (value > MAX_VALUE) value = MAX_VALUE;
+        std::atomic<uint64_t>& count = counts_[bucket_for(value)];
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (value > max_.load(std::memory_order_relaxed)) {
+            max_.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    // Reader side: accumulate bucket counts into counts[BUCKET_COUNT]
+    void add_counts_to(uint64_t* counts) const {
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            counts[i] += counts_[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t max() const {
+        return max_.load(std::memory_order_relaxed);
+    }
+
+    static size_t bucket_for(uint64_t value) {
+        if (value < SUB_BUCKET_COUNT) {
+            return static_cast<size_t>(value);
+        }
+        unsigned msb = 63 - static_cast<unsigned>(__builtin_clzll(value));
+        unsigned shift = msb - (SUB_BUCKET_BITS - 1);
+        return static_cast<size_t>(SUB_BUCKET_COUNT + (msb - SUB_BUCKET_BITS) * SUB_BUCKET_HALF +
+                                   ((value >> shift) - SUB_BUCKET_HALF));
+    }
+
+    // Highest value that lands in a bucket (what percentiles report)
+    static uint64_t bucket_upper(size_t bucket) {
+        if (bucket < SUB_BUCKET_COUNT) {
+            return bucket;
+        }
+        size_t k = bucket - SUB_BUCKET_COUNT;
+        unsigned msb = SUB_BUCKET_BITS + static_cast<unsigned>(k / SUB_BUCKET_HALF);
+        uint64_t sub = SUB_BUCKET_HALF + k % SUB_BUCKET_HALF;
+        unsigned shift = msb - (SUB_BUCKET_BITS - 1);
+        return ((sub + 1) << shift) - 1;
+    }
+
+private:
+    std::atomic<uint64_t> counts_[BUCKET_COUNT];
+    std::atomic<uint64_t> max_;
+};
+
+struct LatencySummary {
+    uint64_t count = 0;
+    uint64_t p50 = 0;
+    uint64_t p99 = 0;
+    uint64_t p999 = 0;
+    uint64_t max = 0;
+};
+
+// One reporting interval, trivially copyable so it can travel through log rings
+struct StatsSnapshot {
+    uint64_t timestamp_ns = 0;           // steady_clock when taken
+    uint64_t interval_ns = 0;            // Span covered by the latency summaries
+    LatencySummary legs[LATENCY_LEG_COUNT];
+    uint64_t unknown_symbols_interval = 0;  // Unknown-symbol events within the interval
+
+    // Cumulative counters since start
+    uint64_t events_processed = 0;
+    uint64_t events_enqueued = 0;
+    uint64_t events_dropped = 0;         // Ingress queue full
+    uint64_t duplicates_dropped = 0;     // Second copies of a sequence (A/B lines)
+    uint64_t sequence_gaps = 0;          // Sequence jumps seen on the feed
+    uint64_t messages_lost = 0;          // Messages missing on every line
+    uint64_t log_records_dropped = 0;    // Log ring full
+    uint64_t queue_depth = 0;            // Events waiting across all shard queues right now
+    uint64_t queue_depth_max = 0;        // Largest backlog any consumer has seen
+    uint64_t unknown_symbols = 0;        // Events dropped for an empty, unknown or over-long symbol
+};
+
+// Producer-side counters (written by the ingress thread only)
+struct IngressStats {
+    std::atomic<uint64_t> events_enqueued{0};
+    std::atomic<uint64_t> events_dropped{0};
+    std::atomic<uint64_t> duplicates_dropped{0};
+    std::atomic<uint64_t> sequence_gaps{0};
+    std::atomic<uint64_t> messages_lost{0};
+
+    void add(std::atomic<uint64_t>& counter, uint64_t n) {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+};
+
+// Consumer-side stats for one shard (written by that consumer thread only)
+struct ShardStats {
+    LatencyHistogram legs[LATENCY_LEG_COUNT];
+    alignas(64) std::atomic<uint64_t> events_processed{0};
+    std::atomic<uint64_t> queue_depth_max{0};
+    std::atomic<uint64_t> unknown_symbols{0};
+
+    void record(LatencyLeg leg, uint64_t ns) {
+        legs[static_cast<size_t>(leg)].record(ns);
+    }
+
+    void count_event() {
+        events_processed.store(events_processed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    void count_unknown_symbol() {
+        unknown_symbols.store(unknown_symbols.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    void observe_queue_depth(uint64_t depth) {
+        if (depth > queue_depth_max.load(std::memory_order_relaxed)) {
+            queue_depth_max.store(depth, std::memory_order_relaxed);
+        }
+    }
+};
+
+// Gathers every thread's stats into snapshots. Threads register their stats
+// before the pipeline starts; collect() runs on the reporting thread and turns
+// the growth of each histogram since the previous call into interval percentiles.
+class StatsCollector {
+public:
+    StatsCollector() : ingress_(nullptr), last_collect_ns_(now_ns()), last_unknown_symbols_(0) {}
+
+    ShardStats* add_shard(const SPSCRingBuffer<OrderBookEvent>* queue) {
+        shards_.push_back(Shard{std::make_unique<ShardStats>(), queue});
+        return shards_.back().stats.get();
+    }
+
+    void set_ingress(const IngressStats* ingress) {
+        ingress_.store(ingress, std::memory_order_release);
+    }
+
+    // Reporting thread only
+    StatsSnapshot collect() {
+        StatsSnapshot snapshot;
+        snapshot.timestamp_ns = now_ns();
+        snapshot.interval_ns = snapshot.timestamp_ns - last_collect_ns_;
+        last_collect_ns_ = snapshot.timestamp_ns;
+
+        std::vector<uint64_t> counts(LatencyHistogram::BUCKET_COUNT);
+        for (size_t leg = 0; leg < LATENCY_LEG_COUNT; ++leg) {
+            std::fill(counts.begin(), counts.end(), 0);
+            uint64_t max = 0;
+            for (const auto& shard : shards_) {
+                shard.stats->legs[leg].add_counts_to(counts.data());
+                if (shard.stats->legs[leg].max() > max) max = shard.stats->legs[leg].max();
+            }
+
+            // Interval distribution = growth since the previous collect()
+            std::vector<uint64_t>& previous = previous_counts_[leg];
+            if (previous.empty()) previous.assign(LatencyHistogram::BUCKET_COUNT, 0);
+            for (size_t i = 0; i < counts.size(); ++i) {
+                uint64_t total = counts[i];
+                counts[i] = total - previous[i];
+                previous[i] = total;
+            }
+            snapshot.legs[leg] = summarize(counts, max);
+        }
+
+        for (const auto& shard : shards_) {
+            snapshot.events_processed += shard.stats->events_processed.load(std::memory_order_relaxed);
+            snapshot.queue_depth += shard.queue->size_approx();
+            uint64_t depth_max = shard.stats->queue_depth_max.load(std::memory_order_relaxed);
+            if (depth_max > snapshot.queue_depth_max) snapshot.queue_depth_max = depth_max;
+            snapshot.unknown_symbols += shard.stats->unknown_symbols.load(std::memory_order_relaxed);
+        }
+        snapshot.unknown_symbols_interval = snapshot.unknown_symbols - last_unknown_symbols_;
+        last_unknown_symbols_ = snapshot.unknown_symbols;
+
+        const IngressStats* ingress = ingress_.load(std::memory_order_acquire);
+        if (ingress) {
+            snapshot.events_enqueued = ingress->events_enqueued.load(std::memory_order_relaxed);
+            snapshot.events_dropped = ingress->events_dropped.load(std::memory_order_relaxed);
+            snapshot.duplicates_dropped = ingress->duplicates_dropped.load(std::memory_order_relaxed);
+            snapshot.sequence_gaps = ingress->sequence_gaps.load(std::memory_order_relaxed);
+            snapshot.messages_lost = ingress->messages_lost.load(std::memory_order_relaxed);
+        }
+        return snapshot;
+    }
+
+private:
+    struct Shard {
+        std::unique_ptr<ShardStats> stats;
+        const SPSCRingBuffer<OrderBookEvent>* queue;
+    };
+
+    static uint64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static LatencySummary summarize(const std::vector<uint64_t>& counts, uint64_t max_seen) {
+        LatencySummary summary;
+        for (uint64_t count : counts) summary.count += count;
+        if (summary.count == 0) return summary;
+
+        // Rank (1-based) of each percentile
+        uint64_t p50_rank = (summary.count * 50 + 99) / 100;
+        uint64_t p99_rank = (summary.count * 99 + 99) / 100;
+        uint64_t p999_rank = (summary.count * 999 + 999) / 1000;
+
+        uint64_t seen = 0;
+        size_t last_bucket = 0;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            if (counts[i] == 0) continue;
+            seen += counts[i];
+            last_bucket = i;
+            uint64_t value = LatencyHistogram::bucket_upper(i);
+            if (summary.p50 == 0 && seen >= p50_rank) summary.p50 = value;
+            if (summary.p99 == 0 && seen >= p99_rank) summary.p99 = value;
+            if (summary.p999 == 0 && seen >= p999_rank) summary.p999 = value;
+        }
+
+        // The bucket bound can overshoot the largest value actually recorded
+        summary.max = LatencyHistogram::bucket_upper(last_bucket);
+        if (max_seen > 0 && summary.max > max_seen) summary.max = max_seen;
+        if (summary.p50 > summary.max) summary.p50 = summary.max;
+        if (summary.p99 > summary.max) summary.p99 = summary.max;
+        if (summary.p999 > summary.max) summary.p999 = summary.max;
+        return summary;
+    }
+
+    std::vector<Shard> shards_;
+    std::atomic<const IngressStats*> ingress_;
+    std::vector<uint64_t> previous_counts_[LATENCY_LEG_COUNT];
+    uint64_t last_collect_ns_;
+    uint64_t last_unknown_symbols_;
+};
+
+// JSON form used in heartbeats and by the API's /api/stats
+inline std::string stats_snapshot_to_json(const StatsSnapshot& snapshot) {
+    std::ostringstream json;
+    json << "{\"interval_ns\":" << snapshot.interval_ns
+         << ",\"events_processed\":" << snapshot.events_processed
+         << ",\"events_enqueued\":" << snapshot.events_enqueued
+         << ",\"events_dropped\":" << snapshot.events_dropped
+         << ",\"duplicates_dropped\":" << snapshot.duplicates_dropped
+         << ",\"sequence_gaps\":" << snapshot.sequence_gaps
+         << ",\"messages_lost\":" << snapshot.messages_lost
+         << ",\"log_records_dropped\":" << snapshot.log_records_dropped
+         << ",\"queue_depth\":" << snapshot.queue_depth
+         << ",\"queue_depth_max\":" << snapshot.queue_depth_max
+         << ",\"unknown_symbols\":" << snapshot.unknown_symbols
+         << ",\"latency_ns\":{";
+    for (size_t leg = 0; leg < LATENCY_LEG_COUNT; ++leg) {
+        const LatencySummary& s = snapshot.legs[leg];
+        json << (leg ? "," : "") << "\"" << latency_leg_name(leg) << "\":{"
+             << "\"count\":" << s.count << ",\"p50\":" << s.p50 << ",\"p99\":" << s.p99
+             << ",\"p99_9\":" << s.p999 << ",\"max\":" << s.max << "}";
+    }
+    json << "}}";
+    return json.str();
+}
+
+#endif // LATENCY_STATS_HPP
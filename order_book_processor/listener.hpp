@@ -14,7 +14,20 @@
 #include <thread>
 #include <chrono>
 #include <sstream>
+#include <vector>
+#include <sys/uio.h>
+#include <time.h>
+#include <linux/net_tstamp.h>
+#include <linux/errqueue.h>
 #include "quote.hpp"
+#include "feed_decoder.hpp"
+
+// Where udp_rx_mono_ns comes from
+enum class RxTimestampSource {
+    USERSPACE,  // steady_clock when the listener gets to the datagram
+    KERNEL,     // SO_TIMESTAMPNS: when the kernel network stack received the packet
+    HARDWARE    // SO_TIMESTAMPING raw hardware stamp (falls back to software if the NIC gives none)
+};
 
 class UDPListener {
 private:
@@ -23,32 +36,50 @@ private:
     // - Port number
     // - Multicast group (optional)
     // - Buffer for receiving data
-    // - Callback function for quote processing (old, unused)
+    // - Decoder (owns the event/quote callbacks)
     
     int socket_fd_;
     uint16_t port_;
     std::string multicast_group_;
     struct ip_mreq mreq_;
+    std::string line_b_group_;          // Redundant copy of the feed (empty = single line)
+    struct ip_mreq mreq_b_;
     bool is_multicast_;
-    std::function<void(const Quote&)> quote_callback_;
-    std::function<void(const OrderBookEvent&)> order_book_callback_;
     std::atomic<bool>* shutdown_flag_;  // Pointer to global shutdown flag
+    FeedDecoder decoder_;               // Payload parsing and callbacks
+    
+    // Batched receive (recvmmsg) state, preallocated once in setup_batched_receive()
+    static constexpr size_t MAX_DATAGRAM_SIZE = 2048;
+    static constexpr size_t RX_CONTROL_SIZE = CMSG_SPACE(sizeof(struct scm_timestamping));
+    size_t batch_size_;
+    RxTimestampSource rx_timestamp_source_;
+    std::vector<char> rx_buffers_;      // batch_size_ * MAX_DATAGRAM_SIZE
+    std::vector<char> rx_control_;      // batch_size_ * RX_CONTROL_SIZE
+    std::vector<struct iovec> rx_iovecs_;
+    std::vector<struct mmsghdr> rx_msgs_;
+    
+    // Receive statistics (written by the listener thread only)
+    uint64_t datagrams_received_;
+    uint64_t receive_syscalls_;
 
 public:
     // Constructor for unicast
     explicit UDPListener(uint16_t port) 
         : socket_fd_(-1), port_(port), multicast_group_(""), is_multicast_(false),
-          quote_callback_(nullptr), order_book_callback_(nullptr), shutdown_flag_(nullptr) {
+          shutdown_flag_(nullptr), batch_size_(1),
+          rx_timestamp_source_(RxTimestampSource::USERSPACE),
+          datagrams_received_(0), receive_syscalls_(0) {
         // Constructor just initializes member variables
         // socket_fd_ = -1 indicates no socket is open yet
-        // quote_callback_ is set to nullptr initially
         // shutdown_flag_ is set to nullptr initially
     }
     
     // Constructor for multicast
     UDPListener(const std::string& multicast_group, uint16_t port)
         : socket_fd_(-1), port_(port), multicast_group_(multicast_group), is_multicast_(true),
-          quote_callback_(nullptr), order_book_callback_(nullptr), shutdown_flag_(nullptr) {
+          shutdown_flag_(nullptr), batch_size_(1),
+          rx_timestamp_source_(RxTimestampSource::USERSPACE),
+          datagrams_received_(0), receive_syscalls_(0) {
     }
     
     // Destructor
@@ -113,6 +144,21 @@ public:
             
             std::cout << "Multicast listener joined group " << multicast_group_ 
                       << " on port " << port_ << std::endl;
+            
+            // Line B arrives on the same socket; the decoder keeps whichever copy is first
+            if (!line_b_group_.empty()) {
+                mreq_b_.imr_multiaddr.s_addr = inet_addr(line_b_group_.c_str());
+                mreq_b_.imr_interface.s_addr = INADDR_ANY;
+                if (setsockopt(socket_fd_, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq_b_, sizeof(mreq_b_)) < 0) {
+                    std::cerr << "Failed to join line B multicast group " << line_b_group_
+                              << ": " << strerror(errno) << std::endl;
+                    close(socket_fd_);
+                    socket_fd_ = -1;
+                    return false;
+                }
+                std::cout << "Multicast listener joined line B group " << line_b_group_
+                          << " on port " << port_ << std::endl;
+            }
         } else {
             // Verify binding was successful for unicast
             struct sockaddr_in bound_addr;
@@ -135,6 +181,10 @@ public:
                 if (setsockopt(socket_fd_, IPPROTO_IP, IP_DROP_MEMBERSHIP, &mreq_, sizeof(mreq_)) < 0) {
                     std::cerr << "Warning: Failed to leave multicast group: " << strerror(errno) << std::endl;
                 }
+                if (!line_b_group_.empty() &&
+                    setsockopt(socket_fd_, IPPROTO_IP, IP_DROP_MEMBERSHIP, &mreq_b_, sizeof(mreq_b_)) < 0) {
+                    std::cerr << "Warning: Failed to leave line B multicast group: " << strerror(errno) << std::endl;
+                }
                 std::cout << "Multicast listener left group " << multicast_group_ << std::endl;
             }
             
@@ -159,67 +209,29 @@ public:
         }
         std::cout << "Socket FD: " << socket_fd_ << std::endl;
         
+        // Batched receive path (also used whenever kernel timestamps are wanted)
+        if (batch_size_ > 1 || rx_timestamp_source_ != RxTimestampSource::USERSPACE) {
+            listen_batched();
+            return;
+        }
+        
         // Buffer to receive incoming data
-        char buffer[1024];  // size based on data format
-        struct sockaddr_in client_addr;
-        socklen_t client_addr_len = sizeof(client_addr);
+        char buffer[MAX_DATAGRAM_SIZE];
         
         while (true) {  // Keep listening until explicitly told to stop
-            // Clear client address structure
-            memset(&client_addr, 0, sizeof(client_addr));
-            
             // Receive UDP packet (non-blocking with MSG_DONTWAIT)
-            // recvfrom() blocks until data arrives, then copies data to buffer
+            // The sender address is not used, so don't ask the kernel for it
             ssize_t bytes_received = recvfrom(socket_fd_, buffer, sizeof(buffer), 
-                                            MSG_DONTWAIT, 
-                                            (struct sockaddr*)&client_addr, &client_addr_len);
+                                            MSG_DONTWAIT, nullptr, nullptr);
+            ++receive_syscalls_;
             
             if (bytes_received > 0) {
-                // Successfully received data
-                // Parse the received JSON data into an OrderBookEvent structure
-                if (order_book_callback_) {
-                    try {
-                        // Convert buffer to string for parsing
-                        std::string json_str(buffer, bytes_received);
-                        
-                        // Parse JSON into OrderBookEvent
-                        OrderBookEvent event = parse_json_order_book_event(json_str);
-                        
-                        // Monotonic receive timestamp for latency measurement
-                        event.udp_rx_mono_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
-                            std::chrono::steady_clock::now().time_since_epoch()).count();
-                        
-                        // Call the callback function with the parsed event
-                        order_book_callback_(event);
-                        
-                    } catch (const std::exception& e) {
-                        std::cerr << "Error parsing order book event: " << e.what() << std::endl;
-                        std::cerr << "Raw data: " << std::string(buffer, bytes_received) << std::endl;
-                        // Don't crash - continue listening
-                    }
-                }
-                // Legacy quote callback support
-                else if (quote_callback_) {
-                    try {
-                        // Convert buffer to string for parsing
-                        std::string json_str(buffer, bytes_received);
-                        
-                        // Simple JSON parsing (for learning - in production use a proper library)
-                        Quote quote = parse_json_quote(json_str);
-                        
-                        // Monotonic receive timestamp for latency measurement
-                        quote.udp_rx_mono_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
-                            std::chrono::steady_clock::now().time_since_epoch()).count();
-                        
-                        // Call the callback function with the parsed quote
-                        quote_callback_(quote);
-                        
-                    } catch (const std::exception& e) {
-                        std::cerr << "Error parsing quote: " << e.what() << std::endl;
-                        std::cerr << "Raw data: " << std::string(buffer, bytes_received) << std::endl;
-                        // Don't crash - continue listening
-                    }
-                }
+                // Successfully received data; stamp before decoding so UDP→Queue covers the decode
+                ++datagrams_received_;
+                uint64_t rx_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+                decoder_.handle_datagram(buffer, static_cast<size_t>(bytes_received), rx_ns);
+                decoder_.flush();
                 
             } else if (bytes_received == -1) {
                 // Error or no data available
@@ -246,14 +258,88 @@ public:
         std::cout << "UDP listener stopped" << std::endl;
     }
     
-    // Set callback for quote processing
-    void set_quote_callback(std::function<void(const Quote&)> callback) {
-        quote_callback_ = callback;
-    }
-    
     // Set callback for order book event processing
     void set_order_book_callback(std::function<void(const OrderBookEvent&)> callback) {
-        order_book_callback_ = callback;
+        decoder_.set_order_book_callback(callback);
+    }
+    
+    // Decode datagrams straight into the queue's slots (takes precedence over the callbacks)
+    void set_output_queue(SPSCRingBuffer<OrderBookEvent>* queue, QueueWakeup* wakeup = nullptr) {
+        decoder_.set_output_queue(queue, wakeup);
+    }
+    
+    // Sharded form: each event goes to queues[shard_map->shard_for(symbol)]
+    void set_output_queues(const std::vector<SPSCRingBuffer<OrderBookEvent>*>& queues, const ShardMap* shard_map,
+                           const std::vector<QueueWakeup*>& wakeups = {}) {
+        decoder_.set_output_queues(queues, shard_map, wakeups);
+    }
+    
+    // Stamp events with their symbol's interned ID (see SymbolDirectory)
+    void set_symbol_directory(SymbolDirectory* symbols) {
+        decoder_.set_symbol_directory(symbols);
+    }
+    
+    void set_exchange_directory(SymbolDirectory* exchanges) {
+        decoder_.set_exchange_directory(exchanges);
+    }
+    
+    uint64_t get_events_enqueued() const {
+        return decoder_.get_events_enqueued();
+    }
+    
+    uint64_t get_events_dropped() const {
+        return decoder_.get_events_dropped();
+    }
+    
+    // Producer counters for the stats reporter (safe to read from other threads)
+    const IngressStats& get_ingress_stats() const {
+        return decoder_.get_ingress_stats();
+    }
+    
+    // Record every received datagram to a capture file (see feed_capture.hpp)
+    void set_capture(FeedCaptureWriter* capture) {
+        decoder_.set_capture(capture);
+    }
+    
+    // Also join a redundant (B line) group on the same port; call before initialize()
+    void set_line_b_group(const std::string& group) {
+        line_b_group_ = group;
+    }
+    
+    // Drop duplicate sequence numbers and count gaps (default: on)
+    void set_sequence_check(bool enabled) {
+        decoder_.set_sequence_check(enabled);
+    }
+    
+    const SequenceArbiter& get_sequence_arbiter() const {
+        return decoder_.get_sequence_arbiter();
+    }
+
+    const OrderIdTable& get_order_ids() const {
+        return decoder_.get_order_ids();
+    }
+    
+    // Drain up to batch_size datagrams per recvmmsg() call (1 = one recvfrom per datagram)
+    void set_batch_size(size_t batch_size) {
+        batch_size_ = batch_size > 0 ? batch_size : 1;
+    }
+    
+    // Select where receive timestamps come from (default: USERSPACE)
+    void set_rx_timestamp_source(RxTimestampSource source) {
+        rx_timestamp_source_ = source;
+    }
+    
+    uint64_t get_datagrams_received() const {
+        return datagrams_received_;
+    }
+    
+    uint64_t get_receive_syscalls() const {
+        return receive_syscalls_;
+    }
+    
+    // Select the ingress wire format (default: AUTO)
+    void set_feed_format(FeedFormat format) {
+        decoder_.set_feed_format(format);
     }
     
     // Set shutdown flag for graceful shutdown
@@ -275,171 +361,156 @@ public:
     UDPListener& operator=(const UDPListener&) = delete;
 
 private:
-    // Helper function to parse JSON order book events
-    OrderBookEvent parse_json_order_book_event(const std::string& json_str) {
-        OrderBookEvent event;
-
-        auto find_string = [&](const char* key) -> std::string {
-            std::string pattern = std::string("\"") + key + "\"";
-            size_t k = json_str.find(pattern);
-            if (k == std::string::npos) return {};
-            k = json_str.find(':', k);
-            if (k == std::string::npos) return {};
-            // skip spaces
-            while (k + 1 < json_str.size() && (json_str[k+1] == ' ')) ++k;
-            if (k + 2 < json_str.size() && json_str[k+1] == '"') {
-                size_t start = k + 2;
-                size_t end = json_str.find('"', start);
-                if (end == std::string::npos) return {};
-                return json_str.substr(start, end - start);
-            }
-            return {};
-        };
-
-        auto find_number = [&](const char* key) -> std::string {
-            std::string pattern = std::string("\"") + key + "\"";
-            size_t k = json_str.find(pattern);
-            if (k == std::string::npos) return {};
-            k = json_str.find(':', k);
-            if (k == std::string::npos) return {};
-            // move to first digit/sign/decimal
-            size_t i = k + 1;
-            while (i < json_str.size() && (json_str[i] == ' ')) ++i;
-            size_t start = i;
-            while (i < json_str.size() && (std::isdigit(json_str[i]) || json_str[i] == '.' || json_str[i] == '-' )) ++i;
-            return json_str.substr(start, i - start);
-        };
-
-        auto find_bool = [&](const char* key) -> bool {
-            std::string pattern = std::string("\"") + key + "\"";
-            size_t k = json_str.find(pattern);
-            if (k == std::string::npos) return false;
-            k = json_str.find(':', k);
-            if (k == std::string::npos) return false;
-            // skip spaces
-            while (k + 1 < json_str.size() && (json_str[k+1] == ' ')) ++k;
-            if (k + 4 < json_str.size() && json_str.substr(k+1, 4) == "true") return true;
-            if (k + 5 < json_str.size() && json_str.substr(k+1, 5) == "false") return false;
-            return false;
-        };
-
-        // Extract basic fields
-        std::string sym = find_string("symbol");
-        std::string ex = find_string("exchange");
-        std::string event_type_str = find_string("event_type");
-        std::string side_str = find_string("side");
-        std::string order_id = find_string("order_id");
+    // Batched receive loop: one recvmmsg() drains up to batch_size_ datagrams into
+    // the preallocated buffer ring. The socket blocks (with a short SO_RCVTIMEO so
+    // shutdown stays responsive) until at least one datagram is ready, then
+    // MSG_WAITFORONE returns whatever else is already queued without waiting.
+    void listen_batched() {
+        if (!setup_batched_receive()) {
+            return;
+        }
         
-        // Extract numeric fields
-        std::string price_str = find_number("price");
-        std::string size_str = find_number("size");
-        std::string remaining_size_str = find_number("remaining_size");
-        std::string trade_price_str = find_number("trade_price");
-        std::string trade_size_str = find_number("trade_size");
-        std::string ts = find_number("timestamp");
-        std::string seq = find_number("sequence_number");
-        std::string ex_mono = find_number("exchange_mono_ns");
+        std::cout << "Batched receive: up to " << batch_size_ << " datagrams per syscall, "
+                  << (rx_timestamp_source_ == RxTimestampSource::HARDWARE ? "hardware" :
+                      rx_timestamp_source_ == RxTimestampSource::KERNEL ? "kernel" : "userspace")
+                  << " receive timestamps" << std::endl;
         
-        // Extract boolean fields
-        bool is_aggressor = find_bool("is_aggressor");
-        bool is_trading_halted = find_bool("is_trading_halted");
+        while (true) {
+            // msg_controllen is value-result, so re-arm it before every call
+            for (size_t i = 0; i < batch_size_; ++i) {
+                rx_msgs_[i].msg_hdr.msg_controllen = RX_CONTROL_SIZE;
+                rx_msgs_[i].msg_hdr.msg_flags = 0;
+            }
+            
+            int received = recvmmsg(socket_fd_, rx_msgs_.data(), static_cast<unsigned int>(batch_size_),
+                                    MSG_WAITFORONE, nullptr);
+            ++receive_syscalls_;
+            
+            if (received > 0) {
+                uint64_t userspace_rx_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+                
+                // Kernel stamps are CLOCK_REALTIME; map them onto the monotonic
+                // clock the rest of the pipeline uses
+                int64_t realtime_to_mono_ns = 0;
+                if (rx_timestamp_source_ != RxTimestampSource::USERSPACE) {
+                    realtime_to_mono_ns = realtime_to_monotonic_offset();
+                }
+                
+                for (int i = 0; i < received; ++i) {
+                    const struct msghdr& hdr = rx_msgs_[i].msg_hdr;
+                    const char* data = &rx_buffers_[static_cast<size_t>(i) * MAX_DATAGRAM_SIZE];
+                    
+                    if (hdr.msg_flags & MSG_TRUNC) {
+                        std::cerr << "Error parsing order book event: datagram larger than "
+                                  << MAX_DATAGRAM_SIZE << " bytes dropped" << std::endl;
+                        continue;
+                    }
+                    
+                    uint64_t rx_ns = userspace_rx_ns;
+                    if (rx_timestamp_source_ != RxTimestampSource::USERSPACE) {
+                        int64_t kernel_rx_ns = extract_rx_timestamp(hdr);
+                        if (kernel_rx_ns > 0) {
+                            rx_ns = static_cast<uint64_t>(kernel_rx_ns + realtime_to_mono_ns);
+                        }
+                    }
+                    
+                    ++datagrams_received_;
+                    decoder_.handle_datagram(data, rx_msgs_[i].msg_len, rx_ns);
+                }
+                
+                // Publish the whole batch to the output queue at once
+                decoder_.flush();
+            } else if (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                std::cerr << "Error receiving data: " << strerror(errno) << std::endl;
+                break;
+            }
+            
+            // Check shutdown flag periodically for responsive shutdown
+            if (shutdown_flag_ && *shutdown_flag_) {
+                break;
+            }
+        }
         
-        // Extract status message
-        std::string status_msg = find_string("status_message");
-
-        // Set basic fields
-        if (!sym.empty()) event.symbol = sym;
-        if (!ex.empty()) event.exchange = ex;
-        if (!order_id.empty()) event.order_id = order_id;
-        if (!status_msg.empty()) event.status_message = status_msg;
+        std::cout << "UDP listener stopped (" << datagrams_received_ << " datagrams in "
+                  << receive_syscalls_ << " receive calls)" << std::endl;
+    }
+    
+    // Allocate the buffer ring and configure blocking timeout and timestamping
+    bool setup_batched_receive() {
+        rx_buffers_.assign(batch_size_ * MAX_DATAGRAM_SIZE, 0);
+        rx_control_.assign(batch_size_ * RX_CONTROL_SIZE, 0);
+        rx_iovecs_.assign(batch_size_, iovec{});
+        rx_msgs_.assign(batch_size_, mmsghdr{});
         
-        // Parse event type
-        if (event_type_str == "ADD_ORDER") event.event_type = OrderBookEventType::ADD_ORDER;
-        else if (event_type_str == "MODIFY_ORDER") event.event_type = OrderBookEventType::MODIFY_ORDER;
-        else if (event_type_str == "CANCEL_ORDER") event.event_type = OrderBookEventType::CANCEL_ORDER;
-        else if (event_type_str == "DELETE_ORDER") event.event_type = OrderBookEventType::DELETE_ORDER;
-        else if (event_type_str == "TRADE") event.event_type = OrderBookEventType::TRADE;
-        else if (event_type_str == "QUOTE_UPDATE") event.event_type = OrderBookEventType::QUOTE_UPDATE;
-        else if (event_type_str == "MARKET_STATUS") event.event_type = OrderBookEventType::MARKET_STATUS;
-        else event.event_type = OrderBookEventType::UNKNOWN;
+        for (size_t i = 0; i < batch_size_; ++i) {
+            rx_iovecs_[i].iov_base = &rx_buffers_[i * MAX_DATAGRAM_SIZE];
+            rx_iovecs_[i].iov_len = MAX_DATAGRAM_SIZE;
+            rx_msgs_[i].msg_hdr.msg_iov = &rx_iovecs_[i];
+            rx_msgs_[i].msg_hdr.msg_iovlen = 1;
+            rx_msgs_[i].msg_hdr.msg_control = &rx_control_[i * RX_CONTROL_SIZE];
+            rx_msgs_[i].msg_hdr.msg_controllen = RX_CONTROL_SIZE;
+        }
         
-        // Parse side
-        if (side_str == "BID") event.side = OrderSide::BID;
-        else if (side_str == "ASK") event.side = OrderSide::ASK;
-        else event.side = OrderSide::UNKNOWN;
+        // Block for at most 100 ms so the shutdown flag is still checked
+        struct timeval timeout;
+        timeout.tv_sec = 0;
+        timeout.tv_usec = 100000;
+        if (setsockopt(socket_fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) < 0) {
+            std::cerr << "Failed to set SO_RCVTIMEO: " << strerror(errno) << std::endl;
+            return false;
+        }
         
-        // Parse numeric fields
-        if (!price_str.empty()) event.price = std::stod(price_str);
-        if (!size_str.empty()) event.size = static_cast<uint32_t>(std::stoul(size_str));
-        if (!remaining_size_str.empty()) event.remaining_size = static_cast<uint32_t>(std::stoul(remaining_size_str));
-        if (!trade_price_str.empty()) event.trade_price = std::stod(trade_price_str);
-        if (!trade_size_str.empty()) event.trade_size = static_cast<uint32_t>(std::stoul(trade_size_str));
-        if (!ts.empty()) event.timestamp = std::stoull(ts);
-        if (!seq.empty()) event.sequence_number = std::stoull(seq);
-        if (!ex_mono.empty()) event.exchange_mono_ns = std::stoull(ex_mono);
+        if (rx_timestamp_source_ == RxTimestampSource::KERNEL) {
+            int enable = 1;
+            if (setsockopt(socket_fd_, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) < 0) {
+                std::cerr << "Failed to enable SO_TIMESTAMPNS: " << strerror(errno)
+                          << " (using userspace timestamps)" << std::endl;
+                rx_timestamp_source_ = RxTimestampSource::USERSPACE;
+            }
+        } else if (rx_timestamp_source_ == RxTimestampSource::HARDWARE) {
+            // Hardware stamps also need the NIC rx filter enabled (e.g. hwstamp_ctl or ptp4l)
+            // and a PHC synchronized to CLOCK_REALTIME (phc2sys)
+            int flags = SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE |
+                        SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+            if (setsockopt(socket_fd_, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) < 0) {
+                std::cerr << "Failed to enable SO_TIMESTAMPING: " << strerror(errno)
+                          << " (using userspace timestamps)" << std::endl;
+                rx_timestamp_source_ = RxTimestampSource::USERSPACE;
+            }
+        }
         
-        // Set boolean fields
-        event.is_aggressor = is_aggressor;
-        event.is_trading_halted = is_trading_halted;
-
-        return event;
+        return true;
     }
-
-    // Old, unused function for parsing quotes
-    Quote parse_json_quote(const std::string& json_str) {
-        Quote quote;
-
-        auto find_string = [&](const char* key) -> std::string {
-            std::string pattern = std::string("\"") + key + "\"";
-            size_t k = json_str.find(pattern);
-            if (k == std::string::npos) return {};
-            k = json_str.find(':', k);
-            if (k == std::string::npos) return {};
-            // skip spaces
-            while (k + 1 < json_str.size() && (json_str[k+1] == ' ')) ++k;
-            if (k + 2 < json_str.size() && json_str[k+1] == '"') {
-                size_t start = k + 2;
-                size_t end = json_str.find('"', start);
-                if (end == std::string::npos) return {};
-                return json_str.substr(start, end - start);
+    
+    // Receive timestamp (CLOCK_REALTIME ns) from the control messages, 0 if none
+    static int64_t extract_rx_timestamp(const struct msghdr& hdr) {
+        for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(const_cast<struct msghdr*>(&hdr)); cmsg;
+             cmsg = CMSG_NXTHDR(const_cast<struct msghdr*>(&hdr), cmsg)) {
+            if (cmsg->cmsg_level != SOL_SOCKET) continue;
+            
+            if (cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+                struct timespec ts;
+                memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+                return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
             }
-            return {};
-        };
-
-        auto find_number = [&](const char* key) -> std::string {
-            std::string pattern = std::string("\"") + key + "\"";
-            size_t k = json_str.find(pattern);
-            if (k == std::string::npos) return {};
-            k = json_str.find(':', k);
-            if (k == std::string::npos) return {};
-            // move to first digit/sign/decimal
-            size_t i = k + 1;
-            while (i < json_str.size() && (json_str[i] == ' ')) ++i;
-            size_t start = i;
-            while (i < json_str.size() && (std::isdigit(json_str[i]) || json_str[i] == '.' || json_str[i] == '-' )) ++i;
-            return json_str.substr(start, i - start);
-        };
-
-        // Extract fields tolerant to spaces
-        std::string sym = find_string("symbol");
-        std::string ex = find_string("exchange");
-        std::string bid_p = find_number("bid_price");
-        std::string bid_s = find_number("bid_size");
-        std::string ask_p = find_number("ask_price");
-        std::string ask_s = find_number("ask_size");
-        std::string ts = find_number("timestamp");
-        std::string ex_mono = find_number("exchange_mono_ns");
-
-        if (!sym.empty()) quote.symbol = sym; else quote.symbol.clear();
-        if (!ex.empty()) quote.exchange = ex; else quote.exchange.clear();
-        if (!bid_p.empty()) quote.bid_price = std::stod(bid_p); else quote.bid_price = 0.0;
-        if (!bid_s.empty()) quote.bid_size = static_cast<uint32_t>(std::stoul(bid_s)); else quote.bid_size = 0;
-        if (!ask_p.empty()) quote.ask_price = std::stod(ask_p); else quote.ask_price = 0.0;
-        if (!ask_s.empty()) quote.ask_size = static_cast<uint32_t>(std::stoul(ask_s)); else quote.ask_size = 0;
-        if (!ts.empty()) quote.timestamp = std::stoull(ts); else quote.timestamp = 0ULL;
-        if (!ex_mono.empty()) quote.exchange_mono_ns = std::stoull(ex_mono); else quote.exchange_mono_ns = 0ULL;
-
-        return quote;
+            if (cmsg->cmsg_type == SCM_TIMESTAMPING) {
+                // ts[0] = software, ts[2] = raw hardware
+                struct scm_timestamping stamps;
+                memcpy(&stamps, CMSG_DATA(cmsg), sizeof(stamps));
+                const struct timespec& ts = (stamps.ts[2].tv_sec || stamps.ts[2].tv_nsec) ? stamps.ts[2] : stamps.ts[0];
+                return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+            }
+        }
+        return 0;
+    }
+    
+    // CLOCK_MONOTONIC - CLOCK_REALTIME, sampled once per batch
+    static int64_t realtime_to_monotonic_offset() {
+        struct timespec mono, real;
+        clock_gettime(CLOCK_MONOTONIC, &mono);
+        clock_gettime(CLOCK_REALTIME, &real);
+        return (static_cast<int64_t>(mono.tv_sec) - real.tv_sec) * 1000000000LL + (mono.tv_nsec - real.tv_nsec);
     }
 };
 
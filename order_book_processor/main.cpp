@@ -6,22 +6,51 @@
 
 #include "queue.hpp"
 #include "listener.hpp"
+#include "xdp_listener.hpp"
+#include "replay_listener.hpp"
+#include "feed_capture.hpp"
+#include "cpu_affinity.hpp"
+#include "wait_strategy.hpp"
 #include "quote.hpp"
 #include "orderbook.hpp"
+#include "tick_order_book.hpp"
 #include "multicast_publisher.hpp"
-#include <map>
+#include "processor_config.hpp"
+#include "shard_map.hpp"
+#include "async_logger.hpp"
+#include "latency_stats.hpp"
+#include "top_of_book_conflator.hpp"
+#include "book_analytics.hpp"
+#include "book_snapshot.hpp"
+#include "symbol_directory.hpp"
+#include <algorithm>
 #include <set>
+#include <memory>
+#include <vector>
 
 // Global flag for graceful shutdown
 std::atomic<bool> shutdown_flag{false};
 
+// Global processor configuration (parsed from the command line)
+ProcessorConfig config;
 
-// Global order books for each symbol
-std::map<std::string, OrderBook> order_books;
 
+// Max events the consumer processes before releasing their slots
+constexpr size_t CONSUMER_BATCH = 64;
 
-// Global multicast publisher
-std::unique_ptr<MulticastPublisher> multicast_publisher;
+// Longest a sleeping consumer waits for its producer before running its timers
+constexpr uint32_t CONSUMER_SLEEP_US = 1000;
+
+// One consumer shard: its own queue, publisher socket and (inside the thread) order books.
+// Nothing is shared between shards, so they scale without contending with each other.
+struct ConsumerShard {
+    std::unique_ptr<SPSCRingBuffer<OrderBookEvent>> queue;
+    std::unique_ptr<QueueWakeup> wakeup;  // Producer's doorbell (--wait hybrid|block only)
+    std::unique_ptr<MulticastPublisher> publisher;
+    LogWriter* log = nullptr;
+    ShardStats* stats = nullptr;        // Owned by the StatsCollector
+    std::thread thread;
+};
 
 // Signal handler for graceful shutdown
 void signal_handler(int signal) {
@@ -32,187 +61,555 @@ void signal_handler(int signal) {
 }
 
 // Producer function - runs in main thread
-void ingress_producer(SPSCRingBuffer<OrderBookEvent>& queue, UDPListener& listener) {
+// Listener is any ingress backend (UDPListener, XDPListener): it needs
+// set_output_queue() and a blocking listen() that honours the shutdown flag
+// With several shards each event is routed by symbol (see ShardMap)
+// exchanges (nullptr = not needed) tags events with their sequence channel
+template<typename Listener>
+void ingress_producer(std::vector<ConsumerShard>& shards, const ShardMap& shard_map, SymbolDirectory& symbols,
+                      SymbolDirectory* exchanges, Listener& listener, StatsCollector& stats_collector) {
     std::cout << "Starting ingress producer..." << std::endl;
     
-    // Producer statistics (atomic counters, no printing)
-    static std::atomic<uint64_t> events_pushed{0};
-    static std::atomic<uint64_t> total_push_latency{0};
-    static std::atomic<uint64_t> events_dropped{0};
+    // Pin before the hot loop starts so the thread never migrates mid-burst
+    if (config.ingress_cpu >= 0 && pin_current_thread(config.ingress_cpu)) {
+        std::cout << "Ingress thread pinned to CPU " << config.ingress_cpu << std::endl;
+    }
+    if (config.rt_priority > 0 && set_current_thread_realtime(config.rt_priority)) {
+        std::cout << "Ingress thread running SCHED_FIFO at priority " << config.rt_priority << std::endl;
+    }
     
-    // Set callback to push order book events to queue
-    listener.set_order_book_callback([&queue](const OrderBookEvent& event) {
-        // Monotonic timestamp for enqueue event
-        auto enq_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
-            std::chrono::steady_clock::now().time_since_epoch()).count();
-        
-        // Prepare a copy to store enqueue timestamp (SPSC copies anyway)
-        OrderBookEvent e = event;
-        e.enqueued_mono_ns = enq_ns;
-        
-        // Try to push event to ring buffer
-        if (queue.try_push(e)) {
-            // Successfully pushed event to queue - just update counters
-            // No printing from producer thread (one writer rule)
-            uint64_t udp_to_queue = (e.udp_rx_mono_ns > 0 && static_cast<uint64_t>(enq_ns) >= e.udp_rx_mono_ns)
-                ? (static_cast<uint64_t>(enq_ns) - e.udp_rx_mono_ns) : 0ULL;
-            events_pushed.fetch_add(1, std::memory_order_relaxed);
-            total_push_latency.fetch_add(udp_to_queue, std::memory_order_relaxed);
-        } else {
-            // Queue is full - just update error counter
-            // No printing from producer thread
-            events_dropped.fetch_add(1, std::memory_order_relaxed);
+    // Decode straight into ring slots (one cache line each): no intermediate copy.
+    // Shards that sleep while idle get rung after each receive batch.
+    if (shards.size() == 1) {
+        listener.set_output_queue(shards[0].queue.get(), shards[0].wakeup.get());
+    } else {
+        std::vector<SPSCRingBuffer<OrderBookEvent>*> queues;
+        std::vector<QueueWakeup*> wakeups;
+        for (auto& shard : shards) {
+            queues.push_back(shard.queue.get());
+            wakeups.push_back(shard.wakeup.get());
         }
-    });
+        listener.set_output_queues(queues, &shard_map, wakeups);
+    }
+    // Symbols become dense IDs here, before any queue, book or publisher sees them
+    listener.set_symbol_directory(&symbols);
+    listener.set_exchange_directory(exchanges);
+    
+    stats_collector.set_ingress(&listener.get_ingress_stats());
     
     // Start listening
     listener.listen();
+    
+    std::cout << "Ingress producer stopped (" << listener.get_events_enqueued() << " enqueued, "
+              << listener.get_events_dropped() << " dropped)" << std::endl;
+    for (const auto& channel : listener.get_sequence_arbiter().get_channels()) {
+        std::cout << "Feed channel " << channel.name << ": " << channel.accepted << " accepted, "
+                  << channel.duplicates << " duplicates, " << channel.gaps << " gaps ("
+                  << channel.messages_lost << " messages lost), " << channel.resets << " resets" << std::endl;
+    }
+    const OrderIdTable& order_ids = listener.get_order_ids();
+    if (order_ids.get_collisions() + order_ids.get_untracked() > 0) {
+        std::cout << "Order IDs: " << order_ids.get_collisions() << " hash collisions resolved, "
+                  << order_ids.get_untracked() << " untracked (table full)" << std::endl;
+    }
 }
 
-// Consumer function - runs in separate thread
-void print_consumer(SPSCRingBuffer<OrderBookEvent>& queue) {
-    std::cout << "Starting print consumer..." << std::endl;
+// Stats reporter - runs in its own thread, off the hot path
+// Every interval it turns the shards' histograms into a percentile snapshot,
+// attaches it to a heartbeat (for the API) and hands it to the logger
+void stats_reporter(StatsCollector& stats_collector, const AsyncLogger& logger, LogWriter* log,
+                    MulticastPublisher* heartbeat_publisher) {
+    const auto interval = std::chrono::milliseconds(config.stats_interval_ms);
+    auto next_report = std::chrono::steady_clock::now() + interval;
+    uint64_t last_processed = 0;
     
     while (!shutdown_flag.load()) {
-        OrderBookEvent event;
+        // Short sleeps keep shutdown responsive with long intervals
+        auto now = std::chrono::steady_clock::now();
+        if (now < next_report) {
+            std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+                next_report - now, std::chrono::milliseconds(50)));
+            continue;
+        }
+        next_report += interval;
         
-        // Try to pop event from queue
-        if (queue.try_pop(event)) {
-            // Get current monotonic timestamp when strategy thread sees the event
-            auto deq_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
-                std::chrono::steady_clock::now().time_since_epoch()).count();
-            
-            // Calculate latency metrics (monotonic, single epoch)
-            uint64_t exch_to_udp = (event.exchange_mono_ns > 0 && event.udp_rx_mono_ns >= event.exchange_mono_ns)
-                ? (event.udp_rx_mono_ns - event.exchange_mono_ns) : 0ULL;
-            uint64_t udp_to_queue = (event.enqueued_mono_ns >= event.udp_rx_mono_ns)
-                ? (event.enqueued_mono_ns - event.udp_rx_mono_ns) : 0ULL;
-            uint64_t queue_to_strategy = (static_cast<uint64_t>(deq_ns) >= event.enqueued_mono_ns)
-                ? (static_cast<uint64_t>(deq_ns) - event.enqueued_mono_ns) : 0ULL;
-            uint64_t total_latency = exch_to_udp + udp_to_queue + queue_to_strategy;
-            
-            // Update statistics counters
-            static uint64_t total_events = 0;
-            static uint64_t total_exchange_latency = 0;
-            static uint64_t total_queue_latency = 0;
-            static uint64_t total_strategy_latency = 0;
-            static uint64_t total_end_to_end = 0;
-            
-            total_events++;
-            total_exchange_latency += exch_to_udp;
-            total_queue_latency += udp_to_queue;
-            total_strategy_latency += queue_to_strategy;
-            total_end_to_end += total_latency;
-            
-            // Update order book based on event type
-            if (event.symbol.empty()) {
-                std::cout << "Warning: Received event with empty symbol" << std::endl;
+        StatsSnapshot snapshot = stats_collector.collect();
+        snapshot.log_records_dropped = logger.get_dropped();
+        
+        if (heartbeat_publisher) {
+            heartbeat_publisher->publish_heartbeat(stats_snapshot_to_json(snapshot));
+        }
+        
+        // Only log intervals that saw traffic
+        if (log && snapshot.events_processed != last_processed) {
+            if (LogRecord* record = log->begin_record()) {
+                record->type = LogRecordType::PERFORMANCE_STATS;
+                record->stats = snapshot;
+                log->end_record();
+            }
+        }
+        last_processed = snapshot.events_processed;
+    }
+}
+
+// One symbol's book and where it stands in the feed (for snapshots)
+template<typename Book>
+struct SymbolBook {
+    Book book;
+    BookSequenceState sequence;
+    
+    explicit SymbolBook(Book&& b) : book(std::move(b)) {}
+};
+
+// Empty book for a symbol, its node slabs drawn from the shard's arena
+template<typename Book>
+Book make_book(const std::string& symbol, BookArena* arena);
+
+template<>
+OrderBook make_book<OrderBook>(const std::string&, BookArena* arena) {
+    OrderBook book;
+    book.set_arena(arena);
+    book.reserve(config.book_orders, config.book_levels);
+    book.set_depth_levels(config.depth_levels);
+    return book;
+}
+
+template<>
+TickOrderBook make_book<TickOrderBook>(const std::string& symbol, BookArena* arena) {
+    TickOrderBook book(config.tick_size_for(symbol), TickOrderBook::DEFAULT_LADDER_SLOTS, config.max_ladder_ticks);
+    book.set_arena(arena);
+    book.reserve(config.book_orders, config.book_levels);
+    book.set_depth_levels(config.depth_levels);
+    return book;
+}
+
+// A shard's books, indexed by symbol ID (null = not seen on this shard).
+// Each book is allocated once and never moves.
+template<typename Book>
+using SymbolBooks = std::vector<std::unique_ptr<SymbolBook<Book>>>;
+
+// Look up (or lazily create) the book for a symbol
+template<typename Book>
+SymbolBook<Book>& find_book(SymbolBooks<Book>& books, SymbolId symbol_id, const SymbolDirectory& symbols,
+                            BookArena* arena) {
+    if (symbol_id >= books.size()) {
+        books.resize(static_cast<size_t>(symbol_id) + 1);
+    }
+    if (!books[symbol_id]) {
+        books[symbol_id] = std::make_unique<SymbolBook<Book>>(make_book<Book>(symbols.name(symbol_id), arena));
+    }
+    return *books[symbol_id];
+}
+
+// Load the snapshots of every symbol this shard owns. Runs before the consumer
+// loop, so live events wait in the queue meanwhile and are then replayed
+// against the restored books.
+template<typename Book>
+void restore_books(SymbolBooks<Book>& books, SymbolDirectory& symbols, SymbolDirectory& exchanges, BookArena* arena,
+                   const std::string& dir, const ShardMap& shard_map, size_t shard) {
+    auto start = std::chrono::steady_clock::now();
+    size_t restored = 0;
+    size_t orders = 0;
+    std::vector<char> data;
+    
+    for (const auto& symbol : list_book_snapshots(dir)) {
+        if (!is_snapshot_symbol(symbol) || shard_map.shard_for(symbol) % config.shard_count != shard) {
+            continue;
+        }
+        std::string path = book_snapshot_path(dir, symbol);
+        if (!read_book_snapshot(path, data)) {
+            continue;
+        }
+        SymbolId symbol_id = symbols.intern(symbol);
+        if (symbol_id == INVALID_SYMBOL_ID) {
+            std::cerr << "Ignoring snapshot " << path << ": symbol directory full" << std::endl;
+            continue;
+        }
+        SymbolBook<Book>& entry = find_book(books, symbol_id, symbols, arena);
+        std::string snapshot_symbol;
+        if (!decode_book_snapshot(data.data(), data.size(), snapshot_symbol, entry.book, entry.sequence, exchanges) ||
+            snapshot_symbol != symbol) {
+            std::cerr << "Ignoring malformed snapshot " << path << std::endl;
+            books[symbol_id].reset();
+            continue;
+        }
+        ++restored;
+        orders += entry.book.get_total_orders();
+    }
+    
+    if (restored > 0) {
+        std::cout << "Shard " << shard << " restored " << restored << " books (" << orders << " orders) from "
+                  << dir << " in " << std::chrono::duration_cast<std::chrono::microseconds>(
+                         std::chrono::steady_clock::now() - start).count() << " us" << std::endl;
+    }
+}
+
+// Consumer function - runs in separate thread (one per shard)
+// Book is the order book backend (OrderBook or TickOrderBook)
+// wakeup is the producer's doorbell when idle consumers sleep (nullptr = they poll)
+// log is this shard's async log ring (nullptr with --verbosity quiet)
+// stats receives this shard's latency histograms (read by the stats reporter)
+// snapshot_writer (nullptr = no --snapshot-dir) persists the books periodically;
+// exchanges names the sequence channels recorded in them
+template<typename Book>
+void print_consumer(SPSCRingBuffer<OrderBookEvent>& queue, QueueWakeup* wakeup,
+                    MulticastPublisher* multicast_publisher, LogWriter* log, ShardStats& stats,
+                    const ShardMap& shard_map, SymbolDirectory& symbols, SymbolDirectory& exchanges,
+                    SnapshotWriter* snapshot_writer, size_t shard) {
+    std::cout << "Starting print consumer..." << std::endl;
+    
+    if (shard < config.shard_cpus.size() && pin_current_thread(config.shard_cpus[shard])) {
+        std::cout << "Consumer shard " << shard << " pinned to CPU " << config.shard_cpus[shard] << std::endl;
+        // The ring was built by the main thread; move it next to the core that drains it
+        int node = bind_memory_to_local_node(queue.storage(), queue.storage_bytes());
+        if (node >= 0) {
+            std::cout << "Consumer shard " << shard << " queue on NUMA node " << node << std::endl;
+        }
+    }
+    if (config.rt_priority > 0 && set_current_thread_realtime(config.rt_priority)) {
+        std::cout << "Consumer shard " << shard << " running SCHED_FIFO at priority " << config.rt_priority
+                  << std::endl;
+    }
+    
+    // Book node slabs come out of one prefaulted, huge-page arena per shard
+    // (--arena-mb), mapped here so its pages land on this core's NUMA node
+    BookArena book_arena;
+    BookArena* arena = nullptr;
+    if (config.arena_mb > 0 && book_arena.initialize(config.arena_mb << 20)) {
+        arena = &book_arena;
+        std::cout << "Shard " << shard << " book arena: " << (book_arena.get_size() >> 20) << " MB"
+                  << (book_arena.uses_huge_pages() ? " (huge pages)" : "") << std::endl;
+    }
+    
+    // Order books for each symbol routed to this shard (owned by the consumer thread).
+    // Books and their node pools are allocated here, after pinning, so first touch
+    // places them on this core's NUMA node.
+    SymbolBooks<Book> order_books;
+    
+    // Top-of-book changes are conflated per symbol and published in packed batches
+    TopOfBookConflator conflator(symbols);
+    
+    // Rolling VWAP, microprice, depth imbalance and order-flow imbalance, kept up to
+    // date per event and published with the top of book (--analytics-window-ms)
+    BookAnalytics analytics(symbols, config.analytics_window_ms);
+    
+    // Start from the last snapshot, if any; restored books go out with the first publish
+    if (snapshot_writer) {
+        restore_books(order_books, symbols, exchanges, arena, snapshot_writer->get_directory(), shard_map, shard);
+        for (size_t id = 0; id < order_books.size(); ++id) {
+            if (order_books[id]) {
+                conflator.update(static_cast<SymbolId>(id), order_books[id]->book);
+                analytics.update(static_cast<SymbolId>(id), order_books[id]->book, order_books[id]->sequence.last_timestamp);
+            }
+        }
+    }
+    uint64_t replay_skipped = 0;        // Live events already contained in a snapshot
+    uint64_t stale_snapshots = 0;       // Snapshots dropped because the feed restarted
+    const auto snapshot_interval = std::chrono::milliseconds(config.snapshot_interval_ms);
+    auto next_snapshot = std::chrono::steady_clock::now() + snapshot_interval;
+    std::vector<char> snapshot_buffer;
+    
+    // Idle waits stay short enough for --conflate-us flushes and snapshot timers
+    uint32_t sleep_us = CONSUMER_SLEEP_US;
+    if (config.conflate_interval_us > 0 && config.conflate_interval_us < sleep_us) {
+        sleep_us = config.conflate_interval_us;
+    }
+    IdleWaiter idle_waiter(config.consumer_wait, wakeup, sleep_us);
+    
+    // Serialize every book changed since the last snapshot; the writer thread does the file I/O
+    auto take_snapshots = [&]() {
+        uint64_t written_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        for (size_t id = 0; id < order_books.size(); ++id) {
+            SymbolBook<Book>* entry = order_books[id].get();
+            const std::string& symbol = symbols.name(static_cast<SymbolId>(id));
+            if (!entry || !entry->sequence.unsaved || !is_snapshot_symbol(symbol)) {
                 continue;
             }
-            
-            OrderBook& book = order_books[event.symbol];
-            
-            switch (event.event_type) {
-                case OrderBookEventType::ADD_ORDER:
-                    // O(1) add order by order_id
-                    book.add_order(event.order_id, event.side, event.price, event.size, 
-                                 event.symbol, event.timestamp);
-                    break;
-                case OrderBookEventType::MODIFY_ORDER:
-                    // O(1) modify order by order_id
-                    book.modify_order(event.order_id, event.size);
-                    break;
-                case OrderBookEventType::CANCEL_ORDER:
-                    // O(1) cancel order by order_id
-                    book.cancel_order(event.order_id);
-                    break;
-                case OrderBookEventType::DELETE_ORDER:
-                    // O(1) cancel order by order_id
-                    book.cancel_order(event.order_id);
-                    break;
-                case OrderBookEventType::TRADE:
-                    // Trades don't directly modify the order book in this simple implementation
-                    // API is now standalone - no direct updates needed
-                    
-                    // Publish trade to multicast
-                    if (multicast_publisher) {
-                        multicast_publisher->publish_trade_update(event.symbol, event.trade_price, 
-                                                               event.trade_size,
-                                                               event.is_aggressor ? OrderSide::BID : OrderSide::ASK,
-                                                               event.timestamp);
-                    }
-                    break;
-                default:
-                    break;
+            encode_book_snapshot(snapshot_buffer, symbol, entry->book, entry->sequence, exchanges, written_ns);
+            snapshot_writer->submit(symbol, std::move(snapshot_buffer));
+            snapshot_buffer = std::vector<char>();
+            entry->sequence.unsaved = false;
+        }
+    };
+    const auto conflate_interval = std::chrono::microseconds(config.conflate_interval_us);
+    auto last_flush = std::chrono::steady_clock::now();
+    bool trades_pending = false;        // Trades queued on the publisher since the last send
+    bool trade_moved_book = false;      // A pending trade executed against a book
+    uint64_t trades_executed = 0;       // Trades that filled a resting order
+    uint64_t trades_unmatched = 0;      // Trades naming no order resting here
+    
+    // At batch end: queue conflated top of book and analytics (if due, or force) and
+    // send everything queued on the publisher with one sendmmsg()
+    auto publish_pending = [&](bool force) {
+        bool book_dirty = conflator.has_dirty() || analytics.has_dirty();
+        if (!multicast_publisher || (!book_dirty && !trades_pending)) {
+            return;
+        }
+        auto now = std::chrono::steady_clock::now();
+        // A trade that moved a book goes out in the same batch as the BBO change it caused
+        bool book_due = book_dirty && (force || trade_moved_book || now - last_flush >= conflate_interval);
+        if (book_due) {
+            uint64_t timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                now.time_since_epoch()).count();
+            conflator.flush(*multicast_publisher, timestamp);
+            analytics.flush(*multicast_publisher, timestamp);
+            last_flush = now;
+        }
+        if (book_due || trades_pending) {
+            multicast_publisher->flush();
+            trades_pending = false;
+            trade_moved_book = false;
+            stats.record(LatencyLeg::PUBLISH, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - now).count());
+        }
+    };
+    
+    // Process one event in place (it lives in a queue slot until released)
+    auto process_event = [&](const OrderBookEvent& event) {
+        // Get current monotonic timestamp when strategy thread sees the event
+        auto deq_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        
+        // Calculate latency metrics (monotonic, single epoch)
+        uint64_t exch_to_udp = (event.exchange_mono_ns > 0 && event.udp_rx_mono_ns >= event.exchange_mono_ns)
+            ? (event.udp_rx_mono_ns - event.exchange_mono_ns) : 0ULL;
+        uint64_t udp_to_queue = event.enqueue_delay_ns;
+        uint64_t queue_to_strategy = (static_cast<uint64_t>(deq_ns) >= event.enqueued_mono_ns())
+            ? (static_cast<uint64_t>(deq_ns) - event.enqueued_mono_ns()) : 0ULL;
+        uint64_t total_latency = exch_to_udp + udp_to_queue + queue_to_strategy;
+        
+        // Record latency distributions (per shard)
+        stats.count_event();
+        stats.record(LatencyLeg::EXCHANGE_TO_UDP, exch_to_udp);
+        stats.record(LatencyLeg::UDP_TO_QUEUE, udp_to_queue);
+        stats.record(LatencyLeg::QUEUE_TO_STRATEGY, queue_to_strategy);
+        stats.record(LatencyLeg::END_TO_END, total_latency);
+        
+        // Update order book based on event type
+        if (event.symbol_id == INVALID_SYMBOL_ID) {
+            // Counted; the stats reporter warns once per interval
+            stats.count_unknown_symbol();
+            return;
+        }
+        
+        const std::string& symbol = symbols.name(event.symbol_id);
+        SymbolBook<Book>& entry = find_book(order_books, event.symbol_id, symbols, arena);
+        Book& book = entry.book;
+        
+        // Replay against a restored book: skip what the snapshot already contains
+        // (each event is judged against its own channel's point)
+        if (entry.sequence.replaying > 0 && config.sequence_check) {
+            SnapshotReplay replay = check_snapshot_replay(entry.sequence, event.exchange_id, event.sequence_number,
+                                                          event.timestamp);
+            if (replay == SnapshotReplay::SKIP) {
+                ++replay_skipped;
+                return;
             }
-                        
-            // Publish to multicast
-            if (multicast_publisher) {
-                uint64_t timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
-                    std::chrono::steady_clock::now().time_since_epoch()).count();
-                multicast_publisher->publish_order_book_update(event.symbol, book, timestamp);
+            if (replay == SnapshotReplay::STALE) {
+                // Start the symbol over: its published depth and analytics came from the dropped book
+                book.clear();
+                entry.sequence.reset();
+                conflator.reset(event.symbol_id);
+                analytics.reset(event.symbol_id);
+                ++stale_snapshots;
             }
-            
-            // Print event information
-            std::cout << "\n=== ORDER BOOK EVENT RECEIVED ===" << std::endl;
-            std::cout << "Symbol: " << event.symbol << std::endl;
-            std::cout << "Event Type: " << static_cast<int>(event.event_type) << std::endl;
-            std::cout << "Order ID: " << event.order_id << std::endl;
-            std::cout << "Side: " << static_cast<int>(event.side) << std::endl;
-            std::cout << "Price: " << event.price << std::endl;
-            std::cout << "Size: " << event.size << std::endl;
-            
-            if (event.event_type == OrderBookEventType::TRADE) {
-                std::cout << "Trade Price: " << event.trade_price << std::endl;
-                std::cout << "Trade Size: " << event.trade_size << std::endl;
-                std::cout << "Is Aggressor: " << (event.is_aggressor ? "Yes" : "No") << std::endl;
+        }
+        
+        switch (event.event_type) {
+            case OrderBookEventType::ADD_ORDER:
+                // O(1) add order by order_id
+                book.add_order(event.order_id, event.side, event.get_price(), event.size, event.timestamp);
+                break;
+            case OrderBookEventType::MODIFY_ORDER:
+                // O(1) modify order by order_id
+                book.modify_order(event.order_id, event.size);
+                break;
+            case OrderBookEventType::CANCEL_ORDER:
+                // O(1) cancel order by order_id
+                book.cancel_order(event.order_id);
+                break;
+            case OrderBookEventType::DELETE_ORDER:
+                // O(1) cancel order by order_id
+                book.cancel_order(event.order_id);
+                break;
+            case OrderBookEventType::TRADE: {
+                // Fill the resting order the trade names, so the book stays right without
+                // waiting for a cancel; the aggressor is judged against the pre-trade BBO
+                double pre_trade_bid = book.get_best_bid().first;
+                double pre_trade_ask = book.get_best_ask().first;
+                OrderSide resting_side = OrderSide::UNKNOWN;
+                if (book.execute_order(event.order_id, event.size, &resting_side)) {
+                    ++trades_executed;
+                    trade_moved_book = true;
+                } else {
+                    ++trades_unmatched;
+                }
+                OrderSide aggressor = infer_aggressor_side(resting_side, event.side, event.is_aggressor(),
+                                                           event.get_price(), pre_trade_bid, pre_trade_ask);
+                analytics.add_trade(event.symbol_id, event.get_price(), event.size, event.timestamp);
+                
+                // Queue trade for multicast (trades are not conflated; sent at batch end)
+                if (multicast_publisher) {
+                    multicast_publisher->publish_trade_update(event.symbol_id, symbol, event.get_price(),
+                                                              event.size, aggressor, event.timestamp);
+                    trades_pending = true;
+                }
+                break;
             }
-            
-            // Show current order book state
-            auto best_bid = book.get_best_bid();
-            auto best_ask = book.get_best_ask();
-            double spread = book.get_spread();
-            
-            std::cout << "--- CURRENT ORDER BOOK ---" << std::endl;
-            std::cout << "Best Bid: " << best_bid.first << " x " << best_bid.second << std::endl;
-            std::cout << "Best Ask: " << best_ask.first << " x " << best_ask.second << std::endl;
-            std::cout << "Spread: " << spread << std::endl;
-            
-            std::cout << "--- LATENCY BREAKDOWN ---" << std::endl;
-            std::cout << "Exchange → UDP Receive: " << exch_to_udp << " ns (" 
-                      << (exch_to_udp / 1000.0) << " μs)" << std::endl;
-            std::cout << "UDP Receive → Queue: " << udp_to_queue << " ns (" 
-                      << (udp_to_queue / 1000.0) << " μs)" << std::endl;
-            std::cout << "Queue → Strategy: " << queue_to_strategy << " ns (" 
-                      << (queue_to_strategy / 1000.0) << " μs)" << std::endl;
-            std::cout << "TOTAL LATENCY: " << total_latency << " ns (" 
-                      << (total_latency / 1000.0) << " μs)" << std::endl;
-            
-            // Print statistics every 10 events
-            if (total_events % 10 == 0) {
-                std::cout << "\n📊 PERFORMANCE STATISTICS (Last " << total_events << " events):" << std::endl;
-                std::cout << "Avg Exchange→UDP: " << (total_exchange_latency / total_events) << " ns" << std::endl;
-                std::cout << "Avg UDP→Queue: " << (total_queue_latency / total_events) << " ns" << std::endl;
-                std::cout << "Avg Queue→Strategy: " << (total_strategy_latency / total_events) << " ns" << std::endl;
-                std::cout << "Avg Total Latency: " << (total_end_to_end / total_events) << " ns" << std::endl;
+            default:
+                break;
+        }
+                    
+        entry.sequence.applied(event.exchange_id, event.sequence_number, event.timestamp);
+        
+        // Mark the symbol for publication if its top of book moved
+        conflator.update(event.symbol_id, book);
+        analytics.update(event.symbol_id, book, event.timestamp);
+        
+        // Hand the event to the logger thread as a fixed-size record; formatting and
+        // stdout writes happen there, never on this thread. Statistics come from the
+        // stats reporter thread.
+        if (log && config.verbosity == Verbosity::EVENTS) {
+            if (LogRecord* record = log->begin_record()) {
+                auto best_bid = book.get_best_bid();
+                auto best_ask = book.get_best_ask();
                 
-                // Note: Producer statistics are tracked but not accessible from consumer
-                // This maintains the one writer rule - only consumer prints
-                std::cout << "Producer Stats - Pushed: [tracked], Dropped: [tracked], Avg Push Latency: [tracked]" << std::endl;
-                std::cout << "=====================" << std::endl;
+                record->type = LogRecordType::ORDER_BOOK_EVENT;
+                LogEventFields& fields = record->event;
+                fields.event_type = event.event_type;
+                fields.side = event.side;
+                fields.is_aggressor = event.is_aggressor();
+                fields.set_symbol(symbol);
+                fields.order_id = event.order_id;
+                if (event.event_type == OrderBookEventType::TRADE) {
+                    fields.trade_price = event.get_price();
+                    fields.trade_size = event.size;
+                } else {
+                    fields.price = event.get_price();
+                    fields.size = event.size;
+                }
+                fields.best_bid_price = best_bid.first;
+                fields.best_bid_size = best_bid.second;
+                fields.best_ask_price = best_ask.first;
+                fields.best_ask_size = best_ask.second;
+                fields.spread = book.get_spread();
+                fields.exchange_to_udp_ns = exch_to_udp;
+                fields.udp_to_queue_ns = udp_to_queue;
+                fields.queue_to_strategy_ns = queue_to_strategy;
+                fields.total_latency_ns = total_latency;
+                log->end_record();
             }
+        }
+    };
+    
+    while (!shutdown_flag.load()) {
+        // Drain what is ready, in place, and hand the slots back with one store
+        size_t ready = queue.readable();
+        if (ready > CONSUMER_BATCH) {
+            ready = CONSUMER_BATCH;
+        }
+        
+        if (ready > 0) {
+            stats.observe_queue_depth(ready);
+            for (size_t i = 0; i < ready; ++i) {
+                process_event(*queue.peek(i));
+            }
+            queue.release(ready);
+        }
+        
+        // Trades and conflated top of book go out at batch end
+        // (top of book at most once per --conflate-us)
+        publish_pending(false);
+        
+        if (snapshot_writer && snapshot_interval.count() > 0 && std::chrono::steady_clock::now() >= next_snapshot) {
+            take_snapshots();
+            next_snapshot += snapshot_interval;
+        }
+        
+        if (ready == 0) {
+            // No events available: yield, spin or sleep per --wait
+            idle_waiter.idle([&queue]() { return queue.readable() > 0; });
         } else {
-            // No events available - yield CPU to other threads
-            // This prevents busy-waiting and reduces CPU usage
-            std::this_thread::yield();
+            idle_waiter.busy();
+        }
+    }
+    
+    publish_pending(true);
+    if (snapshot_writer) {
+        take_snapshots();  // Final state, so a restart picks up exactly here
+        if (replay_skipped > 0 || stale_snapshots > 0) {
+            std::cout << "Shard " << shard << " snapshot replay: " << replay_skipped << " events skipped, "
+                      << stale_snapshots << " stale snapshots dropped" << std::endl;
+        }
+    }
+    if (conflator.get_updates_seen() > 0) {
+        std::cout << "Shard " << shard << " top of book: " << conflator.get_updates_seen() << " updates, "
+                  << conflator.get_updates_published() << " published, " << conflator.get_depth_updates_published()
+                  << " depth updates" << std::endl;
+    }
+    if (analytics.get_updates_published() > 0) {
+        std::cout << "Shard " << shard << " analytics: " << analytics.get_updates_published() << " updates published ("
+                  << analytics.get_window_ms() << " ms window)" << std::endl;
+    }
+    uint64_t unknown_symbols = stats.unknown_symbols.load(std::memory_order_relaxed);
+    if (unknown_symbols > 0) {
+        std::cout << "Shard " << shard << " unknown symbols: " << unknown_symbols
+                  << " events with empty, unknown or over-long symbol dropped" << std::endl;
+    }
+    if (trades_executed + trades_unmatched > 0) {
+        std::cout << "Shard " << shard << " trades: " << trades_executed << " executed against resting orders, "
+                  << trades_unmatched << " unmatched" << std::endl;
+    }
+    
+    // Pool sizing feedback for --book-orders, --book-levels and --arena-mb
+    BookPoolStats peak;
+    size_t book_count = 0;
+    uint64_t rejected_prices = 0;
+    for (const auto& entry : order_books) {
+        if (!entry) continue;
+        BookPoolStats pools = entry->book.get_pool_stats();
+        peak.orders_high_water = std::max(peak.orders_high_water, pools.orders_high_water);
+        peak.levels_high_water = std::max(peak.levels_high_water, pools.levels_high_water);
+        rejected_prices += entry->book.get_rejected_prices();
+        ++book_count;
+    }
+    if (rejected_prices > 0) {
+        std::cout << "Shard " << shard << " rejected prices: " << rejected_prices
+                  << " ADDs outside the book's price range" << std::endl;
+    }
+    if (book_count > 0) {
+        std::cout << "Shard " << shard << " book pools: " << book_count << " books, peak per book "
+                  << peak.orders_high_water << " orders / " << peak.levels_high_water << " levels";
+        if (arena) {
+            std::cout << ", arena " << (book_arena.get_used() >> 10) << " of " << (book_arena.get_size() >> 10)
+                      << " KB used, " << book_arena.get_exhausted() << " heap fallbacks";
         }
+        std::cout << std::endl;
+    }
+    if (multicast_publisher && multicast_publisher->get_packets_sent() > 0) {
+        std::cout << "Shard " << shard << " multicast: " << multicast_publisher->get_packets_sent() << " packets in "
+                  << multicast_publisher->get_send_calls() << " send calls" << std::endl;
+    }
+    if (multicast_publisher && multicast_publisher->get_messages_refused() > 0) {
+        std::cout << "Shard " << shard << " multicast: " << multicast_publisher->get_messages_refused()
+                  << " binary messages refused (symbol longer than " << MULTICAST_SYMBOL_LENGTH
+                  << " characters; use --publish-format json)" << std::endl;
+    }
+    if (wakeup && wakeup->get_wakeups() > 0) {
+        std::cout << "Shard " << shard << " idle wakeups: " << wakeup->get_wakeups() << std::endl;
     }
     
     std::cout << "Print consumer shutting down..." << std::endl;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    if (!parse_processor_args(argc, argv, config)) {
+        return 1;
+    }
+    
     std::cout << "Multicast Market Feed Subscriber - Starting up..." << std::endl;
+    std::cout << "Order book backend: " << (config.book_backend == BookBackend::TICK ? "tick ladder" : "map") << std::endl;
     
     // Set up signal handling
     signal(SIGINT, signal_handler);
@@ -224,35 +621,200 @@ int main() {
     const size_t queue_capacity = 10000;
     
     try {
-        // Initialize multicast publisher (API is now standalone)
-        multicast_publisher = std::make_unique<MulticastPublisher>();
-        if (!multicast_publisher->initialize("224.0.0.1", 12346)) {
-            std::cerr << "Failed to initialize multicast publisher" << std::endl;
-            return 1;
+        // Symbol -> ID interning, shared by ingress and every shard
+        SymbolDirectory symbol_directory(config.max_symbols);
+        
+        // Exchange -> ID, so restored books can tell which sequence channel an event is on
+        SymbolDirectory exchange_directory(MAX_SNAPSHOT_EXCHANGES);
+        SymbolDirectory* exchange_ptr = config.snapshot_dir.empty() ? nullptr : &exchange_directory;
+        
+        // Symbol -> shard routing
+        ShardMap shard_map(config.shard_count);
+        for (const auto& entry : config.shard_assignments) {
+            shard_map.assign(entry.first, entry.second);
         }
         
-        // Initialize components
-        SPSCRingBuffer<OrderBookEvent> event_queue(queue_capacity);
-        UDPListener listener(multicast_group, multicast_port);
+        // Initialize components: a queue and a multicast publisher per shard
+        // (API is now standalone). Separate publisher sockets keep shards from
+        // serializing on one socket's send path.
+        // Console output goes through the async logger (one log ring per shard)
+        AsyncLogger logger;
+        StatsCollector stats_collector;
+        
+        // Raw datagram recording for later --replay (any live backend); opened before
+        // any thread starts, so a bad path can still just return
+        FeedCaptureWriter capture;
+        if (!config.capture_path.empty()) {
+            if (!capture.open(config.capture_path)) {
+                return 1;
+            }
+            std::cout << "Capturing ingress datagrams to " << config.capture_path << std::endl;
+        }
         
-        // Initialize multicast listener
-        if (!listener.initialize()) {
-            std::cerr << "Failed to initialize multicast listener" << std::endl;
-            return 1;
+        // Book snapshots (restored at startup, rewritten every --snapshot-interval)
+        std::unique_ptr<SnapshotWriter> snapshot_writer;
+        if (!config.snapshot_dir.empty()) {
+            snapshot_writer = std::make_unique<SnapshotWriter>(config.snapshot_dir);
+            if (!snapshot_writer->start()) {
+                return 1;
+            }
         }
         
-        // Set shutdown flag for graceful shutdown
-        listener.set_shutdown_flag(&shutdown_flag);
+        std::vector<ConsumerShard> shards(config.shard_count);
+        for (auto& shard : shards) {
+            shard.publisher = std::make_unique<MulticastPublisher>();
+            if (!shard.publisher->initialize("224.0.0.1", 12346)) {
+                std::cerr << "Failed to initialize multicast publisher" << std::endl;
+                return 1;
+            }
+            shard.publisher->set_max_datagram_size(config.publish_datagram_bytes);
+            shard.publisher->set_format(config.publish_format);
+            shard.publisher->set_channel(static_cast<uint16_t>(&shard - shards.data() + 1));
+            shard.queue = std::make_unique<SPSCRingBuffer<OrderBookEvent>>(queue_capacity);
+            if (config.consumer_wait == WaitStrategy::HYBRID || config.consumer_wait == WaitStrategy::BLOCK) {
+                shard.wakeup = std::make_unique<QueueWakeup>();
+            }
+            shard.log = (config.verbosity == Verbosity::QUIET) ? nullptr : logger.add_writer();
+            shard.stats = stats_collector.add_shard(shard.queue.get());
+        }
         
-        // Start consumer thread
-        std::thread consumer_thread(print_consumer, std::ref(event_queue));
+        // Stats reporter: its own log ring and heartbeat socket
+        std::unique_ptr<MulticastPublisher> heartbeat_publisher;
+        LogWriter* stats_log = nullptr;
+        std::thread reporter_thread;
+        if (config.stats_interval_ms > 0) {
+            heartbeat_publisher = std::make_unique<MulticastPublisher>();
+            if (!heartbeat_publisher->initialize("224.0.0.1", 12346)) {
+                std::cerr << "Failed to initialize heartbeat publisher" << std::endl;
+                return 1;
+            }
+            heartbeat_publisher->set_format(config.publish_format);
+            stats_log = (config.verbosity == Verbosity::QUIET) ? nullptr : logger.add_writer();
+        }
+        logger.start();
+        if (shards.size() > 1) {
+            std::cout << "Sharded pipeline: " << shards.size() << " consumer shards" << std::endl;
+        }
         
-        // Run producer in main thread
-        ingress_producer(event_queue, listener);
+        // Start consumer threads
+        for (size_t i = 0; i < shards.size(); ++i) {
+            shards[i].thread = (config.book_backend == BookBackend::TICK)
+                ? std::thread(print_consumer<TickOrderBook>, std::ref(*shards[i].queue), shards[i].wakeup.get(),
+                              shards[i].publisher.get(), shards[i].log, std::ref(*shards[i].stats), std::cref(shard_map),
+                              std::ref(symbol_directory), std::ref(exchange_directory), snapshot_writer.get(), i)
+                : std::thread(print_consumer<OrderBook>, std::ref(*shards[i].queue), shards[i].wakeup.get(),
+                              shards[i].publisher.get(), shards[i].log, std::ref(*shards[i].stats), std::cref(shard_map),
+                              std::ref(symbol_directory), std::ref(exchange_directory), snapshot_writer.get(), i);
+        }
+        if (config.stats_interval_ms > 0) {
+            reporter_thread = std::thread(stats_reporter, std::ref(stats_collector), std::cref(logger), stats_log,
+                                          heartbeat_publisher.get());
+        }
         
-        // Wait for consumer thread to finish
-        if (consumer_thread.joinable()) {
-            consumer_thread.join();
+        auto report_capture = [&capture]() {
+            if (!config.capture_path.empty()) {
+                std::cout << "Capture: " << capture.get_records() << " datagrams, " << capture.get_bytes()
+                          << " bytes written to " << config.capture_path << std::endl;
+                capture.close();
+            }
+        };
+        
+        // Must run while the listener is alive: the reporter reads its counters
+        auto stop_consumers = [&shards, &logger, &reporter_thread, &snapshot_writer]() {
+            shutdown_flag.store(true);
+            if (reporter_thread.joinable()) {
+                reporter_thread.join();
+            }
+            // Wait for consumer threads to finish
+            for (auto& shard : shards) {
+                if (shard.thread.joinable()) {
+                    shard.thread.join();
+                }
+            }
+            // Then let the logger and snapshot writer finish what they left behind
+            logger.stop();
+            if (snapshot_writer) {
+                snapshot_writer->stop();
+                std::cout << "Snapshots: " << snapshot_writer->get_files_written() << " files written to "
+                          << snapshot_writer->get_directory() << std::endl;
+            }
+        };
+        
+        if (config.ingress_backend == IngressBackend::REPLAY) {
+            ReplayListener listener(config.replay_path);
+            listener.set_speed(config.replay_speed);
+            if (!listener.initialize()) {
+                stop_consumers();
+                return 1;
+            }
+            
+            listener.set_shutdown_flag(&shutdown_flag);
+            listener.set_feed_format(config.feed_format);
+            listener.set_sequence_check(config.sequence_check);
+            
+            ingress_producer(shards, shard_map, symbol_directory, exchange_ptr, listener, stats_collector);
+            
+            // Let the consumers finish the replayed events before stopping them
+            auto drained = [&shards]() {
+                for (const auto& shard : shards) {
+                    if (shard.queue->size_approx() > 0) return false;
+                }
+                return true;
+            };
+            while (!shutdown_flag.load() && !drained()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            stop_consumers();
+        } else
+#ifdef ENABLE_AF_XDP
+        if (config.ingress_backend == IngressBackend::XDP) {
+            XDPListener listener(multicast_group, multicast_port, config.xdp_interface, config.xdp_queue);
+            listener.set_mode(config.xdp_mode);
+            listener.set_busy_poll(config.busy_poll_usecs);
+            listener.set_line_b_group(config.feed_line_b_group);
+            listener.set_batch_size(config.recv_batch_size > 1 ? config.recv_batch_size : 64);
+            
+            // Initialize AF_XDP listener
+            if (!listener.initialize()) {
+                std::cerr << "Failed to initialize AF_XDP listener" << std::endl;
+                stop_consumers();
+                return 1;
+            }
+            
+            listener.set_shutdown_flag(&shutdown_flag);
+            listener.set_feed_format(config.feed_format);
+            listener.set_sequence_check(config.sequence_check);
+            listener.set_capture(capture.is_open() ? &capture : nullptr);
+            
+            // Run producer in main thread
+            ingress_producer(shards, shard_map, symbol_directory, exchange_ptr, listener, stats_collector);
+            stop_consumers();
+            report_capture();
+        } else
+#endif
+        {
+            UDPListener listener(multicast_group, multicast_port);
+            listener.set_line_b_group(config.feed_line_b_group);
+            
+            // Initialize multicast listener
+            if (!listener.initialize()) {
+                std::cerr << "Failed to initialize multicast listener" << std::endl;
+                stop_consumers();
+                return 1;
+            }
+            
+            // Set shutdown flag for graceful shutdown
+            listener.set_shutdown_flag(&shutdown_flag);
+            listener.set_feed_format(config.feed_format);
+            listener.set_sequence_check(config.sequence_check);
+            listener.set_batch_size(config.recv_batch_size);
+            listener.set_rx_timestamp_source(config.rx_timestamp_source);
+            listener.set_capture(capture.is_open() ? &capture : nullptr);
+            
+            // Run producer in main thread
+            ingress_producer(shards, shard_map, symbol_directory, exchange_ptr, listener, stats_collector);
+            stop_consumers();
+            report_capture();
         }
         
     } catch (const std::exception& e) {
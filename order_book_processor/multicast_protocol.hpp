@@ -0,0 +1,439 @@
+#ifndef MULTICAST_PROTOCOL_HPP
+#define MULTICAST_PROTOCOL_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include "feed_protocol.hpp"
+#include "depth_view.hpp"
+
+// Multicast output format (processor -> API subscribers)
+//
+// Binary mode sends one packet per datagram: a packet header, then one or more
+// messages back to back:
+//
+//   MulticastPacketHeader (16 bytes) | message | message | ...
+//   message = MulticastHeader (32 bytes) | body (depends on msg_type)
+//
+// Every publisher is its own channel. Its packets carry a per-channel sequence
+// number that increases by one per datagram, so receivers can detect loss.
+//
+// Same conventions as the ingress feed (feed_protocol.hpp): little-endian, no
+// padding, prices as FEED_PRICE_SCALE fixed point, NUL-padded symbols of at
+// most MULTICAST_SYMBOL_LENGTH bytes (the publisher refuses longer ones rather
+// than truncate them, since receivers key on the name).
+// JSON mode (debugging) sends newline-separated text objects instead; the two
+// are told apart by the first two bytes.
+
+// Message types for multicast
+enum class MulticastMessageType {
+    ORDER_BOOK_UPDATE,
+    TRADE_UPDATE,
+    HEARTBEAT,
+    DEPTH_UPDATE,
+    ANALYTICS_UPDATE
+};
+
+// Output wire format selection
+enum class MulticastFormat {
+    JSON,     // Text envelopes, easy to read with tcpdump
+    BINARY    // Fixed-layout messages (this file)
+};
+
+constexpr uint16_t MULTICAST_PACKET_MAGIC = 0x504d;   // "MP" on the wire
+constexpr uint16_t MULTICAST_MAGIC = 0x424d;          // "MB" on the wire
+constexpr uint8_t MULTICAST_PROTOCOL_VERSION = 2;
+
+#pragma pack(push, 1)
+struct MulticastPacketHeader {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t reserved;
+    uint16_t channel;             // Publisher channel ID
+    uint16_t message_count;
+    uint64_t sequence;            // Per channel, +1 per packet, starts at 1
+};
+
+struct MulticastHeader {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t msg_type;             // MulticastMessageType
+    uint16_t length;              // Header + body, in bytes
+    uint16_t symbol_id;           // Processor's interned symbol ID, stable while it runs (the name rides along)
+    char symbol[8];
+    uint64_t sequence;            // Per channel, +1 per message
+    uint64_t timestamp;           // Publisher monotonic clock (ns)
+};
+
+constexpr size_t MULTICAST_SYMBOL_LENGTH = sizeof(MulticastHeader::symbol);
+
+// ORDER_BOOK_UPDATE
+struct MulticastTopOfBookBody {
+    int64_t bid_price;
+    int64_t ask_price;
+    uint32_t bid_size;
+    uint32_t ask_size;
+};
+
+// TRADE_UPDATE
+struct MulticastTradeBody {
+    int64_t price;
+    uint32_t size;
+    uint8_t aggressor_side;       // FeedSide
+    uint8_t reserved[3];
+};
+
+// HEARTBEAT: followed by text_length bytes of JSON (counters and stats)
+struct MulticastHeartbeatBody {
+    uint16_t text_length;
+};
+
+// DEPTH_UPDATE: followed by entry_count MulticastDepthEntry, applied in order
+// (apply_depth_delta) to both sides' best-first levels
+struct MulticastDepthBody {
+    uint8_t flags;                // MULTICAST_DEPTH_RESET: clear both sides first (full refresh)
+    uint8_t depth;                // Levels kept per side
+    uint16_t entry_count;
+    uint8_t reserved[4];
+};
+
+struct MulticastDepthEntry {
+    uint8_t action;               // DepthAction
+    uint8_t side;                 // FeedSide
+    uint8_t level;                // 0 = best
+    uint8_t reserved;
+    uint32_t size;
+    int64_t price;
+};
+
+// ANALYTICS_UPDATE: rolling per-symbol analytics, sent next to the symbol's top of book
+struct MulticastAnalyticsBody {
+    int64_t vwap;                 // 0 = no trades in the window
+    int64_t microprice;           // 0 unless both sides are quoted
+    int64_t order_flow_imbalance; // Shares, signed
+    uint64_t window_volume;
+    int32_t depth_imbalance;      // MULTICAST_RATIO_SCALE fixed point, [-1, 1]
+    uint32_t window_trades;
+    uint32_t window_ms;
+    uint8_t reserved[4];
+};
+#pragma pack(pop)
+
+constexpr uint8_t MULTICAST_DEPTH_RESET = 0x01;
+constexpr int64_t MULTICAST_RATIO_SCALE = 1000000;
+
+static_assert(sizeof(MulticastPacketHeader) == 16, "MulticastPacketHeader layout changed");
+static_assert(sizeof(MulticastHeader) == 32, "MulticastHeader layout changed");
+static_assert(sizeof(MulticastTopOfBookBody) == 24, "MulticastTopOfBookBody layout changed");
+static_assert(sizeof(MulticastTradeBody) == 16, "MulticastTradeBody layout changed");
+static_assert(sizeof(MulticastDepthBody) == 8, "MulticastDepthBody layout changed");
+static_assert(sizeof(MulticastDepthEntry) == 16, "MulticastDepthEntry layout changed");
+static_assert(sizeof(MulticastAnalyticsBody) == 48, "MulticastAnalyticsBody layout changed");
+
+// Top of book as carried by ORDER_BOOK_UPDATE
+struct TopOfBookMessage {
+    std::pair<double, uint32_t> best_bid;     // (price, size)
+    std::pair<double, uint32_t> best_ask;
+    uint64_t sequence;
+    uint64_t timestamp;
+};
+
+// Trade as carried by TRADE_UPDATE
+struct TradeMessage {
+    double price;
+    uint32_t size;
+    OrderSide aggressor_side;
+    uint64_t sequence;
+    uint64_t timestamp;
+};
+
+// Level changes as carried by DEPTH_UPDATE (both sides, in order)
+struct DepthUpdateMessage {
+    bool reset;
+    uint8_t depth;
+    uint16_t delta_count;
+    DepthDelta deltas[4 * MAX_BOOK_DEPTH];
+    uint64_t sequence;
+    uint64_t timestamp;
+};
+
+// Analytics as carried by ANALYTICS_UPDATE (window = the processor's --analytics-window-ms)
+struct AnalyticsMessage {
+    double vwap;                    // Volume-weighted trade price over the window
+    double microprice;              // Size-weighted mid: (bid * ask_size + ask * bid_size) / (bid_size + ask_size)
+    double depth_imbalance;         // (bid - ask) / (bid + ask) resting size over the published depth
+    int64_t order_flow_imbalance;   // Net order flow at the best levels over the window
+    uint64_t window_volume;         // Traded shares in the window
+    uint32_t window_trades;
+    uint32_t window_ms;
+    uint64_t sequence;
+    uint64_t timestamp;
+};
+
+namespace multicast_detail {
+
+// Little-endian conversion is its own inverse
+template<typename T>
+inline T to_le(T v) {
+    return feed_detail::from_le(v);
+}
+
+inline int64_t price_to_wire(double price) {
+    return to_le(static_cast<int64_t>(std::llround(price * static_cast<double>(FEED_PRICE_SCALE))));
+}
+
+inline void write_header(char* out, MulticastMessageType type, size_t length, uint16_t symbol_id,
+                         const std::string& symbol, uint64_t sequence, uint64_t timestamp) {
+    MulticastHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = to_le(MULTICAST_MAGIC);
+    header.version = MULTICAST_PROTOCOL_VERSION;
+    header.msg_type = static_cast<uint8_t>(type);
+    header.length = to_le(static_cast<uint16_t>(length));
+    header.symbol_id = to_le(symbol_id);
+    std::memcpy(header.symbol, symbol.data(), symbol.size() < sizeof(header.symbol) ? symbol.size() : sizeof(header.symbol));
+    header.sequence = to_le(sequence);
+    header.timestamp = to_le(timestamp);
+    std::memcpy(out, &header, sizeof(header));
+}
+
+} // namespace multicast_detail
+
+constexpr size_t MULTICAST_TOP_OF_BOOK_SIZE = sizeof(MulticastHeader) + sizeof(MulticastTopOfBookBody);
+constexpr size_t MULTICAST_TRADE_SIZE = sizeof(MulticastHeader) + sizeof(MulticastTradeBody);
+constexpr size_t MULTICAST_ANALYTICS_SIZE = sizeof(MulticastHeader) + sizeof(MulticastAnalyticsBody);
+
+// Encoders write one complete message at out (caller guarantees the room)
+inline size_t encode_top_of_book(char* out, uint16_t symbol_id, const std::string& symbol, uint64_t sequence,
+                                 uint64_t timestamp, std::pair<double, uint32_t> best_bid,
+                                 std::pair<double, uint32_t> best_ask) {
+    using namespace multicast_detail;
+    write_header(out, MulticastMessageType::ORDER_BOOK_UPDATE, MULTICAST_TOP_OF_BOOK_SIZE, symbol_id, symbol,
+                 sequence, timestamp);
+    MulticastTopOfBookBody body;
+    body.bid_price = price_to_wire(best_bid.first);
+    body.ask_price = price_to_wire(best_ask.first);
+    body.bid_size = to_le(best_bid.second);
+    body.ask_size = to_le(best_ask.second);
+    std::memcpy(out + sizeof(MulticastHeader), &body, sizeof(body));
+    return MULTICAST_TOP_OF_BOOK_SIZE;
+}
+
+inline size_t encode_trade(char* out, uint16_t symbol_id, const std::string& symbol, uint64_t sequence,
+                           uint64_t timestamp, double price, uint32_t size, OrderSide aggressor_side) {
+    using namespace multicast_detail;
+    write_header(out, MulticastMessageType::TRADE_UPDATE, MULTICAST_TRADE_SIZE, symbol_id, symbol,
+                 sequence, timestamp);
+    MulticastTradeBody body;
+    std::memset(&body, 0, sizeof(body));
+    body.price = price_to_wire(price);
+    body.size = to_le(size);
+    body.aggressor_side = static_cast<uint8_t>(aggressor_side == OrderSide::BID ? FeedSide::BID :
+                                               aggressor_side == OrderSide::ASK ? FeedSide::ASK : FeedSide::UNKNOWN);
+    std::memcpy(out + sizeof(MulticastHeader), &body, sizeof(body));
+    return MULTICAST_TRADE_SIZE;
+}
+
+inline size_t encode_analytics(char* out, uint16_t symbol_id, const std::string& symbol, uint64_t sequence,
+                               uint64_t timestamp, const AnalyticsMessage& analytics) {
+    using namespace multicast_detail;
+    write_header(out, MulticastMessageType::ANALYTICS_UPDATE, MULTICAST_ANALYTICS_SIZE, symbol_id, symbol,
+                 sequence, timestamp);
+    MulticastAnalyticsBody body;
+    std::memset(&body, 0, sizeof(body));
+    body.vwap = price_to_wire(analytics.vwap);
+    body.microprice = price_to_wire(analytics.microprice);
+    body.order_flow_imbalance = to_le(analytics.order_flow_imbalance);
+    body.window_volume = to_le(analytics.window_volume);
+    body.depth_imbalance = to_le(static_cast<int32_t>(
+        std::llround(analytics.depth_imbalance * static_cast<double>(MULTICAST_RATIO_SCALE))));
+    body.window_trades = to_le(analytics.window_trades);
+    body.window_ms = to_le(analytics.window_ms);
+    std::memcpy(out + sizeof(MulticastHeader), &body, sizeof(body));
+    return MULTICAST_ANALYTICS_SIZE;
+}
+
+// Depth update size for a given number of deltas
+inline size_t multicast_depth_size(size_t delta_count) {
+    return sizeof(MulticastHeader) + sizeof(MulticastDepthBody) + delta_count * sizeof(MulticastDepthEntry);
+}
+
+inline size_t encode_depth_update(char* out, uint16_t symbol_id, const std::string& symbol, uint64_t sequence,
+                                  uint64_t timestamp, bool reset, size_t depth, const DepthDelta* deltas,
+                                  size_t delta_count) {
+    using namespace multicast_detail;
+    size_t length = multicast_depth_size(delta_count);
+    write_header(out, MulticastMessageType::DEPTH_UPDATE, length, symbol_id, symbol, sequence, timestamp);
+    MulticastDepthBody body;
+    std::memset(&body, 0, sizeof(body));
+    body.flags = reset ? MULTICAST_DEPTH_RESET : 0;
+    body.depth = static_cast<uint8_t>(depth);
+    body.entry_count = to_le(static_cast<uint16_t>(delta_count));
+    char* cursor = out + sizeof(MulticastHeader);
+    std::memcpy(cursor, &body, sizeof(body));
+    cursor += sizeof(body);
+    for (size_t i = 0; i < delta_count; ++i) {
+        MulticastDepthEntry entry;
+        entry.action = static_cast<uint8_t>(deltas[i].action);
+        entry.side = static_cast<uint8_t>(deltas[i].side == OrderSide::BID ? FeedSide::BID : FeedSide::ASK);
+        entry.level = deltas[i].level;
+        entry.reserved = 0;
+        entry.size = to_le(deltas[i].size);
+        entry.price = price_to_wire(deltas[i].price);
+        std::memcpy(cursor, &entry, sizeof(entry));
+        cursor += sizeof(entry);
+    }
+    return length;
+}
+
+// Heartbeat size for a given JSON text length
+inline size_t multicast_heartbeat_size(size_t text_length) {
+    return sizeof(MulticastHeader) + sizeof(MulticastHeartbeatBody) + text_length;
+}
+
+inline size_t encode_heartbeat(char* out, uint64_t sequence, uint64_t timestamp, const std::string& text) {
+    using namespace multicast_detail;
+    size_t length = multicast_heartbeat_size(text.size());
+    write_header(out, MulticastMessageType::HEARTBEAT, length, 0, std::string(), sequence, timestamp);
+    MulticastHeartbeatBody body;
+    body.text_length = to_le(static_cast<uint16_t>(text.size()));
+    std::memcpy(out + sizeof(MulticastHeader), &body, sizeof(body));
+    std::memcpy(out + sizeof(MulticastHeader) + sizeof(body), text.data(), text.size());
+    return length;
+}
+
+inline void encode_packet_header(char* out, uint16_t channel, uint16_t message_count, uint64_t sequence) {
+    using namespace multicast_detail;
+    MulticastPacketHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = to_le(MULTICAST_PACKET_MAGIC);
+    header.version = MULTICAST_PROTOCOL_VERSION;
+    header.channel = to_le(channel);
+    header.message_count = to_le(message_count);
+    header.sequence = to_le(sequence);
+    std::memcpy(out, &header, sizeof(header));
+}
+
+// True if the datagram starts with a binary multicast packet
+inline bool is_binary_multicast_message(const char* data, size_t len) {
+    uint16_t magic;
+    if (len < sizeof(magic)) return false;
+    std::memcpy(&magic, data, sizeof(magic));
+    return feed_detail::from_le(magic) == MULTICAST_PACKET_MAGIC;
+}
+
+// Validate and copy out the packet header at the start of a datagram
+inline bool decode_packet_header(const char* data, size_t len, MulticastPacketHeader& header) {
+    using namespace feed_detail;
+    if (len < sizeof(MulticastPacketHeader)) return false;
+    std::memcpy(&header, data, sizeof(header));
+    if (from_le(header.magic) != MULTICAST_PACKET_MAGIC || header.version != MULTICAST_PROTOCOL_VERSION) {
+        return false;
+    }
+    header.channel = from_le(header.channel);
+    header.message_count = from_le(header.message_count);
+    header.sequence = from_le(header.sequence);
+    return true;
+}
+
+// Validate and copy out the header of the message at data.
+// Returns the message length (header + body), or 0 if it is truncated or malformed.
+inline size_t decode_multicast_header(const char* data, size_t len, MulticastHeader& header) {
+    using namespace feed_detail;
+    if (len < sizeof(MulticastHeader)) return 0;
+    std::memcpy(&header, data, sizeof(header));
+    size_t length = from_le(header.length);
+    if (from_le(header.magic) != MULTICAST_MAGIC || header.version != MULTICAST_PROTOCOL_VERSION ||
+        length < sizeof(MulticastHeader) || length > len) {
+        return 0;
+    }
+    header.symbol_id = from_le(header.symbol_id);
+    header.sequence = from_le(header.sequence);
+    header.timestamp = from_le(header.timestamp);
+    return length;
+}
+
+inline bool decode_top_of_book(const MulticastHeader& header, const char* body, size_t body_len,
+                               TopOfBookMessage& message) {
+    using namespace feed_detail;
+    if (body_len < sizeof(MulticastTopOfBookBody)) return false;
+    MulticastTopOfBookBody wire;
+    std::memcpy(&wire, body, sizeof(wire));
+    message.best_bid = std::make_pair(price_from_wire(wire.bid_price), from_le(wire.bid_size));
+    message.best_ask = std::make_pair(price_from_wire(wire.ask_price), from_le(wire.ask_size));
+    message.sequence = header.sequence;
+    message.timestamp = header.timestamp;
+    return true;
+}
+
+inline bool decode_trade(const MulticastHeader& header, const char* body, size_t body_len, TradeMessage& message) {
+    using namespace feed_detail;
+    if (body_len < sizeof(MulticastTradeBody)) return false;
+    MulticastTradeBody wire;
+    std::memcpy(&wire, body, sizeof(wire));
+    message.price = price_from_wire(wire.price);
+    message.size = from_le(wire.size);
+    switch (static_cast<FeedSide>(wire.aggressor_side)) {
+        case FeedSide::BID: message.aggressor_side = OrderSide::BID; break;
+        case FeedSide::ASK: message.aggressor_side = OrderSide::ASK; break;
+        default: message.aggressor_side = OrderSide::UNKNOWN; break;
+    }
+    message.sequence = header.sequence;
+    message.timestamp = header.timestamp;
+    return true;
+}
+
+inline bool decode_analytics(const MulticastHeader& header, const char* body, size_t body_len,
+                             AnalyticsMessage& message) {
+    using namespace feed_detail;
+    if (body_len < sizeof(MulticastAnalyticsBody)) return false;
+    MulticastAnalyticsBody wire;
+    std::memcpy(&wire, body, sizeof(wire));
+    message.vwap = price_from_wire(wire.vwap);
+    message.microprice = price_from_wire(wire.microprice);
+    message.order_flow_imbalance = from_le(wire.order_flow_imbalance);
+    message.window_volume = from_le(wire.window_volume);
+    message.depth_imbalance = static_cast<double>(from_le(wire.depth_imbalance)) /
+                              static_cast<double>(MULTICAST_RATIO_SCALE);
+    message.window_trades = from_le(wire.window_trades);
+    message.window_ms = from_le(wire.window_ms);
+    message.sequence = header.sequence;
+    message.timestamp = header.timestamp;
+    return true;
+}
+
+inline bool decode_depth_update(const MulticastHeader& header, const char* body, size_t body_len,
+                                DepthUpdateMessage& message) {
+    using namespace feed_detail;
+    if (body_len < sizeof(MulticastDepthBody)) return false;
+    MulticastDepthBody wire;
+    std::memcpy(&wire, body, sizeof(wire));
+    size_t count = from_le(wire.entry_count);
+    if (count > 4 * MAX_BOOK_DEPTH || wire.depth > MAX_BOOK_DEPTH ||
+        body_len < sizeof(wire) + count * sizeof(MulticastDepthEntry)) {
+        return false;
+    }
+    const char* cursor = body + sizeof(wire);
+    for (size_t i = 0; i < count; ++i, cursor += sizeof(MulticastDepthEntry)) {
+        MulticastDepthEntry entry;
+        std::memcpy(&entry, cursor, sizeof(entry));
+        if (entry.action > static_cast<uint8_t>(DepthAction::DELETE)) return false;
+        DepthDelta& delta = message.deltas[i];
+        delta.action = static_cast<DepthAction>(entry.action);
+        delta.side = static_cast<FeedSide>(entry.side) == FeedSide::BID ? OrderSide::BID : OrderSide::ASK;
+        delta.level = entry.level;
+        delta.size = from_le(entry.size);
+        delta.price = price_from_wire(entry.price);
+    }
+    message.reset = (wire.flags & MULTICAST_DEPTH_RESET) != 0;
+    message.depth = wire.depth;
+    message.delta_count = static_cast<uint16_t>(count);
+    message.sequence = header.sequence;
+    message.timestamp = header.timestamp;
+    return true;
+}
+
+#endif // MULTICAST_PROTOCOL_HPP
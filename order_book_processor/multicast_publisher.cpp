@@ -2,12 +2,17 @@
 #include <sstream>
 #include <iomanip>
 #include <chrono>
+#include <cstdio>
 
 MulticastPublisher::MulticastPublisher() 
-    : socket_fd_(-1), port_(0), initialized_(false), messages_sent_(0), bytes_sent_(0) {
+    : socket_fd_(-1), port_(0), initialized_(false), format_(MulticastFormat::BINARY), channel_(0),
+      max_datagram_size_(1472), packets_(MAX_QUEUED_PACKETS * 1472), queued_packets_(0), packet_len_(0),
+      packet_messages_(0), sequence_(0), packet_sequence_(0), messages_sent_(0), bytes_sent_(0),
+      packets_sent_(0), send_calls_(0), messages_refused_(0) {
 }
 
 MulticastPublisher::~MulticastPublisher() {
+    flush();
     if (socket_fd_ >= 0) {
         close(socket_fd_);
     }
@@ -59,53 +64,282 @@ bool MulticastPublisher::initialize(const std::string& multicast_group, int port
     return true;
 }
 
-void MulticastPublisher::publish_order_book_update(const std::string& symbol, const OrderBook& book, uint64_t timestamp) {
+void MulticastPublisher::publish_top_of_book(SymbolId symbol_id, const std::string& symbol,
+                                             std::pair<double, uint32_t> best_bid,
+                                             std::pair<double, uint32_t> best_ask, uint64_t timestamp) {
     if (!initialized_) {
         std::cerr << "Multicast publisher not initialized" << std::endl;
         return;
     }
     
-    std::string json_data = order_book_to_json(book);
-    MulticastMessage message(MulticastMessageType::ORDER_BOOK_UPDATE, symbol, timestamp, json_data);
+    append_top_of_book(TopOfBookUpdate{symbol_id, &symbol, best_bid, best_ask}, timestamp);
+    flush();
+}
+
+void MulticastPublisher::publish_top_of_book_batch(const std::vector<TopOfBookUpdate>& updates, uint64_t timestamp) {
+    if (!initialized_) {
+        std::cerr << "Multicast publisher not initialized" << std::endl;
+        return;
+    }
     
-    if (send_message(message)) {
-        messages_sent_++;
-        bytes_sent_ += json_data.length();
+    for (const auto& update : updates) {
+        append_top_of_book(update, timestamp);
     }
 }
 
-void MulticastPublisher::publish_trade_update(const std::string& symbol, double price, uint32_t size, 
-                                            OrderSide aggressor_side, uint64_t timestamp) {
+void MulticastPublisher::publish_depth_update(SymbolId symbol_id, const std::string& symbol, bool reset,
+                                              size_t depth, const DepthDelta* deltas, size_t count, uint64_t timestamp) {
     if (!initialized_) {
         std::cerr << "Multicast publisher not initialized" << std::endl;
         return;
     }
+    if (refuse_symbol(symbol)) {
+        return;
+    }
     
-    std::string json_data = trade_to_json(price, size, aggressor_side);
-    MulticastMessage message(MulticastMessageType::TRADE_UPDATE, symbol, timestamp, json_data);
+    // Deltas are applied in order, so a long update can be cut into consecutive messages
+    size_t room = max_datagram_size_ - sizeof(MulticastPacketHeader);
+    size_t per_message = format_ == MulticastFormat::BINARY
+        ? (room - multicast_depth_size(0)) / sizeof(MulticastDepthEntry)
+        : (room - 160) / JSON_DEPTH_ENTRY_BYTES;
     
-    if (send_message(message)) {
+    size_t offset = 0;
+    do {
+        size_t chunk = count - offset < per_message ? count - offset : per_message;
+        bool chunk_reset = reset && offset == 0;
+        size_t len;
+        if (format_ == MulticastFormat::BINARY) {
+            char* out = reserve_packet(multicast_depth_size(chunk));
+            len = encode_depth_update(out, symbol_id, symbol, ++sequence_, timestamp, chunk_reset, depth,
+                                      deltas + offset, chunk);
+            packet_len_ += len;
+            packet_messages_++;
+        } else {
+            char line[8192];  // Room for a full two-sided update (4 * MAX_BOOK_DEPTH deltas)
+            len = format_depth_update(line, sizeof(line), symbol, chunk_reset, depth, deltas + offset, chunk, timestamp);
+            if (len == 0) {
+                std::cerr << "Depth message too long for " << symbol << std::endl;
+                return;
+            }
+            append_json_line(line, len);
+        }
         messages_sent_++;
-        bytes_sent_ += json_data.length();
+        bytes_sent_ += len;
+        offset += chunk;
+    } while (offset < count);
+}
+
+void MulticastPublisher::publish_trade_update(SymbolId symbol_id, const std::string& symbol, double price,
+                                              uint32_t size, OrderSide aggressor_side, uint64_t timestamp) {
+    if (!initialized_) {
+        std::cerr << "Multicast publisher not initialized" << std::endl;
+        return;
+    }
+    if (refuse_symbol(symbol)) {
+        return;
     }
+    
+    size_t len;
+    if (format_ == MulticastFormat::BINARY) {
+        char* out = reserve_packet(MULTICAST_TRADE_SIZE);
+        len = encode_trade(out, symbol_id, symbol, ++sequence_, timestamp, price, size, aggressor_side);
+        packet_len_ += len;
+        packet_messages_++;
+    } else {
+        char line[512];
+        len = format_trade(line, sizeof(line), symbol, price, size, aggressor_side, timestamp);
+        if (len == 0) {
+            std::cerr << "Trade message too long for " << symbol << std::endl;
+            return;
+        }
+        append_json_line(line, len);
+    }
+    
+    messages_sent_++;
+    bytes_sent_ += len;
 }
 
-void MulticastPublisher::publish_heartbeat() {
+void MulticastPublisher::publish_analytics_update(SymbolId symbol_id, const std::string& symbol,
+                                                  const AnalyticsMessage& analytics, uint64_t timestamp) {
     if (!initialized_) {
+        std::cerr << "Multicast publisher not initialized" << std::endl;
+        return;
+    }
+    if (refuse_symbol(symbol)) {
         return;
     }
     
+    size_t len;
+    if (format_ == MulticastFormat::BINARY) {
+        char* out = reserve_packet(MULTICAST_ANALYTICS_SIZE);
+        len = encode_analytics(out, symbol_id, symbol, ++sequence_, timestamp, analytics);
+        packet_len_ += len;
+        packet_messages_++;
+    } else {
+        char line[512];
+        len = format_analytics(line, sizeof(line), symbol, analytics, timestamp);
+        if (len == 0) {
+            std::cerr << "Analytics message too long for " << symbol << std::endl;
+            return;
+        }
+        append_json_line(line, len);
+    }
+    
+    messages_sent_++;
+    bytes_sent_ += len;
+}
+
+void MulticastPublisher::flush() {
+    finish_packet();
+    send_queued();
+}
+
+void MulticastPublisher::publish_heartbeat(const std::string& stats_json) {
+    if (!initialized_) {
+        return;
+    }
+    
+    // Keep the heartbeat behind everything already published
+    flush();
+    
     std::ostringstream json;
-    json << "{\"messages_sent\":" << messages_sent_ << ",\"bytes_sent\":" << bytes_sent_ << "}";
+    json << "{\"messages_sent\":" << messages_sent_ << ",\"bytes_sent\":" << bytes_sent_;
+    if (!stats_json.empty()) {
+        json << ",\"stats\":" << stats_json;
+    }
+    json << "}";
+    
+    uint64_t timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
     
-    MulticastMessage message(MulticastMessageType::HEARTBEAT, "", 
-                           std::chrono::duration_cast<std::chrono::nanoseconds>(
-                               std::chrono::steady_clock::now().time_since_epoch()).count(),
-                           json.str());
+    if (format_ == MulticastFormat::BINARY) {
+        // Own packet, sized for the text (may exceed the max datagram size)
+        std::string text = json.str();
+        size_t length = sizeof(MulticastPacketHeader) + multicast_heartbeat_size(text.size());
+        if (length > MAX_PACKET_SIZE) {
+            std::cerr << "Heartbeat too large: " << length << " bytes" << std::endl;
+            return;
+        }
+        std::vector<char> packet(length);
+        encode_packet_header(packet.data(), channel_, 1, ++packet_sequence_);
+        encode_heartbeat(packet.data() + sizeof(MulticastPacketHeader), ++sequence_, timestamp, text);
+        if (send_datagram(packet.data(), packet.size())) {
+            packets_sent_++;
+        }
+        send_calls_++;
+        return;
+    }
     
+    MulticastMessage message(MulticastMessageType::HEARTBEAT, "", timestamp, json.str());
     send_message(message);
 }
 
+void MulticastPublisher::set_max_datagram_size(size_t bytes) {
+    flush();
+    max_datagram_size_ = bytes < MAX_PACKET_SIZE ? bytes : MAX_PACKET_SIZE;
+    packets_.assign(MAX_QUEUED_PACKETS * max_datagram_size_, 0);
+}
+
+char* MulticastPublisher::reserve_packet(size_t len) {
+    if (packet_len_ > 0 && packet_len_ + len > max_datagram_size_) {
+        finish_packet();
+    }
+    if (packet_len_ == 0 && format_ == MulticastFormat::BINARY) {
+        packet_len_ = sizeof(MulticastPacketHeader);  // Stamped by finish_packet()
+    }
+    return current_packet() + packet_len_;
+}
+
+void MulticastPublisher::finish_packet() {
+    if (packet_len_ == 0) {
+        return;
+    }
+    
+    if (format_ == MulticastFormat::BINARY) {
+        encode_packet_header(current_packet(), channel_, packet_messages_, ++packet_sequence_);
+    }
+    packet_lens_[queued_packets_++] = packet_len_;
+    packet_len_ = 0;
+    packet_messages_ = 0;
+    
+    if (queued_packets_ == MAX_QUEUED_PACKETS) {
+        send_queued();
+    }
+}
+
+void MulticastPublisher::send_queued() {
+    if (queued_packets_ == 0 || socket_fd_ < 0) {
+        queued_packets_ = 0;
+        return;
+    }
+    
+    for (size_t i = 0; i < queued_packets_; ++i) {
+        iov_[i].iov_base = packets_.data() + i * max_datagram_size_;
+        iov_[i].iov_len = packet_lens_[i];
+        memset(&msgs_[i], 0, sizeof(msgs_[i]));
+        msgs_[i].msg_hdr.msg_name = &multicast_addr_;
+        msgs_[i].msg_hdr.msg_namelen = sizeof(multicast_addr_);
+        msgs_[i].msg_hdr.msg_iov = &iov_[i];
+        msgs_[i].msg_hdr.msg_iovlen = 1;
+    }
+    
+    // sendmmsg() may stop early (e.g. a full socket buffer); resubmit the rest
+    size_t sent = 0;
+    while (sent < queued_packets_) {
+        int n = sendmmsg(socket_fd_, msgs_ + sent, static_cast<unsigned int>(queued_packets_ - sent), 0);
+        send_calls_++;
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Failed to send multicast batch: " << strerror(errno) << std::endl;
+            break;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    
+    packets_sent_ += sent;
+    queued_packets_ = 0;
+}
+
+void MulticastPublisher::append_top_of_book(const TopOfBookUpdate& update, uint64_t timestamp) {
+    if (refuse_symbol(*update.symbol)) {
+        return;
+    }
+    size_t len;
+    if (format_ == MulticastFormat::BINARY) {
+        char* out = reserve_packet(MULTICAST_TOP_OF_BOOK_SIZE);
+        len = encode_top_of_book(out, update.symbol_id, *update.symbol, ++sequence_, timestamp,
+                                 update.best_bid, update.best_ask);
+        packet_len_ += len;
+        packet_messages_++;
+    } else {
+        char line[512];
+        len = format_top_of_book(line, sizeof(line), update, timestamp);
+        if (len == 0) {
+            std::cerr << "Top of book message too long for " << *update.symbol << std::endl;
+            return;
+        }
+        append_json_line(line, len);
+    }
+    
+    messages_sent_++;
+    bytes_sent_ += len;
+}
+
+void MulticastPublisher::append_json_line(const char* line, size_t len) {
+    // Newline-separated JSON
+    char* out = reserve_packet(len + 1);
+    if (packet_len_ > 0) {
+        *out++ = '\n';
+        packet_len_++;
+    }
+    std::memcpy(out, line, len);
+    packet_len_ += len;
+    packet_messages_++;
+}
+
+
 bool MulticastPublisher::send_message(const MulticastMessage& message) {
     if (socket_fd_ < 0) {
         return false;
@@ -121,9 +355,16 @@ bool MulticastPublisher::send_message(const MulticastMessage& message) {
     json << "}";
     
     std::string json_str = json.str();
+    return send_datagram(json_str.c_str(), json_str.length());
+}
+
+bool MulticastPublisher::send_datagram(const char* data, size_t len) {
+    if (socket_fd_ < 0) {
+        return false;
+    }
     
     // Send over multicast
-    ssize_t bytes_sent = sendto(socket_fd_, json_str.c_str(), json_str.length(), 0,
+    ssize_t bytes_sent = sendto(socket_fd_, data, len, 0,
                                (struct sockaddr*)&multicast_addr_, sizeof(multicast_addr_));
     
     if (bytes_sent < 0) {
@@ -134,19 +375,10 @@ bool MulticastPublisher::send_message(const MulticastMessage& message) {
     return true;
 }
 
-std::string MulticastPublisher::order_book_to_json(const OrderBook& book) {
-    std::ostringstream json;
-    json << std::fixed << std::setprecision(6);
-    
-    // Get best bid/ask
-    auto best_bid = book.get_best_bid();
-    auto best_ask = book.get_best_ask();
-    
-    json << "{";
-    json << "\"best_bid_price\":" << best_bid.first << ",";
-    json << "\"best_bid_size\":" << best_bid.second << ",";
-    json << "\"best_ask_price\":" << best_ask.first << ",";
-    json << "\"best_ask_size\":" << best_ask.second << ",";
+size_t MulticastPublisher::format_top_of_book(char* buffer, size_t size, const TopOfBookUpdate& update,
+                                              uint64_t timestamp) {
+    const auto& best_bid = update.best_bid;
+    const auto& best_ask = update.best_ask;
     
     // Calculate spread and midprice
     double spread = 0.0;
@@ -156,9 +388,6 @@ std::string MulticastPublisher::order_book_to_json(const OrderBook& book) {
         midprice = (best_bid.first + best_ask.first) / 2.0;
     }
     
-    json << "\"spread\":" << spread << ",";
-    json << "\"midprice\":" << midprice << ",";
-    
     // Calculate quote imbalance
     uint32_t total_size = best_bid.second + best_ask.second;
     double quote_imbalance = 0.0;
@@ -167,21 +396,77 @@ std::string MulticastPublisher::order_book_to_json(const OrderBook& book) {
                           static_cast<double>(best_ask.second)) / total_size;
     }
     
-    json << "\"quote_imbalance\":" << quote_imbalance;
-    json << "}";
+    // Same envelope as send_message(), written without a stream
+    int len = snprintf(buffer, size,
+                       "{\"type\":%d,\"symbol\":\"%s\",\"timestamp\":%llu,\"data\":{"
+                       "\"best_bid_price\":%.6f,\"best_bid_size\":%u,\"best_ask_price\":%.6f,\"best_ask_size\":%u,"
+                       "\"spread\":%.6f,\"midprice\":%.6f,\"quote_imbalance\":%.6f}}",
+                       static_cast<int>(MulticastMessageType::ORDER_BOOK_UPDATE), update.symbol->c_str(),
+                       static_cast<unsigned long long>(timestamp),
+                       best_bid.first, best_bid.second, best_ask.first, best_ask.second,
+                       spread, midprice, quote_imbalance);
     
-    return json.str();
+    if (len < 0 || static_cast<size_t>(len) >= size) {
+        return 0;
+    }
+    return static_cast<size_t>(len);
 }
 
-std::string MulticastPublisher::trade_to_json(double price, uint32_t size, OrderSide aggressor_side) {
-    std::ostringstream json;
-    json << std::fixed << std::setprecision(6);
+size_t MulticastPublisher::format_analytics(char* buffer, size_t size, const std::string& symbol,
+                                            const AnalyticsMessage& analytics, uint64_t timestamp) {
+    int len = snprintf(buffer, size,
+                       "{\"type\":%d,\"symbol\":\"%s\",\"timestamp\":%llu,\"data\":{"
+                       "\"vwap\":%.6f,\"microprice\":%.6f,\"depth_imbalance\":%.6f,\"order_flow_imbalance\":%lld,"
+                       "\"window_volume\":%llu,\"window_trades\":%u,\"window_ms\":%u}}",
+                       static_cast<int>(MulticastMessageType::ANALYTICS_UPDATE), symbol.c_str(),
+                       static_cast<unsigned long long>(timestamp), analytics.vwap, analytics.microprice,
+                       analytics.depth_imbalance, static_cast<long long>(analytics.order_flow_imbalance),
+                       static_cast<unsigned long long>(analytics.window_volume), analytics.window_trades,
+                       analytics.window_ms);
     
-    json << "{";
-    json << "\"price\":" << price << ",";
-    json << "\"size\":" << size << ",";
-    json << "\"aggressor_side\":\"" << (aggressor_side == OrderSide::BID ? "BID" : "ASK") << "\"";
-    json << "}";
+    if (len < 0 || static_cast<size_t>(len) >= size) {
+        return 0;
+    }
+    return static_cast<size_t>(len);
+}
+
+size_t MulticastPublisher::format_depth_update(char* buffer, size_t size, const std::string& symbol, bool reset,
+                                               size_t depth, const DepthDelta* deltas, size_t count,
+                                               uint64_t timestamp) {
+    static const char* const ACTIONS[] = {"NEW", "CHANGE", "DELETE"};
+    
+    int len = snprintf(buffer, size,
+                       "{\"type\":%d,\"symbol\":\"%s\",\"timestamp\":%llu,\"data\":{"
+                       "\"reset\":%s,\"depth\":%zu,\"levels\":[",
+                       static_cast<int>(MulticastMessageType::DEPTH_UPDATE), symbol.c_str(),
+                       static_cast<unsigned long long>(timestamp), reset ? "true" : "false", depth);
+    for (size_t i = 0; i < count && len >= 0 && static_cast<size_t>(len) < size; ++i) {
+        len += snprintf(buffer + len, size - len, "%s{\"action\":\"%s\",\"side\":\"%s\",\"level\":%u,"
+                        "\"price\":%.6f,\"size\":%u}", i > 0 ? "," : "",
+                        ACTIONS[static_cast<int>(deltas[i].action)], deltas[i].side == OrderSide::BID ? "BID" : "ASK",
+                        static_cast<unsigned>(deltas[i].level), deltas[i].price, deltas[i].size);
+    }
+    if (len >= 0 && static_cast<size_t>(len) < size) {
+        len += snprintf(buffer + len, size - len, "]}}");
+    }
+    
+    if (len < 0 || static_cast<size_t>(len) >= size) {
+        return 0;
+    }
+    return static_cast<size_t>(len);
+}
+
+size_t MulticastPublisher::format_trade(char* buffer, size_t size, const std::string& symbol, double price,
+                                        uint32_t trade_size, OrderSide aggressor_side, uint64_t timestamp) {
+    int len = snprintf(buffer, size,
+                       "{\"type\":%d,\"symbol\":\"%s\",\"timestamp\":%llu,\"data\":{"
+                       "\"price\":%.6f,\"size\":%u,\"aggressor_side\":\"%s\"}}",
+                       static_cast<int>(MulticastMessageType::TRADE_UPDATE), symbol.c_str(),
+                       static_cast<unsigned long long>(timestamp), price, trade_size,
+                       aggressor_side == OrderSide::BID ? "BID" : aggressor_side == OrderSide::ASK ? "ASK" : "UNKNOWN");
     
-    return json.str();
+    if (len < 0 || static_cast<size_t>(len) >= size) {
+        return 0;
+    }
+    return static_cast<size_t>(len);
 }
@@ -4,18 +4,15 @@
 #include <string>
 #include <iostream>
 #include <cstring>
+#include <utility>
+#include <vector>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include "../order_book_processor/orderbook.hpp"
-
-// Message types for multicast
-enum class MulticastMessageType {
-    ORDER_BOOK_UPDATE,
-    TRADE_UPDATE,
-    HEARTBEAT
-};
+#include "../order_book_processor/multicast_protocol.hpp"
+#include "../order_book_processor/symbol_directory.hpp"
 
 // Multicast message structure
 struct MulticastMessage {
@@ -29,6 +26,14 @@ struct MulticastMessage {
         : type(t), symbol(s), timestamp(ts), data(d) {}
 };
 
+// One symbol's top of book for a batched publish
+struct TopOfBookUpdate {
+    SymbolId symbol_id;
+    const std::string* symbol;
+    std::pair<double, uint32_t> best_bid;
+    std::pair<double, uint32_t> best_ask;
+};
+
 // UDP Multicast Publisher
 class MulticastPublisher {
 public:
@@ -38,32 +43,117 @@ public:
     // Initialize multicast socket
     bool initialize(const std::string& multicast_group, int port, int ttl = 1);
     
-    // Publish order book updates
-    void publish_order_book_update(const std::string& symbol, const OrderBook& book, uint64_t timestamp);
+    // Symbols are passed as their interned ID (binary header) and name (header and JSON)
+    
+    // Publish order book updates (any book backend exposing get_best_bid/get_best_ask)
+    template<typename Book>
+    void publish_order_book_update(SymbolId symbol_id, const std::string& symbol, const Book& book,
+                                   uint64_t timestamp) {
+        publish_top_of_book(symbol_id, symbol, book.get_best_bid(), book.get_best_ask(), timestamp);
+    }
+    
+    // Publish a top-of-book update from best bid/ask (price, size) pairs (sent immediately)
+    void publish_top_of_book(SymbolId symbol_id, const std::string& symbol, std::pair<double, uint32_t> best_bid,
+                             std::pair<double, uint32_t> best_ask, uint64_t timestamp);
+    
+    // Queue several top-of-book updates, packed into as few datagrams as possible
+    // (each datagram stays within the max datagram size); sent by flush()
+    void publish_top_of_book_batch(const std::vector<TopOfBookUpdate>& updates, uint64_t timestamp);
     
-    // Publish trade updates
-    void publish_trade_update(const std::string& symbol, double price, uint32_t size, 
-                            OrderSide aggressor_side, uint64_t timestamp);
+    // Queue one symbol's depth level deltas (reset = full refresh, deltas rebuild the levels
+    // from empty); split across messages when they would not fit one datagram. Sent by flush()
+    void publish_depth_update(SymbolId symbol_id, const std::string& symbol, bool reset, size_t depth,
+                              const DepthDelta* deltas, size_t count, uint64_t timestamp);
     
-    // Publish heartbeat
-    void publish_heartbeat();
+    // Queue a trade update; sent by flush()
+    void publish_trade_update(SymbolId symbol_id, const std::string& symbol, double price, uint32_t size,
+                              OrderSide aggressor_side, uint64_t timestamp);
+    
+    // Queue a symbol's rolling analytics (after its top of book, same batch); sent by flush()
+    void publish_analytics_update(SymbolId symbol_id, const std::string& symbol, const AnalyticsMessage& analytics,
+                                  uint64_t timestamp);
+    
+    // Send every queued datagram with one sendmmsg() (call at batch boundaries)
+    void flush();
+    
+    // Publish heartbeat immediately (after anything queued);
+    // stats_json (a JSON object) is attached as "stats" when given
+    void publish_heartbeat(const std::string& stats_json = "");
+    
+    // Largest packed datagram payload (default 1472 = 1500 byte MTU minus IP/UDP headers)
+    void set_max_datagram_size(size_t bytes);
+    
+    // Output wire format (default: BINARY; JSON is for debugging)
+    void set_format(MulticastFormat format) { flush(); format_ = format; }
+    
+    // Channel ID stamped on binary packets; give every publisher on a group its own
+    void set_channel(uint16_t channel) { channel_ = channel; }
     
     // Check if initialized
     bool is_initialized() const { return socket_fd_ >= 0; }
     
+    // Format one JSON top-of-book message (envelope included) into buffer; returns its length, 0 if it does not fit
+    static size_t format_top_of_book(char* buffer, size_t size, const TopOfBookUpdate& update, uint64_t timestamp);
+    
+    // Same for a trade
+    static size_t format_trade(char* buffer, size_t size, const std::string& symbol, double price, uint32_t trade_size,
+                               OrderSide aggressor_side, uint64_t timestamp);
+    
+    // Same for analytics
+    static size_t format_analytics(char* buffer, size_t size, const std::string& symbol,
+                                   const AnalyticsMessage& analytics, uint64_t timestamp);
+    
+    // Same for depth deltas
+    static size_t format_depth_update(char* buffer, size_t size, const std::string& symbol, bool reset, size_t depth,
+                                      const DepthDelta* deltas, size_t count, uint64_t timestamp);
+    
     // Get multicast group and port
     std::string get_multicast_group() const { return multicast_group_; }
     int get_port() const { return port_; }
     
+    // Datagrams sent and the sendmmsg()/sendto() calls it took
+    uint64_t get_packets_sent() const { return packets_sent_; }
+    uint64_t get_send_calls() const { return send_calls_; }
+    
+    // Binary messages not sent because the symbol is longer than MULTICAST_SYMBOL_LENGTH
+    uint64_t get_messages_refused() const { return messages_refused_; }
+    
+    // Disable copy constructor and assignment
+    MulticastPublisher(const MulticastPublisher&) = delete;
+    MulticastPublisher& operator=(const MulticastPublisher&) = delete;
+    
 private:
     // Send message over multicast
     bool send_message(const MulticastMessage& message);
     
-    // Convert order book to JSON
-    std::string order_book_to_json(const OrderBook& book);
+    // Send one datagram
+    bool send_datagram(const char* data, size_t len);
+    
+    // Room for len more bytes in the current packet, finishing it first if it would overflow
+    char* reserve_packet(size_t len);
     
-    // Convert trade to JSON
-    std::string trade_to_json(double price, uint32_t size, OrderSide aggressor_side);
+    // Close the current packet (stamp its header) and queue it
+    void finish_packet();
+    
+    // sendmmsg() every queued packet
+    void send_queued();
+    
+    char* current_packet() { return packets_.data() + queued_packets_ * max_datagram_size_; }
+    
+    // Binary format and a symbol the header cannot hold whole: count it, send nothing
+    bool refuse_symbol(const std::string& symbol) {
+        if (format_ != MulticastFormat::BINARY || symbol.size() <= MULTICAST_SYMBOL_LENGTH) {
+            return false;
+        }
+        ++messages_refused_;
+        return true;
+    }
+    
+    // Add one top-of-book message to the current packet
+    void append_top_of_book(const TopOfBookUpdate& update, uint64_t timestamp);
+    
+    // Add one JSON line to the current packet
+    void append_json_line(const char* line, size_t len);
     
     // Member variables
     int socket_fd_;
@@ -71,10 +161,32 @@ private:
     std::string multicast_group_;
     int port_;
     bool initialized_;
+    MulticastFormat format_;
+    uint16_t channel_;
+    
+    // Outgoing packets: MAX_QUEUED_PACKETS slots of max_datagram_size_ bytes, allocated once.
+    // Slots [0, queued_packets_) are complete; the next slot is under construction.
+    static constexpr size_t MAX_PACKET_SIZE = 65507;
+    static constexpr size_t MAX_QUEUED_PACKETS = 32;
+    static constexpr size_t JSON_DEPTH_ENTRY_BYTES = 96;  // Upper bound on one formatted JSON depth delta
+    size_t max_datagram_size_;
+    std::vector<char> packets_;
+    size_t packet_lens_[MAX_QUEUED_PACKETS];
+    size_t queued_packets_;
+    size_t packet_len_;             // Bytes in the packet under construction
+    uint16_t packet_messages_;      // Messages in the packet under construction
+    struct iovec iov_[MAX_QUEUED_PACKETS];
+    struct mmsghdr msgs_[MAX_QUEUED_PACKETS];
+    
+    uint64_t sequence_;             // Last message sequence number used
+    uint64_t packet_sequence_;      // Last packet sequence number used
     
     // Message counters for debugging
     uint64_t messages_sent_;
     uint64_t bytes_sent_;
+    uint64_t packets_sent_;
+    uint64_t send_calls_;
+    uint64_t messages_refused_;
 };
 
 #endif // MULTICAST_PUBLISHER_HPP
@@ -0,0 +1,236 @@
+#ifndef OBJECT_POOL_HPP
+#define OBJECT_POOL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "book_arena.hpp"
+
+// Slab allocator for fixed-size blocks.
+// Blocks are carved out of chunks of chunk_size blocks and recycled through an
+// intrusive free list, so once the pool has grown to the working set,
+// allocate() and deallocate() never touch the heap. Addresses are stable for
+// the lifetime of the pool (chunks are never freed or moved). Chunks come from
+// the arena when one is set and has room, from the heap otherwise.
+class BlockPool {
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    static constexpr size_t BLOCK_ALIGN = alignof(std::max_align_t);
+
+    std::vector<std::unique_ptr<unsigned char[]>> heap_chunks_;
+    BookArena* arena_;
+    FreeBlock* free_list_;
+    size_t block_size_;
+    size_t chunk_size_;
+    size_t capacity_;
+    size_t in_use_;
+    size_t high_water_;
+
+public:
+    explicit BlockPool(size_t block_size, size_t chunk_size = 1024)
+        : arena_(nullptr), free_list_(nullptr),
+          block_size_((std::max(block_size, sizeof(FreeBlock)) + BLOCK_ALIGN - 1) / BLOCK_ALIGN * BLOCK_ALIGN),
+          chunk_size_(chunk_size > 0 ? chunk_size : 1), capacity_(0), in_use_(0), high_water_(0) {}
+
+    BlockPool(BlockPool&& other) noexcept
+        : heap_chunks_(std::move(other.heap_chunks_)), arena_(other.arena_), free_list_(other.free_list_),
+          block_size_(other.block_size_), chunk_size_(other.chunk_size_), capacity_(other.capacity_),
+          in_use_(other.in_use_), high_water_(other.high_water_) {
+        other.free_list_ = nullptr;
+        other.capacity_ = 0;
+        other.in_use_ = 0;
+    }
+
+    BlockPool& operator=(BlockPool&& other) noexcept {
+        if (this != &other) {
+            heap_chunks_ = std::move(other.heap_chunks_);
+            arena_ = other.arena_;
+            free_list_ = other.free_list_;
+            block_size_ = other.block_size_;
+            chunk_size_ = other.chunk_size_;
+            capacity_ = other.capacity_;
+            in_use_ = other.in_use_;
+            high_water_ = other.high_water_;
+            other.free_list_ = nullptr;
+            other.capacity_ = 0;
+            other.in_use_ = 0;
+        }
+        return *this;
+    }
+
+    // Draw future chunks from arena (nullptr = heap). Set before the pool grows.
+    void set_arena(BookArena* arena) {
+        arena_ = arena;
+    }
+
+    // Whether a request of bytes fits one block
+    bool serves(size_t bytes) const {
+        return bytes <= block_size_;
+    }
+
+    void* allocate() {
+        if (!free_list_) {
+            grow();
+        }
+        FreeBlock* block = free_list_;
+        free_list_ = block->next;
+        if (++in_use_ > high_water_) {
+            high_water_ = in_use_;
+        }
+        return block;
+    }
+
+    void deallocate(void* pointer) {
+        FreeBlock* block = static_cast<FreeBlock*>(pointer);
+        block->next = free_list_;
+        free_list_ = block;
+        --in_use_;
+    }
+
+    // Pre-grow the pool so the first `count` blocks need no allocation
+    void reserve(size_t count) {
+        while (capacity_ < count) {
+            grow();
+        }
+    }
+
+    size_t in_use() const { return in_use_; }
+    size_t high_water() const { return high_water_; }    // Most blocks ever in use at once
+    size_t capacity() const { return capacity_; }
+
+    // Disable copy constructor and assignment
+    BlockPool(const BlockPool&) = delete;
+    BlockPool& operator=(const BlockPool&) = delete;
+
+private:
+    void grow() {
+        size_t bytes = block_size_ * chunk_size_;
+        unsigned char* chunk = arena_ ? static_cast<unsigned char*>(arena_->allocate(bytes, BLOCK_ALIGN)) : nullptr;
+        if (!chunk) {
+            heap_chunks_.emplace_back(new unsigned char[bytes]);
+            chunk = heap_chunks_.back().get();
+        }
+        for (size_t i = 0; i < chunk_size_; ++i) {
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + i * block_size_);
+            block->next = free_list_;
+            free_list_ = block;
+        }
+        capacity_ += chunk_size_;
+    }
+};
+
+// Typed slab pool: constructs objects in BlockPool blocks
+template<typename T>
+class ObjectPool {
+    static_assert(alignof(T) <= alignof(std::max_align_t), "ObjectPool does not over-align");
+
+private:
+    BlockPool blocks_;
+
+public:
+    explicit ObjectPool(size_t chunk_size = 1024) : blocks_(sizeof(T), chunk_size) {}
+
+    // The owner is responsible for destroying live objects before the pool goes away
+    ~ObjectPool() = default;
+
+    ObjectPool(ObjectPool&&) noexcept = default;
+    ObjectPool& operator=(ObjectPool&&) noexcept = default;
+
+    // Draw future chunks from arena (nullptr = heap)
+    void set_arena(BookArena* arena) {
+        blocks_.set_arena(arena);
+    }
+
+    // Construct an object in a pooled slot
+    template<typename... Args>
+    T* create(Args&&... args) {
+        return new (blocks_.allocate()) T(std::forward<Args>(args)...);
+    }
+
+    // Destroy an object and return its slot to the free list
+    void destroy(T* object) {
+        if (!object) return;
+        object->~T();
+        blocks_.deallocate(object);
+    }
+
+    // Pre-grow the pool so the first `count` objects need no allocation
+    void reserve(size_t count) {
+        blocks_.reserve(count);
+    }
+
+    size_t in_use() const {
+        return blocks_.in_use();
+    }
+
+    size_t high_water() const {
+        return blocks_.high_water();
+    }
+
+    size_t capacity() const {
+        return blocks_.capacity();
+    }
+
+    // Disable copy constructor and assignment
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+};
+
+// Standard allocator over a BlockPool, for node containers (std::map, std::list):
+// single-node requests are served by the pool, anything else (or a node larger
+// than the pool's blocks) goes to the heap. Size the pool for the container's
+// node, i.e. the value plus the container's links. Copies, including rebound ones,
+// share the pool, which must outlive the container.
+template<typename T>
+class PoolAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    explicit PoolAllocator(BlockPool* pool) noexcept : pool_(pool) {}
+
+    template<typename U>
+    PoolAllocator(const PoolAllocator<U>& other) noexcept : pool_(other.pool()) {}
+
+    T* allocate(size_t count) {
+        if (count == 1 && alignof(T) <= alignof(std::max_align_t) && pool_->serves(sizeof(T))) {
+            return static_cast<T*>(pool_->allocate());
+        }
+        return static_cast<T*>(::operator new(count * sizeof(T)));
+    }
+
+    void deallocate(T* pointer, size_t count) noexcept {
+        if (count == 1 && alignof(T) <= alignof(std::max_align_t) && pool_->serves(sizeof(T))) {
+            pool_->deallocate(pointer);
+        } else {
+            ::operator delete(pointer);
+        }
+    }
+
+    BlockPool* pool() const noexcept {
+        return pool_;
+    }
+
+    template<typename U>
+    bool operator==(const PoolAllocator<U>& other) const noexcept {
+        return pool_ == other.pool();
+    }
+
+    template<typename U>
+    bool operator!=(const PoolAllocator<U>& other) const noexcept {
+        return pool_ != other.pool();
+    }
+
+private:
+    BlockPool* pool_;
+};
+
+#endif // OBJECT_POOL_HPP
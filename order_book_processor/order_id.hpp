@@ -0,0 +1,157 @@
+#ifndef ORDER_ID_HPP
+#define ORDER_ID_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "flat_hash_map.hpp"
+
+// Exchange order IDs are interned into 64-bit integers at ingress so the book
+// never hashes or stores strings.
+using OrderId = uint64_t;
+
+// Reserved value (never produced by intern_order_id, rejected by the book)
+constexpr OrderId INVALID_ORDER_ID = ~0ULL;
+
+// Set on IDs derived from a hash; clear on IDs parsed from decimal digits
+constexpr OrderId HASHED_ORDER_ID_BIT = 1ULL << 63;
+
+// Intern an exchange order ID string.
+// Purely numeric IDs below 2^63 are parsed as-is, so they round-trip and keep
+// their natural ordering. Anything else (e.g. "AAPL_1042") is hashed with
+// 64-bit FNV-1a into the HASHED_ORDER_ID_BIT namespace, so the two kinds can
+// never collide with each other. Two hashed IDs can still collide; OrderIdTable
+// resolves that at ingress.
+inline OrderId intern_order_id(std::string_view raw_id) {
+    if (raw_id.empty()) {
+        return INVALID_ORDER_ID;
+    }
+
+    if (raw_id.size() <= 18) {  // 18 digits always fit below 2^63
+        OrderId value = 0;
+        bool numeric = true;
+        for (char c : raw_id) {
+            if (c < '0' || c > '9') {
+                numeric = false;
+                break;
+            }
+            value = value * 10 + static_cast<OrderId>(c - '0');
+        }
+        if (numeric) {
+            return value;
+        }
+    }
+
+    uint64_t hash = 14695981039346656037ULL;  // FNV-1a offset basis
+    for (char c : raw_id) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;  // FNV-1a prime
+    }
+
+    OrderId id = hash | HASHED_ORDER_ID_BIT;
+    return id == INVALID_ORDER_ID ? (id - 1) : id;
+}
+
+// Intern table for non-numeric order IDs, owned by the ingress thread.
+//
+// Each ID string is hashed as by intern_order_id and remembered under its ID,
+// so a second string that hashes to a taken ID is detected, counted and moved
+// to the next free ID instead of silently merging with the first order. Each
+// entry mirrors its order's resting size the way the book changes it (ADD and
+// MODIFY set it, a TRADE fills it), so the entry is released when the book
+// drops the order: on CANCEL, DELETE or a full fill. An entry another string
+// was moved past is kept, so that string still finds its ID. Numeric IDs
+// bypass the table.
+// When the table is full, new strings get their plain hash and are counted as
+// untracked.
+class OrderIdTable {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 1 << 20;
+
+    explicit OrderIdTable(size_t capacity = DEFAULT_CAPACITY)
+        : capacity_(capacity), collisions_(0), untracked_(0) {}
+
+    OrderId intern(std::string_view raw_id) {
+        OrderId id = intern_order_id(raw_id);
+        if (!(id & HASHED_ORDER_ID_BIT) || id == INVALID_ORDER_ID) {
+            return id;
+        }
+
+        bool collided = false;
+        for (Entry* entry = ids_.find(id); entry; entry = ids_.find(id)) {
+            if (entry->name == raw_id) {
+                return id;
+            }
+            entry->probed_past = true;
+            collided = true;
+            id = next_id(id);
+        }
+
+        if (ids_.size() >= capacity_) {
+            ++untracked_;
+            return id;
+        }
+        ids_.try_emplace(id, Entry{std::string(raw_id), 0, false});
+        if (collided) {
+            ++collisions_;
+        }
+        return id;
+    }
+
+    // The order now rests with size (ADD, MODIFY)
+    void set_size(OrderId id, uint32_t size) {
+        if (Entry* entry = ids_.find(id)) {
+            entry->remaining = size;
+        }
+    }
+
+    // A trade executed quantity against the order; a full fill releases it, as
+    // execute_order drops the order from the book (so does a trade against an
+    // ID that never rested)
+    void fill(OrderId id, uint32_t quantity) {
+        Entry* entry = ids_.find(id);
+        if (!entry) return;
+        if (quantity >= entry->remaining) {
+            release(id);
+        } else {
+            entry->remaining -= quantity;
+        }
+    }
+
+    // The order is gone (CANCEL/DELETE): forget its string
+    void release(OrderId id) {
+        const Entry* entry = ids_.find(id);
+        if (entry && !entry->probed_past) {
+            ids_.erase(id);
+        }
+    }
+
+    size_t size() const { return ids_.size(); }
+    uint64_t get_collisions() const { return collisions_; }    // Strings moved off their hash
+    uint64_t get_untracked() const { return untracked_; }      // Strings hashed without a table entry
+
+    // Disable copy constructor and assignment
+    OrderIdTable(const OrderIdTable&) = delete;
+    OrderIdTable& operator=(const OrderIdTable&) = delete;
+
+private:
+    struct Entry {
+        std::string name;
+        uint32_t remaining;             // Resting size the book holds for the order
+        bool probed_past;               // Another string hashed here and moved on
+    };
+
+    // Next ID in the hashed namespace, skipping INVALID_ORDER_ID
+    static OrderId next_id(OrderId id) {
+        OrderId next = (id + 1) | HASHED_ORDER_ID_BIT;
+        return next == INVALID_ORDER_ID ? HASHED_ORDER_ID_BIT : next;
+    }
+
+    FlatHashMap<Entry> ids_;
+    size_t capacity_;
+    uint64_t collisions_;
+    uint64_t untracked_;
+};
+
+#endif // ORDER_ID_HPP
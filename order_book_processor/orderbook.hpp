@@ -1,215 +1,331 @@
 #ifndef ORDERBOOK_HPP
 #define ORDERBOOK_HPP
 
+#include <cmath>
 #include <map>
-#include <unordered_map>
-#include <deque>
+#include <memory>
 #include <cstdint>
-#include <string>
+#include <utility>
 #include <vector>
 #include "quote.hpp"
+#include "object_pool.hpp"
+#include "flat_hash_map.hpp"
+#include "depth_view.hpp"
+
+struct PriceLevel;
 
 // Individual order structure
+// Orders are pool-allocated nodes linked directly into their price level's
+// FIFO queue, so the order-id index points straight at the queue entry.
 struct Order {
-    std::string order_id;
+    OrderId order_id;
     OrderSide side;
     double price;
     uint32_t size;
     uint64_t timestamp;
-    std::string symbol;
+    
+    // Intrusive links (owned by the PriceLevel the order rests at)
+    Order* prev = nullptr;
+    Order* next = nullptr;
+    PriceLevel* level = nullptr;
     
     Order() = default;
-    Order(const std::string& oid, OrderSide s, double p, uint32_t sz, uint64_t ts, const std::string& sym)
-        : order_id(oid), side(s), price(p), size(sz), timestamp(ts), symbol(sym) {}
+    Order(OrderId oid, OrderSide s, double p, uint32_t sz, uint64_t ts)
+        : order_id(oid), side(s), price(p), size(sz), timestamp(ts) {}
 };
 
-// Order entry in price level queue
-struct OrderEntry {
-    std::string order_id;
-    uint32_t size;
-    uint64_t timestamp;  // For price-time priority
-    
-    OrderEntry(const std::string& id, uint32_t s, uint64_t ts) 
-        : order_id(id), size(s), timestamp(ts) {}
-};
+// Order entry in price level queue (the order node itself)
+using OrderEntry = Order;
 
 // Price level structure with FIFO ordering for price-time priority
+// Orders form an intrusive doubly-linked list (head = oldest), so add, modify
+// and remove are O(1) pointer updates with no allocation or rehashing.
 struct PriceLevel {
     double price;
     uint32_t total_size;
-    std::deque<OrderEntry> order_queue;  // FIFO queue for price-time priority
-    std::unordered_map<std::string, std::deque<OrderEntry>::iterator> order_lookup;  // O(1) lookup by order_id
+    uint32_t order_count;
+    Order* head;  // Front of FIFO queue (next to execute)
+    Order* tail;  // Back of FIFO queue (most recent)
     
-    PriceLevel() : price(0.0), total_size(0) {}
-    PriceLevel(double p) : price(p), total_size(0) {}
+    PriceLevel() : price(0.0), total_size(0), order_count(0), head(nullptr), tail(nullptr) {}
+    PriceLevel(double p) : price(p), total_size(0), order_count(0), head(nullptr), tail(nullptr) {}
     
-    void add_order(const std::string& order_id, uint32_t size, uint64_t timestamp) {
+    void add_order(Order* order) {
         // Add to end of queue (FIFO)
-        order_queue.emplace_back(order_id, size, timestamp);
-        auto it = order_queue.end();
-        --it;  // Get iterator to the newly added element
-        order_lookup[order_id] = it;
-        total_size += size;
-    }
-    
-    void modify_order(const std::string& order_id, uint32_t new_size) {
-        auto lookup_it = order_lookup.find(order_id);
-        if (lookup_it != order_lookup.end()) {
-            auto queue_it = lookup_it->second;
-            total_size = total_size - queue_it->size + new_size;
-            queue_it->size = new_size;
+        order->prev = tail;
+        order->next = nullptr;
+        order->level = this;
+        if (tail) {
+            tail->next = order;
+        } else {
+            head = order;
         }
+        tail = order;
+        total_size += order->size;
+        ++order_count;
+    }
+    
+    void modify_order(Order* order, uint32_t new_size) {
+        // Size changes keep queue position in this simple model
+        total_size = total_size - order->size + new_size;
+        order->size = new_size;
     }
     
-    void remove_order(const std::string& order_id) {
-        auto lookup_it = order_lookup.find(order_id);
-        if (lookup_it != order_lookup.end()) {
-            auto queue_it = lookup_it->second;
-            total_size -= queue_it->size;
-            
-            // Remove from queue (this invalidates iterators, so we need to rebuild lookup)
-            order_queue.erase(queue_it);
-            order_lookup.erase(lookup_it);
-            
-            // Rebuild lookup map with new iterators
-            rebuild_lookup();
+    void remove_order(Order* order) {
+        // Unlink in O(1)
+        if (order->prev) {
+            order->prev->next = order->next;
+        } else {
+            head = order->next;
+        }
+        if (order->next) {
+            order->next->prev = order->prev;
+        } else {
+            tail = order->prev;
         }
+        total_size -= order->size;
+        --order_count;
+        order->prev = nullptr;
+        order->next = nullptr;
+        order->level = nullptr;
     }
     
     bool empty() const {
-        return order_queue.empty();
+        return head == nullptr;
     }
     
     // Get the next order to execute (front of queue)
     const OrderEntry* get_next_order() const {
-        if (order_queue.empty()) return nullptr;
-        return &order_queue.front();
+        return head;
     }
     
     // Get all orders in FIFO order
-    std::vector<OrderEntry> get_orders_fifo() const {
-        std::vector<OrderEntry> result;
-        for (const auto& entry : order_queue) {
+    std::vector<const OrderEntry*> get_orders_fifo() const {
+        std::vector<const OrderEntry*> result;
+        result.reserve(order_count);
+        for (const Order* entry = head; entry; entry = entry->next) {
             result.push_back(entry);
         }
         return result;
     }
-    
-private:
-    void rebuild_lookup() {
-        order_lookup.clear();
-        for (auto it = order_queue.begin(); it != order_queue.end(); ++it) {
-            order_lookup[it->order_id] = it;
-        }
-    }
 };
 
+// Node pool occupancy of one book (high water = most ever in use at once)
+struct BookPoolStats {
+    size_t orders_high_water = 0;
+    size_t orders_capacity = 0;
+    size_t levels_high_water = 0;
+    size_t levels_capacity = 0;
+};
+
+// Side that initiated a trade (the taker), from the best evidence available:
+//  1. resting_side: the trade executed against an order resting in our book,
+//     so the aggressor is on the other side
+//  2. the feed's own label: the reported order's side, which was the aggressor
+//     when reported_aggressor is set and the passive side otherwise
+//  3. the quote rule against the BBO before the trade: at or through the ask
+//     a buyer lifted the offer, at or through the bid a seller hit it
+// UNKNOWN if none of them says (no side, and a print strictly inside the spread).
+inline OrderSide infer_aggressor_side(OrderSide resting_side, OrderSide reported_side, bool reported_aggressor,
+                                      double price, double best_bid, double best_ask) {
+    auto opposite = [](OrderSide side) { return side == OrderSide::BID ? OrderSide::ASK : OrderSide::BID; };
+    if (resting_side == OrderSide::BID || resting_side == OrderSide::ASK) {
+        return opposite(resting_side);
+    }
+    if (reported_side == OrderSide::BID || reported_side == OrderSide::ASK) {
+        return reported_aggressor ? reported_side : opposite(reported_side);
+    }
+    if (best_ask > 0.0 && price >= best_ask) {
+        return OrderSide::BID;
+    }
+    if (best_bid > 0.0 && price <= best_bid) {
+        return OrderSide::ASK;
+    }
+    return OrderSide::UNKNOWN;
+}
+
 // Optimized order book with O(1) operations using order_id
 class OrderBook {
 private:
-    // Order lookup by order_id for O(1) access
-    std::unordered_map<std::string, Order> orders_by_id;
+    using LevelAllocator = PoolAllocator<std::pair<const double, PriceLevel>>;
+    
+    // Map node: the level plus red-black tree links and color (three pointers
+    // and a flag in both libstdc++ and libc++)
+    static constexpr size_t LEVEL_NODE_BYTES = sizeof(std::pair<const double, PriceLevel>) + 4 * sizeof(void*);
+    
+    // Pool-allocated order nodes (no allocation per order once warmed up)
+    ObjectPool<Order> order_pool;
+    
+    // Order lookup by interned order_id for O(1) access, pointing straight at the node
+    FlatHashMap<Order*> orders_by_id;
+    
+    // Map nodes for both sides come from one pool, so new price levels do not
+    // allocate either. Heap-held so its address survives moving the book.
+    std::unique_ptr<BlockPool> level_nodes;
     
     // Price level aggregation for efficient best bid/ask
-    std::map<double, PriceLevel, std::greater<double>> bid_levels;  // price -> level (descending)
-    std::map<double, PriceLevel> ask_levels;                        // price -> level (ascending)
-
+    std::map<double, PriceLevel, std::greater<double>, LevelAllocator> bid_levels;  // price -> level (descending)
+    std::map<double, PriceLevel, std::less<double>, LevelAllocator> ask_levels;     // price -> level (ascending)
+    
+    // Best N levels per side, updated with every level change (off until set_depth_levels)
+    DepthView bid_depth{true};
+    DepthView ask_depth{false};
+    
+    uint64_t rejected_prices = 0;   // ADDs refused for a non-finite price
+    
 public:
-    OrderBook() = default;
+    OrderBook()
+        : level_nodes(std::make_unique<BlockPool>(LEVEL_NODE_BYTES, 256)),
+          bid_levels(std::greater<double>(), LevelAllocator(level_nodes.get())),
+          ask_levels(std::less<double>(), LevelAllocator(level_nodes.get())) {}
+    ~OrderBook() { clear(); }
+    
+    OrderBook(OrderBook&&) = default;
+    
+    // Members are replaced in declaration order, which would free our level pool
+    // while our maps still hold its nodes: empty the book first
+    OrderBook& operator=(OrderBook&& other) {
+        if (this != &other) {
+            clear();
+            order_pool = std::move(other.order_pool);
+            orders_by_id = std::move(other.orders_by_id);
+            bid_levels = std::move(other.bid_levels);
+            ask_levels = std::move(other.ask_levels);
+            level_nodes = std::move(other.level_nodes);
+            bid_depth = std::move(other.bid_depth);
+            ask_depth = std::move(other.ask_depth);
+            rejected_prices = other.rejected_prices;
+        }
+        return *this;
+    }
+    
+    // Carve future order and level slabs out of arena (nullptr = heap). Call
+    // before the book grows, e.g. right after constructing it.
+    void set_arena(BookArena* arena) {
+        order_pool.set_arena(arena);
+        level_nodes->set_arena(arena);
+    }
+    
+    // Pre-size for orders resting orders on levels price levels (both sides),
+    // so a book that stays within them never allocates
+    void reserve(size_t orders, size_t levels) {
+        order_pool.reserve(orders);
+        orders_by_id.reserve(orders);
+        level_nodes->reserve(levels);
+    }
+    
+    BookPoolStats get_pool_stats() const {
+        BookPoolStats stats;
+        stats.orders_high_water = order_pool.high_water();
+        stats.orders_capacity = order_pool.capacity();
+        stats.levels_high_water = level_nodes->high_water();
+        stats.levels_capacity = level_nodes->capacity();
+        return stats;
+    }
+    
+    // ADDs refused for a price the book cannot key on
+    uint64_t get_rejected_prices() const {
+        return rejected_prices;
+    }
     
     // O(1) add order by order_id
-    bool add_order(const std::string& order_id, OrderSide side, double price, uint32_t size, 
-                   const std::string& symbol = "", uint64_t timestamp = 0) {
-        // Check if order already exists
-        if (orders_by_id.find(order_id) != orders_by_id.end()) {
-            return false;  // Order already exists
+    bool add_order(OrderId order_id, OrderSide side, double price, uint32_t size, uint64_t timestamp = 0) {
+        if (side != OrderSide::BID && side != OrderSide::ASK) {
+            return false;
+        }
+        if (!std::isfinite(price)) {
+            ++rejected_prices;
+            return false;  // NaN would break the level maps' ordering
         }
         
-        // Create order
-        Order order(order_id, side, price, size, timestamp, symbol);
+        // Check if order already exists
+        auto inserted = orders_by_id.try_emplace(order_id, nullptr);
+        if (!inserted.second) {
+            return false;  // Order already exists (or invalid order_id)
+        }
         
-        // Store order by order_id for O(1) lookup
-        orders_by_id[order_id] = order;
+        // Create order node and store it by order_id for O(1) lookup
+        Order* order = order_pool.create(order_id, side, price, size, timestamp);
+        *inserted.first = order;
         
         // Update price level aggregation with FIFO ordering
-        if (side == OrderSide::BID) {
-            if (bid_levels.find(price) == bid_levels.end()) {
-                bid_levels[price] = PriceLevel(price);
-            }
-            bid_levels[price].add_order(order_id, size, timestamp);
-        } else if (side == OrderSide::ASK) {
-            if (ask_levels.find(price) == ask_levels.end()) {
-                ask_levels[price] = PriceLevel(price);
-            }
-            ask_levels[price].add_order(order_id, size, timestamp);
-        }
+        PriceLevel& level = side == OrderSide::BID ? bid_levels.try_emplace(price, price).first->second
+                                                   : ask_levels.try_emplace(price, price).first->second;
+        level.add_order(order);
+        update_depth(side, level.price, level.total_size);
         
         return true;
     }
     
     // O(1) modify order by order_id
-    bool modify_order(const std::string& order_id, uint32_t new_size) {
-        auto order_it = orders_by_id.find(order_id);
-        if (order_it == orders_by_id.end()) {
+    bool modify_order(OrderId order_id, uint32_t new_size) {
+        Order** slot = orders_by_id.find(order_id);
+        if (!slot) {
             return false;  // Order not found
         }
         
-        Order& order = order_it->second;
-        order.size = new_size;
-        
-        // Update price level aggregation
-        if (order.side == OrderSide::BID) {
-            auto level_it = bid_levels.find(order.price);
-            if (level_it != bid_levels.end()) {
-                level_it->second.modify_order(order_id, new_size);
-            }
-        } else if (order.side == OrderSide::ASK) {
-            auto level_it = ask_levels.find(order.price);
-            if (level_it != ask_levels.end()) {
-                level_it->second.modify_order(order_id, new_size);
-            }
-        }
+        Order* order = *slot;
+        PriceLevel* level = order->level;
+        level->modify_order(order, new_size);
+        update_depth(order->side, level->price, level->total_size);
         
         return true;
     }
     
     // O(1) cancel order by order_id
-    bool cancel_order(const std::string& order_id) {
-        auto order_it = orders_by_id.find(order_id);
-        if (order_it == orders_by_id.end()) {
+    bool cancel_order(OrderId order_id) {
+        Order** slot = orders_by_id.find(order_id);
+        if (!slot) {
             return false;  // Order not found
         }
         
-        const Order& order = order_it->second;
+        Order* order = *slot;
+        PriceLevel* level = order->level;
+        level->remove_order(order);
         
-        // Update price level aggregation
-        if (order.side == OrderSide::BID) {
-            auto level_it = bid_levels.find(order.price);
-            if (level_it != bid_levels.end()) {
-                level_it->second.remove_order(order_id);
-                // Remove empty price levels
-                if (level_it->second.empty()) {
-                    bid_levels.erase(level_it);
-                }
-            }
-        } else if (order.side == OrderSide::ASK) {
-            auto level_it = ask_levels.find(order.price);
-            if (level_it != ask_levels.end()) {
-                level_it->second.remove_order(order_id);
-                // Remove empty price levels
-                if (level_it->second.empty()) {
-                    ask_levels.erase(level_it);
-                }
+        // Remove empty price levels
+        uint32_t level_size = level->total_size;
+        if (level->empty()) {
+            level_size = 0;
+            if (order->side == OrderSide::BID) {
+                bid_levels.erase(order->price);
+            } else {
+                ask_levels.erase(order->price);
             }
         }
+        update_depth(order->side, order->price, level_size);
         
-        // Remove order from lookup
-        orders_by_id.erase(order_it);
+        // Remove order from lookup and return the node to the pool
+        orders_by_id.erase(order_id);
+        order_pool.destroy(order);
         
         return true;
     }
     
     
+    // O(1) fill quantity of a resting order (a trade against it). A partly
+    // filled order keeps its FIFO position; a filled one is removed. The
+    // order's side is stored in resting_side (if given) when it is found.
+    bool execute_order(OrderId order_id, uint32_t quantity, OrderSide* resting_side = nullptr) {
+        Order** slot = orders_by_id.find(order_id);
+        if (!slot) {
+            return false;  // Not resting here (e.g. the aggressor's own ID)
+        }
+        
+        Order* order = *slot;
+        if (resting_side) {
+            *resting_side = order->side;
+        }
+        if (quantity >= order->size) {
+            return cancel_order(order_id);
+        }
+        PriceLevel* level = order->level;
+        level->modify_order(order, order->size - quantity);
+        update_depth(order->side, level->price, level->total_size);
+        
+        return true;
+    }
+    
     // O(1) get best bid using price level aggregation
     std::pair<double, uint32_t> get_best_bid() const {
         if (bid_levels.empty()) return {0.0, 0};
@@ -235,14 +351,8 @@ public:
     
     // O(log n) get total size at a specific price level
     uint32_t get_size_at_price(OrderSide side, double price) const {
-        if (side == OrderSide::BID) {
-            auto it = bid_levels.find(price);
-            return (it != bid_levels.end()) ? it->second.total_size : 0;
-        } else if (side == OrderSide::ASK) {
-            auto it = ask_levels.find(price);
-            return (it != ask_levels.end()) ? it->second.total_size : 0;
-        }
-        return 0;
+        const PriceLevel* level = find_level(side, price);
+        return level ? level->total_size : 0;
     }
     
     // Get number of price levels on each side
@@ -260,14 +370,14 @@ public:
     }
     
     // O(1) check if order exists by order_id
-    bool has_order(const std::string& order_id) const {
-        return orders_by_id.find(order_id) != orders_by_id.end();
+    bool has_order(OrderId order_id) const {
+        return orders_by_id.contains(order_id);
     }
     
     // O(1) get order by order_id
-    const Order* get_order(const std::string& order_id) const {
-        auto it = orders_by_id.find(order_id);
-        return (it != orders_by_id.end()) ? &it->second : nullptr;
+    const Order* get_order(OrderId order_id) const {
+        Order* const* slot = orders_by_id.find(order_id);
+        return slot ? *slot : nullptr;
     }
     
     // Check if order book is empty
@@ -275,31 +385,44 @@ public:
         return bid_levels.empty() && ask_levels.empty();
     }
     
+    // Keep the best levels (at most MAX_BOOK_DEPTH, 0 = off) per side in step with the book
+    void set_depth_levels(size_t levels) {
+        bid_depth.set_depth(levels);
+        ask_depth.set_depth(levels);
+        for (auto it = bid_levels.begin(); it != bid_levels.end() && !bid_depth.full(); ++it) {
+            bid_depth.push_back(it->second.price, it->second.total_size);
+        }
+        for (auto it = ask_levels.begin(); it != ask_levels.end() && !ask_depth.full(); ++it) {
+            ask_depth.push_back(it->second.price, it->second.total_size);
+        }
+    }
+    
+    size_t get_depth_levels() const {
+        return bid_depth.depth();
+    }
+    
+    // O(1) best levels of one side, best first
+    const DepthView& get_depth(OrderSide side) const {
+        return side == OrderSide::BID ? bid_depth : ask_depth;
+    }
+    
     // Clear the order book
     void clear() {
+        orders_by_id.for_each([this](OrderId, Order* order) { order_pool.destroy(order); });
         orders_by_id.clear();
         bid_levels.clear();
         ask_levels.clear();
+        bid_depth.clear();
+        ask_depth.clear();
     }
     
     // Get all orders at a price level in FIFO order (for debugging/analysis)
-    std::vector<std::string> get_orders_at_price(OrderSide side, double price) const {
-        std::vector<std::string> order_ids;
-        if (side == OrderSide::BID) {
-            auto it = bid_levels.find(price);
-            if (it != bid_levels.end()) {
-                auto orders_fifo = it->second.get_orders_fifo();
-                for (const auto& entry : orders_fifo) {
-                    order_ids.push_back(entry.order_id);
-                }
-            }
-        } else if (side == OrderSide::ASK) {
-            auto it = ask_levels.find(price);
-            if (it != ask_levels.end()) {
-                auto orders_fifo = it->second.get_orders_fifo();
-                for (const auto& entry : orders_fifo) {
-                    order_ids.push_back(entry.order_id);
-                }
+    std::vector<OrderId> get_orders_at_price(OrderSide side, double price) const {
+        std::vector<OrderId> order_ids;
+        const PriceLevel* level = find_level(side, price);
+        if (level) {
+            for (const Order* entry = level->head; entry; entry = entry->next) {
+                order_ids.push_back(entry->order_id);
             }
         }
         return order_ids;
@@ -307,16 +430,47 @@ public:
     
     // Get next order to execute at a price level (FIFO front)
     const OrderEntry* get_next_order_at_price(OrderSide side, double price) const {
+        const PriceLevel* level = find_level(side, price);
+        return level ? level->get_next_order() : nullptr;
+    }
+    
+    // Visit every resting order, level by level and oldest first within a level,
+    // so re-adding them in visit order rebuilds the same queues (snapshots)
+    template<typename Fn>
+    void for_each_order(Fn&& fn) const {
+        for (const auto& level : bid_levels) {
+            for (const Order* order = level.second.head; order; order = order->next) fn(*order);
+        }
+        for (const auto& level : ask_levels) {
+            for (const Order* order = level.second.head; order; order = order->next) fn(*order);
+        }
+    }
+    
+private:
+    // First level behind price in priority order (one map lookup, only when a full view loses a level)
+    template<typename Levels>
+    static bool next_level(const Levels& levels, double price, DepthEntry& out) {
+        auto it = levels.upper_bound(price);
+        if (it == levels.end()) return false;
+        out = DepthEntry{it->second.price, it->second.total_size};
+        return true;
+    }
+    
+    void update_depth(OrderSide side, double price, uint32_t size) {
+        if (side == OrderSide::BID) {
+            bid_depth.update(price, size, [this](double p, DepthEntry& out) { return next_level(bid_levels, p, out); });
+        } else {
+            ask_depth.update(price, size, [this](double p, DepthEntry& out) { return next_level(ask_levels, p, out); });
+        }
+    }
+    
+    const PriceLevel* find_level(OrderSide side, double price) const {
         if (side == OrderSide::BID) {
             auto it = bid_levels.find(price);
-            if (it != bid_levels.end()) {
-                return it->second.get_next_order();
-            }
+            return (it != bid_levels.end()) ? &it->second : nullptr;
         } else if (side == OrderSide::ASK) {
             auto it = ask_levels.find(price);
-            if (it != ask_levels.end()) {
-                return it->second.get_next_order();
-            }
+            return (it != ask_levels.end()) ? &it->second : nullptr;
         }
         return nullptr;
     }
@@ -0,0 +1,434 @@
+#ifndef PROCESSOR_CONFIG_HPP
+#define PROCESSOR_CONFIG_HPP
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "feed_protocol.hpp"
+#include "multicast_protocol.hpp"
+#include "listener.hpp"
+#include "xdp_listener.hpp"
+#include "replay_listener.hpp"
+#include "async_logger.hpp"
+#include "symbol_directory.hpp"
+#include "wait_strategy.hpp"
+#include "tick_order_book.hpp"
+
+// Order book storage backend used by the consumer
+enum class BookBackend {
+    MAP,    // OrderBook: std::map price levels keyed on double
+    TICK    // TickOrderBook: integer-tick flat-array price ladder
+};
+
+// Where datagrams come from
+enum class IngressBackend {
+    SOCKET, // UDPListener: kernel UDP socket (recvfrom/recvmmsg)
+    XDP,    // XDPListener: AF_XDP kernel bypass (needs -DENABLE_AF_XDP)
+    REPLAY  // ReplayListener: datagrams from a capture file
+};
+
+// Runtime configuration for the order book processor
+struct ProcessorConfig {
+    BookBackend book_backend = BookBackend::MAP;
+    double default_tick_size = 0.01;
+    std::map<std::string, double> symbol_tick_sizes;  // Per-symbol overrides
+    size_t max_ladder_ticks = TickOrderBook::DEFAULT_MAX_LADDER_TICKS;  // Tick ladder window cap per side
+    FeedFormat feed_format = FeedFormat::AUTO;
+    std::string feed_line_b_group;                     // Redundant feed line on the same port (empty = none)
+    bool sequence_check = true;                        // A/B dedupe and gap detection on sequence numbers
+    size_t recv_batch_size = 1;                        // Datagrams per recvmmsg() (1 = recvfrom)
+    RxTimestampSource rx_timestamp_source = RxTimestampSource::USERSPACE;
+    IngressBackend ingress_backend = IngressBackend::SOCKET;
+    std::string xdp_interface;                         // Required for --ingress xdp
+    uint32_t xdp_queue = 0;
+    XdpMode xdp_mode = XdpMode::SKB;
+    std::string capture_path;                          // Record ingress datagrams here (empty = off)
+    std::string replay_path;                           // Capture file for --ingress replay
+    double replay_speed = 0.0;                         // Recorded pacing multiplier (0 = full speed)
+    int busy_poll_usecs = 0;                           // AF_XDP SO_BUSY_POLL (0 = off)
+    int ingress_cpu = -1;                              // Core for the ingress thread (-1 = unpinned)
+    size_t shard_count = 1;                            // Consumer threads, each with its own queue and books
+    std::vector<int> shard_cpus;                       // Core per shard consumer (missing = unpinned)
+    int rt_priority = 0;                               // SCHED_FIFO priority for ingress and shards (0 = normal)
+    WaitStrategy consumer_wait = WaitStrategy::YIELD;  // What an idle shard consumer does
+    std::map<std::string, size_t> shard_assignments;   // Symbols pinned to a shard (others are hashed)
+    Verbosity verbosity = Verbosity::EVENTS;
+    uint32_t stats_interval_ms = 1000;                 // Latency percentile snapshots (0 = off)
+    uint32_t conflate_interval_us = 0;                 // Top-of-book flush period (0 = after every consumer batch)
+    size_t publish_datagram_bytes = 1472;              // Packed top-of-book datagram limit
+    MulticastFormat publish_format = MulticastFormat::BINARY;
+    size_t depth_levels = 10;                          // Book levels per side published as deltas (0 = top of book only)
+    uint32_t analytics_window_ms = 5000;               // Rolling VWAP / order-flow window (0 = analytics off)
+    std::string snapshot_dir;                          // Book snapshots (empty = off)
+    uint32_t snapshot_interval_ms = 5000;              // Snapshot period (0 = only at shutdown)
+    size_t max_symbols = SymbolDirectory::DEFAULT_CAPACITY;  // Symbol directory capacity (IDs per run)
+    size_t arena_mb = 0;                               // Prefaulted book arena per shard (0 = slabs from the heap)
+    size_t book_orders = 0;                            // Orders pre-reserved per new book
+    size_t book_levels = 0;                            // Price levels pre-reserved per new book (both sides)
+
+    double tick_size_for(const std::string& symbol) const {
+        auto it = symbol_tick_sizes.find(symbol);
+        return it != symbol_tick_sizes.end() ? it->second : default_tick_size;
+    }
+};
+
+inline void print_usage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --book map|tick                    Order book backend (default: map)\n"
+              << "  --tick-size SIZE                   Default tick size for the tick backend (default: 0.01)\n"
+              << "  --tick-size SYMBOL=SIZE            Per-symbol tick size override (repeatable)\n"
+              << "  --max-ladder-ticks N               Widest tick ladder per side; ADDs beyond it are rejected\n"
+              << "                                     (default: 1048576)\n"
+              << "  --feed-format json|binary|auto     Ingress wire format (default: auto)\n"
+              << "  --feed-b-group GROUP               Also join the feed's redundant B line (same port)\n"
+              << "  --sequence-check on|off            Drop duplicate sequence numbers, count gaps (default: on)\n"
+              << "  --recv-batch N                     Datagrams drained per recvmmsg() call (default: 1)\n"
+              << "  --rx-timestamp user|kernel|hardware  Source of receive timestamps (default: user)\n"
+              << "  --ingress socket|xdp               Ingress backend (default: socket)\n"
+              << "  --capture FILE                     Record every ingress datagram to FILE\n"
+              << "  --replay FILE                      Replay a capture file instead of listening\n"
+              << "  --replay-speed max|X               Replay as fast as possible, or at X times recorded pacing (default: max)\n"
+              << "  --xdp-if IFNAME                    Interface for the AF_XDP backend\n"
+              << "  --xdp-queue N                      NIC RX queue the feed is steered to (default: 0)\n"
+              << "  --xdp-mode skb|native|zerocopy     AF_XDP attach mode (default: skb)\n"
+              << "  --busy-poll USECS                  Busy-poll the AF_XDP socket (default: 0 = off)\n"
+              << "  --ingress-cpu N                    Pin the ingress thread to CPU N\n"
+              << "  --shards N                         Consumer shards, symbols hashed across them (default: 1)\n"
+              << "  --shard-cpus CPU[,CPU...]          Pin shard consumer i to the i-th CPU\n"
+              << "  --shard-map SYMBOL=SHARD           Pin a symbol to a shard (repeatable)\n"
+              << "  --rt-priority N                    Run ingress and shard threads SCHED_FIFO at N (1-99, default: off)\n"
+              << "  --wait yield|spin|hybrid|block     Idle shard consumers yield, spin, spin then sleep, or sleep (default: yield)\n"
+              << "  --verbosity quiet|stats|events     Console output: none, periodic stats, or every event (default: events)\n"
+              << "  --stats-interval MS                Latency percentile snapshot period (default: 1000, 0 = off)\n"
+              << "  --conflate-us USECS                Publish changed top-of-book at most every USECS (default: 0 = per batch)\n"
+              << "  --publish-mtu BYTES                Max packed top-of-book datagram payload (default: 1472)\n"
+              << "  --publish-format json|binary       Multicast output format (default: binary)\n"
+              << "  --depth-levels N                   Levels per side kept and published as deltas (default: 10, max: 20, 0 = off)\n"
+              << "  --analytics-window-ms MS           Rolling VWAP and order-flow window (default: 5000, 0 = off)\n"
+              << "  --snapshot-dir DIR                 Restore books from DIR at startup and snapshot them there\n"
+              << "  --snapshot-interval MS             Book snapshot period (default: 5000, 0 = only at shutdown)\n"
+              << "  --max-symbols N                    Distinct symbols accepted per run (default: 4096, max: 65535)\n"
+              << "  --arena-mb N                       Prefaulted, huge-page book arena per shard (default: 0 = heap)\n"
+              << "  --book-orders N                    Orders reserved up front for each new book (default: 0)\n"
+              << "  --book-levels N                    Price levels reserved up front for each new book (default: 0)\n"
+              << "  --help                             Show this message" << std::endl;
+}
+
+// Parse command line options into config. Returns false on invalid input or --help.
+inline bool parse_processor_args(int argc, char* argv[], ProcessorConfig& config) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (arg == "--help" || arg == "-h") {
+            print_usage(argv[0]);
+            return false;
+        } else if (arg == "--book" && has_value) {
+            std::string value = argv[++i];
+            if (value == "map") {
+                config.book_backend = BookBackend::MAP;
+            } else if (value == "tick") {
+                config.book_backend = BookBackend::TICK;
+            } else {
+                std::cerr << "Unknown book backend: " << value << std::endl;
+                return false;
+            }
+        } else if (arg == "--tick-size" && has_value) {
+            std::string value = argv[++i];
+            size_t eq = value.find('=');
+            double tick_size = std::atof(value.c_str() + (eq == std::string::npos ? 0 : eq + 1));
+            if (tick_size <= 0.0) {
+                std::cerr << "Invalid tick size: " << value << std::endl;
+                return false;
+            }
+            if (eq == std::string::npos) {
+                config.default_tick_size = tick_size;
+            } else {
+                config.symbol_tick_sizes[value.substr(0, eq)] = tick_size;
+            }
+        } else if (arg == "--max-ladder-ticks" && has_value) {
+            long ticks = std::atol(argv[++i]);
+            if (ticks < 64 || ticks > (1L << 30)) {
+                std::cerr << "Invalid ladder size: " << argv[i] << " (64 to 1073741824 ticks)" << std::endl;
+                return false;
+            }
+            config.max_ladder_ticks = static_cast<size_t>(ticks);
+        } else if (arg == "--feed-format" && has_value) {
+            std::string value = argv[++i];
+            if (value == "json") {
+                config.feed_format = FeedFormat::JSON;
+            } else if (value == "binary") {
+                config.feed_format = FeedFormat::BINARY;
+            } else if (value == "auto") {
+                config.feed_format = FeedFormat::AUTO;
+            } else {
+                std::cerr << "Unknown feed format: " << value << std::endl;
+                return false;
+            }
+        } else if (arg == "--feed-b-group" && has_value) {
+            config.feed_line_b_group = argv[++i];
+            struct in_addr addr;
+            if (inet_pton(AF_INET, config.feed_line_b_group.c_str(), &addr) != 1 ||
+                !IN_MULTICAST(ntohl(addr.s_addr))) {
+                std::cerr << "Invalid line B multicast group: " << config.feed_line_b_group << std::endl;
+                return false;
+            }
+        } else if (arg == "--sequence-check" && has_value) {
+            std::string value = argv[++i];
+            if (value == "on") {
+                config.sequence_check = true;
+            } else if (value == "off") {
+                config.sequence_check = false;
+            } else {
+                std::cerr << "Unknown sequence check setting: " << value << std::endl;
+                return false;
+            }
+        } else if (arg == "--recv-batch" && has_value) {
+            long batch = std::atol(argv[++i]);
+            if (batch < 1 || batch > 1024) {
+                std::cerr << "Invalid receive batch size: " << argv[i] << std::endl;
+                return false;
+            }
+            config.recv_batch_size = static_cast<size_t>(batch);
+        } else if (arg == "--rx-timestamp" && has_value) {
+            std::string value = argv[++i];
+            if (value == "user") {
+                config.rx_timestamp_source = RxTimestampSource::USERSPACE;
+            } else if (value == "kernel") {
+                config.rx_timestamp_source = RxTimestampSource::KERNEL;
+            } else if (value == "hardware") {
+                config.rx_timestamp_source = RxTimestampSource::HARDWARE;
+            } else {
+                std::cerr << "Unknown receive timestamp source: " << value << std::endl;
+                return false;
+            }
+        } else if (arg == "--ingress" && has_value) {
+            std::string value = argv[++i];
+            if (value == "socket") {
+                config.ingress_backend = IngressBackend::SOCKET;
+            } else if (value == "xdp") {
+#ifdef ENABLE_AF_XDP
+                config.ingress_backend = IngressBackend::XDP;
+#else
+                std::cerr << "AF_XDP ingress not available: rebuild with -DENABLE_AF_XDP" << std::endl;
+                return false;
+#endif
+            } else {
+                std::cerr << "Unknown ingress backend: " << value << std::endl;
+                return false;
+            }
+        } else if (arg == "--capture" && has_value) {
+            config.capture_path = argv[++i];
+        } else if (arg == "--replay" && has_value) {
+            config.replay_path = argv[++i];
+            config.ingress_backend = IngressBackend::REPLAY;
+        } else if (arg == "--replay-speed" && has_value) {
+            std::string value = argv[++i];
+            double speed = value == "max" ? 0.0 : std::atof(value.c_str());
+            if (value != "max" && !(speed > 0.0 && speed <= 1000000.0)) {
+                std::cerr << "Invalid replay speed: " << value << std::endl;
+                return false;
+            }
+            config.replay_speed = speed;
+        } else if (arg == "--xdp-if" && has_value) {
+            config.xdp_interface = argv[++i];
+        } else if (arg == "--xdp-queue" && has_value) {
+            long queue = std::atol(argv[++i]);
+            if (queue < 0 || queue > 63) {
+                std::cerr << "Invalid XDP queue: " << argv[i] << std::endl;
+                return false;
+            }
+            config.xdp_queue = static_cast<uint32_t>(queue);
+        } else if (arg == "--xdp-mode" && has_value) {
+            std::string value = argv[++i];
+            if (value == "skb") {
+                config.xdp_mode = XdpMode::SKB;
+            } else if (value == "native") {
+                config.xdp_mode = XdpMode::NATIVE;
+            } else if (value == "zerocopy") {
+                config.xdp_mode = XdpMode::ZEROCOPY;
+            } else {
+                std::cerr << "Unknown XDP mode: " << value << std::endl;
+                return false;
+            }
+        } else if (arg == "--busy-poll" && has_value) {
+            long usecs = std::atol(argv[++i]);
+            if (usecs < 0 || usecs > 1000000) {
+                std::cerr << "Invalid busy-poll time: " << argv[i] << std::endl;
+                return false;
+            }
+            config.busy_poll_usecs = static_cast<int>(usecs);
+        } else if (arg == "--ingress-cpu" && has_value) {
+            long cpu = std::atol(argv[++i]);
+            if (cpu < 0) {
+                std::cerr << "Invalid ingress CPU: " << argv[i] << std::endl;
+                return false;
+            }
+            config.ingress_cpu = static_cast<int>(cpu);
+        } else if (arg == "--shards" && has_value) {
+            long shards = std::atol(argv[++i]);
+            if (shards < 1 || shards > 64) {
+                std::cerr << "Invalid shard count: " << argv[i] << std::endl;
+                return false;
+            }
+            config.shard_count = static_cast<size_t>(shards);
+        } else if (arg == "--shard-cpus" && has_value) {
+            std::string value = argv[++i];
+            config.shard_cpus.clear();
+            size_t start = 0;
+            while (start <= value.size()) {
+                size_t comma = value.find(',', start);
+                std::string cpu = value.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+                if (cpu.empty() || cpu.find_first_not_of("0123456789") != std::string::npos) {
+                    std::cerr << "Invalid shard CPU list: " << value << std::endl;
+                    return false;
+                }
+                config.shard_cpus.push_back(std::atoi(cpu.c_str()));
+                if (comma == std::string::npos) break;
+                start = comma + 1;
+            }
+        } else if (arg == "--shard-map" && has_value) {
+            std::string value = argv[++i];
+            size_t eq = value.find('=');
+            if (eq == std::string::npos || eq == 0 || eq + 1 == value.size() ||
+                value.find_first_not_of("0123456789", eq + 1) != std::string::npos) {
+                std::cerr << "Invalid shard assignment: " << value << std::endl;
+                return false;
+            }
+            config.shard_assignments[value.substr(0, eq)] = static_cast<size_t>(std::atol(value.c_str() + eq + 1));
+        } else if (arg == "--rt-priority" && has_value) {
+            long priority = std::atol(argv[++i]);
+            if (priority < 1 || priority > 99) {
+                std::cerr << "Invalid real-time priority: " << argv[i] << std::endl;
+                return false;
+            }
+            config.rt_priority = static_cast<int>(priority);
+        } else if (arg == "--wait" && has_value) {
+            std::string value = argv[++i];
+            if (value == "yield") {
+                config.consumer_wait = WaitStrategy::YIELD;
+            } else if (value == "spin") {
+                config.consumer_wait = WaitStrategy::SPIN;
+            } else if (value == "hybrid") {
+                config.consumer_wait = WaitStrategy::HYBRID;
+            } else if (value == "block") {
+                config.consumer_wait = WaitStrategy::BLOCK;
+            } else {
+                std::cerr << "Unknown wait strategy: " << value << std::endl;
+                return false;
+            }
+        } else if (arg == "--verbosity" && has_value) {
+            std::string value = argv[++i];
+            if (value == "quiet") {
+                config.verbosity = Verbosity::QUIET;
+            } else if (value == "stats") {
+                config.verbosity = Verbosity::STATS;
+            } else if (value == "events") {
+                config.verbosity = Verbosity::EVENTS;
+            } else {
+                std::cerr << "Unknown verbosity: " << value << std::endl;
+                return false;
+            }
+        } else if (arg == "--stats-interval" && has_value) {
+            long ms = std::atol(argv[++i]);
+            if (ms < 0 || ms > 3600000) {
+                std::cerr << "Invalid stats interval: " << argv[i] << std::endl;
+                return false;
+            }
+            config.stats_interval_ms = static_cast<uint32_t>(ms);
+        } else if (arg == "--conflate-us" && has_value) {
+            long usecs = std::atol(argv[++i]);
+            if (usecs < 0 || usecs > 10000000) {
+                std::cerr << "Invalid conflation interval: " << argv[i] << std::endl;
+                return false;
+            }
+            config.conflate_interval_us = static_cast<uint32_t>(usecs);
+        } else if (arg == "--publish-mtu" && has_value) {
+            long bytes = std::atol(argv[++i]);
+            if (bytes < 512 || bytes > 65507) {
+                std::cerr << "Invalid publish datagram size: " << argv[i] << std::endl;
+                return false;
+            }
+            config.publish_datagram_bytes = static_cast<size_t>(bytes);
+        } else if (arg == "--publish-format" && has_value) {
+            std::string value = argv[++i];
+            if (value == "json") {
+                config.publish_format = MulticastFormat::JSON;
+            } else if (value == "binary") {
+                config.publish_format = MulticastFormat::BINARY;
+            } else {
+                std::cerr << "Unknown publish format: " << value << std::endl;
+                return false;
+            }
+        } else if (arg == "--depth-levels" && has_value) {
+            long levels = std::atol(argv[++i]);
+            if (levels < 0 || levels > static_cast<long>(MAX_BOOK_DEPTH)) {
+                std::cerr << "Invalid depth levels: " << argv[i] << std::endl;
+                return false;
+            }
+            config.depth_levels = static_cast<size_t>(levels);
+        } else if (arg == "--analytics-window-ms" && has_value) {
+            long ms = std::atol(argv[++i]);
+            if (ms < 0 || ms > 3600000) {
+                std::cerr << "Invalid analytics window: " << argv[i] << std::endl;
+                return false;
+            }
+            config.analytics_window_ms = static_cast<uint32_t>(ms);
+        } else if (arg == "--max-symbols" && has_value) {
+            long symbols = std::atol(argv[++i]);
+            if (symbols < 1 || symbols >= static_cast<long>(INVALID_SYMBOL_ID)) {
+                std::cerr << "Invalid max symbols: " << argv[i] << std::endl;
+                return false;
+            }
+            config.max_symbols = static_cast<size_t>(symbols);
+        } else if (arg == "--arena-mb" && has_value) {
+            long mb = std::atol(argv[++i]);
+            if (mb < 0 || mb > 65536) {
+                std::cerr << "Invalid arena size: " << argv[i] << std::endl;
+                return false;
+            }
+            config.arena_mb = static_cast<size_t>(mb);
+        } else if ((arg == "--book-orders" || arg == "--book-levels") && has_value) {
+            long count = std::atol(argv[++i]);
+            if (count < 0 || count > 100000000) {
+                std::cerr << "Invalid " << arg.substr(2) << " reservation: " << argv[i] << std::endl;
+                return false;
+            }
+            (arg == "--book-orders" ? config.book_orders : config.book_levels) = static_cast<size_t>(count);
+        } else if (arg == "--snapshot-dir" && has_value) {
+            config.snapshot_dir = argv[++i];
+        } else if (arg == "--snapshot-interval" && has_value) {
+            long ms = std::atol(argv[++i]);
+            if (ms < 0 || ms > 3600000) {
+                std::cerr << "Invalid snapshot interval: " << argv[i] << std::endl;
+                return false;
+            }
+            config.snapshot_interval_ms = static_cast<uint32_t>(ms);
+        } else {
+            std::cerr << "Unknown or incomplete option: " << arg << std::endl;
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+    
+    if (config.ingress_backend == IngressBackend::REPLAY && !config.capture_path.empty()) {
+        std::cerr << "--capture cannot be combined with --replay" << std::endl;
+        return false;
+    }
+    if (config.ingress_backend == IngressBackend::XDP && config.xdp_interface.empty()) {
+        std::cerr << "--ingress xdp requires --xdp-if" << std::endl;
+        return false;
+    }
+    for (const auto& entry : config.shard_assignments) {
+        if (entry.second >= config.shard_count) {
+            std::cerr << "Shard " << entry.second << " for " << entry.first
+                      << " out of range (--shards " << config.shard_count << ")" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif // PROCESSOR_CONFIG_HPP
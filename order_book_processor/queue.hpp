@@ -11,24 +11,31 @@ template<typename T>
 class SPSCRingBuffer {
 private:
     // Ring buffer storage - aligned for cache performance
+    // buffer_, capacity_ and mask_ are read-only after construction and share one line
     alignas(64) T* buffer_;
     
     // Buffer capacity (must be power of 2 for efficient modulo)
     size_t capacity_;
     
+    // Mask for efficient modulo operation (capacity - 1)
+    size_t mask_;
+    
     // Head pointer (producer position) - atomic for thread safety
+    // Producer line: head_ plus the producer's last-seen copy of tail_. The
+    // producer only loads the real tail_ (consumer line) when the ring looks full.
     alignas(64) std::atomic<size_t> head_;
+    size_t cached_tail_;
     
-    // Tail pointer (consumer position) - atomic for thread safety  
+    // Tail pointer (consumer position) - atomic for thread safety
+    // Consumer line: tail_ plus the consumer's last-seen copy of head_, refreshed
+    // only when the ring looks empty.
     alignas(64) std::atomic<size_t> tail_;
-    
-    // Mask for efficient modulo operation (capacity - 1)
-    size_t mask_;
+    size_t cached_head_;
 
 public:
     // Constructor
     explicit SPSCRingBuffer(size_t capacity) 
-        : capacity_(0), head_(0), tail_(0), mask_(0) {
+        : buffer_(nullptr), capacity_(0), mask_(0), head_(0), cached_tail_(0), tail_(0), cached_head_(0) {
         
         // Ensure capacity is a power of 2 for efficient modulo with mask
         if (capacity == 0) {
@@ -74,20 +81,24 @@ public:
     
     // Producer operations (single producer)
     bool push(const T& item) {
-        // Check if buffer is full
-        if (full()) {
-            // Buffer is full, cannot push
-            return false;
-        }
-        
-        // Get current head position
+        // Get current head position (only the producer writes it)
         size_t head = head_.load(std::memory_order_relaxed);
+        size_t next = (head + 1) & mask_;
+        
+        // Check if buffer is full, going to the consumer's line only if the cache says so
+        if (next == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (next == cached_tail_) {
+                // Buffer is full, cannot push
+                return false;
+            }
+        }
         
         // Copy item to buffer at head position
         buffer_[head] = item;
         
-        // Advance head pointer (wrapping around if needed)
-        head_.store((head + 1) & mask_, std::memory_order_release);
+        // Advance head pointer (wrapping around if needed); publishes the slot
+        head_.store(next, std::memory_order_release);
         
         return true;
     }
@@ -99,19 +110,22 @@ public:
     
     // Consumer operations (single consumer)
     bool pop(T& item) {
-        // Check if buffer is empty
-        if (empty()) {
-            // Buffer is empty, cannot pop
-            return false;
-        }
-        
-        // Get current tail position
+        // Get current tail position (only the consumer writes it)
         size_t tail = tail_.load(std::memory_order_relaxed);
         
+        // Check if buffer is empty, going to the producer's line only if the cache says so
+        if (tail == cached_head_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail == cached_head_) {
+                // Buffer is empty, cannot pop
+                return false;
+            }
+        }
+        
         // Copy item from buffer at tail position
         item = buffer_[tail];
         
-        // Advance tail pointer (wrapping around if needed)
+        // Advance tail pointer (wrapping around if needed); hands the slot back
         tail_.store((tail + 1) & mask_, std::memory_order_release);
         
         return true;
@@ -122,36 +136,105 @@ public:
         return pop(item);
     }
     
+    // Zero-copy producer API: write the event in place, then publish it.
+    // claim(i) returns the i-th free slot past the write position (nullptr if fewer
+    // than i + 1 slots are free); commit(n) publishes the first n claimed slots
+    // with a single release store. Slots keep their previous contents, so the
+    // producer overwrites only the fields it decodes.
+    T* claim(size_t offset = 0) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (offset >= free_slots(head, cached_tail_)) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (offset >= free_slots(head, cached_tail_)) {
+                return nullptr;
+            }
+        }
+        return &buffer_[(head + offset) & mask_];
+    }
+    
+    void commit(size_t count = 1) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        head_.store((head + count) & mask_, std::memory_order_release);
+    }
+    
+    // Slots the producer can claim right now (producer thread only)
+    size_t writable() {
+        cached_tail_ = tail_.load(std::memory_order_acquire);
+        return free_slots(head_.load(std::memory_order_relaxed), cached_tail_);
+    }
+    
+    // Zero-copy consumer API: process events in place, then hand the slots back.
+    // peek(i) returns the i-th published event (nullptr if fewer than i + 1 are
+    // ready); release(n) frees the first n with a single release store. The
+    // producer may overwrite a slot as soon as it is released.
+    const T* peek(size_t offset = 0) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (offset >= ((cached_head_ - tail) & mask_)) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (offset >= ((cached_head_ - tail) & mask_)) {
+                return nullptr;
+            }
+        }
+        return &buffer_[(tail + offset) & mask_];
+    }
+    
+    void release(size_t count = 1) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        tail_.store((tail + count) & mask_, std::memory_order_release);
+    }
+    
+    // Events the consumer can peek right now (consumer thread only)
+    size_t readable() {
+        cached_head_ = head_.load(std::memory_order_acquire);
+        return (cached_head_ - tail_.load(std::memory_order_relaxed)) & mask_;
+    }
+    
     // Utility functions
+    // These read both indices and are only a snapshot when called off the owning thread
     bool empty() const {
-        return head_.load(std::memory_order_relaxed) == 
-               tail_.load(std::memory_order_relaxed);
+        return head_.load(std::memory_order_acquire) == 
+               tail_.load(std::memory_order_acquire);
     }
     
     bool full() const {
-        size_t head = head_.load(std::memory_order_relaxed);
-        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_acquire);
         return ((head + 1) & mask_) == tail;
     }
     
+    // Approximate occupancy, safe from any thread (backpressure monitoring)
+    size_t size_approx() const {
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        return (head - tail) & mask_;
+    }
+    
     size_t size() const {
-        size_t head = head_.load(std::memory_order_relaxed);
-        size_t tail = tail_.load(std::memory_order_relaxed);
-        
-        if (head >= tail) {
-            return head - tail;
-        } else {
-            return (capacity_ - tail) + head;
-        }
+        return size_approx();
     }
     
     size_t capacity() const {
         return capacity_;
     }
     
+    // Slot array, for memory placement (e.g. moving it to the consumer's NUMA node)
+    const void* storage() const {
+        return buffer_;
+    }
+    
+    size_t storage_bytes() const {
+        return capacity_ * sizeof(T);
+    }
+    
     // Disable copy constructor and assignment
     SPSCRingBuffer(const SPSCRingBuffer&) = delete;
     SPSCRingBuffer& operator=(const SPSCRingBuffer&) = delete;
+
+private:
+    // One slot always stays empty so head == tail means empty
+    size_t free_slots(size_t head, size_t tail) const {
+        return mask_ - ((head - tail) & mask_);
+    }
 };
 
 #endif // QUEUE_HPP 
\ No newline at end of file
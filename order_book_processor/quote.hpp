@@ -1,11 +1,14 @@
 #ifndef QUOTE_HPP
 #define QUOTE_HPP
 
+#include <cmath>
 #include <cstdint>
-#include <string>
+#include <type_traits>
+#include "order_id.hpp"
+#include "symbol_directory.hpp"
 
 // Order book event types (Level 2/3 market data)
-enum class OrderBookEventType {
+enum class OrderBookEventType : uint8_t {
     ADD_ORDER,      // New order added to book
     MODIFY_ORDER,   // Existing order modified (price/size)
     CANCEL_ORDER,   // Order cancelled
@@ -17,33 +20,28 @@ enum class OrderBookEventType {
 };
 
 // Order side
-enum class OrderSide {
+enum class OrderSide : uint8_t {
     BID,    // Buy side
     ASK,    // Sell side
     UNKNOWN
 };
 
-struct OrderBookEvent {
-    // Event identification
-    OrderBookEventType event_type = OrderBookEventType::UNKNOWN;
-    std::string symbol;
-    std::string exchange;
-    std::string order_id;        // Exchange order ID
-    
-    // Order details
-    OrderSide side = OrderSide::UNKNOWN;
-    double price = 0.0;
-    uint32_t size = 0;           // Order size
-    uint32_t remaining_size = 0; // For modify/cancel events
-    
-    // Trade details (for TRADE events)
-    double trade_price = 0.0;
-    uint32_t trade_size = 0;
-    bool is_aggressor = false;   // True if this order was the aggressor
-    
-    // Market status (for MARKET_STATUS events)
-    std::string status_message;
-    bool is_trading_halted = false;
+// Event prices are signed fixed-point integers with EVENT_PRICE_SCALE units per 1.0
+// (the binary feed's own scale, so decoding copies them as-is)
+constexpr int64_t EVENT_PRICE_SCALE = 1000000;
+
+// OrderBookEvent::flags
+constexpr uint8_t EVENT_FLAG_AGGRESSOR = 0x01;        // TRADE: this order was the aggressor
+constexpr uint8_t EVENT_FLAG_TRADING_HALTED = 0x02;   // MARKET_STATUS: trading is halted
+
+// One decoded feed message, exactly one cache line and trivially copyable, so a
+// queue slot is a plain 64-byte block. Variable-length text (symbol, exchange,
+// status message) stays out of band: the symbol and exchange travel as interned
+// IDs, and status text is handed to the decoder's caller alongside the event
+// (see FeedMessageText).
+struct alignas(64) OrderBookEvent {
+    OrderId order_id = INVALID_ORDER_ID;  // Exchange order ID (interned at ingress)
+    int64_t price = 0;                    // Order price, or trade price for TRADE (EVENT_PRICE_SCALE)
     
     // Timestamps
     uint64_t timestamp = 0;           // Exchange timestamp (wall clock)
@@ -52,54 +50,27 @@ struct OrderBookEvent {
     // Monotonic timestamps (nanoseconds, single epoch for latency measurement)
     uint64_t exchange_mono_ns = 0;    // When exchange generated the event
     uint64_t udp_rx_mono_ns = 0;      // When UDP listener received the packet
-    uint64_t enqueued_mono_ns = 0;    // When producer enqueued into SPSC
-
-    // Default constructor
-    OrderBookEvent() = default;
-
-    // Convenience constructors
-    OrderBookEvent(OrderBookEventType type, const std::string& sym, const std::string& ex)
-        : event_type(type), symbol(sym), exchange(ex) {}
-        
-    OrderBookEvent(OrderBookEventType type, const std::string& sym, const std::string& ex,
-                   OrderSide s, double p, uint32_t sz, const std::string& oid)
-        : event_type(type), symbol(sym), exchange(ex), order_id(oid),
-          side(s), price(p), size(sz) {}
+    uint32_t enqueue_delay_ns = 0;    // Receive -> enqueued into SPSC (saturates at ~4.3 s)
+    
+    uint32_t size = 0;                // Order size, or trade size for TRADE
+    SymbolId symbol_id = INVALID_SYMBOL_ID;  // Interned at ingress (see SymbolDirectory)
+    OrderBookEventType event_type = OrderBookEventType::UNKNOWN;
+    OrderSide side = OrderSide::UNKNOWN;
+    uint8_t flags = 0;                // EVENT_FLAG_*
+    SymbolId exchange_id = INVALID_SYMBOL_ID;  // Sequence channel, interned at ingress (snapshots only)
+    
+    double get_price() const { return static_cast<double>(price) / static_cast<double>(EVENT_PRICE_SCALE); }
+    uint64_t enqueued_mono_ns() const { return udp_rx_mono_ns + enqueue_delay_ns; }
+    bool is_aggressor() const { return (flags & EVENT_FLAG_AGGRESSOR) != 0; }
+    bool is_trading_halted() const { return (flags & EVENT_FLAG_TRADING_HALTED) != 0; }
 };
 
-// Legacy Quote struct (Not used currently)
-struct Quote {
-    // Core market data (top-of-book)
-    std::string symbol;
-    double bid_price;
-    uint32_t bid_size;
-    double ask_price;
-    uint32_t ask_size;
-
-    // Wall-clock exchange timestamp from feed (may be simulated)
-    uint64_t timestamp;           // Exchange timestamp (wall clock, if provided)
-    std::string exchange;
+static_assert(sizeof(OrderBookEvent) == 64, "OrderBookEvent should fill exactly one cache line");
+static_assert(std::is_trivially_copyable<OrderBookEvent>::value, "OrderBookEvent must stay trivially copyable");
 
-    // Monotonic timestamps (nanoseconds, single epoch for the whole pipeline)
-    // These are used for latency calculations
-    uint64_t exchange_mono_ns = 0;   // When exchange generated (simulated) the update
-    uint64_t udp_rx_mono_ns = 0;     // When UDP listener received the packet
-    uint64_t enqueued_mono_ns = 0;   // When producer enqueued into SPSC
-
-    // Legacy fields (not used in new monotonic pipeline)
-    uint64_t receive_timestamp = 0;   // Deprecated
-    uint64_t queue_push_timestamp = 0; // Deprecated
-    uint64_t push_latency = 0;         // Deprecated
-    bool queue_full = false;           // For overflow tracking if needed
-
-    // Default constructor
-    Quote() = default;
-
-    // Convenience constructor
-    Quote(const std::string& sym, double bid, uint32_t bid_sz,
-          double ask, uint32_t ask_sz, uint64_t ts, const std::string& ex)
-        : symbol(sym), bid_price(bid), bid_size(bid_sz),
-          ask_price(ask), ask_size(ask_sz), timestamp(ts), exchange(ex) {}
-};
+// Fixed-point event price for a decimal price (rounded to the nearest unit)
+inline int64_t to_event_price(double price) {
+    return static_cast<int64_t>(std::llround(price * static_cast<double>(EVENT_PRICE_SCALE)));
+}
 
-#endif // QUOTE_HPP 
\ No newline at end of file
+#endif // QUOTE_HPP
@@ -0,0 +1,186 @@
+#ifndef REPLAY_LISTENER_HPP
+#define REPLAY_LISTENER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "feed_capture.hpp"
+#include "feed_decoder.hpp"
+
+// Capture file ingress backend (same interface as UDPListener).
+//
+// Feeds the datagrams of a --capture file through the same FeedDecoder, queues
+// and consumers as live traffic, either as fast as the pipeline takes them
+// (speed 0) or at the recorded pacing scaled by speed (1 = real time). Full
+// queues push back on the replay instead of dropping, so every run processes
+// the same events. Receive timestamps are taken at replay time, so every leg
+// except Exchange → UDP measures this run.
+class ReplayListener {
+private:
+    std::string path_;
+    FeedCaptureReader reader_;
+    double speed_;                      // 0 = as fast as possible
+    std::atomic<bool>* shutdown_flag_;
+    FeedDecoder decoder_;
+
+    static constexpr size_t MAX_SPEED_BATCH = 64;  // Datagrams published per flush at full speed
+    uint64_t datagrams_replayed_;
+
+public:
+    explicit ReplayListener(const std::string& path)
+        : path_(path), speed_(0.0), shutdown_flag_(nullptr), datagrams_replayed_(0) {}
+
+    bool initialize() {
+        if (!reader_.open(path_)) {
+            return false;
+        }
+        std::cout << "Replaying capture " << path_ << " (" << reader_.get_size() << " bytes, "
+                  << (speed_ > 0.0 ? "recorded pacing x" + std::to_string(speed_) : std::string("full speed"))
+                  << ")" << std::endl;
+        return true;
+    }
+
+    // Replay the whole capture, then return
+    void listen() {
+        const char* data = nullptr;
+        size_t len = 0;
+        uint64_t recorded_ns = 0;
+        uint64_t first_recorded_ns = 0;
+        uint64_t paced_ns = 0;          // Recorded time since the first datagram, never goes backwards
+        size_t batch = 0;
+        auto start = std::chrono::steady_clock::now();
+
+        while (reader_.next(data, len, recorded_ns)) {
+            if (shutdown_flag_ && shutdown_flag_->load(std::memory_order_relaxed)) {
+                break;
+            }
+
+            if (speed_ > 0.0) {
+                if (datagrams_replayed_ == 0) {
+                    first_recorded_ns = recorded_ns;
+                }
+                // A receive timestamp that stepped back replays immediately instead of wrapping
+                if (recorded_ns > first_recorded_ns && recorded_ns - first_recorded_ns > paced_ns) {
+                    paced_ns = recorded_ns - first_recorded_ns;
+                }
+                wait_until(start + std::chrono::nanoseconds(static_cast<int64_t>(
+                    static_cast<double>(paced_ns) / speed_)));
+            }
+
+            // Stamp before decoding, like a live receive, so UDP -> Queue covers the decode
+            uint64_t rx_mono_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+            decoder_.handle_datagram(data, len, rx_mono_ns);
+            ++datagrams_replayed_;
+
+            // Paced replay publishes each datagram like a live receive; full speed batches
+            if (speed_ > 0.0 || ++batch == MAX_SPEED_BATCH) {
+                decoder_.flush();
+                batch = 0;
+            }
+        }
+        decoder_.flush();
+
+        auto elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        std::cout << "Replay finished: " << datagrams_replayed_ << " datagrams in " << elapsed_us / 1000.0
+                  << " ms (" << (elapsed_us > 0 ? datagrams_replayed_ * 1000000ULL / static_cast<uint64_t>(elapsed_us) : 0)
+                  << " datagrams/s)" << std::endl;
+    }
+
+    void shutdown() {}
+
+    // Set callback for order book event processing
+    void set_order_book_callback(std::function<void(const OrderBookEvent&)> callback) {
+        decoder_.set_order_book_callback(callback);
+    }
+
+    // Decode datagrams straight into the queue's slots (takes precedence over the callbacks)
+    void set_output_queue(SPSCRingBuffer<OrderBookEvent>* queue, QueueWakeup* wakeup = nullptr) {
+        decoder_.set_output_queue(queue, wakeup);
+    }
+
+    // Sharded form: each event goes to queues[shard_map->shard_for(symbol)]
+    void set_output_queues(const std::vector<SPSCRingBuffer<OrderBookEvent>*>& queues, const ShardMap* shard_map,
+                           const std::vector<QueueWakeup*>& wakeups = {}) {
+        decoder_.set_output_queues(queues, shard_map, wakeups);
+    }
+
+    // Stamp events with their symbol's interned ID (see SymbolDirectory)
+    void set_symbol_directory(SymbolDirectory* symbols) {
+        decoder_.set_symbol_directory(symbols);
+    }
+
+    void set_exchange_directory(SymbolDirectory* exchanges) {
+        decoder_.set_exchange_directory(exchanges);
+    }
+
+    uint64_t get_events_enqueued() const {
+        return decoder_.get_events_enqueued();
+    }
+
+    uint64_t get_events_dropped() const {
+        return decoder_.get_events_dropped();
+    }
+
+    // Producer counters for the stats reporter (safe to read from other threads)
+    const IngressStats& get_ingress_stats() const {
+        return decoder_.get_ingress_stats();
+    }
+
+    // Drop duplicate sequence numbers and count gaps (default: on)
+    void set_sequence_check(bool enabled) {
+        decoder_.set_sequence_check(enabled);
+    }
+
+    const SequenceArbiter& get_sequence_arbiter() const {
+        return decoder_.get_sequence_arbiter();
+    }
+
+    const OrderIdTable& get_order_ids() const {
+        return decoder_.get_order_ids();
+    }
+
+    // Select the ingress wire format (default: AUTO)
+    void set_feed_format(FeedFormat format) {
+        decoder_.set_feed_format(format);
+    }
+
+    // Recorded pacing multiplier (0 = as fast as possible)
+    void set_speed(double speed) {
+        speed_ = speed > 0.0 ? speed : 0.0;
+    }
+
+    // Set shutdown flag for graceful shutdown; full queues wait on the consumers until it is set
+    void set_shutdown_flag(std::atomic<bool>* flag) {
+        shutdown_flag_ = flag;
+        decoder_.set_block_when_full(flag);
+    }
+
+    uint64_t get_datagrams_replayed() const {
+        return datagrams_replayed_;
+    }
+
+    // Disable copy constructor and assignment
+    ReplayListener(const ReplayListener&) = delete;
+    ReplayListener& operator=(const ReplayListener&) = delete;
+
+private:
+    // Sleep for long waits, spin for the last stretch so pacing stays accurate
+    void wait_until(std::chrono::steady_clock::time_point target) {
+        while (true) {
+            auto now = std::chrono::steady_clock::now();
+            if (now >= target) return;
+            if (shutdown_flag_ && shutdown_flag_->load(std::memory_order_relaxed)) return;
+            if (target - now > std::chrono::microseconds(200)) {
+                std::this_thread::sleep_for(target - now - std::chrono::microseconds(100));
+            }
+        }
+    }
+};
+
+#endif // REPLAY_LISTENER_HPP
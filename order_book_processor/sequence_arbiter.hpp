@@ -0,0 +1,92 @@
+#ifndef SEQUENCE_ARBITER_HPP
+#define SEQUENCE_ARBITER_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Outcome of offering one message to the arbiter
+enum class SequenceCheck {
+    ACCEPT,     // Next expected sequence (or first message seen on the channel)
+    GAP,        // Ahead of the expected sequence: accepted, the skipped messages are lost
+    DUPLICATE,  // Already seen (the other feed line's copy, or a late packet): drop it
+    RESET       // Far behind the expected sequence: the feed restarted, accepted
+};
+
+// A/B line arbitration and gap detection on the feed's sequence numbers.
+//
+// Each channel (the exchange code; every exchange numbers its own stream) keeps
+// the next sequence it expects. The first copy of a sequence to arrive wins,
+// from whichever line is faster right now, and any later copy is dropped. There
+// is no reorder buffer: a message is only used if it arrives before any later
+// sequence on its channel, so the books never see events out of order.
+// Owned by the ingress thread.
+class SequenceArbiter {
+public:
+    // Messages behind the expected sequence that still count as late copies;
+    // anything further back is taken as a sequence reset (feed restart)
+    static constexpr uint64_t LATE_WINDOW = 65536;
+
+    struct Channel {
+        std::string name;
+        uint64_t next_expected = 0;
+        uint64_t accepted = 0;
+        uint64_t duplicates = 0;
+        uint64_t gaps = 0;
+        uint64_t messages_lost = 0;     // Sum of gap sizes
+        uint64_t resets = 0;
+    };
+
+    // lost is set to the number of skipped messages for GAP, 0 otherwise
+    SequenceCheck check(std::string_view channel_name, uint64_t sequence, uint64_t& lost) {
+        lost = 0;
+        Channel& channel = find_channel(channel_name);
+
+        if (channel.accepted == 0) {
+            channel.next_expected = sequence + 1;
+            ++channel.accepted;
+            return SequenceCheck::ACCEPT;
+        }
+        if (sequence == channel.next_expected) {
+            ++channel.next_expected;
+            ++channel.accepted;
+            return SequenceCheck::ACCEPT;
+        }
+        if (sequence > channel.next_expected) {
+            lost = sequence - channel.next_expected;
+            ++channel.gaps;
+            channel.messages_lost += lost;
+            channel.next_expected = sequence + 1;
+            ++channel.accepted;
+            return SequenceCheck::GAP;
+        }
+        if (channel.next_expected - sequence <= LATE_WINDOW) {
+            ++channel.duplicates;
+            return SequenceCheck::DUPLICATE;
+        }
+        ++channel.resets;
+        channel.next_expected = sequence + 1;
+        ++channel.accepted;
+        return SequenceCheck::RESET;
+    }
+
+    const std::vector<Channel>& get_channels() const {
+        return channels_;
+    }
+
+private:
+    // Linear scan: a feed has a handful of channels at most
+    Channel& find_channel(std::string_view name) {
+        for (auto& channel : channels_) {
+            if (channel.name == name) return channel;
+        }
+        channels_.emplace_back();
+        channels_.back().name = std::string(name);
+        return channels_.back();
+    }
+
+    std::vector<Channel> channels_;
+};
+
+#endif // SEQUENCE_ARBITER_HPP
@@ -0,0 +1,54 @@
+#ifndef SHARD_MAP_HPP
+#define SHARD_MAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+
+// Symbol -> consumer shard assignment.
+// Symbols are spread by a stable FNV-1a hash unless pinned explicitly (e.g. to
+// give a hot symbol a shard of its own). A symbol always maps to the same shard,
+// so the single producer keeps per-symbol ordering across shards.
+class ShardMap {
+private:
+    size_t shard_count_;
+    std::map<std::string, size_t, std::less<>> pinned_;  // Explicit overrides
+
+public:
+    explicit ShardMap(size_t shard_count = 1) : shard_count_(shard_count > 0 ? shard_count : 1) {}
+
+    // Pin a symbol to a shard (ignored if shard is out of range)
+    void assign(const std::string& symbol, size_t shard) {
+        if (shard < shard_count_) {
+            pinned_[symbol] = shard;
+        }
+    }
+
+    size_t shard_for(std::string_view symbol) const {
+        if (shard_count_ == 1) {
+            return 0;
+        }
+        if (!pinned_.empty()) {
+            auto it = pinned_.find(symbol);
+            if (it != pinned_.end()) {
+                return it->second;
+            }
+        }
+
+        uint64_t hash = 14695981039346656037ULL;  // FNV-1a offset basis
+        for (char c : symbol) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211ULL;  // FNV-1a prime
+        }
+        return static_cast<size_t>(hash % shard_count_);
+    }
+
+    size_t shard_count() const {
+        return shard_count_;
+    }
+};
+
+#endif // SHARD_MAP_HPP
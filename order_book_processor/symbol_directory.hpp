@@ -0,0 +1,116 @@
+#ifndef SYMBOL_DIRECTORY_HPP
+#define SYMBOL_DIRECTORY_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+// Symbols are interned into dense 16-bit IDs at ingress, so everything
+// downstream (routing, books, conflation, publishing) indexes arrays instead
+// of hashing or comparing strings. IDs count up from 0 in first-seen order and
+// stay fixed for the life of the process; the binary multicast header carries
+// them next to the name.
+using SymbolId = uint16_t;
+
+// Reserved value (never handed out: empty or over-long symbol, or directory full)
+constexpr SymbolId INVALID_SYMBOL_ID = 0xFFFF;
+
+// Symbol name <-> ID table shared by the ingress thread and the consumer shards.
+//
+// Lookups are lock-free: open addressing with linear probing over a power-of-two
+// table at most half full, where a slot is published (release) only after its
+// name is stored, so a probe can stop at the first unused slot. Adding a symbol
+// takes a mutex, which only happens once per symbol. Names are never moved, so
+// name(id) references stay valid.
+class SymbolDirectory {
+public:
+    static constexpr size_t MAX_SYMBOL_LENGTH = 15;
+    static constexpr size_t DEFAULT_CAPACITY = 4096;
+
+    explicit SymbolDirectory(size_t capacity = DEFAULT_CAPACITY)
+        : capacity_(capacity < INVALID_SYMBOL_ID ? capacity : INVALID_SYMBOL_ID), count_(0) {
+        size_t table_size = 1;
+        while (table_size < capacity_ * 2) table_size <<= 1;
+        mask_ = table_size - 1;
+        slots_.reset(new std::atomic<SymbolId>[table_size]);
+        for (size_t i = 0; i < table_size; ++i) {
+            slots_[i].store(INVALID_SYMBOL_ID, std::memory_order_relaxed);
+        }
+        names_.reset(new std::string[capacity_]);
+    }
+
+    // ID of symbol, assigning the next one on first sight (any thread).
+    // INVALID_SYMBOL_ID if it is empty, too long, or the directory is full.
+    SymbolId intern(std::string_view symbol) {
+        SymbolId id = find(symbol);
+        if (id != INVALID_SYMBOL_ID || symbol.empty() || symbol.size() > MAX_SYMBOL_LENGTH) {
+            return id;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t slot = probe(symbol);
+        id = slots_[slot].load(std::memory_order_relaxed);
+        if (id != INVALID_SYMBOL_ID) {
+            return id;  // Added by another thread meanwhile
+        }
+        size_t count = count_.load(std::memory_order_relaxed);
+        if (count == capacity_) {
+            return INVALID_SYMBOL_ID;
+        }
+        id = static_cast<SymbolId>(count);
+        names_[id].assign(symbol.data(), symbol.size());
+        slots_[slot].store(id, std::memory_order_release);
+        count_.store(count + 1, std::memory_order_release);
+        return id;
+    }
+
+    // ID of a known symbol, INVALID_SYMBOL_ID if it was never interned (any thread)
+    SymbolId find(std::string_view symbol) const {
+        if (symbol.empty() || symbol.size() > MAX_SYMBOL_LENGTH) {
+            return INVALID_SYMBOL_ID;
+        }
+        return slots_[probe(symbol)].load(std::memory_order_acquire);
+    }
+
+    // Name of an ID returned by intern() (any thread that got the ID)
+    const std::string& name(SymbolId id) const {
+        return names_[id];
+    }
+
+    // Symbols interned so far; every ID below this is valid
+    size_t size() const { return count_.load(std::memory_order_acquire); }
+    size_t capacity() const { return capacity_; }
+
+    // Disable copy constructor and assignment
+    SymbolDirectory(const SymbolDirectory&) = delete;
+    SymbolDirectory& operator=(const SymbolDirectory&) = delete;
+
+private:
+    // The slot holding symbol, or the unused slot where it would go
+    size_t probe(std::string_view symbol) const {
+        uint64_t hash = 14695981039346656037ULL;  // FNV-1a offset basis
+        for (char c : symbol) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211ULL;  // FNV-1a prime
+        }
+        for (size_t i = hash & mask_;; i = (i + 1) & mask_) {
+            SymbolId id = slots_[i].load(std::memory_order_acquire);
+            if (id == INVALID_SYMBOL_ID || names_[id] == symbol) {
+                return i;
+            }
+        }
+    }
+
+    size_t capacity_;
+    size_t mask_;
+    std::unique_ptr<std::atomic<SymbolId>[]> slots_;   // Hash table of IDs (INVALID = unused)
+    std::unique_ptr<std::string[]> names_;             // By ID, written once before the ID is published
+    std::atomic<size_t> count_;
+    std::mutex mutex_;                                 // Serializes adds
+};
+
+#endif // SYMBOL_DIRECTORY_HPP
@@ -0,0 +1,603 @@
+#ifndef TICK_ORDER_BOOK_HPP
+#define TICK_ORDER_BOOK_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+#include "quote.hpp"
+#include "orderbook.hpp"
+#include "object_pool.hpp"
+#include "flat_hash_map.hpp"
+#include "depth_view.hpp"
+
+// One side of a tick-indexed book.
+// Levels live in a contiguous window of slots indexed by (tick - base_tick_),
+// centered on the touch. Each slot holds an index into a stable level pool, and
+// an occupancy bitmap lets us find the next best level with a few word scans
+// instead of walking a tree. The window never grows past max_slots, so a stray
+// price far from the book is refused instead of sizing the ladder after it.
+class PriceLadder {
+private:
+    static constexpr int32_t EMPTY_SLOT = -1;
+
+    bool is_bid_;                        // Bids: best = highest tick, asks: best = lowest tick
+    int64_t base_tick_;                  // Tick stored in slots_[0]
+    size_t max_slots_;                   // Largest window (a power of two)
+    std::vector<int32_t> slots_;         // tick - base_tick_ -> index into level_pool_
+    std::vector<uint64_t> occupied_;     // One bit per slot, set when the level is non-empty
+    int64_t best_tick_;                  // Valid only when level_count_ > 0
+    size_t level_count_;
+    size_t level_high_water_;            // Most levels ever in use at once
+
+    std::deque<PriceLevel> level_pool_;  // Stable addresses, reused through free_levels_
+    std::vector<int32_t> free_levels_;
+
+public:
+    PriceLadder(bool is_bid, size_t initial_slots, size_t max_slots)
+        : is_bid_(is_bid), base_tick_(0), max_slots_(64), best_tick_(0), level_count_(0), level_high_water_(0) {
+        while (max_slots_ < max_slots) {
+            max_slots_ <<= 1;
+        }
+        size_t capacity = 64;
+        while (capacity < initial_slots && capacity < max_slots_) {
+            capacity <<= 1;
+        }
+        slots_.assign(capacity, EMPTY_SLOT);
+        occupied_.assign(capacity / 64, 0);
+    }
+
+    // O(1) level lookup by tick (nullptr if the level does not exist)
+    PriceLevel* find(int64_t tick) {
+        if (!in_window(tick)) return nullptr;
+        int32_t idx = slots_[static_cast<size_t>(tick - base_tick_)];
+        return idx == EMPTY_SLOT ? nullptr : &level_pool_[idx];
+    }
+
+    const PriceLevel* find(int64_t tick) const {
+        if (!in_window(tick)) return nullptr;
+        int32_t idx = slots_[static_cast<size_t>(tick - base_tick_)];
+        return idx == EMPTY_SLOT ? nullptr : &level_pool_[idx];
+    }
+
+    // O(1) amortized: returns the level at tick, creating it if needed.
+    // The window is re-anchored (and grown if the book is wider than it) only
+    // when a price lands outside of it. nullptr when tick and the occupied
+    // levels cannot fit in max_slots.
+    PriceLevel* find_or_create(int64_t tick, double price) {
+        if (!in_window(tick) && !reanchor(tick)) {
+            return nullptr;
+        }
+
+        size_t pos = static_cast<size_t>(tick - base_tick_);
+        if (slots_[pos] != EMPTY_SLOT) {
+            return &level_pool_[slots_[pos]];
+        }
+
+        int32_t idx;
+        if (!free_levels_.empty()) {
+            idx = free_levels_.back();
+            free_levels_.pop_back();
+            level_pool_[idx] = PriceLevel(price);
+        } else {
+            idx = static_cast<int32_t>(level_pool_.size());
+            level_pool_.emplace_back(price);
+        }
+
+        slots_[pos] = idx;
+        occupied_[pos >> 6] |= (1ULL << (pos & 63));
+
+        if (level_count_ == 0 || is_better(tick, best_tick_)) {
+            best_tick_ = tick;
+        }
+        if (++level_count_ > level_high_water_) {
+            level_high_water_ = level_count_;
+        }
+
+        return &level_pool_[idx];
+    }
+
+    // O(1) erase, plus a bitmap scan when the best level goes away
+    void erase(int64_t tick) {
+        if (!in_window(tick)) return;
+
+        size_t pos = static_cast<size_t>(tick - base_tick_);
+        int32_t idx = slots_[pos];
+        if (idx == EMPTY_SLOT) return;
+
+        level_pool_[idx] = PriceLevel();
+        free_levels_.push_back(idx);
+        slots_[pos] = EMPTY_SLOT;
+        occupied_[pos >> 6] &= ~(1ULL << (pos & 63));
+        --level_count_;
+
+        if (level_count_ > 0 && tick == best_tick_) {
+            best_tick_ = base_tick_ + (is_bid_ ? scan_down(pos) : scan_up(pos));
+        }
+    }
+
+    // O(1) best level (nullptr if the side is empty)
+    const PriceLevel* best() const {
+        return level_count_ > 0 ? find(best_tick_) : nullptr;
+    }
+
+    // First level behind tick in priority order (lower for bids, higher for asks),
+    // found with a bitmap scan; nullptr if there is none
+    const PriceLevel* next_worse(int64_t tick) const {
+        if (level_count_ == 0) return nullptr;
+        int64_t end = base_tick_ + static_cast<int64_t>(slots_.size());
+        size_t pos;
+        if (is_bid_) {
+            if (tick <= base_tick_) return nullptr;
+            if (!try_scan_down(tick > end ? slots_.size() - 1 : static_cast<size_t>(tick - 1 - base_tick_), pos)) {
+                return nullptr;
+            }
+        } else {
+            if (tick >= end - 1) return nullptr;
+            if (!try_scan_up(tick < base_tick_ ? 0 : static_cast<size_t>(tick + 1 - base_tick_), pos)) {
+                return nullptr;
+            }
+        }
+        return &level_pool_[slots_[pos]];
+    }
+
+    size_t size() const {
+        return level_count_;
+    }
+
+    bool empty() const {
+        return level_count_ == 0;
+    }
+
+    // Pre-create levels so the first `count` distinct levels need no allocation
+    void reserve(size_t count) {
+        while (level_pool_.size() < count) {
+            free_levels_.push_back(static_cast<int32_t>(level_pool_.size()));
+            level_pool_.emplace_back();
+        }
+    }
+
+    size_t high_water() const {
+        return level_high_water_;
+    }
+
+    size_t capacity() const {
+        return level_pool_.size();
+    }
+
+    // Visit every non-empty level in ascending tick order
+    template<typename Fn>
+    void for_each_level(Fn&& fn) const {
+        for (size_t word = 0; word < occupied_.size(); ++word) {
+            for (uint64_t bits = occupied_[word]; bits; bits &= bits - 1) {
+                size_t pos = (word << 6) + static_cast<size_t>(__builtin_ctzll(bits));
+                fn(level_pool_[slots_[pos]]);
+            }
+        }
+    }
+
+    void clear() {
+        std::fill(slots_.begin(), slots_.end(), EMPTY_SLOT);
+        std::fill(occupied_.begin(), occupied_.end(), 0);
+        // Keep the levels for reuse: a cleared book refills without allocating
+        free_levels_.clear();
+        for (size_t idx = level_pool_.size(); idx-- > 0;) {
+            level_pool_[idx] = PriceLevel();
+            free_levels_.push_back(static_cast<int32_t>(idx));
+        }
+        level_count_ = 0;
+    }
+
+private:
+    bool in_window(int64_t tick) const {
+        return tick >= base_tick_ && tick < base_tick_ + static_cast<int64_t>(slots_.size());
+    }
+
+    bool is_better(int64_t a, int64_t b) const {
+        return is_bid_ ? a > b : a < b;
+    }
+
+    // Highest occupied slot position <= pos (caller guarantees one exists)
+    size_t scan_down(size_t pos) const {
+        size_t word = pos >> 6;
+        uint64_t bits = occupied_[word] & (~0ULL >> (63 - (pos & 63)));
+        while (bits == 0) {
+            bits = occupied_[--word];
+        }
+        return (word << 6) + (63 - static_cast<size_t>(__builtin_clzll(bits)));
+    }
+
+    // Lowest occupied slot position >= pos (caller guarantees one exists)
+    size_t scan_up(size_t pos) const {
+        size_t word = pos >> 6;
+        uint64_t bits = occupied_[word] & (~0ULL << (pos & 63));
+        while (bits == 0) {
+            bits = occupied_[++word];
+        }
+        return (word << 6) + static_cast<size_t>(__builtin_ctzll(bits));
+    }
+
+    // Bounded scan_down/scan_up: false when no occupied slot exists in that direction
+    bool try_scan_down(size_t pos, size_t& found) const {
+        size_t word = pos >> 6;
+        uint64_t bits = occupied_[word] & (~0ULL >> (63 - (pos & 63)));
+        while (bits == 0) {
+            if (word == 0) return false;
+            bits = occupied_[--word];
+        }
+        found = (word << 6) + (63 - static_cast<size_t>(__builtin_clzll(bits)));
+        return true;
+    }
+
+    bool try_scan_up(size_t pos, size_t& found) const {
+        size_t word = pos >> 6;
+        uint64_t bits = occupied_[word] & (~0ULL << (pos & 63));
+        while (bits == 0) {
+            if (++word == occupied_.size()) return false;
+            bits = occupied_[word];
+        }
+        found = (word << 6) + static_cast<size_t>(__builtin_ctzll(bits));
+        return true;
+    }
+
+    // Move the window so that it covers `tick` and every occupied level,
+    // doubling the capacity until the occupied span fits with headroom (up to
+    // max_slots_). False, leaving the window as it was, when the span is wider.
+    // Ticks are bounded by TickOrderBook::MAX_TICK, so the span cannot overflow.
+    bool reanchor(int64_t tick) {
+        int64_t low = tick;
+        int64_t high = tick;
+        if (level_count_ > 0) {
+            low = std::min(low, base_tick_ + static_cast<int64_t>(scan_up(0)));
+            high = std::max(high, base_tick_ + static_cast<int64_t>(scan_down(slots_.size() - 1)));
+        }
+
+        size_t span = static_cast<size_t>(high - low) + 1;
+        if (span > max_slots_) {
+            return false;
+        }
+        size_t capacity = slots_.size();
+        while (capacity < span * 2 && capacity < max_slots_) {
+            capacity <<= 1;
+        }
+
+        // Center the occupied span in the new window
+        int64_t new_base = low - static_cast<int64_t>((capacity - span) / 2);
+
+        std::vector<int32_t> new_slots(capacity, EMPTY_SLOT);
+        std::vector<uint64_t> new_occupied(capacity / 64, 0);
+        for (size_t pos = 0; pos < slots_.size(); ++pos) {
+            if (slots_[pos] == EMPTY_SLOT) continue;
+            size_t new_pos = static_cast<size_t>(base_tick_ + static_cast<int64_t>(pos) - new_base);
+            new_slots[new_pos] = slots_[pos];
+            new_occupied[new_pos >> 6] |= (1ULL << (new_pos & 63));
+        }
+
+        slots_.swap(new_slots);
+        occupied_.swap(new_occupied);
+        base_tick_ = new_base;
+        return true;
+    }
+};
+
+// Order book backed by integer-tick price ladders.
+// Drop-in alternative to OrderBook (same public API): prices are converted
+// to ticks with the symbol's tick size, so level lookups, inserts and erases
+// are array indexing instead of floating-point keyed std::map operations.
+// Each side's ladder spans at most max_ladder_ticks; an order priced outside
+// that window around the resting levels is rejected and counted.
+class TickOrderBook {
+private:
+    double tick_size_;
+    uint64_t rejected_prices_;
+
+    // Pool-allocated order nodes (no allocation per order once warmed up)
+    ObjectPool<Order> order_pool;
+
+    // Order lookup by interned order_id for O(1) access, pointing straight at the node
+    FlatHashMap<Order*> orders_by_id;
+
+    // Tick-indexed price levels for O(1) best bid/ask
+    PriceLadder bid_levels;
+    PriceLadder ask_levels;
+
+    // Best N levels per side, updated with every level change (off until set_depth_levels)
+    DepthView bid_depth{true};
+    DepthView ask_depth{false};
+
+public:
+    static constexpr size_t DEFAULT_LADDER_SLOTS = 4096;
+    static constexpr size_t DEFAULT_MAX_LADDER_TICKS = 1 << 20;    // 4 MB of slots per side at most
+
+    // Largest tick magnitude accepted (doubles stay exact integers below it)
+    static constexpr int64_t MAX_TICK = 1LL << 52;
+    static constexpr int64_t INVALID_TICK = INT64_MIN;
+
+    explicit TickOrderBook(double tick_size = 0.01, size_t ladder_slots = DEFAULT_LADDER_SLOTS,
+                           size_t max_ladder_ticks = DEFAULT_MAX_LADDER_TICKS)
+        : tick_size_(tick_size), rejected_prices_(0),
+          bid_levels(true, ladder_slots, max_ladder_ticks),
+          ask_levels(false, ladder_slots, max_ladder_ticks) {}
+
+    ~TickOrderBook() { clear(); }
+
+    TickOrderBook(TickOrderBook&&) = default;
+    TickOrderBook& operator=(TickOrderBook&&) = default;
+
+    double get_tick_size() const {
+        return tick_size_;
+    }
+
+    // Carve future order slabs out of arena (nullptr = heap). Price levels live
+    // in the ladders' own pools. Call before the book grows.
+    void set_arena(BookArena* arena) {
+        order_pool.set_arena(arena);
+    }
+
+    // Pre-size for orders resting orders on levels price levels (both sides),
+    // so a book that stays within them never allocates
+    void reserve(size_t orders, size_t levels) {
+        order_pool.reserve(orders);
+        orders_by_id.reserve(orders);
+        bid_levels.reserve((levels + 1) / 2);
+        ask_levels.reserve((levels + 1) / 2);
+    }
+
+    BookPoolStats get_pool_stats() const {
+        BookPoolStats stats;
+        stats.orders_high_water = order_pool.high_water();
+        stats.orders_capacity = order_pool.capacity();
+        stats.levels_high_water = bid_levels.high_water() + ask_levels.high_water();
+        stats.levels_capacity = bid_levels.capacity() + ask_levels.capacity();
+        return stats;
+    }
+
+    // INVALID_TICK for a price that is not finite or beyond MAX_TICK ticks
+    int64_t price_to_ticks(double price) const {
+        double ticks = price / tick_size_;
+        if (!(std::fabs(ticks) < static_cast<double>(MAX_TICK))) {
+            return INVALID_TICK;
+        }
+        return static_cast<int64_t>(std::llround(ticks));
+    }
+
+    // ADDs refused for a price the ladder window cannot cover
+    uint64_t get_rejected_prices() const {
+        return rejected_prices_;
+    }
+
+    // O(1) add order by order_id
+    bool add_order(OrderId order_id, OrderSide side, double price, uint32_t size, uint64_t timestamp = 0) {
+        if (side != OrderSide::BID && side != OrderSide::ASK) {
+            return false;
+        }
+
+        auto inserted = orders_by_id.try_emplace(order_id, nullptr);
+        if (!inserted.second) {
+            return false;  // Order already exists (or invalid order_id)
+        }
+
+        int64_t tick = price_to_ticks(price);
+        PriceLevel* level = tick != INVALID_TICK ? ladder(side).find_or_create(tick, price) : nullptr;
+        if (!level) {
+            orders_by_id.erase(order_id);
+            ++rejected_prices_;
+            return false;  // Outlier or garbage price
+        }
+
+        Order* order = order_pool.create(order_id, side, price, size, timestamp);
+        *inserted.first = order;
+        level->add_order(order);
+        update_depth(side, level->price, level->total_size);
+        return true;
+    }
+
+    // O(1) modify order by order_id
+    bool modify_order(OrderId order_id, uint32_t new_size) {
+        Order** slot = orders_by_id.find(order_id);
+        if (!slot) {
+            return false;  // Order not found
+        }
+
+        Order* order = *slot;
+        PriceLevel* level = order->level;
+        level->modify_order(order, new_size);
+        update_depth(order->side, level->price, level->total_size);
+        return true;
+    }
+
+    // O(1) cancel order by order_id
+    bool cancel_order(OrderId order_id) {
+        Order** slot = orders_by_id.find(order_id);
+        if (!slot) {
+            return false;  // Order not found
+        }
+
+        Order* order = *slot;
+        PriceLevel* level = order->level;
+        level->remove_order(order);
+
+        // Remove empty price levels (the level is recycled, so keep its price for the depth view)
+        double level_price = level->price;
+        uint32_t level_size = level->total_size;
+        if (level->empty()) {
+            level_size = 0;
+            ladder(order->side).erase(price_to_ticks(order->price));
+        }
+        update_depth(order->side, level_price, level_size);
+
+        orders_by_id.erase(order_id);
+        order_pool.destroy(order);
+        return true;
+    }
+
+    // O(1) fill quantity of a resting order (a trade against it). A partly
+    // filled order keeps its FIFO position; a filled one is removed. The
+    // order's side is stored in resting_side (if given) when it is found.
+    bool execute_order(OrderId order_id, uint32_t quantity, OrderSide* resting_side = nullptr) {
+        Order** slot = orders_by_id.find(order_id);
+        if (!slot) {
+            return false;  // Not resting here (e.g. the aggressor's own ID)
+        }
+
+        Order* order = *slot;
+        if (resting_side) {
+            *resting_side = order->side;
+        }
+        if (quantity >= order->size) {
+            return cancel_order(order_id);
+        }
+        PriceLevel* level = order->level;
+        level->modify_order(order, order->size - quantity);
+        update_depth(order->side, level->price, level->total_size);
+        return true;
+    }
+
+    // O(1) get best bid
+    std::pair<double, uint32_t> get_best_bid() const {
+        const PriceLevel* level = bid_levels.best();
+        if (!level) return {0.0, 0};
+        return {level->price, level->total_size};
+    }
+
+    // O(1) get best ask
+    std::pair<double, uint32_t> get_best_ask() const {
+        const PriceLevel* level = ask_levels.best();
+        if (!level) return {0.0, 0};
+        return {level->price, level->total_size};
+    }
+
+    double get_spread() const {
+        auto bid = get_best_bid();
+        auto ask = get_best_ask();
+        if (bid.first > 0 && ask.first > 0) {
+            return ask.first - bid.first;
+        }
+        return 0.0;
+    }
+
+    // O(1) get total size at a specific price level
+    uint32_t get_size_at_price(OrderSide side, double price) const {
+        const PriceLevel* level = find_level(side, price);
+        return level ? level->total_size : 0;
+    }
+
+    // Get number of price levels on each side
+    size_t get_bid_levels() const {
+        return bid_levels.size();
+    }
+
+    size_t get_ask_levels() const {
+        return ask_levels.size();
+    }
+
+    // Get number of individual orders
+    size_t get_total_orders() const {
+        return orders_by_id.size();
+    }
+
+    // O(1) check if order exists by order_id
+    bool has_order(OrderId order_id) const {
+        return orders_by_id.contains(order_id);
+    }
+
+    // O(1) get order by order_id
+    const Order* get_order(OrderId order_id) const {
+        Order* const* slot = orders_by_id.find(order_id);
+        return slot ? *slot : nullptr;
+    }
+
+    // Check if order book is empty
+    bool is_empty() const {
+        return bid_levels.empty() && ask_levels.empty();
+    }
+
+    // Keep the best levels (at most MAX_BOOK_DEPTH, 0 = off) per side in step with the book
+    void set_depth_levels(size_t levels) {
+        bid_depth.set_depth(levels);
+        ask_depth.set_depth(levels);
+        fill_depth(bid_levels, bid_depth);
+        fill_depth(ask_levels, ask_depth);
+    }
+
+    size_t get_depth_levels() const {
+        return bid_depth.depth();
+    }
+
+    // O(1) best levels of one side, best first
+    const DepthView& get_depth(OrderSide side) const {
+        return side == OrderSide::BID ? bid_depth : ask_depth;
+    }
+
+    // Clear the order book
+    void clear() {
+        orders_by_id.for_each([this](OrderId, Order* order) { order_pool.destroy(order); });
+        orders_by_id.clear();
+        bid_levels.clear();
+        ask_levels.clear();
+        bid_depth.clear();
+        ask_depth.clear();
+    }
+
+    // Get all orders at a price level in FIFO order (for debugging/analysis)
+    std::vector<OrderId> get_orders_at_price(OrderSide side, double price) const {
+        std::vector<OrderId> order_ids;
+        const PriceLevel* level = find_level(side, price);
+        if (level) {
+            for (const Order* entry = level->head; entry; entry = entry->next) {
+                order_ids.push_back(entry->order_id);
+            }
+        }
+        return order_ids;
+    }
+
+    // Get next order to execute at a price level (FIFO front)
+    const OrderEntry* get_next_order_at_price(OrderSide side, double price) const {
+        const PriceLevel* level = find_level(side, price);
+        return level ? level->get_next_order() : nullptr;
+    }
+
+    // Visit every resting order, level by level and oldest first within a level,
+    // so re-adding them in visit order rebuilds the same queues (snapshots)
+    template<typename Fn>
+    void for_each_order(Fn&& fn) const {
+        auto visit_level = [&fn](const PriceLevel& level) {
+            for (const Order* order = level.head; order; order = order->next) fn(*order);
+        };
+        bid_levels.for_each_level(visit_level);
+        ask_levels.for_each_level(visit_level);
+    }
+
+private:
+    PriceLadder& ladder(OrderSide side) {
+        return side == OrderSide::BID ? bid_levels : ask_levels;
+    }
+
+    void update_depth(OrderSide side, double price, uint32_t size) {
+        const PriceLadder& levels = ladder(side);
+        auto next_worse = [this, &levels](double p, DepthEntry& out) {
+            const PriceLevel* level = levels.next_worse(price_to_ticks(p));
+            if (!level) return false;
+            out = DepthEntry{level->price, level->total_size};
+            return true;
+        };
+        (side == OrderSide::BID ? bid_depth : ask_depth).update(price, size, next_worse);
+    }
+
+    void fill_depth(const PriceLadder& levels, DepthView& view) {
+        for (const PriceLevel* level = levels.best(); level && !view.full();
+             level = levels.next_worse(price_to_ticks(level->price))) {
+            view.push_back(level->price, level->total_size);
+        }
+    }
+
+    const PriceLevel* find_level(OrderSide side, double price) const {
+        if (side == OrderSide::BID) return bid_levels.find(price_to_ticks(price));
+        if (side == OrderSide::ASK) return ask_levels.find(price_to_ticks(price));
+        return nullptr;
+    }
+};
+
+#endif // TICK_ORDER_BOOK_HPP
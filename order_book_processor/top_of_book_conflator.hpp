@@ -0,0 +1,156 @@
+#ifndef TOP_OF_BOOK_CONFLATOR_HPP
+#define TOP_OF_BOOK_CONFLATOR_HPP
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "multicast_publisher.hpp"
+#include "symbol_directory.hpp"
+
+// Conflates top-of-book publication for one consumer shard.
+// update() runs after every event but only marks a symbol dirty when its best
+// bid/ask (price or size) actually changed; flush() publishes the latest state of
+// every dirty symbol in one packed batch. Symbols are tracked by interned ID in a
+// flat array (names come from the directory). Owned by a single consumer thread.
+//
+// When the book keeps a depth view (set_depth_levels), a change inside it also
+// marks the symbol dirty, and flush() sends the level deltas since the last
+// publish. Every DEPTH_REFRESH_NS a symbol's depth goes out in full instead, so
+// late joiners and receivers that lost a packet converge.
+class TopOfBookConflator {
+public:
+    static constexpr uint64_t DEPTH_REFRESH_NS = 1000000000ULL;
+
+    explicit TopOfBookConflator(const SymbolDirectory& symbols)
+        : symbols_(symbols), updates_seen_(0), updates_published_(0), depth_updates_published_(0) {}
+
+    // Record the book's BBO after an event (any backend with get_best_bid/get_best_ask)
+    template<typename Book>
+    void update(SymbolId symbol_id, const Book& book) {
+        ++updates_seen_;
+        std::pair<double, uint32_t> best_bid = book.get_best_bid();
+        std::pair<double, uint32_t> best_ask = book.get_best_ask();
+
+        if (symbol_id >= entries_.size()) {
+            entries_.resize(static_cast<size_t>(symbol_id) + 1);
+        }
+
+        Entry& entry = entries_[symbol_id];
+        const DepthView& bid_depth = book.get_depth(OrderSide::BID);
+        const DepthView& ask_depth = book.get_depth(OrderSide::ASK);
+        bool depth_changed = bid_depth.version() != entry.bid_version || ask_depth.version() != entry.ask_version;
+        if (entry.published_once && entry.best_bid == best_bid && entry.best_ask == best_ask && !depth_changed) {
+            return;  // Change behind the view, nothing new to publish
+        }
+        entry.best_bid = best_bid;
+        entry.best_ask = best_ask;
+        if (bid_depth.depth() > 0) {
+            // Books are heap-allocated once per symbol by the consumer, so the views stay put
+            entry.bid_depth = &bid_depth;
+            entry.ask_depth = &ask_depth;
+            entry.bid_version = bid_depth.version();
+            entry.ask_version = ask_depth.version();
+        }
+        entry.published_once = true;
+        if (!entry.dirty) {
+            entry.dirty = true;
+            dirty_.push_back(symbol_id);
+        }
+    }
+
+    // Start a symbol over (its book was cleared): the next update goes out with full depth
+    void reset(SymbolId symbol_id) {
+        if (symbol_id >= entries_.size()) return;
+        Entry& entry = entries_[symbol_id];
+        entry.published_once = false;
+        entry.next_refresh = 0;
+    }
+
+    bool has_dirty() const {
+        return !dirty_.empty();
+    }
+
+    // Publish every dirty symbol's latest BBO, packed into as few datagrams as fit.
+    // Returns the number of symbols published.
+    size_t flush(MulticastPublisher& publisher, uint64_t timestamp) {
+        if (dirty_.empty()) {
+            return 0;
+        }
+
+        batch_.clear();
+        for (SymbolId symbol_id : dirty_) {
+            Entry& entry = entries_[symbol_id];
+            const std::string& symbol = symbols_.name(symbol_id);
+            entry.dirty = false;
+            batch_.push_back(TopOfBookUpdate{symbol_id, &symbol, entry.best_bid, entry.best_ask});
+            if (entry.bid_depth) {
+                publish_depth(publisher, symbol_id, symbol, entry, timestamp);
+            }
+        }
+        dirty_.clear();
+
+        publisher.publish_top_of_book_batch(batch_, timestamp);
+        updates_published_ += batch_.size();
+        return batch_.size();
+    }
+
+    uint64_t get_updates_seen() const { return updates_seen_; }
+    uint64_t get_updates_published() const { return updates_published_; }
+    uint64_t get_depth_updates_published() const { return depth_updates_published_; }
+
+    // Disable copy constructor and assignment
+    TopOfBookConflator(const TopOfBookConflator&) = delete;
+    TopOfBookConflator& operator=(const TopOfBookConflator&) = delete;
+
+private:
+    struct Entry {
+        std::pair<double, uint32_t> best_bid{0.0, 0};
+        std::pair<double, uint32_t> best_ask{0.0, 0};
+        bool published_once = false;    // First update always goes out
+        bool dirty = false;             // Queued in dirty_
+        
+        // Depth views of the book (nullptr when it keeps none), as of the last update()
+        const DepthView* bid_depth = nullptr;
+        const DepthView* ask_depth = nullptr;
+        uint64_t bid_version = 0;
+        uint64_t ask_version = 0;
+        
+        // Levels as subscribers last saw them
+        DepthEntry published_bids[MAX_BOOK_DEPTH];
+        DepthEntry published_asks[MAX_BOOK_DEPTH];
+        uint32_t published_bid_count = 0;
+        uint32_t published_ask_count = 0;
+        uint64_t next_refresh = 0;      // Timestamp of the next full depth refresh
+    };
+    
+    // Queue the depth deltas since the last publish (or the full depth, when a refresh is due)
+    void publish_depth(MulticastPublisher& publisher, SymbolId symbol_id, const std::string& symbol, Entry& entry,
+                       uint64_t timestamp) {
+        bool reset = timestamp >= entry.next_refresh;
+        if (reset) {
+            entry.published_bid_count = 0;
+            entry.published_ask_count = 0;
+            entry.next_refresh = timestamp + DEPTH_REFRESH_NS;
+        }
+        
+        size_t count = diff_depth(entry.published_bids, entry.published_bid_count, *entry.bid_depth, deltas_);
+        count += diff_depth(entry.published_asks, entry.published_ask_count, *entry.ask_depth, deltas_ + count);
+        if (count > 0 || reset) {
+            publisher.publish_depth_update(symbol_id, symbol, reset, entry.bid_depth->depth(), deltas_, count,
+                                           timestamp);
+            ++depth_updates_published_;
+        }
+    }
+
+    const SymbolDirectory& symbols_;
+    std::vector<Entry> entries_;                // By symbol ID
+    std::vector<SymbolId> dirty_;               // Symbols changed since the last flush
+    std::vector<TopOfBookUpdate> batch_;        // Reused flush buffer
+    DepthDelta deltas_[4 * MAX_BOOK_DEPTH];     // One symbol's depth deltas, both sides
+    uint64_t updates_seen_;
+    uint64_t updates_published_;
+    uint64_t depth_updates_published_;
+};
+
+#endif // TOP_OF_BOOK_CONFLATOR_HPP
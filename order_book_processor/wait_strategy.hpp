@@ -0,0 +1,144 @@
+#ifndef WAIT_STRATEGY_HPP
+#define WAIT_STRATEGY_HPP
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// What a consumer does when its queue is empty
+enum class WaitStrategy {
+    YIELD,  // sched_yield() and poll again (default)
+    SPIN,   // Busy-poll with a pause hint: lowest latency, burns the whole core
+    HYBRID, // Spin for a while, then sleep on a futex until the producer commits
+    BLOCK   // Sleep on the futex right away: no idle CPU, a wakeup's latency per burst
+};
+
+// Spin-loop hint: lets the sibling hyperthread run and saves power while polling
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+// Futex doorbell for one sleeping consumer.
+//
+// The consumer announces itself, re-checks its queue and sleeps; the producer
+// publishes, then rings only if someone is asleep. A full fence on each side
+// guarantees that either the consumer sees the new events or the producer sees
+// the sleeper, so no wakeup is lost. With nobody asleep notify() costs the
+// fence and one load; the syscall only happens for a real wakeup.
+class QueueWakeup {
+public:
+    QueueWakeup() : epoch_(0), sleeping_(0), wakeups_(0) {}
+
+    // Producer: call after publishing events
+    void notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping_.load(std::memory_order_relaxed) != 0) {
+            epoch_.fetch_add(1, std::memory_order_release);
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+            wakeups_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Consumer: sleep until notify() or timeout_us pass, unless ready() already holds
+    template<typename Ready>
+    void wait(Ready&& ready, uint32_t timeout_us) {
+        uint32_t epoch = epoch_.load(std::memory_order_acquire);
+        sleeping_.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!ready()) {
+            timespec timeout{static_cast<time_t>(timeout_us / 1000000), static_cast<long>(timeout_us % 1000000) * 1000};
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAIT_PRIVATE, epoch, &timeout, nullptr, 0);
+        }
+        sleeping_.store(0, std::memory_order_relaxed);
+    }
+
+    // Futex wakeups issued by the producer (any thread)
+    uint64_t get_wakeups() const {
+        return wakeups_.load(std::memory_order_relaxed);
+    }
+
+    // Disable copy constructor and assignment
+    QueueWakeup(const QueueWakeup&) = delete;
+    QueueWakeup& operator=(const QueueWakeup&) = delete;
+
+private:
+    std::atomic<uint32_t> epoch_;       // Futex word: bumped by every wakeup
+    std::atomic<uint32_t> sleeping_;    // Consumer is (about to be) in FUTEX_WAIT
+    std::atomic<uint64_t> wakeups_;
+};
+
+// A consumer's idle loop: call idle() each time it finds its queue empty and
+// busy() each time it finds work. wakeup is only used by HYBRID and BLOCK and
+// must then be the one the queue's producer notifies.
+class IdleWaiter {
+public:
+    // Spin this long before sleeping. Timed, not counted: a pause costs ~10 cycles
+    // on some cores and ~140 on others.
+    static constexpr std::chrono::microseconds HYBRID_SPIN_TIME{50};
+    static constexpr uint32_t DEADLINE_CHECK_SPINS = 32;  // Pauses between clock reads
+
+    IdleWaiter(WaitStrategy strategy, QueueWakeup* wakeup, uint32_t sleep_timeout_us)
+        : strategy_(!wakeup && (strategy == WaitStrategy::HYBRID || strategy == WaitStrategy::BLOCK)
+                        ? WaitStrategy::YIELD : strategy),
+          wakeup_(wakeup), sleep_timeout_us_(sleep_timeout_us), spins_(0), spin_expired_(false) {}
+
+    // Wait a little; ready() says whether work arrived (checked before sleeping).
+    // Sleeps are bounded by sleep_timeout_us so timers in the caller's loop still run.
+    template<typename Ready>
+    void idle(Ready&& ready) {
+        switch (strategy_) {
+            case WaitStrategy::SPIN:
+                cpu_relax();
+                break;
+            case WaitStrategy::HYBRID:
+                if (!spin_expired_) {
+                    if (spins_ == 0) {
+                        spin_deadline_ = std::chrono::steady_clock::now() + HYBRID_SPIN_TIME;
+                    }
+                    cpu_relax();
+                    if (++spins_ % DEADLINE_CHECK_SPINS == 0 && std::chrono::steady_clock::now() >= spin_deadline_) {
+                        spin_expired_ = true;
+                    }
+                } else {
+                    wakeup_->wait(ready, sleep_timeout_us_);
+                }
+                break;
+            case WaitStrategy::BLOCK:
+                wakeup_->wait(ready, sleep_timeout_us_);
+                break;
+            default:
+                std::this_thread::yield();
+                break;
+        }
+    }
+
+    void busy() {
+        spins_ = 0;
+        spin_expired_ = false;
+    }
+
+private:
+    WaitStrategy strategy_;
+    QueueWakeup* wakeup_;
+    uint32_t sleep_timeout_us_;
+    uint32_t spins_;                    // Consecutive idle polls (HYBRID)
+    bool spin_expired_;                 // HYBRID_SPIN_TIME passed since the first of them
+    std::chrono::steady_clock::time_point spin_deadline_;
+};
+
+#endif // WAIT_STRATEGY_HPP
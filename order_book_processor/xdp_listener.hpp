@@ -0,0 +1,685 @@
+#ifndef XDP_LISTENER_HPP
+#define XDP_LISTENER_HPP
+
+#include <cstdint>
+
+// How the AF_XDP socket is attached to the NIC
+enum class XdpMode {
+    SKB,        // Generic XDP + copy mode: works on any interface, least gain
+    NATIVE,     // Driver XDP hook, frames copied into the umem
+    ZEROCOPY    // Driver XDP hook, NIC DMAs straight into the umem
+};
+
+#ifdef ENABLE_AF_XDP
+
+#include <cstddef>
+#include <string>
+#include <functional>
+#include <vector>
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <poll.h>
+#include <unistd.h>
+#include <linux/if_xdp.h>
+#include <linux/if_link.h>
+#include <linux/bpf.h>
+#include "quote.hpp"
+#include "feed_decoder.hpp"
+
+#ifndef SO_PREFER_BUSY_POLL
+#define SO_PREFER_BUSY_POLL 69
+#endif
+#ifndef SO_BUSY_POLL_BUDGET
+#define SO_BUSY_POLL_BUDGET 70
+#endif
+#ifndef BPF_JMP32
+#define BPF_JMP32 0x06
+#endif
+
+// AF_XDP ingress backend (same interface as UDPListener).
+//
+// A tiny XDP program on one NIC RX queue redirects the feed's frames (IPv4 UDP
+// to the configured group(s) and port) into an AF_XDP socket whose umem is
+// mapped into this process, so they skip the kernel network stack entirely.
+// Everything else on the queue (ARP, TCP, IGMP queries, other groups) is passed
+// to the kernel as usual. Headers are checked again in userspace, and the UDP
+// payload goes to the same FeedDecoder the socket backend uses.
+//
+// Steer the feed onto its own queue so other traffic stays off the hot path:
+//   ethtool -N <if> flow-type udp4 dst-ip 224.0.0.1 dst-port 12345 action <queue>
+// (with a line B group, add a rule steering it to the same queue)
+// Needs Linux 5.9+ (bpf_link for XDP) and CAP_NET_ADMIN + CAP_BPF (or root).
+// No libbpf/libxdp dependency: the program and maps are set up with raw bpf().
+class XDPListener {
+private:
+    // Single-producer/single-consumer ring shared with the kernel
+    struct XskRing {
+        uint32_t* producer = nullptr;
+        uint32_t* consumer = nullptr;
+        uint32_t* flags = nullptr;
+        void* descs = nullptr;
+        void* map = nullptr;
+        size_t map_size = 0;
+        uint32_t size = 0;
+        uint32_t mask = 0;
+    };
+
+    static constexpr uint32_t FRAME_SIZE = 2048;       // One frame per umem chunk
+    static constexpr uint32_t NUM_FRAMES = 4096;
+    static constexpr uint32_t RING_SIZE = 2048;        // Fill and RX ring depth
+    static constexpr uint32_t XSKMAP_ENTRIES = 64;     // Max RX queue index + 1
+
+    std::string multicast_group_;
+    std::string line_b_group_;          // Redundant copy of the feed (empty = single line)
+    uint16_t port_;
+    std::string interface_;
+    uint32_t queue_id_;
+    XdpMode mode_;
+    int busy_poll_usecs_;               // 0 = sleep in poll() when idle
+    size_t batch_size_;                 // Max frames consumed per pass
+
+    int ifindex_;
+    int xsk_fd_;
+    int igmp_fd_;                       // Plain UDP socket holding the group membership
+    int map_fd_;
+    int prog_fd_;
+    int link_fd_;
+    char* umem_;
+    size_t umem_size_;
+    XskRing fill_;
+    XskRing rx_;
+    uint32_t group_addr_;               // Network byte order
+    uint32_t line_b_addr_;              // 0 = no line B
+    uint16_t port_be_;
+
+    std::atomic<bool>* shutdown_flag_;
+    FeedDecoder decoder_;
+
+    // Receive statistics (written by the listener thread only)
+    uint64_t frames_received_;
+    uint64_t frames_filtered_;          // Redirected but failed the userspace header check
+    uint64_t datagrams_received_;
+
+public:
+    XDPListener(const std::string& multicast_group, uint16_t port,
+                const std::string& interface, uint32_t queue_id)
+        : multicast_group_(multicast_group), port_(port), interface_(interface), queue_id_(queue_id),
+          mode_(XdpMode::SKB), busy_poll_usecs_(0), batch_size_(64),
+          ifindex_(0), xsk_fd_(-1), igmp_fd_(-1), map_fd_(-1), prog_fd_(-1), link_fd_(-1),
+          umem_(nullptr), umem_size_(0), group_addr_(0), line_b_addr_(0), port_be_(htons(port)),
+          shutdown_flag_(nullptr), frames_received_(0), frames_filtered_(0), datagrams_received_(0) {}
+
+    ~XDPListener() {
+        shutdown();
+    }
+
+    // Setup and teardown
+    bool initialize() {
+        ifindex_ = static_cast<int>(if_nametoindex(interface_.c_str()));
+        if (ifindex_ == 0) {
+            std::cerr << "Failed to find interface " << interface_ << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        if (inet_pton(AF_INET, multicast_group_.c_str(), &group_addr_) != 1) {
+            std::cerr << "Invalid multicast group " << multicast_group_ << std::endl;
+            return false;
+        }
+        if (!line_b_group_.empty() && inet_pton(AF_INET, line_b_group_.c_str(), &line_b_addr_) != 1) {
+            std::cerr << "Invalid line B multicast group " << line_b_group_ << std::endl;
+            return false;
+        }
+
+        if (!join_group() || !create_umem_socket() || !load_redirect_program()) {
+            shutdown();
+            return false;
+        }
+        if (busy_poll_usecs_ > 0) {
+            enable_busy_poll();
+        }
+
+        std::cout << "AF_XDP listener on " << interface_ << " queue " << queue_id_ << " ("
+                  << (mode_ == XdpMode::ZEROCOPY ? "zero-copy" : mode_ == XdpMode::NATIVE ? "native" : "skb")
+                  << " mode), filtering " << multicast_group_
+                  << (line_b_addr_ ? " + " + line_b_group_ : std::string()) << ":" << port_ << std::endl;
+        return true;
+    }
+
+    void shutdown() {
+        // Closing the link fd detaches the XDP program
+        if (link_fd_ != -1) { close(link_fd_); link_fd_ = -1; }
+        if (prog_fd_ != -1) { close(prog_fd_); prog_fd_ = -1; }
+        if (map_fd_ != -1) { close(map_fd_); map_fd_ = -1; }
+        unmap_ring(fill_);
+        unmap_ring(rx_);
+        if (xsk_fd_ != -1) { close(xsk_fd_); xsk_fd_ = -1; }
+        if (umem_) { munmap(umem_, umem_size_); umem_ = nullptr; }
+        if (igmp_fd_ != -1) {
+            close(igmp_fd_);  // Drops the group membership
+            igmp_fd_ = -1;
+            std::cout << "AF_XDP listener shutdown complete" << std::endl;
+        }
+    }
+
+    // Main listening loop: consume RX descriptors, filter, decode, recycle frames
+    // into the fill ring. With busy-poll enabled the loop never sleeps; an empty
+    // pass calls recvfrom() to drive the driver's NAPI poll from this core.
+    void listen() {
+        if (xsk_fd_ == -1) {
+            std::cerr << "Cannot listen: AF_XDP socket not initialized" << std::endl;
+            return;
+        }
+
+        std::cout << "Listening for multicast frames from " << multicast_group_ << ":" << port_
+                  << " (" << (busy_poll_usecs_ > 0 ? "busy-poll" : "poll") << ")..." << std::endl;
+
+        while (!(shutdown_flag_ && *shutdown_flag_)) {
+            uint32_t rx_prod = __atomic_load_n(rx_.producer, __ATOMIC_ACQUIRE);
+            uint32_t rx_cons = *rx_.consumer;
+            uint32_t available = rx_prod - rx_cons;
+
+            if (available == 0) {
+                wait_for_frames();
+                continue;
+            }
+            if (available > batch_size_) {
+                available = static_cast<uint32_t>(batch_size_);
+            }
+
+            uint64_t rx_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+
+            const struct xdp_desc* descs = static_cast<const struct xdp_desc*>(rx_.descs);
+            uint64_t* fill_addrs = static_cast<uint64_t*>(fill_.descs);
+            uint32_t fill_prod = *fill_.producer;
+
+            for (uint32_t i = 0; i < available; ++i) {
+                const struct xdp_desc& desc = descs[(rx_cons + i) & rx_.mask];
+                ++frames_received_;
+
+                const char* payload = nullptr;
+                size_t payload_len = 0;
+                if (match_frame(umem_ + desc.addr, desc.len, payload, payload_len)) {
+                    ++datagrams_received_;
+                    decoder_.handle_datagram(payload, payload_len, rx_ns);
+                } else {
+                    ++frames_filtered_;
+                }
+
+                // Hand the frame straight back; the fill ring can never overflow
+                // because it holds exactly the frames not sitting in the RX ring
+                fill_addrs[(fill_prod + i) & fill_.mask] = desc.addr & ~static_cast<uint64_t>(FRAME_SIZE - 1);
+            }
+
+            decoder_.flush();
+            __atomic_store_n(rx_.consumer, rx_cons + available, __ATOMIC_RELEASE);
+            __atomic_store_n(fill_.producer, fill_prod + available, __ATOMIC_RELEASE);
+        }
+
+        std::cout << "AF_XDP listener stopped (" << frames_received_ << " frames, "
+                  << frames_filtered_ << " filtered)" << std::endl;
+    }
+
+    // Set callback for order book event processing
+    void set_order_book_callback(std::function<void(const OrderBookEvent&)> callback) {
+        decoder_.set_order_book_callback(callback);
+    }
+
+    // Decode datagrams straight into the queue's slots (takes precedence over the callbacks)
+    void set_output_queue(SPSCRingBuffer<OrderBookEvent>* queue, QueueWakeup* wakeup = nullptr) {
+        decoder_.set_output_queue(queue, wakeup);
+    }
+
+    // Sharded form: each event goes to queues[shard_map->shard_for(symbol)]
+    void set_output_queues(const std::vector<SPSCRingBuffer<OrderBookEvent>*>& queues, const ShardMap* shard_map,
+                           const std::vector<QueueWakeup*>& wakeups = {}) {
+        decoder_.set_output_queues(queues, shard_map, wakeups);
+    }
+
+    // Stamp events with their symbol's interned ID (see SymbolDirectory)
+    void set_symbol_directory(SymbolDirectory* symbols) {
+        decoder_.set_symbol_directory(symbols);
+    }
+
+    void set_exchange_directory(SymbolDirectory* exchanges) {
+        decoder_.set_exchange_directory(exchanges);
+    }
+
+    uint64_t get_events_enqueued() const {
+        return decoder_.get_events_enqueued();
+    }
+
+    uint64_t get_events_dropped() const {
+        return decoder_.get_events_dropped();
+    }
+
+    // Producer counters for the stats reporter (safe to read from other threads)
+    const IngressStats& get_ingress_stats() const {
+        return decoder_.get_ingress_stats();
+    }
+
+    // Record every received datagram to a capture file (see feed_capture.hpp)
+    void set_capture(FeedCaptureWriter* capture) {
+        decoder_.set_capture(capture);
+    }
+
+    // Also accept a redundant (B line) group on the same port. Must be set before initialize().
+    void set_line_b_group(const std::string& group) {
+        line_b_group_ = group;
+    }
+
+    // Drop duplicate sequence numbers and count gaps (default: on)
+    void set_sequence_check(bool enabled) {
+        decoder_.set_sequence_check(enabled);
+    }
+
+    const SequenceArbiter& get_sequence_arbiter() const {
+        return decoder_.get_sequence_arbiter();
+    }
+
+    const OrderIdTable& get_order_ids() const {
+        return decoder_.get_order_ids();
+    }
+
+    // Select the ingress wire format (default: AUTO)
+    void set_feed_format(FeedFormat format) {
+        decoder_.set_feed_format(format);
+    }
+
+    // Attach mode (default: SKB). Must be set before initialize().
+    void set_mode(XdpMode mode) {
+        mode_ = mode;
+    }
+
+    // SO_BUSY_POLL budget in microseconds (0 = off). Must be set before initialize().
+    void set_busy_poll(int usecs) {
+        busy_poll_usecs_ = usecs > 0 ? usecs : 0;
+    }
+
+    // Max frames consumed per pass over the RX ring
+    void set_batch_size(size_t batch_size) {
+        batch_size_ = batch_size > 0 ? batch_size : 1;
+    }
+
+    // Set shutdown flag for graceful shutdown
+    void set_shutdown_flag(std::atomic<bool>* flag) {
+        shutdown_flag_ = flag;
+    }
+
+    uint64_t get_datagrams_received() const {
+        return datagrams_received_;
+    }
+
+    uint64_t get_frames_filtered() const {
+        return frames_filtered_;
+    }
+
+    bool is_listening() const {
+        return xsk_fd_ != -1;
+    }
+
+    uint16_t get_port() const {
+        return port_;
+    }
+
+    // Disable copy constructor and assignment
+    XDPListener(const XDPListener&) = delete;
+    XDPListener& operator=(const XDPListener&) = delete;
+
+private:
+    // Userspace filter: Ethernet (optionally 802.1Q) -> IPv4 -> UDP to our group/port.
+    // Fragments are dropped; the feed never sends datagrams larger than one frame.
+    bool match_frame(const char* frame, uint32_t len, const char*& payload, size_t& payload_len) const {
+        size_t offset = 12;
+        if (len < offset + 2) return false;
+        uint16_t ether_type = load_be16(frame + offset);
+        offset += 2;
+        if (ether_type == 0x8100) {  // VLAN tag
+            if (len < offset + 4) return false;
+            ether_type = load_be16(frame + offset + 2);
+            offset += 4;
+        }
+        if (ether_type != 0x0800) return false;
+
+        const unsigned char* ip = reinterpret_cast<const unsigned char*>(frame + offset);
+        if (len < offset + 20 || (ip[0] >> 4) != 4) return false;
+        size_t ip_header_len = static_cast<size_t>(ip[0] & 0x0F) * 4;
+        size_t ip_total_len = load_be16(frame + offset + 2);
+        if (ip_header_len < 20 || ip_total_len < ip_header_len || len < offset + ip_total_len) return false;
+        if (ip[9] != IPPROTO_UDP) return false;
+        if (load_be16(frame + offset + 6) & 0x3FFF) return false;  // MF flag or fragment offset
+
+        uint32_t dst_addr;
+        std::memcpy(&dst_addr, ip + 16, sizeof(dst_addr));
+        if (dst_addr != group_addr_ && (line_b_addr_ == 0 || dst_addr != line_b_addr_)) return false;
+
+        if (ip_total_len < ip_header_len + 8) return false;  // No room for the UDP header
+        const char* udp = frame + offset + ip_header_len;
+        size_t udp_len = load_be16(udp + 4);
+        uint16_t dst_port;
+        std::memcpy(&dst_port, udp + 2, sizeof(dst_port));
+        if (dst_port != port_be_ || udp_len < 8 || udp_len > ip_total_len - ip_header_len) {
+            return false;
+        }
+
+        payload = udp + 8;
+        payload_len = udp_len - 8;
+        return true;
+    }
+
+    static uint16_t load_be16(const char* p) {
+        const unsigned char* b = reinterpret_cast<const unsigned char*>(p);
+        return static_cast<uint16_t>((b[0] << 8) | b[1]);
+    }
+
+    // Idle path once the RX ring is empty
+    void wait_for_frames() {
+        if (busy_poll_usecs_ > 0) {
+            // Drives the driver's NAPI poll from this thread (SO_PREFER_BUSY_POLL)
+            recvfrom(xsk_fd_, nullptr, 0, MSG_DONTWAIT, nullptr, nullptr);
+            return;
+        }
+        // need_wakeup: the kernel only refills RX after being kicked
+        struct pollfd pfd;
+        pfd.fd = xsk_fd_;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        poll(&pfd, 1, 100);  // Short timeout keeps shutdown responsive
+    }
+
+    // The NIC delivers multicast only for groups someone joined, and IGMP reports
+    // still go through the kernel, so keep an ordinary socket in the group
+    bool join_group() {
+        igmp_fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+        if (igmp_fd_ == -1) {
+            std::cerr << "Failed to create socket: " << strerror(errno) << std::endl;
+            return false;
+        }
+        struct ip_mreqn mreq;
+        memset(&mreq, 0, sizeof(mreq));
+        mreq.imr_multiaddr.s_addr = group_addr_;
+        mreq.imr_ifindex = ifindex_;
+        if (setsockopt(igmp_fd_, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+            std::cerr << "Failed to join multicast group " << multicast_group_
+                      << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        if (line_b_addr_ != 0) {
+            mreq.imr_multiaddr.s_addr = line_b_addr_;
+            if (setsockopt(igmp_fd_, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+                std::cerr << "Failed to join line B multicast group " << line_b_group_
+                          << ": " << strerror(errno) << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool create_umem_socket() {
+        xsk_fd_ = socket(AF_XDP, SOCK_RAW, 0);
+        if (xsk_fd_ == -1) {
+            std::cerr << "Failed to create AF_XDP socket: " << strerror(errno) << std::endl;
+            return false;
+        }
+
+        umem_size_ = static_cast<size_t>(NUM_FRAMES) * FRAME_SIZE;
+        void* umem = mmap(nullptr, umem_size_, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+        if (umem == MAP_FAILED) {
+            std::cerr << "Failed to allocate umem: " << strerror(errno) << std::endl;
+            return false;
+        }
+        umem_ = static_cast<char*>(umem);
+
+        struct xdp_umem_reg reg;
+        memset(&reg, 0, sizeof(reg));
+        reg.addr = reinterpret_cast<uint64_t>(umem_);
+        reg.len = umem_size_;
+        reg.chunk_size = FRAME_SIZE;
+        reg.headroom = 0;
+        if (setsockopt(xsk_fd_, SOL_XDP, XDP_UMEM_REG, &reg, sizeof(reg)) < 0) {
+            std::cerr << "Failed to register umem: " << strerror(errno) << std::endl;
+            return false;
+        }
+
+        // The completion ring is mandatory even though this socket never transmits
+        uint32_t ring_size = RING_SIZE;
+        if (setsockopt(xsk_fd_, SOL_XDP, XDP_UMEM_FILL_RING, &ring_size, sizeof(ring_size)) < 0 ||
+            setsockopt(xsk_fd_, SOL_XDP, XDP_UMEM_COMPLETION_RING, &ring_size, sizeof(ring_size)) < 0 ||
+            setsockopt(xsk_fd_, SOL_XDP, XDP_RX_RING, &ring_size, sizeof(ring_size)) < 0) {
+            std::cerr << "Failed to size AF_XDP rings: " << strerror(errno) << std::endl;
+            return false;
+        }
+
+        struct xdp_mmap_offsets offsets;
+        socklen_t optlen = sizeof(offsets);
+        if (getsockopt(xsk_fd_, SOL_XDP, XDP_MMAP_OFFSETS, &offsets, &optlen) < 0) {
+            std::cerr << "Failed to query AF_XDP ring offsets: " << strerror(errno) << std::endl;
+            return false;
+        }
+        if (!map_ring(fill_, offsets.fr, XDP_UMEM_PGOFF_FILL_RING, sizeof(uint64_t)) ||
+            !map_ring(rx_, offsets.rx, XDP_PGOFF_RX_RING, sizeof(struct xdp_desc))) {
+            return false;
+        }
+
+        struct sockaddr_xdp addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sxdp_family = AF_XDP;
+        addr.sxdp_ifindex = static_cast<uint32_t>(ifindex_);
+        addr.sxdp_queue_id = queue_id_;
+        addr.sxdp_flags = XDP_USE_NEED_WAKEUP | (mode_ == XdpMode::ZEROCOPY ? XDP_ZEROCOPY : XDP_COPY);
+        if (bind(xsk_fd_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+            std::cerr << "Failed to bind AF_XDP socket to " << interface_ << " queue " << queue_id_
+                      << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+
+        // Give the kernel the first RING_SIZE frames; the rest are never needed
+        // because every consumed frame is recycled immediately
+        uint64_t* fill_addrs = static_cast<uint64_t*>(fill_.descs);
+        for (uint32_t i = 0; i < RING_SIZE; ++i) {
+            fill_addrs[i] = static_cast<uint64_t>(i) * FRAME_SIZE;
+        }
+        __atomic_store_n(fill_.producer, RING_SIZE, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    bool map_ring(XskRing& ring, const struct xdp_ring_offset& off, off_t pgoff, size_t desc_size) {
+        ring.map_size = off.desc + RING_SIZE * desc_size;
+        void* map = mmap(nullptr, ring.map_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, xsk_fd_, pgoff);
+        if (map == MAP_FAILED) {
+            std::cerr << "Failed to map AF_XDP ring: " << strerror(errno) << std::endl;
+            ring.map = nullptr;
+            return false;
+        }
+        char* base = static_cast<char*>(map);
+        ring.map = map;
+        ring.producer = reinterpret_cast<uint32_t*>(base + off.producer);
+        ring.consumer = reinterpret_cast<uint32_t*>(base + off.consumer);
+        ring.flags = reinterpret_cast<uint32_t*>(base + off.flags);
+        ring.descs = base + off.desc;
+        ring.size = RING_SIZE;
+        ring.mask = RING_SIZE - 1;
+        return true;
+    }
+
+    static void unmap_ring(XskRing& ring) {
+        if (ring.map) {
+            munmap(ring.map, ring.map_size);
+            ring = XskRing();
+        }
+    }
+
+    static long bpf_call(int cmd, union bpf_attr& attr) {
+        return syscall(__NR_bpf, cmd, &attr, sizeof(attr));
+    }
+
+    // Load and attach a program that matches frames the way match_frame() does
+    // (Ethernet, optional 802.1Q tag, unfragmented IPv4 UDP to our group(s)/port)
+    // and redirects those:  return bpf_redirect_map(&xsks, ctx->rx_queue_index, XDP_PASS);
+    // Anything else, and frames on queues without a socket in the map, goes to
+    // the kernel stack.
+    bool load_redirect_program() {
+        union bpf_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.map_type = BPF_MAP_TYPE_XSKMAP;
+        attr.key_size = sizeof(uint32_t);
+        attr.value_size = sizeof(uint32_t);
+        attr.max_entries = XSKMAP_ENTRIES;
+        map_fd_ = static_cast<int>(bpf_call(BPF_MAP_CREATE, attr));
+        if (map_fd_ < 0) {
+            std::cerr << "Failed to create XSKMAP: " << strerror(errno) << std::endl;
+            return false;
+        }
+
+        // Registers: r6 = ctx, r2 = data, r3 = data_end, r7 = IPv4 header, r4/r5 scratch.
+        // Packet loads see raw network-order bytes, so constants are compared in network order.
+        std::vector<struct bpf_insn> insns;
+        std::vector<size_t> to_pass;    // Jumps to patch to the XDP_PASS exit
+        auto emit = [&insns](uint8_t code, uint8_t dst, uint8_t src, int16_t off, int32_t imm) {
+            struct bpf_insn insn;
+            memset(&insn, 0, sizeof(insn));
+            insn.code = code;
+            insn.dst_reg = dst & 0x0F;
+            insn.src_reg = src & 0x0F;
+            insn.off = off;
+            insn.imm = imm;
+            insns.push_back(insn);
+            return insns.size() - 1;
+        };
+        auto pass_unless = [&](uint8_t jump_op, uint8_t dst, uint8_t src, int32_t imm) {
+            to_pass.push_back(emit(jump_op, dst, src, 0, imm));
+        };
+        auto jump_to = [&insns](size_t jump, size_t target) {
+            insns[jump].off = static_cast<int16_t>(target - jump - 1);
+        };
+
+        emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_6, BPF_REG_1, 0, 0);
+        emit(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_2, BPF_REG_6, offsetof(struct xdp_md, data), 0);
+        emit(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_3, BPF_REG_6, offsetof(struct xdp_md, data_end), 0);
+
+        // Ethernet type, behind one VLAN tag if present; r7 = IPv4 header
+        emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_4, BPF_REG_2, 0, 0);
+        emit(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0, 14);
+        pass_unless(BPF_JMP | BPF_JGT | BPF_X, BPF_REG_4, BPF_REG_3, 0);
+        emit(BPF_LDX | BPF_MEM | BPF_H, BPF_REG_5, BPF_REG_2, 12, 0);
+        emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_7, BPF_REG_2, 0, 0);
+        emit(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_7, 0, 0, 14);
+        size_t untagged = emit(BPF_JMP | BPF_JNE | BPF_K, BPF_REG_5, 0, 0, htons(0x8100));
+        emit(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0, 4);
+        pass_unless(BPF_JMP | BPF_JGT | BPF_X, BPF_REG_4, BPF_REG_3, 0);
+        emit(BPF_LDX | BPF_MEM | BPF_H, BPF_REG_5, BPF_REG_2, 16, 0);
+        emit(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_7, 0, 0, 4);
+        jump_to(untagged, insns.size());
+        pass_unless(BPF_JMP | BPF_JNE | BPF_K, BPF_REG_5, 0, htons(0x0800));
+
+        // IPv4: UDP, not a fragment, to the group or line B
+        emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_4, BPF_REG_7, 0, 0);
+        emit(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0, 20);
+        pass_unless(BPF_JMP | BPF_JGT | BPF_X, BPF_REG_4, BPF_REG_3, 0);
+        emit(BPF_LDX | BPF_MEM | BPF_B, BPF_REG_5, BPF_REG_7, 9, 0);
+        pass_unless(BPF_JMP | BPF_JNE | BPF_K, BPF_REG_5, 0, IPPROTO_UDP);
+        emit(BPF_LDX | BPF_MEM | BPF_H, BPF_REG_5, BPF_REG_7, 6, 0);
+        emit(BPF_ALU64 | BPF_AND | BPF_K, BPF_REG_5, 0, 0, htons(0x3FFF));  // MF flag or fragment offset
+        pass_unless(BPF_JMP | BPF_JNE | BPF_K, BPF_REG_5, 0, 0);
+        emit(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_5, BPF_REG_7, 16, 0);
+        size_t group_match = emit(BPF_JMP32 | BPF_JEQ | BPF_K, BPF_REG_5, 0, 0, static_cast<int32_t>(group_addr_));
+        size_t line_b_match = 0;
+        if (line_b_addr_ != 0) {
+            line_b_match = emit(BPF_JMP32 | BPF_JEQ | BPF_K, BPF_REG_5, 0, 0, static_cast<int32_t>(line_b_addr_));
+        }
+        pass_unless(BPF_JA | BPF_JMP, 0, 0, 0);
+        jump_to(group_match, insns.size());
+        if (line_b_addr_ != 0) {
+            jump_to(line_b_match, insns.size());
+        }
+
+        // UDP destination port, behind an IP header of ihl * 4 bytes
+        emit(BPF_LDX | BPF_MEM | BPF_B, BPF_REG_5, BPF_REG_7, 0, 0);
+        emit(BPF_ALU64 | BPF_AND | BPF_K, BPF_REG_5, 0, 0, 0x0F);
+        emit(BPF_ALU64 | BPF_LSH | BPF_K, BPF_REG_5, 0, 0, 2);
+        pass_unless(BPF_JMP | BPF_JLT | BPF_K, BPF_REG_5, 0, 20);
+        emit(BPF_ALU64 | BPF_ADD | BPF_X, BPF_REG_7, BPF_REG_5, 0, 0);
+        emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_4, BPF_REG_7, 0, 0);
+        emit(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0, 8);
+        pass_unless(BPF_JMP | BPF_JGT | BPF_X, BPF_REG_4, BPF_REG_3, 0);
+        emit(BPF_LDX | BPF_MEM | BPF_H, BPF_REG_5, BPF_REG_7, 2, 0);
+        pass_unless(BPF_JMP | BPF_JNE | BPF_K, BPF_REG_5, 0, port_be_);
+
+        // Feed frame: r2 = ctx->rx_queue_index, r1 = &xsks (64-bit immediate, two
+        // slots), r3 = XDP_PASS (action when the map slot is empty)
+        emit(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_2, BPF_REG_6, offsetof(struct xdp_md, rx_queue_index), 0);
+        emit(BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, map_fd_);
+        emit(0, 0, 0, 0, 0);
+        emit(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_3, 0, 0, XDP_PASS);
+        emit(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map);
+        emit(BPF_JMP | BPF_EXIT, 0, 0, 0, 0);
+
+        // Not the feed: hand it to the kernel
+        for (size_t jump : to_pass) {
+            jump_to(jump, insns.size());
+        }
+        emit(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, XDP_PASS);
+        emit(BPF_JMP | BPF_EXIT, 0, 0, 0, 0);
+        static const char license[] = "Dual BSD/GPL";
+
+        memset(&attr, 0, sizeof(attr));
+        attr.prog_type = BPF_PROG_TYPE_XDP;
+        attr.expected_attach_type = BPF_XDP;
+        attr.insns = reinterpret_cast<uint64_t>(insns.data());
+        attr.insn_cnt = static_cast<uint32_t>(insns.size());
+        attr.license = reinterpret_cast<uint64_t>(license);
+        prog_fd_ = static_cast<int>(bpf_call(BPF_PROG_LOAD, attr));
+        if (prog_fd_ < 0) {
+            std::cerr << "Failed to load XDP program: " << strerror(errno) << std::endl;
+            return false;
+        }
+
+        uint32_t key = queue_id_;
+        uint32_t value = static_cast<uint32_t>(xsk_fd_);
+        memset(&attr, 0, sizeof(attr));
+        attr.map_fd = static_cast<uint32_t>(map_fd_);
+        attr.key = reinterpret_cast<uint64_t>(&key);
+        attr.value = reinterpret_cast<uint64_t>(&value);
+        if (bpf_call(BPF_MAP_UPDATE_ELEM, attr) < 0) {
+            std::cerr << "Failed to register AF_XDP socket in XSKMAP: " << strerror(errno) << std::endl;
+            return false;
+        }
+
+        memset(&attr, 0, sizeof(attr));
+        attr.link_create.prog_fd = static_cast<uint32_t>(prog_fd_);
+        attr.link_create.target_ifindex = static_cast<uint32_t>(ifindex_);
+        attr.link_create.attach_type = BPF_XDP;
+        attr.link_create.flags = (mode_ == XdpMode::SKB) ? XDP_FLAGS_SKB_MODE : XDP_FLAGS_DRV_MODE;
+        link_fd_ = static_cast<int>(bpf_call(BPF_LINK_CREATE, attr));
+        if (link_fd_ < 0) {
+            std::cerr << "Failed to attach XDP program to " << interface_ << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Preferred busy polling: the kernel defers IRQs while this thread keeps polling
+    void enable_busy_poll() {
+        int usecs = busy_poll_usecs_;
+        int prefer = 1;
+        int budget = static_cast<int>(batch_size_);
+        if (setsockopt(xsk_fd_, SOL_SOCKET, SO_BUSY_POLL, &usecs, sizeof(usecs)) < 0 ||
+            setsockopt(xsk_fd_, SOL_SOCKET, SO_PREFER_BUSY_POLL, &prefer, sizeof(prefer)) < 0 ||
+            setsockopt(xsk_fd_, SOL_SOCKET, SO_BUSY_POLL_BUDGET, &budget, sizeof(budget)) < 0) {
+            std::cerr << "Warning: Failed to enable busy polling: " << strerror(errno) << std::endl;
+        }
+    }
+};
+
+#endif // ENABLE_AF_XDP
+
+#endif // XDP_LISTENER_HPP